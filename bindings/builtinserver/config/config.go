@@ -14,10 +14,12 @@ type StorageConf struct {
 }
 
 type NetConf struct {
-	HTTPAddr string `yaml:"httpaddr"`
-	RPCAddr  string `yaml:"rpcaddr"`
-	WebRoot  string `yaml:"webroot"`
-	Security bool   `yaml:"security"`
+	HTTPAddr     string `yaml:"httpaddr"`
+	RPCAddr      string `yaml:"rpcaddr"`
+	WebRoot      string `yaml:"webroot"`
+	Security     bool   `yaml:"security"`
+	RPCWorkers   int    `yaml:"rpc_workers"`
+	RPCQueueSize int    `yaml:"rpc_queue_size"`
 }
 
 type LoggerConf struct {
@@ -66,9 +68,11 @@ func DefaultServerConfig() *ServerConfig {
 			Autorepair:      false,
 		},
 		Net: NetConf{
-			HTTPAddr: "0.0.0.0:9088",
-			RPCAddr:  "0.0.0.0:6534",
-			Security: false,
+			HTTPAddr:     "0.0.0.0:9088",
+			RPCAddr:      "0.0.0.0:6534",
+			Security:     false,
+			RPCWorkers:   4,
+			RPCQueueSize: 1024,
 		},
 		Logger: LoggerConf{
 			ServerLog: "stdout",
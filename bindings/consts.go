@@ -71,6 +71,7 @@ const (
 	QueryOpenBracket       = 18
 	QueryCloseBracket      = 19
 	QueryJoinCondition     = 20
+	QueryParallel          = 21
 
 	LeftJoin    = 0
 	InnerJoin   = 1
@@ -140,4 +141,5 @@ const (
 	ErrStateInvalidated = 14
 	ErrTimeout          = 19
 	ErrCanceled         = 20
+	ErrOverloaded       = 21
 )
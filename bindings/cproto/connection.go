@@ -57,6 +57,7 @@ const (
 	cmdModifyItem        = 33
 	cmdDeleteQuery       = 34
 	cmdUpdateQuery       = 35
+	cmdModifyItems       = 36
 	cmdSelect            = 48
 	cmdSelectSQL         = 49
 	cmdFetchResults      = 50
@@ -174,6 +174,11 @@ int64_t QueryResults::Iterator::GetLSN() {
 	return itemParams_.lsn;
 }
 
+int QueryResults::Iterator::GetID() {
+	readNext();
+	return itemParams_.id;
+}
+
 bool QueryResults::Iterator::IsRaw() {
 	readNext();
 	return itemParams_.raw;
@@ -36,6 +36,7 @@ public:
 		Error GetCJSON(WrSerializer &wrser, bool withHdrLen = true);
 		Item GetItem();
 		int64_t GetLSN();
+		int GetID();
 		bool IsRaw();
 		string_view GetRaw();
 		Iterator &operator++();
@@ -25,6 +25,10 @@ Error Reindexer::Update(string_view nsName, Item& item) { return impl_->Update(n
 Error Reindexer::Update(const Query& q, QueryResults& result) { return impl_->Update(q, result, ctx_); }
 Error Reindexer::Upsert(string_view nsName, Item& item) { return impl_->Upsert(nsName, item, ctx_); }
 Error Reindexer::Delete(string_view nsName, Item& item) { return impl_->Delete(nsName, item, ctx_); }
+Error Reindexer::ModifyItems(string_view nsName, std::vector<Item>& items, const std::vector<ItemModifyMode>& modes,
+							 std::vector<Error>& statuses) {
+	return impl_->ModifyItems(nsName, items, modes, statuses, ctx_);
+}
 Item Reindexer::NewItem(string_view nsName) { return impl_->NewItem(nsName); }
 Error Reindexer::GetMeta(string_view nsName, const string& key, string& data) { return impl_->GetMeta(nsName, key, data, ctx_); }
 Error Reindexer::PutMeta(string_view nsName, const string& key, const string_view& data) { return impl_->PutMeta(nsName, key, data, ctx_); }
@@ -42,6 +46,7 @@ Error Reindexer::SubscribeUpdates(IUpdatesObserver* observer, bool subscribe) {
 Error Reindexer::GetSqlSuggestions(const string_view sqlQuery, int pos, vector<string>& suggests) {
 	return impl_->GetSqlSuggestions(sqlQuery, pos, suggests);
 }
+Error Reindexer::GetServerVersion(string& version) { return impl_->GetServerVersion(version, ctx_); }
 
 }  // namespace client
 }  // namespace reindexer
@@ -107,6 +107,13 @@ public:
 	/// @param nsName - Name of namespace
 	/// @param item - Item, obtained by call to NewItem of the same namespace
 	Error Delete(string_view nsName, Item &item);
+	/// Insert, update, upsert or delete several items of namespace by the single request
+	/// Can't be used with completion
+	/// @param nsName - Name of namespace
+	/// @param items - Items, obtained by call to NewItem of the same namespace. On success item.GetID() will return internal Item ID
+	/// @param modes - Modification mode of each item
+	/// @param statuses - Result of each item modification. Returned error is set only if whole request is failed
+	Error ModifyItems(string_view nsName, std::vector<Item> &items, const std::vector<ItemModifyMode> &modes, std::vector<Error> &statuses);
 	/// Delete all items froms namespace, which matches provided Query
 	/// @param query - Query with conditions
 	/// @param result - QueryResults with IDs of deleted items
@@ -151,6 +158,9 @@ public:
 	/// @param pos - position in sql query for suggestions.
 	/// @param suggestions - all the suggestions for 'pos' position in query.
 	Error GetSqlSuggestions(const string_view sqlQuery, int pos, vector<string> &suggestions);
+	/// Get version of reindexer server
+	/// @param version - version of server, e.g. "2.3.4"
+	Error GetServerVersion(string &version);
 
 	/// Add cancelable context
 	/// @param cancelCtx - context pointer
@@ -9,18 +9,21 @@ using std::chrono::seconds;
 
 struct ReindexerConfig {
 	ReindexerConfig(int _ConnPoolSize = 4, int _WorkerThreads = 1, int _FetchAmount = 10000, seconds _ConnectTimeout = seconds(0),
-					seconds _RequestTimeout = seconds(0))
+					seconds _RequestTimeout = seconds(0), bool _EnableCompression = false)
 		: ConnPoolSize(_ConnPoolSize),
 		  WorkerThreads(_WorkerThreads),
 		  FetchAmount(_FetchAmount),
 		  ConnectTimeout(_ConnectTimeout),
-		  RequestTimeout(_RequestTimeout) {}
+		  RequestTimeout(_RequestTimeout),
+		  EnableCompression(_EnableCompression) {}
 
 	int ConnPoolSize;
 	int WorkerThreads;
 	int FetchAmount;
 	seconds ConnectTimeout;
 	seconds RequestTimeout;
+	// Compress large requests and responses, if server supports it
+	bool EnableCompression;
 };
 
 }  // namespace client
@@ -70,7 +70,8 @@ void RPCClient::run(int thIdx) {
 	delayedUpdates_.clear();
 
 	for (int i = thIdx; i < config_.ConnPoolSize; i += config_.WorkerThreads) {
-		connections_[i].reset(new cproto::ClientConnection(workers_[thIdx].loop_, &uri_, config_.ConnectTimeout, config_.RequestTimeout));
+		connections_[i].reset(new cproto::ClientConnection(workers_[thIdx].loop_, &uri_, config_.ConnectTimeout, config_.RequestTimeout,
+														   config_.EnableCompression));
 	}
 
 	ev::periodic checker;
@@ -145,6 +146,76 @@ Error RPCClient::Delete(string_view nsName, Item& item, const InternalRdxContext
 	return modifyItem(nsName, item, ModeDelete, config_.RequestTimeout, ctx);
 }
 
+Error RPCClient::ModifyItems(string_view nsName, std::vector<Item>& items, const std::vector<ItemModifyMode>& modes,
+							 std::vector<Error>& statuses, const InternalRdxContext& ctx) {
+	if (ctx.cmpl()) return Error(errParams, "Bulk modify can't be used with completion");
+	if (modes.size() != items.size()) {
+		return Error(errParams, "Count of modes %d is not equal to count of items %d", modes.size(), items.size());
+	}
+	statuses.assign(items.size(), Error());
+	if (items.empty()) return errOK;
+
+	seconds netTimeout = config_.RequestTimeout;
+	bool withNetTimeout = (netTimeout.count() > 0);
+	for (int tryCount = 0;; tryCount++) {
+		WrSerializer ser;
+		ser.PutVarUint(items.size());
+		for (size_t i = 0; i < items.size(); ++i) {
+			ser.PutVarUint(modes[i]);
+			ser.PutVString(items[i].GetCJSON());
+		}
+
+		auto conn = getConn();
+		auto netDeadline = conn->Now() + netTimeout;
+		auto ret = conn->Call({cproto::kCmdModifyItems, netTimeout, ctx.execTimeout()}, nsName, int(FormatCJson), ser.Slice(),
+							  items[0].GetStateToken());
+		if (withNetTimeout) {
+			netTimeout = netDeadline - conn->Now();
+		}
+		if (!ret.Status().ok() && (ret.Status().code() != errStateInvalidated || tryCount > 2)) return ret.Status();
+
+		bool tmUpdated = false;
+		if (ret.Status().ok()) {
+			try {
+				auto args = ret.GetArgs(1);
+				const p_string statusesPack(args[0]);
+				Serializer rser(statusesPack);
+				tmUpdated = rser.GetVarUint();
+				const size_t count = rser.GetVarUint();
+				if (count != items.size()) return Error(errLogic, "Unexpected count of statuses %d, need %d", count, items.size());
+				for (size_t i = 0; i < count; ++i) {
+					const int code = rser.GetVarint();
+					statuses[i] = Error(code, rser.GetVString());
+					items[i].setID(rser.GetVarint());
+				}
+			} catch (const Error& err) {
+				return err;
+			}
+			if (!tmUpdated) return errOK;
+		}
+
+		// Tags of namespace were changed - make select to update state
+		QueryResults qr;
+		InternalRdxContext ctxCompl = ctx.WithCompletion(nullptr);
+		auto err = selectImpl(Query(string(nsName)).Limit(0), qr, nullptr, netTimeout, ctxCompl);
+		if (err.code() == errTimeout) {
+			return Error(errTimeout, "Request timeout");
+		}
+		if (withNetTimeout) {
+			netTimeout = netDeadline - conn->Now();
+		}
+		if (tmUpdated) return err;
+
+		for (auto& item : items) {
+			auto newItem = NewItem(nsName);
+			char* endp = nullptr;
+			err = newItem.FromJSON(item.impl_->GetJSON(), &endp);
+			if (!err.ok()) return err;
+			item = std::move(newItem);
+		}
+	}
+}
+
 Error RPCClient::modifyItem(string_view nsName, Item& item, int mode, seconds netTimeout, const InternalRdxContext& ctx) {
 	if (ctx.cmpl()) {
 		return modifyItemAsync(nsName, &item, mode, nullptr, netTimeout, ctx);
@@ -423,14 +494,14 @@ Error RPCClient::selectImpl(const Query& query, QueryResults& result, cproto::Cl
 		}
 	};
 
+	cproto::ClientConnection::CommandParams params{cproto::kCmdSelect, netTimeout, ctx.execTimeout(), ctx.getCancelCtx()};
+	params.pointSelect = cproto::IsPointSelect(query);
 	if (!ctx.cmpl()) {
-		auto ret = conn->Call({cproto::kCmdSelect, netTimeout, ctx.execTimeout(), ctx.getCancelCtx()}, qser.Slice(), flags,
-							  config_.FetchAmount, pser.Slice());
+		auto ret = conn->Call(params, qser.Slice(), flags, config_.FetchAmount, pser.Slice());
 		icompl(ret, conn);
 		return ret.Status();
 	} else {
-		conn->Call(icompl, {cproto::kCmdSelect, netTimeout, ctx.execTimeout(), ctx.getCancelCtx()}, qser.Slice(), flags,
-				   config_.FetchAmount, pser.Slice());
+		conn->Call(icompl, params, qser.Slice(), flags, config_.FetchAmount, pser.Slice());
 		return errOK;
 	}
 }
@@ -477,6 +548,14 @@ Error RPCClient::EnumNamespaces(vector<NamespaceDef>& defs, bool bEnumAll, const
 	}
 }
 
+Error RPCClient::GetServerVersion(string& version, const InternalRdxContext& ctx) {
+	auto conn = getConn();
+	// Connection logs in before the first request, so version of server is known after any request
+	auto ret = conn->Call({cproto::kCmdPing, config_.RequestTimeout, ctx.execTimeout()});
+	if (ret.Status().ok()) version = conn->ServerVersion();
+	return ret.Status();
+}
+
 Error RPCClient::EnumDatabases(vector<string>& dbList, const InternalRdxContext& ctx) {
 	try {
 		auto ret = getConn()->Call({cproto::kCmdEnumDatabases, config_.RequestTimeout, ctx.execTimeout()}, 0);
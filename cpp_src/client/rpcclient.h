@@ -55,6 +55,8 @@ public:
 	Error Update(string_view nsName, client::Item &item, const InternalRdxContext &ctx);
 	Error Upsert(string_view nsName, client::Item &item, const InternalRdxContext &ctx);
 	Error Delete(string_view nsName, client::Item &item, const InternalRdxContext &ctx);
+	Error ModifyItems(string_view nsName, std::vector<client::Item> &items, const std::vector<ItemModifyMode> &modes,
+					  std::vector<Error> &statuses, const InternalRdxContext &ctx);
 	Error Delete(const Query &query, QueryResults &result, const InternalRdxContext &ctx);
 	Error Update(const Query &query, QueryResults &result, const InternalRdxContext &ctx);
 	Error Select(string_view query, QueryResults &result, const InternalRdxContext &ctx, cproto::ClientConnection *conn = nullptr) {
@@ -70,6 +72,7 @@ public:
 	Error EnumMeta(string_view nsName, vector<string> &keys, const InternalRdxContext &ctx);
 	Error SubscribeUpdates(IUpdatesObserver *observer, bool subscribe);
 	Error GetSqlSuggestions(string_view query, int pos, std::vector<std::string> &suggests);
+	Error GetServerVersion(string &version, const InternalRdxContext &ctx);
 
 private:
 	Error selectImpl(string_view query, QueryResults &result, cproto::ClientConnection *, seconds netTimeout,
@@ -295,6 +295,34 @@ void Aggregator::Aggregate(const PayloadValue &data) {
 	}
 }
 
+void Aggregator::Merge(Aggregator &&other) {
+	assert(aggType_ == other.aggType_);
+	switch (aggType_) {
+		case AggSum:
+		case AggAvg:
+			result_ += other.result_;
+			hitCount_ += other.hitCount_;
+			break;
+		case AggMin:
+			result_ = std::min(other.result_, result_);
+			break;
+		case AggMax:
+			result_ = std::max(other.result_, result_);
+			break;
+		case AggFacet:
+			if (multifieldFacets_) {
+				assert(other.multifieldFacets_);
+				for (auto &facet : *other.multifieldFacets_) (*multifieldFacets_)[facet.first] += facet.second;
+			} else {
+				assert(singlefieldFacets_ && other.singlefieldFacets_);
+				for (auto &facet : *other.singlefieldFacets_) (*singlefieldFacets_)[facet.first] += facet.second;
+			}
+			break;
+		case AggUnknown:
+			break;
+	}
+}
+
 void Aggregator::aggregate(const Variant &v) {
 	switch (aggType_) {
 		case AggSum:
@@ -24,6 +24,8 @@ public:
 	~Aggregator();
 
 	void Aggregate(const PayloadValue &lhs);
+	// Merge partial results of other aggregator of the same type
+	void Merge(Aggregator &&other);
 	AggregationResult GetResult() const;
 
 	Aggregator(const Aggregator &) = delete;
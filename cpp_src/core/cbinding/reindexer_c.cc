@@ -208,6 +208,79 @@ reindexer_ret reindexer_modify_item_packed(uintptr_t rx, reindexer_buffer args,
 	return ret2c(err, out);
 }
 
+reindexer_ret reindexer_modify_items_packed(uintptr_t rx, reindexer_buffer args, reindexer_buffer data, reindexer_ctx_info ctx_info) {
+	Serializer ser(args.data, args.len);
+	string_view ns = ser.GetVString();
+	int format = ser.GetVarUint();
+	int state_token = ser.GetVarUint();
+
+	reindexer_resbuffer out = {0, 0, 0};
+	Error err = err_not_init;
+	if (rx) {
+		CGORdxCtxKeeper rdxKeeper(rx, ctx_info, ctx_pool);
+
+		Serializer dser(data.data, data.len);
+		const unsigned count = dser.GetVarUint();
+		vector<Error> statuses(count);
+		vector<Item> items;
+		vector<ItemModifyMode> modes;
+		vector<unsigned> positions;
+		items.reserve(count);
+		modes.reserve(count);
+		positions.reserve(count);
+		bool tmUpdated = false;
+		err = errOK;
+		for (unsigned i = 0; i < count && err.ok(); ++i) {
+			const auto mode = ItemModifyMode(dser.GetVarUint());
+			string_view itemData = dser.GetVString();
+			Item item = rdxKeeper.db().NewItem(ns);
+			reindexer_buffer itemBuf{const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(itemData.data())), int(itemData.size())};
+			Error itemErr;
+			procces_packed_item(item, mode, state_token, itemBuf, {}, format, itemErr);
+			if (itemErr.code() == errStateInvalidated || !item.Status().ok()) {
+				// Whole batch is failed
+				err = itemErr;
+			} else if (!itemErr.ok()) {
+				statuses[i] = itemErr;
+			} else {
+				tmUpdated = tmUpdated || item.IsTagsUpdated();
+				items.emplace_back(std::move(item));
+				modes.push_back(mode);
+				positions.push_back(i);
+			}
+		}
+
+		vector<Error> applied;
+		if (err.ok()) err = rdxKeeper.db().ModifyItems(ns, items, modes, applied);
+
+		if (err.ok()) {
+			QueryResultsWrapper* res = new_results();
+			if (!res) {
+				return ret2c(err_too_many_queries, out);
+			}
+			res->ser.PutVarUint(tmUpdated);
+			res->ser.PutVarUint(count);
+			size_t pos = 0;
+			for (unsigned i = 0; i < count; ++i) {
+				int id = -1;
+				if (pos < positions.size() && positions[pos] == i) {
+					statuses[i] = applied[pos];
+					id = items[pos].GetID();
+					++pos;
+				}
+				res->ser.PutVarint(statuses[i].code());
+				res->ser.PutVString(statuses[i].what());
+				res->ser.PutVarint(id);
+			}
+			out.len = res->ser.Len();
+			out.data = uintptr_t(res->ser.Buf());
+			out.results_ptr = uintptr_t(res);
+		}
+	}
+
+	return ret2c(err, out);
+}
+
 reindexer_tx_ret reindexer_start_transaction(uintptr_t rx, reindexer_string nsName) {
 	auto db = reinterpret_cast<Reindexer*>(rx);
 	reindexer_tx_ret ret{0, {nullptr, 0}};
@@ -434,6 +507,56 @@ reindexer_ret reindexer_select_query(uintptr_t rx, struct reindexer_buffer in, i
 	return ret2c(res, out);
 }
 
+reindexer_prepared_ret reindexer_prepare_sql(uintptr_t rx, reindexer_string query, reindexer_ctx_info ctx_info) {
+	reindexer_prepared_ret ret{0, {nullptr, 0}};
+	if (!rx) {
+		ret.err = error2c(err_not_init);
+		return ret;
+	}
+	CGORdxCtxKeeper rdxKeeper(rx, ctx_info, ctx_pool);
+	PreparedQuery::Ptr prepared;
+	Error err = rdxKeeper.db().Prepare(str2cv(query), prepared);
+	if (err.ok()) {
+		ret.prepared_id = reinterpret_cast<uintptr_t>(new PreparedQuery::Ptr(std::move(prepared)));
+	} else {
+		ret.err = error2c(err);
+	}
+	return ret;
+}
+
+reindexer_ret reindexer_select_prepared(uintptr_t rx, uintptr_t prepared, reindexer_buffer args, int as_json, int32_t* pt_versions,
+										int pt_versions_count, reindexer_ctx_info ctx_info) {
+	reindexer_resbuffer out = {0, 0, 0};
+	Error res = err_not_init;
+	if (rx) {
+		auto preparedPtr = reinterpret_cast<PreparedQuery::Ptr*>(prepared);
+		if (!preparedPtr) {
+			return ret2c(Error(errParams, "Invalid prepared query"), out);
+		}
+		Serializer ser(args.data, args.len);
+		VariantArray values;
+		for (int cnt = ser.GetVarUint(); cnt > 0; cnt--) values.push_back(ser.GetVariant().EnsureHold());
+
+		CGORdxCtxKeeper rdxKeeper(rx, ctx_info, ctx_pool);
+		QueryResultsWrapper* result = new_results();
+		if (!result) {
+			return ret2c(err_too_many_queries, out);
+		}
+		res = rdxKeeper.db().Select(**preparedPtr, values, *result);
+		if (res.ok()) {
+			results2c(result, &out, as_json, pt_versions, pt_versions_count);
+		} else {
+			put_results_to_pool(result);
+		}
+	}
+	return ret2c(res, out);
+}
+
+reindexer_error reindexer_free_prepared(uintptr_t prepared) {
+	delete reinterpret_cast<PreparedQuery::Ptr*>(prepared);
+	return error2c(errOK);
+}
+
 reindexer_ret reindexer_delete_query(uintptr_t rx, reindexer_buffer in, reindexer_ctx_info ctx_info) {
 	reindexer_resbuffer out{0, 0, 0};
 	Error res = err_not_init;
@@ -562,6 +685,15 @@ reindexer_error reindexer_commit(uintptr_t rx, reindexer_string nsName) {
 	return error2c(!db ? err_not_init : db->Commit(str2cv(nsName)));
 }
 
+reindexer_error reindexer_wait_durable(uintptr_t rx, reindexer_string nsName, int64_t lsn, reindexer_ctx_info ctx_info) {
+	Error res = err_not_init;
+	if (rx) {
+		CGORdxCtxKeeper rdxKeeper(rx, ctx_info, ctx_pool);
+		res = rdxKeeper.db().WaitDurable(str2cv(nsName), lsn);
+	}
+	return error2c(res);
+}
+
 void reindexer_enable_logger(void (*logWriter)(int, char*)) { logInstallWriter(logWriter); }
 
 void reindexer_disable_logger() { logInstallWriter(nullptr); }
@@ -35,11 +35,17 @@ reindexer_ret reindexer_commit_transaction(uintptr_t rx, uintptr_t tr, reindexer
 reindexer_error reindexer_rollback_transaction(uintptr_t rx, uintptr_t tr);
 
 reindexer_ret reindexer_modify_item_packed(uintptr_t rx, reindexer_buffer args, reindexer_buffer data, reindexer_ctx_info ctx_info);
+reindexer_ret reindexer_modify_items_packed(uintptr_t rx, reindexer_buffer args, reindexer_buffer data, reindexer_ctx_info ctx_info);
 reindexer_ret reindexer_select(uintptr_t rx, reindexer_string query, int as_json, int32_t *pt_versions, int pt_versions_count,
 							   reindexer_ctx_info ctx_info);
 
 reindexer_ret reindexer_select_query(uintptr_t rx, reindexer_buffer in, int as_json, int32_t *pt_versions, int pt_versions_count,
 									 reindexer_ctx_info ctx_info);
+reindexer_prepared_ret reindexer_prepare_sql(uintptr_t rx, reindexer_string query, reindexer_ctx_info ctx_info);
+reindexer_ret reindexer_select_prepared(uintptr_t rx, uintptr_t prepared, reindexer_buffer args, int as_json, int32_t *pt_versions,
+										int pt_versions_count, reindexer_ctx_info ctx_info);
+reindexer_error reindexer_free_prepared(uintptr_t prepared);
+
 reindexer_ret reindexer_delete_query(uintptr_t rx, reindexer_buffer in, reindexer_ctx_info ctx_info);
 reindexer_ret reindexer_update_query(uintptr_t rx, reindexer_buffer in, reindexer_ctx_info ctx_info);
 
@@ -47,6 +53,7 @@ reindexer_error reindexer_free_buffer(reindexer_resbuffer in);
 reindexer_error reindexer_free_buffers(reindexer_resbuffer *in, int count);
 
 reindexer_error reindexer_commit(uintptr_t rx, reindexer_string nsName);
+reindexer_error reindexer_wait_durable(uintptr_t rx, reindexer_string nsName, int64_t lsn, reindexer_ctx_info ctx_info);
 
 reindexer_error reindexer_put_meta(uintptr_t rx, reindexer_string ns, reindexer_string key, reindexer_string data,
 								   reindexer_ctx_info ctx_info);
@@ -39,6 +39,11 @@ typedef struct reindexer_tx_ret {
 	reindexer_error err;
 } reindexer_tx_ret;
 
+typedef struct reindexer_prepared_ret {
+	uintptr_t prepared_id;
+	reindexer_error err;
+} reindexer_prepared_ret;
+
 typedef struct reindexer_ctx_info {
 	uint64_t ctx_id;  // 3 most significant bits will be used as flags and discarded
 	int64_t exec_timeout;
@@ -0,0 +1,328 @@
+#include "core/columnscan.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define REINDEX_COLUMN_SCAN_X86 1
+#include <immintrin.h>
+#define REINDEX_TARGET_AVX2 __attribute__((target("avx2")))
+#define REINDEX_TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+
+namespace reindexer {
+
+// Rows are checked by blocks of 64, match result of block is 64-bit mask
+constexpr size_t kColumnScanBlockSize = 64;
+
+template <typename T>
+using BlockKernel = uint64_t (*)(const T *block, const ColumnFilter<T> &filter);
+
+template <typename T>
+static uint64_t matchRange(const T *block, size_t count, const ColumnFilter<T> &filter) {
+	uint64_t mask = 0;
+	for (size_t i = 0; i < count; ++i) mask |= uint64_t(block[i] >= filter.min && block[i] <= filter.max) << i;
+	return mask;
+}
+
+template <typename T>
+static uint64_t matchSet(const T *block, size_t count, const ColumnFilter<T> &filter) {
+	uint64_t mask = 0;
+	for (size_t i = 0; i < count; ++i) {
+		bool match = false;
+		for (const T &v : filter.values) match |= (block[i] == v);
+		mask |= uint64_t(match) << i;
+	}
+	return mask;
+}
+
+template <typename T>
+static uint64_t matchRangeBlock(const T *block, const ColumnFilter<T> &filter) {
+	return matchRange(block, kColumnScanBlockSize, filter);
+}
+
+template <typename T>
+static uint64_t matchSetBlock(const T *block, const ColumnFilter<T> &filter) {
+	return matchSet(block, kColumnScanBlockSize, filter);
+}
+
+#ifdef REINDEX_COLUMN_SCAN_X86
+
+// Vector operations for each column type. Each operation returns bit mask with one bit per lane
+template <typename T>
+struct Avx2Ops;
+
+template <>
+struct Avx2Ops<int> {
+	using V = __m256i;
+	static constexpr size_t kLanes = 8;
+	REINDEX_TARGET_AVX2 static V load(const int *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+	REINDEX_TARGET_AVX2 static V set1(int v) { return _mm256_set1_epi32(v); }
+	REINDEX_TARGET_AVX2 static unsigned inRange(V v, V min, V max) {
+		const V out = _mm256_or_si256(_mm256_cmpgt_epi32(min, v), _mm256_cmpgt_epi32(v, max));
+		return ~unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(out))) & 0xFF;
+	}
+	REINDEX_TARGET_AVX2 static V eq(V v, V x) { return _mm256_cmpeq_epi32(v, x); }
+	REINDEX_TARGET_AVX2 static V or_(V a, V b) { return _mm256_or_si256(a, b); }
+	REINDEX_TARGET_AVX2 static V zero() { return _mm256_setzero_si256(); }
+	REINDEX_TARGET_AVX2 static unsigned mask(V v) { return unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(v))); }
+};
+
+template <>
+struct Avx2Ops<int64_t> {
+	using V = __m256i;
+	static constexpr size_t kLanes = 4;
+	REINDEX_TARGET_AVX2 static V load(const int64_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+	REINDEX_TARGET_AVX2 static V set1(int64_t v) { return _mm256_set1_epi64x(v); }
+	REINDEX_TARGET_AVX2 static unsigned inRange(V v, V min, V max) {
+		const V out = _mm256_or_si256(_mm256_cmpgt_epi64(min, v), _mm256_cmpgt_epi64(v, max));
+		return ~unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(out))) & 0xF;
+	}
+	REINDEX_TARGET_AVX2 static V eq(V v, V x) { return _mm256_cmpeq_epi64(v, x); }
+	REINDEX_TARGET_AVX2 static V or_(V a, V b) { return _mm256_or_si256(a, b); }
+	REINDEX_TARGET_AVX2 static V zero() { return _mm256_setzero_si256(); }
+	REINDEX_TARGET_AVX2 static unsigned mask(V v) { return unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(v))); }
+};
+
+template <>
+struct Avx2Ops<double> {
+	using V = __m256d;
+	static constexpr size_t kLanes = 4;
+	REINDEX_TARGET_AVX2 static V load(const double *p) { return _mm256_loadu_pd(p); }
+	REINDEX_TARGET_AVX2 static V set1(double v) { return _mm256_set1_pd(v); }
+	REINDEX_TARGET_AVX2 static unsigned inRange(V v, V min, V max) {
+		return unsigned(_mm256_movemask_pd(_mm256_and_pd(_mm256_cmp_pd(v, min, _CMP_GE_OQ), _mm256_cmp_pd(v, max, _CMP_LE_OQ))));
+	}
+	REINDEX_TARGET_AVX2 static V eq(V v, V x) { return _mm256_cmp_pd(v, x, _CMP_EQ_OQ); }
+	REINDEX_TARGET_AVX2 static V or_(V a, V b) { return _mm256_or_pd(a, b); }
+	REINDEX_TARGET_AVX2 static V zero() { return _mm256_setzero_pd(); }
+	REINDEX_TARGET_AVX2 static unsigned mask(V v) { return unsigned(_mm256_movemask_pd(v)); }
+};
+
+template <>
+struct Avx2Ops<uint8_t> {
+	using V = __m256i;
+	static constexpr size_t kLanes = 32;
+	REINDEX_TARGET_AVX2 static V load(const uint8_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+	REINDEX_TARGET_AVX2 static V set1(uint8_t v) { return _mm256_set1_epi8(char(v)); }
+	REINDEX_TARGET_AVX2 static unsigned inRange(V v, V min, V max) {
+		const V in = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(v, min), v), _mm256_cmpeq_epi8(_mm256_min_epu8(v, max), v));
+		return unsigned(_mm256_movemask_epi8(in));
+	}
+	REINDEX_TARGET_AVX2 static V eq(V v, V x) { return _mm256_cmpeq_epi8(v, x); }
+	REINDEX_TARGET_AVX2 static V or_(V a, V b) { return _mm256_or_si256(a, b); }
+	REINDEX_TARGET_AVX2 static V zero() { return _mm256_setzero_si256(); }
+	REINDEX_TARGET_AVX2 static unsigned mask(V v) { return unsigned(_mm256_movemask_epi8(v)); }
+};
+
+template <typename T>
+struct Sse42Ops;
+
+template <>
+struct Sse42Ops<int> {
+	using V = __m128i;
+	static constexpr size_t kLanes = 4;
+	REINDEX_TARGET_SSE42 static V load(const int *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+	REINDEX_TARGET_SSE42 static V set1(int v) { return _mm_set1_epi32(v); }
+	REINDEX_TARGET_SSE42 static unsigned inRange(V v, V min, V max) {
+		const V out = _mm_or_si128(_mm_cmpgt_epi32(min, v), _mm_cmpgt_epi32(v, max));
+		return ~unsigned(_mm_movemask_ps(_mm_castsi128_ps(out))) & 0xF;
+	}
+	REINDEX_TARGET_SSE42 static V eq(V v, V x) { return _mm_cmpeq_epi32(v, x); }
+	REINDEX_TARGET_SSE42 static V or_(V a, V b) { return _mm_or_si128(a, b); }
+	REINDEX_TARGET_SSE42 static V zero() { return _mm_setzero_si128(); }
+	REINDEX_TARGET_SSE42 static unsigned mask(V v) { return unsigned(_mm_movemask_ps(_mm_castsi128_ps(v))); }
+};
+
+template <>
+struct Sse42Ops<int64_t> {
+	using V = __m128i;
+	static constexpr size_t kLanes = 2;
+	REINDEX_TARGET_SSE42 static V load(const int64_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+	REINDEX_TARGET_SSE42 static V set1(int64_t v) { return _mm_set1_epi64x(v); }
+	REINDEX_TARGET_SSE42 static unsigned inRange(V v, V min, V max) {
+		const V out = _mm_or_si128(_mm_cmpgt_epi64(min, v), _mm_cmpgt_epi64(v, max));
+		return ~unsigned(_mm_movemask_pd(_mm_castsi128_pd(out))) & 0x3;
+	}
+	REINDEX_TARGET_SSE42 static V eq(V v, V x) { return _mm_cmpeq_epi64(v, x); }
+	REINDEX_TARGET_SSE42 static V or_(V a, V b) { return _mm_or_si128(a, b); }
+	REINDEX_TARGET_SSE42 static V zero() { return _mm_setzero_si128(); }
+	REINDEX_TARGET_SSE42 static unsigned mask(V v) { return unsigned(_mm_movemask_pd(_mm_castsi128_pd(v))); }
+};
+
+template <>
+struct Sse42Ops<double> {
+	using V = __m128d;
+	static constexpr size_t kLanes = 2;
+	REINDEX_TARGET_SSE42 static V load(const double *p) { return _mm_loadu_pd(p); }
+	REINDEX_TARGET_SSE42 static V set1(double v) { return _mm_set1_pd(v); }
+	REINDEX_TARGET_SSE42 static unsigned inRange(V v, V min, V max) {
+		return unsigned(_mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(v, min), _mm_cmple_pd(v, max))));
+	}
+	REINDEX_TARGET_SSE42 static V eq(V v, V x) { return _mm_cmpeq_pd(v, x); }
+	REINDEX_TARGET_SSE42 static V or_(V a, V b) { return _mm_or_pd(a, b); }
+	REINDEX_TARGET_SSE42 static V zero() { return _mm_setzero_pd(); }
+	REINDEX_TARGET_SSE42 static unsigned mask(V v) { return unsigned(_mm_movemask_pd(v)); }
+};
+
+template <>
+struct Sse42Ops<uint8_t> {
+	using V = __m128i;
+	static constexpr size_t kLanes = 16;
+	REINDEX_TARGET_SSE42 static V load(const uint8_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+	REINDEX_TARGET_SSE42 static V set1(uint8_t v) { return _mm_set1_epi8(char(v)); }
+	REINDEX_TARGET_SSE42 static unsigned inRange(V v, V min, V max) {
+		const V in = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, min), v), _mm_cmpeq_epi8(_mm_min_epu8(v, max), v));
+		return unsigned(_mm_movemask_epi8(in));
+	}
+	REINDEX_TARGET_SSE42 static V eq(V v, V x) { return _mm_cmpeq_epi8(v, x); }
+	REINDEX_TARGET_SSE42 static V or_(V a, V b) { return _mm_or_si128(a, b); }
+	REINDEX_TARGET_SSE42 static V zero() { return _mm_setzero_si128(); }
+	REINDEX_TARGET_SSE42 static unsigned mask(V v) { return unsigned(_mm_movemask_epi8(v)); }
+};
+
+// Block kernels have to be compiled separately for each instructions set, so they are duplicated for AVX2 and SSE4.2
+template <typename T>
+REINDEX_TARGET_AVX2 static uint64_t matchRangeBlockAvx2(const T *block, const ColumnFilter<T> &filter) {
+	using Ops = Avx2Ops<T>;
+	const auto min = Ops::set1(filter.min), max = Ops::set1(filter.max);
+	uint64_t mask = 0;
+	for (size_t i = 0; i < kColumnScanBlockSize; i += Ops::kLanes) mask |= uint64_t(Ops::inRange(Ops::load(block + i), min, max)) << i;
+	return mask;
+}
+
+template <typename T>
+REINDEX_TARGET_AVX2 static uint64_t matchSetBlockAvx2(const T *block, const ColumnFilter<T> &filter) {
+	using Ops = Avx2Ops<T>;
+	typename Ops::V values[kMaxColumnScanSetSize];
+	const size_t valuesCount = filter.values.size();
+	for (size_t j = 0; j < valuesCount; ++j) values[j] = Ops::set1(filter.values[j]);
+	uint64_t mask = 0;
+	for (size_t i = 0; i < kColumnScanBlockSize; i += Ops::kLanes) {
+		const auto v = Ops::load(block + i);
+		auto match = Ops::zero();
+		for (size_t j = 0; j < valuesCount; ++j) match = Ops::or_(match, Ops::eq(v, values[j]));
+		mask |= uint64_t(Ops::mask(match)) << i;
+	}
+	return mask;
+}
+
+template <typename T>
+REINDEX_TARGET_SSE42 static uint64_t matchRangeBlockSse42(const T *block, const ColumnFilter<T> &filter) {
+	using Ops = Sse42Ops<T>;
+	const auto min = Ops::set1(filter.min), max = Ops::set1(filter.max);
+	uint64_t mask = 0;
+	for (size_t i = 0; i < kColumnScanBlockSize; i += Ops::kLanes) mask |= uint64_t(Ops::inRange(Ops::load(block + i), min, max)) << i;
+	return mask;
+}
+
+template <typename T>
+REINDEX_TARGET_SSE42 static uint64_t matchSetBlockSse42(const T *block, const ColumnFilter<T> &filter) {
+	using Ops = Sse42Ops<T>;
+	typename Ops::V values[kMaxColumnScanSetSize];
+	const size_t valuesCount = filter.values.size();
+	for (size_t j = 0; j < valuesCount; ++j) values[j] = Ops::set1(filter.values[j]);
+	uint64_t mask = 0;
+	for (size_t i = 0; i < kColumnScanBlockSize; i += Ops::kLanes) {
+		const auto v = Ops::load(block + i);
+		auto match = Ops::zero();
+		for (size_t j = 0; j < valuesCount; ++j) match = Ops::or_(match, Ops::eq(v, values[j]));
+		mask |= uint64_t(Ops::mask(match)) << i;
+	}
+	return mask;
+}
+
+enum class ColumnScanISA { Plain, SSE42, AVX2 };
+
+static ColumnScanISA detectISA() {
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return ColumnScanISA::AVX2;
+	if (__builtin_cpu_supports("sse4.2")) return ColumnScanISA::SSE42;
+	return ColumnScanISA::Plain;
+}
+
+static ColumnScanISA columnScanISA() {
+	static const ColumnScanISA isa = detectISA();
+	return isa;
+}
+
+template <typename T>
+static BlockKernel<T> selectKernel(bool isSet) {
+	switch (columnScanISA()) {
+		case ColumnScanISA::AVX2:
+			return isSet ? matchSetBlockAvx2<T> : matchRangeBlockAvx2<T>;
+		case ColumnScanISA::SSE42:
+			return isSet ? matchSetBlockSse42<T> : matchRangeBlockSse42<T>;
+		case ColumnScanISA::Plain:
+			break;
+	}
+	return isSet ? matchSetBlock<T> : matchRangeBlock<T>;
+}
+
+const char *ColumnScanInstructionsSet() {
+	switch (columnScanISA()) {
+		case ColumnScanISA::AVX2:
+			return "avx2";
+		case ColumnScanISA::SSE42:
+			return "sse4.2";
+		case ColumnScanISA::Plain:
+			break;
+	}
+	return "plain";
+}
+
+#else  // REINDEX_COLUMN_SCAN_X86
+
+template <typename T>
+static BlockKernel<T> selectKernel(bool isSet) {
+	return isSet ? matchSetBlock<T> : matchRangeBlock<T>;
+}
+
+const char *ColumnScanInstructionsSet() { return "plain"; }
+
+#endif  // REINDEX_COLUMN_SCAN_X86
+
+static inline void appendMatched(uint64_t mask, size_t base, IdSet &ids) {
+	while (mask) {
+#if defined(__GNUC__) || defined(__clang__)
+		const int bit = __builtin_ctzll(mask);
+#else
+		int bit = 0;
+		while (!(mask & (uint64_t(1) << bit))) ++bit;
+#endif
+		ids.Add(IdType(base + bit), IdSet::Unordered, 0);
+		mask &= mask - 1;
+	}
+}
+
+template <typename T>
+static void scanColumn(const T *column, size_t rowsCount, const ColumnFilter<T> &filter, IdSet &ids) {
+	if (filter.empty || !rowsCount) return;
+	const BlockKernel<T> kernel = selectKernel<T>(filter.IsSet());
+	size_t i = 0;
+	for (; i + kColumnScanBlockSize <= rowsCount; i += kColumnScanBlockSize) appendMatched(kernel(column + i, filter), i, ids);
+	if (i < rowsCount) {
+		const size_t tail = rowsCount - i;
+		appendMatched(filter.IsSet() ? matchSet(column + i, tail, filter) : matchRange(column + i, tail, filter), i, ids);
+	}
+}
+
+template <typename T>
+void ScanColumn(const T *column, size_t rowsCount, const ColumnFilter<T> &filter, IdSet &ids) {
+	scanColumn(column, rowsCount, filter, ids);
+}
+
+// Bool column is scanned as column of bytes
+template <>
+void ScanColumn(const bool *column, size_t rowsCount, const ColumnFilter<bool> &filter, IdSet &ids) {
+	static_assert(sizeof(bool) == sizeof(uint8_t), "Unexpected size of bool");
+	ColumnFilter<uint8_t> bytesFilter;
+	bytesFilter.min = filter.min;
+	bytesFilter.max = filter.max;
+	bytesFilter.empty = filter.empty;
+	for (bool v : filter.values) bytesFilter.values.push_back(v);
+	scanColumn(reinterpret_cast<const uint8_t *>(column), rowsCount, bytesFilter, ids);
+}
+
+template void ScanColumn<int>(const int *, size_t, const ColumnFilter<int> &, IdSet &);
+template void ScanColumn<int64_t>(const int64_t *, size_t, const ColumnFilter<int64_t> &, IdSet &);
+template void ScanColumn<double>(const double *, size_t, const ColumnFilter<double> &, IdSet &);
+
+}  // namespace reindexer
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <limits>
+#include "core/idset.h"
+#include "estl/h_vector.h"
+
+namespace reindexer {
+
+// Max count of values in condition SET, which can be checked by column scan
+const size_t kMaxColumnScanSetSize = 8;
+
+/// Predicate over dense column of scalar values.
+/// Value matches if it is in range [min, max], or, for set filter, if it is equal to one of values
+template <typename T>
+struct ColumnFilter {
+	bool IsSet() const { return !values.empty(); }
+
+	T min = std::numeric_limits<T>::lowest();
+	T max = std::numeric_limits<T>::max();
+	h_vector<T, kMaxColumnScanSetSize> values;
+	// Filter can't match any value
+	bool empty = false;
+};
+
+/// Batched scan of dense column of index store.
+/// Predicate is checked over blocks of rows with SIMD instructions, which are selected in runtime (AVX2, SSE4.2 or plain C++)
+/// @param column - pointer to column data
+/// @param rowsCount - count of rows in column
+/// @param filter - predicate to check
+/// @param ids - matched rowIds are appended to idset in ascending order
+template <typename T>
+void ScanColumn(const T *column, size_t rowsCount, const ColumnFilter<T> &filter, IdSet &ids);
+
+/// Name of instructions set, which is used by ScanColumn
+const char *ColumnScanInstructionsSet();
+
+}  // namespace reindexer
@@ -1,4 +1,6 @@
 #include "core/comparator.h"
+#include <cmath>
+#include "core/columnscan.h"
 #include "core/payload/payloadiface.h"
 
 namespace reindexer {
@@ -7,8 +9,8 @@ Comparator::Comparator() {}
 Comparator::~Comparator() {}
 
 Comparator::Comparator(CondType cond, KeyValueType type, const VariantArray &values, bool isArray, bool distinct, PayloadType payloadType,
-					   const FieldsSet &fields, void *rawData, const CollateOpts &collateOpts)
-	: ComparatorVars(cond, type, isArray, payloadType, fields, rawData, collateOpts),
+					   const FieldsSet &fields, void *rawData, size_t rawDataSize, const CollateOpts &collateOpts)
+	: ComparatorVars(cond, type, isArray, payloadType, fields, rawData, rawDataSize, collateOpts),
 	  cmpBool(distinct),
 	  cmpInt(distinct),
 	  cmpInt64(distinct),
@@ -112,4 +114,81 @@ bool Comparator::Compare(const PayloadValue &data, int rowId) {
 	return false;
 }
 
+// Column filter checks only non-strict range bounds, so strict bounds are converted to the nearest value of type.
+// Strict condition with bound at the edge of type can't match anything
+template <typename T>
+static bool isEdgeValue(T v, bool lower) {
+	return v == (lower ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max());
+}
+static bool isEdgeValue(double v, bool lower) { return std::isinf(v) && (lower ? v < 0 : v > 0); }
+
+template <typename T>
+static T nextValue(T v, bool up) {
+	return up ? T(v + 1) : T(v - 1);
+}
+static double nextValue(double v, bool up) {
+	return std::nextafter(v, up ? std::numeric_limits<double>::infinity() : -std::numeric_limits<double>::infinity());
+}
+
+template <typename T>
+static bool makeColumnFilter(CondType cond, const ComparatorImpl<T> &cmp, ColumnFilter<T> &filter) {
+	if (cmp.distS_) return false;
+	switch (cond) {
+		case CondEq:
+			filter.min = filter.max = cmp.values_[0];
+			break;
+		case CondLt:
+			if (isEdgeValue(cmp.values_[0], true)) filter.empty = true;
+			filter.max = nextValue(cmp.values_[0], false);
+			break;
+		case CondLe:
+			filter.max = cmp.values_[0];
+			break;
+		case CondGt:
+			if (isEdgeValue(cmp.values_[0], false)) filter.empty = true;
+			filter.min = nextValue(cmp.values_[0], true);
+			break;
+		case CondGe:
+			filter.min = cmp.values_[0];
+			break;
+		case CondRange:
+			filter.min = cmp.values_[0];
+			filter.max = cmp.values_[1];
+			break;
+		case CondSet:
+			if (cmp.valuesS_->size() > kMaxColumnScanSetSize) return false;
+			for (const T &v : *cmp.valuesS_) filter.values.push_back(v);
+			if (filter.values.empty()) filter.empty = true;
+			break;
+		default:
+			return false;
+	}
+	return true;
+}
+
+template <typename T>
+static bool scanColumn(CondType cond, const ComparatorImpl<T> &cmp, const uint8_t *rawData, size_t rowsCount, IdSet &ids) {
+	ColumnFilter<T> filter;
+	if (!makeColumnFilter(cond, cmp, filter)) return false;
+	ScanColumn(reinterpret_cast<const T *>(rawData), rowsCount, filter, ids);
+	return true;
+}
+
+bool Comparator::ScanColumn(size_t rowsCount, IdSet &ids) const {
+	if (!rawData_ || isArray_ || cmpEqualPosition.IsBinded() || fields_.getTagsPathsLength() > 0) return false;
+	rowsCount = std::min(rowsCount, rawDataSize_);
+	switch (type_) {
+		case KeyValueBool:
+			return scanColumn(cond_, cmpBool, rawData_, rowsCount, ids);
+		case KeyValueInt:
+			return scanColumn(cond_, cmpInt, rawData_, rowsCount, ids);
+		case KeyValueInt64:
+			return scanColumn(cond_, cmpInt64, rawData_, rowsCount, ids);
+		case KeyValueDouble:
+			return scanColumn(cond_, cmpDouble, rawData_, rowsCount, ids);
+		default:
+			return false;
+	}
+}
+
 }  // namespace reindexer
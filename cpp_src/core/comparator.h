@@ -5,14 +5,19 @@
 
 namespace reindexer {
 
+class IdSet;
+
 class Comparator : public ComparatorVars {
 public:
 	Comparator();
 	Comparator(CondType cond, KeyValueType type, const VariantArray &values, bool isArray, bool distinct, PayloadType payloadType,
-			   const FieldsSet &fields, void *rawData = nullptr, const CollateOpts &collateOpts = CollateOpts());
+			   const FieldsSet &fields, void *rawData = nullptr, size_t rawDataSize = 0, const CollateOpts &collateOpts = CollateOpts());
 	~Comparator();
 
 	bool Compare(const PayloadValue &lhs, int rowId);
+	// Check condition over first rowsCount rows of column with batched scan. Matched rowIds are appended to ids
+	// @return false, if condition can't be checked by column scan
+	bool ScanColumn(size_t rowsCount, IdSet &ids) const;
 	void Bind(PayloadType type, int field);
 	void BindEqualPosition(int field, const VariantArray &val, CondType cond);
 	void BindEqualPosition(const TagsPath &tagsPath, const VariantArray &val, CondType cond);
@@ -12,11 +12,12 @@ namespace reindexer {
 
 struct ComparatorVars {
 	ComparatorVars(CondType cond, KeyValueType type, bool isArray, PayloadType payloadType, const FieldsSet &fields, void *rawData,
-				   const CollateOpts &collateOpts)
+				   size_t rawDataSize, const CollateOpts &collateOpts)
 		: cond_(cond),
 		  type_(type),
 		  isArray_(isArray),
 		  rawData_(reinterpret_cast<uint8_t *>(rawData)),
+		  rawDataSize_(rawDataSize),
 		  collateOpts_(collateOpts),
 		  payloadType_(payloadType),
 		  fields_(fields) {}
@@ -28,6 +29,8 @@ struct ComparatorVars {
 	unsigned offset_ = 0;
 	unsigned sizeof_ = 0;
 	uint8_t *rawData_ = nullptr;
+	// Count of rows in column (rawData_)
+	size_t rawDataSize_ = 0;
 	CollateOpts collateOpts_;
 	PayloadType payloadType_;
 	FieldsSet fields_;
@@ -48,6 +48,9 @@ Error DBConfigProvider::FromJSON(const gason::JsonNode &root) {
 				data.mergeLimitCount = nsNode["merge_limit_count"].As<int>(data.mergeLimitCount);
 				data.optimizationTimeout = nsNode["optimization_timeout_ms"].As<int>(data.optimizationTimeout);
 				data.optimizationSortWorkers = nsNode["optimization_sort_workers"].As<int>(data.optimizationSortWorkers);
+				data.walSize = nsNode["wal_size"].As<int64_t>(data.walSize);
+				data.walMaxBytes = nsNode["wal_max_bytes"].As<int64_t>(data.walMaxBytes);
+				data.resultsCacheSize = nsNode["results_cache_size"].As<int64_t>(data.resultsCacheSize);
 				namespacesData_.emplace(nsNode["namespace"].As<string>(), std::move(data));
 			}
 			auto it = handlers_.find(NamespaceDataConf);
@@ -111,6 +114,7 @@ Error ReplicationConfigData::FromYML(const string &yaml) {
 		role = str2role(root["role"].As<std::string>(role2str(role)));
 		forceSyncOnLogicError = root["force_sync_on_logic_error"].As<bool>(forceSyncOnLogicError);
 		forceSyncOnWrongDataHash = root["force_sync_on_wrong_data_hash"].As<bool>(forceSyncOnWrongDataHash);
+		snapshotChunkSize = root["snapshot_chunk_size"].As<int>(snapshotChunkSize);
 
 		auto &node = root["namespaces"];
 		namespaces.clear();
@@ -135,6 +139,7 @@ Error ReplicationConfigData::FromJSON(const gason::JsonNode &root) {
 		role = str2role(root["role"].As<string>("none"));
 		forceSyncOnLogicError = root["force_sync_on_logic_error"].As<bool>();
 		forceSyncOnWrongDataHash = root["force_sync_on_wrong_data_hash"].As<bool>();
+		snapshotChunkSize = root["snapshot_chunk_size"].As<int>(0);
 
 		namespaces.clear();
 		for (auto &objNode : root["namespaces"]) {
@@ -176,6 +181,7 @@ void ReplicationConfigData::GetJSON(JsonBuilder &jb) const {
 	jb.Put("timeout_sec", timeoutSec);
 	jb.Put("force_sync_on_logic_error", forceSyncOnLogicError);
 	jb.Put("force_sync_on_wrong_data_hash", forceSyncOnWrongDataHash);
+	jb.Put("snapshot_chunk_size", snapshotChunkSize);
 	{
 		auto arrNode = jb.Array("namespaces");
 		for (const auto &ns : namespaces) arrNode.Put(nullptr, ns);
@@ -217,6 +223,10 @@ void ReplicationConfigData::GetYAML(WrSerializer &ser) const {
 			"# force resync on wrong data hash conditions\n"
 			"force_sync_on_wrong_data_hash: " + (forceSyncOnWrongDataHash ? "true" : "false") + "\n"
 			"\n"
+			"# Count of items in chunk of bulk snapshot of namespace on forced sync. Chunks are fetched in parallel by conn_pool_size connections\n"
+			"# 0 means, that namespace is fetched by single query\n"
+			"snapshot_chunk_size: " + std::to_string(snapshotChunkSize) + "\n"
+			"\n"
 			"# List of namespaces for replication. If emply, all namespaces\n"
 			"# All replicated namespaces will become read only for slave\n"
 			"# It should be written as YAML sequence, JSON-style arrays are not supported\n"
@@ -7,6 +7,7 @@
 #include "estl/fast_hash_set.h"
 #include "estl/mutex.h"
 #include "estl/shared_mutex.h"
+#include "replicator/walrecord.h"
 #include "tools/errors.h"
 #include "tools/stringstools.h"
 
@@ -38,6 +39,9 @@ struct NamespaceConfigData {
 	int mergeLimitCount = 30000;
 	int optimizationTimeout = 800;
 	int optimizationSortWorkers = 4;
+	int64_t walSize = kDefaultWALSize;
+	int64_t walMaxBytes = kDefaultWALBytes;
+	int64_t resultsCacheSize = 0;
 };
 
 enum ReplicationRole { ReplicationNone, ReplicationMaster, ReplicationSlave };
@@ -56,13 +60,16 @@ struct ReplicationConfigData {
 	int timeoutSec = 30;
 	bool forceSyncOnLogicError = false;
 	bool forceSyncOnWrongDataHash = false;
+	// Count of items in chunk of bulk snapshot of namespace on forced sync. Chunks are fetched by connPoolSize connections in parallel.
+	// 0 means, that namespace is fetched by single query
+	int snapshotChunkSize = 0;
 	fast_hash_set<string, nocase_hash_str, nocase_equal_str> namespaces;
 
 	bool operator==(const ReplicationConfigData &rdata) const noexcept {
 		return (role == rdata.role) && (connPoolSize == rdata.connPoolSize) && (workerThreads == rdata.workerThreads) &&
 			   (clusterID == rdata.clusterID) && (forceSyncOnLogicError == rdata.forceSyncOnLogicError) &&
 			   (forceSyncOnWrongDataHash == rdata.forceSyncOnWrongDataHash) && (masterDSN == rdata.masterDSN) &&
-			   (timeoutSec == rdata.timeoutSec) && (namespaces == rdata.namespaces);
+			   (timeoutSec == rdata.timeoutSec) && (snapshotChunkSize == rdata.snapshotChunkSize) && (namespaces == rdata.namespaces);
 	}
 	bool operator!=(const ReplicationConfigData &rdata) const noexcept { return !operator==(rdata); }
 
@@ -25,6 +25,7 @@ void FtFastConfig::parse(string_view json) {
 		maxTypoLen = root["max_typo_len"].As<>(maxTypoLen, 0, 100);
 		maxRebuildSteps = root["max_rebuild_steps"].As<>(maxRebuildSteps, 1, 500);
 		maxStepSize = root["max_step_size"].As<>(maxStepSize, 5);
+		maxRebuildStalenessMs = root["max_rebuild_staleness_ms"].As<>(maxRebuildStalenessMs, 0);
 		parseBase(root);
 	} catch (const gason::Exception &ex) {
 		throw Error(errParseJson, "FtFastConfig: %s", ex.what());
@@ -23,6 +23,8 @@ struct FtFastConfig : public BaseFTConfig {
 
 	int maxRebuildSteps = 50;
 	int maxStepSize = 4000;
+	// Time in ms, during which selects use outdated data, while it's rebuilt in background. 0 - data is rebuilt by select
+	int maxRebuildStalenessMs = 0;
 };
 
 }  // namespace reindexer
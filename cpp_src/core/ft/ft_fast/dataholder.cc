@@ -1,12 +1,13 @@
 ﻿#include "dataholder.h"
 #include <sstream>
+#include "tools/serializer.h"
 
 namespace reindexer {
 
 vector<PackedWordEntry>& DataHolder::GetWords() { return words_; }
-suffix_map<char, WordIdType>& DataHolder::GetSuffix() { return steps.back().suffixes_; }
+suffix_map<char, WordIdType>& DataHolder::GetSuffix() { return steps.back()->suffixes_; }
 
-flat_str_multimap<char, WordIdType>& DataHolder::GetTypos() { return steps.back().typos_; }
+flat_str_multimap<char, WordIdType>& DataHolder::GetTypos() { return steps.back()->typos_; }
 
 WordIdType DataHolder::findWord(string_view word) {
 	WordIdType id;
@@ -14,8 +15,8 @@ WordIdType DataHolder::findWord(string_view word) {
 	if (steps.size() <= 1) return id;
 
 	for (auto step = steps.begin(); step != steps.end() - 1; ++step) {
-		auto it = step->suffixes_.lower_bound(word);
-		if (it != step->suffixes_.end() && size_t(step->suffixes_.word_len_at(GetSuffixWordId(it->second, *step))) == word.size()) {
+		auto it = (*step)->suffixes_.lower_bound(word);
+		if (it != (*step)->suffixes_.end() && size_t((*step)->suffixes_.word_len_at(GetSuffixWordId(it->second, **step))) == word.size()) {
 			return it->second;
 		}
 	}
@@ -26,7 +27,7 @@ WordIdType DataHolder::findWord(string_view word) {
 size_t DataHolder::GetMemStat() {
 	size_t res = 0;
 	for (auto& step : steps) {
-		res += step.typos_.heap_size() + step.suffixes_.heap_size();
+		res += step->typos_.heap_size() + step->suffixes_.heap_size();
 	}
 	for (auto& w : words_) {
 		res += sizeof(w) + w.vids_.heap_size();
@@ -37,11 +38,11 @@ size_t DataHolder::GetMemStat() {
 
 void DataHolder::SetWordsOffset(uint32_t word_offset) {
 	assert(!steps.empty());
-	if (status_ == CreateNew) steps.back().wordOffset_ = word_offset;
+	if (status_ == CreateNew) steps.back()->wordOffset_ = word_offset;
 }
 uint32_t DataHolder::GetWordsOffset() {
 	assert(!steps.empty());
-	return steps.back().wordOffset_;
+	return steps.back()->wordOffset_;
 }
 WordIdType DataHolder::BuildWordId(uint32_t id) {
 	WordIdType wId;
@@ -67,11 +68,11 @@ uint32_t DataHolder::GetSuffixWordId(WordIdType id, const CommitStep& step) {
 	return id.b.id - step.wordOffset_;
 }
 
-uint32_t DataHolder::GetSuffixWordId(WordIdType id) { return GetSuffixWordId(id, steps.back()); }
+uint32_t DataHolder::GetSuffixWordId(WordIdType id) { return GetSuffixWordId(id, *steps.back()); }
 
 DataHolder::CommitStep& DataHolder::GetStep(WordIdType id) {
 	assert(id.b.step_num < steps.size());
-	return steps[id.b.step_num];
+	return *steps[id.b.step_num];
 }
 
 PackedWordEntry& DataHolder::getWordById(WordIdType id) {
@@ -81,8 +82,8 @@ PackedWordEntry& DataHolder::getWordById(WordIdType id) {
 }
 
 void DataHolder::Clear() {
-	steps.resize(1);
-	steps.front().clear();
+	steps.clear();
+	steps.push_back(std::make_shared<CommitStep>());
 	avgWordsCount_.clear();
 	words_.clear();
 	vdocs_.clear();
@@ -97,23 +98,96 @@ void DataHolder::StartCommit(bool complte_updated) {
 		Clear();
 	} else if (NeedRecomitLast()) {
 		status_ = RecommitLast;
-		words_.erase(words_.begin() + steps.back().wordOffset_, words_.end());
+		words_.erase(words_.begin() + steps.back()->wordOffset_, words_.end());
 
 		for (auto& word : words_) {
 			word.vids_.erase_back(word.cur_step_pos_);
 		}
 
-		steps.back().clear();
+		// The last step may be shared with the other generation of data, so it's replaced instead of clear
+		auto step = std::make_shared<CommitStep>();
+		step->wordOffset_ = steps.back()->wordOffset_;
+		steps.back() = std::move(step);
 	} else {
 		for (auto& word : words_) {
 			word.cur_step_pos_ = word.vids_.end().pos();
 		}
 		status_ = CreateNew;
-		steps.emplace_back(CommitStep{});
+		steps.push_back(std::make_shared<CommitStep>());
 	}
 	return;
 }
 
+void DataHolder::Serialize(WrSerializer& ser) const {
+	ser.PutVarUint(status_);
+	ser.PutVarUint(cur_vdoc_pos_);
+	ser.PutVarUint(steps.size());
+	for (auto& step : steps) {
+		ser.PutVarUint(step->wordOffset_);
+		step->suffixes_.serialize(ser);
+		step->typos_.serialize(ser);
+	}
+	ser.PutVarUint(avgWordsCount_.size());
+	for (double cnt : avgWordsCount_) ser.PutDouble(cnt);
+	ser.PutVarUint(words_.size());
+	for (auto& word : words_) {
+		ser.PutVarUint(word.cur_step_pos_);
+		word.vids_.serialize(ser);
+	}
+	ser.PutVarUint(vdocs_.size());
+	for (auto& vdoc : vdocs_) {
+		ser.PutVarUint(vdoc.wordsCount.size());
+		for (size_t i = 0; i < vdoc.wordsCount.size(); ++i) {
+			ser.PutDouble(vdoc.wordsCount[i]);
+			ser.PutDouble(vdoc.mostFreqWordCount[i]);
+		}
+	}
+}
+
+void DataHolder::Deserialize(Serializer& ser) {
+	Clear();
+	auto status = ser.GetVarUint();
+	if (status > CreateNew) throw Error(errParseBin, "Invalid fulltext commit status %d", status);
+	status_ = ProcessStatus(status);
+	cur_vdoc_pos_ = ser.GetVarUint();
+	size_t stepsCount = ser.GetVarUint();
+	if (!stepsCount || stepsCount > kWordIdMaxStepVal) throw Error(errParseBin, "Invalid fulltext steps count %d", stepsCount);
+	steps.clear();
+	for (size_t i = 0; i < stepsCount; ++i) {
+		steps.push_back(std::make_shared<CommitStep>());
+		auto& step = *steps.back();
+		step.wordOffset_ = ser.GetVarUint();
+		step.suffixes_.deserialize(ser);
+		step.typos_.deserialize(ser);
+	}
+	avgWordsCount_.resize(ser.GetVarUint());
+	for (double& cnt : avgWordsCount_) cnt = ser.GetDouble();
+	words_.resize(ser.GetVarUint());
+	for (auto& word : words_) {
+		word.cur_step_pos_ = ser.GetVarUint();
+		word.vids_.deserialize(ser);
+	}
+	vdocs_.resize(ser.GetVarUint());
+	for (auto& vdoc : vdocs_) {
+		vdoc.keyEntry = nullptr;
+		size_t fieldsCount = ser.GetVarUint();
+		for (size_t i = 0; i < fieldsCount; ++i) {
+			vdoc.wordsCount.push_back(ser.GetDouble());
+			vdoc.mostFreqWordCount.push_back(ser.GetDouble());
+		}
+	}
+}
+
+void DataHolder::CopyFrom(const DataHolder& other) {
+	// Suffixes and typos of steps are not copied: new commit either appends a new step, or replaces the last one
+	steps = other.steps;
+	avgWordsCount_ = other.avgWordsCount_;
+	words_ = other.words_;
+	vdocs_ = other.vdocs_;
+	status_ = other.status_;
+	cur_vdoc_pos_ = other.cur_vdoc_pos_;
+}
+
 string DataHolder::Dump() {
 	std::stringstream ss;
 	ss << "Holder dump: step count: " << steps.size() << std::endl;
@@ -133,10 +207,10 @@ string DataHolder::Dump() {
 	size_t counter = 0;
 	for (auto& step : steps) {
 		ss << "Step : " << std::to_string(counter);
-		if (!step.suffixes_.word_size()) ss << " - empty step";
+		if (!step->suffixes_.word_size()) ss << " - empty step";
 		ss << std::endl;
-		for (size_t i = 0; i < step.suffixes_.word_size(); i++) {
-			ss << step.suffixes_.word_at(i) << std::endl;
+		for (size_t i = 0; i < step->suffixes_.word_size(); i++) {
+			ss << step->suffixes_.word_at(i) << std::endl;
 		}
 		counter++;
 	}
@@ -144,11 +218,11 @@ string DataHolder::Dump() {
 }
 
 bool DataHolder::NeedRebuild(bool complte_updated) {
-	return ((steps.size() == 1 && steps.front().suffixes_.word_size() < size_t(cfg_->maxStepSize)) || steps.empty() ||
+	return ((steps.size() == 1 && steps.front()->suffixes_.word_size() < size_t(cfg_->maxStepSize)) || steps.empty() ||
 			steps.size() >= size_t(cfg_->maxRebuildSteps) || complte_updated);
 }
 
-bool DataHolder::NeedRecomitLast() { return steps.back().suffixes_.word_size() < size_t(cfg_->maxStepSize); }
+bool DataHolder::NeedRecomitLast() { return steps.back()->suffixes_.word_size() < size_t(cfg_->maxStepSize); }
 void DataHolder::SetConfig(FtFastConfig* cfg) {
 	cfg_ = cfg;
 	steps.reserve(cfg_->maxRebuildSteps + 1);
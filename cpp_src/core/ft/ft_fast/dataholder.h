@@ -13,6 +13,9 @@
 
 namespace reindexer {
 
+class WrSerializer;
+class Serializer;
+
 using std::unique_ptr;
 using std::vector;
 using std::pair;
@@ -88,7 +91,15 @@ public:
 	bool NeedClear(bool complte_updated);
 	void Clear();
 
-	vector<CommitStep> steps;
+	// Serializes committed data. Keys of vdocs are not serialized
+	void Serialize(WrSerializer& ser) const;
+	// Restores data, serialized by Serialize. Keys of vdocs are set to nullptr
+	void Deserialize(Serializer& ser);
+	// Copies committed data, including keys of vdocs. Commit steps are shared with other. Searchers and stemmers are not copied
+	void CopyFrom(const DataHolder& other);
+
+	// Steps are immutable, except the last one, which is replaced on recommit. So they may be shared by several generations of data
+	vector<std::shared_ptr<CommitStep>> steps;
 	vector<double> avgWordsCount_;
 	vector<PackedWordEntry> words_;
 
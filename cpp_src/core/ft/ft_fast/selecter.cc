@@ -161,7 +161,7 @@ void Selecter::processVariants(FtSelectContext &ctx) {
 			ctx.foundWords.clear();
 		}
 		for (auto &step : holder_.steps) {
-			processStepVariants(ctx, step, variant, res);
+			processStepVariants(ctx, *step, variant, res);
 		}
 	}
 }
@@ -171,7 +171,7 @@ void Selecter::processTypos(FtSelectContext &ctx, FtDSLEntry &term) {
 
 	for (auto &step : holder_.steps) {
 		typos_context tctx[kMaxTyposInWord];
-		auto &typos = step.typos_;
+		auto &typos = step->typos_;
 		int matched = 0, skiped = 0, vids = 0;
 		mktypos(tctx, term.pattern, holder_.cfg_->maxTyposInWord, holder_.cfg_->maxTypoLen, [&](string_view typo, int tcount) {
 			auto typoRng = typos.equal_range(typo);
@@ -1,17 +1,265 @@
 #include "core/idset.h"
 #include <algorithm>
+#include <cstring>
 #include "tools/errors.h"
 
 namespace reindexer {
-void IdSetPlain::Commit() {}
+// Bitmap is used only if it's several times smaller, than plain idset
+const int kMinBitmapMemoryGain = 2;
 
-void IdSet::Commit() {
+void IdSetPlain::Commit(bool /*allowBitmap*/, int /*sortedIdxCount*/) {}
+
+// Sort orders are stored sequentially, sz positions each. Inserts position of new id to each sort order, while sort orders are moved
+// from src to dst (dst >= src). Space for sz + 1 positions of each sort order has to be reserved
+static void insertSortPositions(IdType *src, IdType *dst, size_t sz, const IdType *sortPositions, int sortedIdxCount) {
+	// Each sort order is shifted by one more position, than the previous one, so they are moved starting from the last
+	for (int i = sortedIdxCount - 1; i >= 0; --i) {
+		IdType *from = src + i * sz, *to = dst + i * (sz + 1);
+		const IdType pos = sortPositions[i];
+		const size_t insPos = std::lower_bound(from, from + sz, pos) - from;
+		std::memmove(to + insPos + 1, from + insPos, (sz - insPos) * sizeof(IdType));
+		std::memmove(to, from, insPos * sizeof(IdType));
+		to[insPos] = pos;
+	}
+}
+
+// Erases position of id from each sort order, while sort orders are moved from src to dst (dst <= src)
+static void eraseSortPositions(IdType *src, IdType *dst, size_t sz, IdType id, const IdType *sortPositions, int sortedIdxCount) {
+	// Each sort order is shifted by one more position, than the previous one, so they are moved starting from the first
+	for (int i = 0; i < sortedIdxCount; ++i) {
+		IdType *from = src + i * sz, *to = dst + i * (sz - 1);
+		const IdType pos = sortPositions[i];
+		const size_t delPos = std::lower_bound(from, from + sz, pos) - from;
+		assertf(delPos < sz && from[delPos] == pos, "Position %d of id %d is not found in sort order %d", pos, id, i + 1);
+		(void)id;
+		std::memmove(to, from, delPos * sizeof(IdType));
+		std::memmove(to + delPos, from + delPos + 1, (sz - delPos - 1) * sizeof(IdType));
+	}
+}
+
+// Replaces position in sort order of sz positions
+static void moveSortPosition(IdType *sorted, size_t sz, SortType sortId, IdType from, IdType to) {
+	IdType *fromIt = std::lower_bound(sorted, sorted + sz, from);
+	assertf(fromIt != sorted + sz && *fromIt == from, "Position %d is not found in sort order %d", from, sortId);
+	(void)sortId;
+	IdType *toIt = std::lower_bound(sorted, sorted + sz, to);
+	if (toIt > fromIt) {
+		std::memmove(fromIt, fromIt + 1, (toIt - fromIt - 1) * sizeof(IdType));
+		*(toIt - 1) = to;
+	} else {
+		std::memmove(toIt + 1, toIt, (fromIt - toIt) * sizeof(IdType));
+		*toIt = to;
+	}
+}
+
+void IdSetPlain::AddSorted(IdType id, const IdType *sortPositions, int sortedIdxCount) {
+	const size_t sz = size();
+	const size_t idPos = std::lower_bound(begin(), end(), id) - begin();
+	if (idPos != sz && (*this)[idPos] == id) return;
+
+	// Sort orders are made a part of vector, so they are kept on reallocation
+	base_idset::resize(sz * (sortedIdxCount + 1));
+	grow((sz + 1) * (sortedIdxCount + 1));
+	if (is_hdata()) reserve(capacity() + 1);
+	IdType *ids = base_idset::data();
+	insertSortPositions(ids + sz, ids + sz + 1, sz, sortPositions, sortedIdxCount);
+	std::memmove(ids + idPos + 1, ids + idPos, (sz - idPos) * sizeof(IdType));
+	ids[idPos] = id;
+	base_idset::resize(sz + 1);
+}
+
+int IdSetPlain::EraseSorted(IdType id, const IdType *sortPositions, int sortedIdxCount) {
+	const size_t sz = size();
+	const size_t idPos = std::lower_bound(begin(), end(), id) - begin();
+	if (idPos == sz || (*this)[idPos] != id) return 0;
+
+	IdType *ids = base_idset::data();
+	std::memmove(ids + idPos, ids + idPos + 1, (sz - idPos - 1) * sizeof(IdType));
+	eraseSortPositions(ids + sz, ids + sz - 1, sz, id, sortPositions, sortedIdxCount);
+	base_idset::resize(sz - 1);
+	return 1;
+}
+
+void IdSetPlain::MoveSortPosition(SortType sortId, IdType from, IdType to) {
+	const size_t sz = size();
+	moveSortPosition(base_idset::data() + sortId * sz, sz, sortId, from, to);
+}
+
+// Last position of sort order, except of position except
+static IdType sortedBack(IdSetRef sorted, IdType except) {
+	for (auto it = sorted.rbegin(); it != sorted.rend(); ++it) {
+		if (*it != except) return *it;
+	}
+	return -1;
+}
+
+IdType IdSetPlain::SortedBack(unsigned sortId, IdType except) const { return sortedBack(Sorted(sortId), except); }
+
+// Bitmap may be shared with copies of idset, so only the changed chunk of bitmap is copied
+void IdSet::AddSorted(IdType id, const IdType *sortPositions, int sortedIdxCount) {
+	if (!sortedSets_) {
+		assert(!usingBtree_);
+		if (!bitmap_ && IdSetPlain::size() < size_t(kMaxPlainSortedIdsetSize)) {
+			if (set_) set_->insert(id);
+			IdSetPlain::AddSorted(id, sortPositions, sortedIdxCount);
+			return;
+		}
+		// Idset is too large to update sort orders in plain vector. Moving them to btrees costs O(kMaxPlainSortedIdsetSize) once
+		moveSortedToBTrees(sortedIdxCount);
+	} else if (!bitmap_ && !usingBtree_) {
+		moveIdsToBTree();
+	}
+	if (bitmap_) {
+		if (!mutableBitmap().Add(id)) return;
+	} else if (!set_->insert(id).second) {
+		return;
+	}
+	for (int i = 0; i < sortedIdxCount; ++i) (*sortedSets_)[i].insert(sortPositions[i]);
+}
+
+int IdSet::EraseSorted(IdType id, const IdType *sortPositions, int sortedIdxCount) {
+	if (!sortedSets_) {
+		assert(!usingBtree_);
+		if (!bitmap_) {
+			if (set_) set_->erase(id);
+			return IdSetPlain::EraseSorted(id, sortPositions, sortedIdxCount);
+		}
+		moveSortedToBTrees(sortedIdxCount);
+	} else if (!bitmap_ && !usingBtree_) {
+		moveIdsToBTree();
+	}
+	if (bitmap_) {
+		if (!mutableBitmap().Remove(id)) return 0;
+	} else if (!set_->erase(id)) {
+		return 0;
+	}
+	for (int i = 0; i < sortedIdxCount; ++i) {
+		const int erased = (*sortedSets_)[i].erase(sortPositions[i]);
+		assertf(erased, "Position %d of id %d is not found in sort order %d", sortPositions[i], id, i + 1);
+		(void)erased;
+	}
+	return 1;
+}
+
+void IdSet::MoveSortPosition(SortType sortId, IdType from, IdType to) {
+	if (base_idsetset *sorted = SortedBTree(sortId)) {
+		const int erased = sorted->erase(from);
+		assertf(erased, "Position %d is not found in sort order %d", from, sortId);
+		(void)erased;
+		sorted->insert(to);
+		return;
+	}
+	assert(!usingBtree_);
+	if (!bitmap_) {
+		IdSetPlain::MoveSortPosition(sortId, from, to);
+		return;
+	}
+	const size_t sz = bitmap_->Cardinality();
+	assertf(capacity() >= sortId * sz, "error capacity()=%d,sortId=%d,size()=%d", capacity(), sortId, sz);
+	moveSortPosition(base_idset::data() + (sortId - 1) * sz, sz, sortId, from, to);
+}
+
+IdType IdSet::SortedBack(unsigned sortId, IdType except) const {
+	const base_idsetset *sorted = SortedBTree(sortId);
+	if (!sorted) return sortedBack(Sorted(sortId), except);
+	for (auto it = sorted->rbegin(); it != sorted->rend(); ++it) {
+		if (*it != except) return *it;
+	}
+	return -1;
+}
+
+size_t IdSet::BTreeSize() const {
+	size_t size = set_ ? sizeof(*set_.get()) + set_->size() * sizeof(int) : 0;
+	if (sortedSets_) {
+		size += sizeof(*sortedSets_) + sortedSets_->capacity() * sizeof(base_idsetset);
+		for (const base_idsetset &sorted : *sortedSets_) size += sorted.size() * sizeof(IdType);
+	}
+	return size;
+}
+
+void IdSet::ReserveForSorted(int sortedIdxCount, bool updatable) {
+	if (updatable && sortedIdxCount && idsCount() > size_t(kMaxPlainSortedIdsetSize)) {
+		// Sort orders are built to btrees. Idset may be read concurrently, while they are built, so ids are moved to btree only
+		// on the first update
+		if (!sortedSets_ || int(sortedSets_->size()) != sortedIdxCount) sortedSets_.reset(new std::vector<base_idsetset>(sortedIdxCount));
+		// Vector of bitmap idset holds only sort orders
+		if (bitmap_) base_idset::clear();
+		return;
+	}
+	sortedSets_.reset();
+	if (bitmap_) {
+		reserve(size() * sortedIdxCount);
+		return;
+	}
+	reserve(((set_ ? set_->size() : size())) * (sortedIdxCount + 1));
+	if (updatable && is_hdata()) reserve(capacity() + 1);
+}
+
+void IdSet::moveSortedToBTrees(int sortedIdxCount) {
+	const size_t sz = idsCount();
+	assertf(capacity() >= sz * (bitmap_ ? sortedIdxCount : sortedIdxCount + 1), "error capacity()=%d,sortedIdxCount=%d,size()=%d",
+			capacity(), sortedIdxCount, sz);
+	sortedSets_.reset(new std::vector<base_idsetset>(sortedIdxCount));
+	// Sort orders of bitmap idset are placed from the beginning of vector, and of plain idset - after ids
+	const IdType *sorted = base_idset::data() + (bitmap_ ? 0 : sz);
+	for (int i = 0; i < sortedIdxCount; ++i) (*sortedSets_)[i].insert(sorted + i * sz, sorted + (i + 1) * sz);
+	if (bitmap_) {
+		base_idset::clear();
+	} else {
+		moveIdsToBTree();
+	}
+}
+
+void IdSet::moveIdsToBTree() {
+	if (!set_) set_.reset(new base_idsetset(begin(), end()));
+	usingBtree_ = true;
+	base_idset::clear();
+}
+
+void IdSet::Commit(bool allowBitmap, int sortedIdxCount) {
+	// Sort orders in btrees are rebuilt after commit
+	sortedSets_.reset();
+	if (bitmap_) return;
 	if (!size() && set_) {
 		resize(0);
 		for (auto id : *set_) push_back(id);
 	}
 
 	usingBtree_ = false;
+
+	if (allowBitmap && int(size()) >= kMinBitmapIdsetSize &&
+		IdSetBitmap::EstimateHeapSize(data(), data() + size()) * kMinBitmapMemoryGain <= size() * sizeof(IdType)) {
+		setBitmap(IdSetBitmap(data(), data() + size()), sortedIdxCount);
+	}
+}
+
+void IdSet::setBitmap(IdSetBitmap &&bitmap, int sortedIdxCount) {
+	const size_t sz = IdSetPlain::size();
+	// Sort orders are kept only if they are reserved (i.e. may be built already). Otherwise they will be reserved on build
+	base_idset sortOrders;
+	if (sortedIdxCount && capacity() >= sz * (sortedIdxCount + 1)) {
+		sortOrders.reserve(sz * sortedIdxCount);
+		sortOrders.insert(sortOrders.end(), data() + sz, data() + sz * (sortedIdxCount + 1));
+		sortOrders.resize(0);
+	}
+	base_idset::operator=(std::move(sortOrders));
+	bitmap_ = std::make_shared<IdSetBitmap>(std::move(bitmap));
+	set_.reset();
+	usingBtree_ = false;
+}
+
+// Copy of bitmap shares its chunks, so only the chunks, which are modified later, are copied
+IdSetBitmap &IdSet::mutableBitmap() {
+	if (bitmap_.use_count() > 1) bitmap_ = std::make_shared<IdSetBitmap>(*bitmap_);
+	return *bitmap_;
+}
+
+// Sort orders are not kept: idset is unpacked only to be modified
+void IdSet::unpackBitmap() {
+	auto bitmap = std::move(bitmap_);
+	resize(0);
+	reserve(bitmap->Cardinality());
+	bitmap->ForEach([this](IdType id) { push_back(id); });
 }
 
 string IdSetPlain::Dump() {
@@ -3,11 +3,15 @@
 #include <core/type_consts.h>
 #include <algorithm>
 #include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
+#include "core/idsetbitmap.h"
 #include "cpp-btree/btree_set.h"
 #include "estl/h_vector.h"
 #include "estl/intrusive_ptr.h"
 #include "estl/span.h"
+#include "tools/errors.h"
 
 namespace reindexer {
 using std::string;
@@ -15,6 +19,7 @@ using std::shared_ptr;
 
 using base_idset = h_vector<IdType, 3>;
 using base_idsetset = btree::btree_set<int>;
+using IdSetRef = span<IdType>;
 
 class IdSetPlain : protected base_idset {
 public:
@@ -60,31 +65,97 @@ public:
 		return d.second - d.first;
 	}
 
-	void Commit();
+	// Sort orders of idset are stored in reserved space after ids: for each sort id - positions of ids in sort order, in ascending order.
+	// The following methods modify idset and keep its sort orders actual. Update moves all the ids and positions, so it costs O(size):
+	// plain idsets are used by dense indexes, which trade update speed for memory.
+	// Adds id and inserts its positions in sort orders
+	void AddSorted(IdType id, const IdType *sortPositions, int sortedIdxCount);
+	// Erases id and its positions in sort orders
+	int EraseSorted(IdType id, const IdType *sortPositions, int sortedIdxCount);
+	// Replaces position of some id in sort order
+	void MoveSortPosition(SortType sortId, IdType from, IdType to);
+
+	void Commit(bool allowBitmap = false, int sortedIdxCount = 0);
 	bool IsCommited() const { return true; }
 	bool IsEmpty() const { return empty(); }
 	size_t BTreeSize() const { return 0; }
 	const base_idsetset *BTree() const { return nullptr; }
-	void ReserveForSorted(int sortedIdxCount) { reserve(size() * (sortedIdxCount + 1)); }
+	size_t BitmapSize() const { return 0; }
+	const IdSetBitmap *Bitmap() const { return nullptr; }
+	// Plain idset keeps sort orders only in plain vector
+	const base_idsetset *SortedBTree(unsigned /*sortId*/) const { return nullptr; }
+	base_idsetset *SortedBTree(unsigned /*sortId*/) { return nullptr; }
+	// Reserves space for sort orders. Sort orders, which are updated in place, are kept in heap storage: inline storage is moved with idset
+	// without them
+	void ReserveForSorted(int sortedIdxCount, bool updatable = false) {
+		reserve(size() * (sortedIdxCount + 1));
+		if (updatable && is_hdata()) reserve(capacity() + 1);
+	}
+	// Ids in order of sort index with sortId (0 - ids in ascending order)
+	IdSetRef Sorted(unsigned sortId) const {
+		assertf(capacity() >= (sortId + 1) * size(), "error capacity()=%d,sortId=%d,size()=%d", capacity(), sortId, size());
+		return IdSetRef(data() + sortId * size(), size());
+	}
+	// The first position in sort order
+	IdType SortedFront(unsigned sortId) const { return Sorted(sortId).front(); }
+	// The last position in sort order except of position except, or -1 if there is no such position
+	IdType SortedBack(unsigned sortId, IdType except = -1) const;
+	template <typename F>
+	void ForEach(const F &f) const {
+		for (IdType id : *this) f(id);
+	}
 	string Dump();
 };
 
 // maxmimum size of idset without building btree
 const int kMaxPlainIdsetSize = 16;
+// minimum size of idset, which may be converted to bitmap on commit
+const int kMinBitmapIdsetSize = 4096;
+// maximum size of idset, which updatable sort orders are kept in plain vector. Update of them moves up to size * (sortedIdxCount + 1)
+// ids and positions. Updatable sort orders of greater idsets are kept in btrees, which are updated in O(log(size))
+const int kMaxPlainSortedIdsetSize = 1024;
+static_assert(kMaxPlainSortedIdsetSize < kMinBitmapIdsetSize, "Updatable sort orders of bitmap idset have to be kept in btrees");
 
-class IdSet : public IdSetPlain {
+// Ids are stored either in plain vector, or in btree (while idset is modified), or in bitmap (in committed idset).
+// Plain vector is not accessible directly, because it doesn't hold ids in bitmap mode
+class IdSet : protected IdSetPlain {
 	friend class SingleSelectKeyResult;
 
 public:
+	using IdSetPlain::iterator;
+	using IdSetPlain::const_iterator;
+	using IdSetPlain::const_reverse_iterator;
+	using IdSetPlain::value_type;
+	using IdSetPlain::EditMode;
+	using IdSetPlain::Ordered;
+	using IdSetPlain::Auto;
+	using IdSetPlain::Unordered;
+	using IdSetPlain::reserve;
+	using IdSetPlain::capacity;
+	using IdSetPlain::shrink_to_fit;
+	using IdSetPlain::heap_size;
+	using IdSetPlain::Dump;
+
 	using Ptr = intrusive_ptr<intrusive_atomic_rc_wrapper<IdSet>>;
 	IdSet() : usingBtree_(false) {}
+	// Sort orders are not copied (plain vector copies only ids), so they have to be rebuilt by the copy
 	IdSet(const IdSet &other)
-		: IdSetPlain(other), set_(!other.set_ ? nullptr : new base_idsetset(*other.set_)), usingBtree_(other.usingBtree_.load()) {}
-	IdSet(IdSet &&other) noexcept : IdSetPlain(std::move(other)), set_(std::move(other.set_)), usingBtree_(other.usingBtree_.load()) {}
+		: IdSetPlain(other),
+		  set_(!other.set_ ? nullptr : new base_idsetset(*other.set_)),
+		  bitmap_(other.bitmap_),
+		  usingBtree_(other.usingBtree_.load()) {}
+	IdSet(IdSet &&other) noexcept
+		: IdSetPlain(std::move(other)),
+		  set_(std::move(other.set_)),
+		  bitmap_(std::move(other.bitmap_)),
+		  sortedSets_(std::move(other.sortedSets_)),
+		  usingBtree_(other.usingBtree_.load()) {}
 	IdSet &operator=(IdSet &&other) noexcept {
 		if (&other != this) {
 			IdSetPlain::operator=(std::move(other));
 			set_ = std::move(other.set_);
+			bitmap_ = std::move(other.bitmap_);
+			sortedSets_ = std::move(other.sortedSets_);
 			usingBtree_ = other.usingBtree_.load();
 		}
 		return *this;
@@ -93,11 +164,24 @@ public:
 		if (&other != this) {
 			IdSetPlain::operator=(other);
 			set_.reset(!other.set_ ? nullptr : new base_idsetset(*other.set_));
+			bitmap_ = other.bitmap_;
+			sortedSets_.reset();
 			usingBtree_ = other.usingBtree_.load();
 		}
 		return *this;
 	}
+	size_t size() const { return bitmap_ ? bitmap_->Cardinality() : IdSetPlain::size(); }
+	bool empty() const { return !size(); }
+	void clear() {
+		bitmap_.reset();
+		sortedSets_.reset();
+		IdSetPlain::clear();
+	}
+
+	// Add, Append and Erase don't keep sort orders, so they have to be rebuilt after them
 	void Add(IdType id, EditMode editMode, int sortedIdxCount) {
+		sortedSets_.reset();
+		if (bitmap_) unpackBitmap();
 		// Reserve extra space for sort orders data
 		grow(((set_ ? set_->size() : size()) + 1) * (sortedIdxCount + 1));
 
@@ -126,6 +210,8 @@ public:
 
 	template <typename InputIt>
 	void Append(InputIt first, InputIt last, EditMode editMode = Auto) {
+		sortedSets_.reset();
+		if (bitmap_) unpackBitmap();
 		if (editMode == Unordered) {
 			assert(!set_);
 			insert(base_idset::end(), first, last);
@@ -144,6 +230,8 @@ public:
 	}
 
 	int Erase(IdType id) {
+		sortedSets_.reset();
+		if (bitmap_) unpackBitmap();
 		if (!set_) {
 			auto d = std::equal_range(begin(), end(), id);
 			base_idset::erase(d.first, d.second);
@@ -155,12 +243,54 @@ public:
 		}
 		return 0;
 	}
-	void Commit();
+	// Sort orders are kept either in plain vector (by committed idset; its btree copy of ids, if any, is updated as well), or in btrees,
+	// if they are built updatable for large idset. In the latter case ids are moved to btree (unless they are in bitmap) on the first
+	// update, so each next update costs O(log(size)). Plain vector sort orders are moved to btrees, when idset grows over
+	// kMaxPlainSortedIdsetSize.
+	// Bitmap idset is updated in place without unpacking
+	void AddSorted(IdType id, const IdType *sortPositions, int sortedIdxCount);
+	int EraseSorted(IdType id, const IdType *sortPositions, int sortedIdxCount);
+	void MoveSortPosition(SortType sortId, IdType from, IdType to);
+	// Commits changes. If allowBitmap is set and ids are dense enough, idset is converted to compressed bitmap.
+	// Sort orders of bitmap idset (except of ids order itself) are kept in plain vector
+	void Commit(bool allowBitmap = false, int sortedIdxCount = 0);
 	bool IsCommited() const { return !usingBtree_; }
 	bool IsEmpty() const { return empty() && (!set_ || set_->empty()); }
-	size_t BTreeSize() const { return set_ ? sizeof(*set_.get()) + set_->size() * sizeof(int) : 0; }
+	size_t BTreeSize() const;
 	const base_idsetset *BTree() const { return set_.get(); }
-	void ReserveForSorted(int sortedIdxCount) { reserve(((set_ ? set_->size() : size())) * (sortedIdxCount + 1)); }
+	size_t BitmapSize() const { return bitmap_ ? sizeof(*bitmap_.get()) + bitmap_->HeapSize() : 0; }
+	const IdSetBitmap *Bitmap() const { return bitmap_.get(); }
+	// Sort order with sortId, which is kept in btree, or nullptr, if sort orders are kept in plain vector
+	const base_idsetset *SortedBTree(unsigned sortId) const { return sortId && sortedSets_ ? &(*sortedSets_)[sortId - 1] : nullptr; }
+	base_idsetset *SortedBTree(unsigned sortId) { return sortId && sortedSets_ ? &(*sortedSets_)[sortId - 1] : nullptr; }
+	// Reserves space for sort orders. Updatable sort orders of large idset are prepared to be built in btrees
+	void ReserveForSorted(int sortedIdxCount, bool updatable = false);
+	// Replaces content of idset with bitmap
+	void SetBitmap(IdSetBitmap &&bitmap) { setBitmap(std::move(bitmap), 0); }
+	// In bitmap mode ids are not available as plain vector, so sortId must not be 0. Sort orders in btrees are available by SortedBTree
+	IdSetRef Sorted(unsigned sortId) const {
+		assert(!SortedBTree(sortId));
+		if (!bitmap_) return IdSetPlain::Sorted(sortId);
+		assert(sortId);
+		const size_t sz = size();
+		assertf(capacity() >= sortId * sz, "error capacity()=%d,sortId=%d,size()=%d", capacity(), sortId, sz);
+		return IdSetRef(data() + (sortId - 1) * sz, sz);
+	}
+	IdType SortedFront(unsigned sortId) const {
+		const base_idsetset *sorted = SortedBTree(sortId);
+		return sorted ? *sorted->begin() : Sorted(sortId).front();
+	}
+	IdType SortedBack(unsigned sortId, IdType except = -1) const;
+	template <typename F>
+	void ForEach(const F &f) const {
+		if (bitmap_) {
+			bitmap_->ForEach(f);
+		} else if (usingBtree_) {
+			for (IdType id : *set_) f(id);
+		} else {
+			IdSetPlain::ForEach(f);
+		}
+	}
 
 protected:
 	template <typename>
@@ -168,10 +298,23 @@ protected:
 	template <typename>
 	friend class BtreeIndexReverseIteratorImpl;
 
+	// Replaces content of idset with bitmap. Sort orders are moved to the beginning of plain vector
+	void setBitmap(IdSetBitmap &&bitmap, int sortedIdxCount);
+	void unpackBitmap();
+	IdSetBitmap &mutableBitmap();
+	// Count of ids in any mode
+	size_t idsCount() const { return bitmap_ ? bitmap_->Cardinality() : (usingBtree_ ? set_->size() : IdSetPlain::size()); }
+	// Moves ids (unless they are in bitmap) and sort orders from plain vector to btrees
+	void moveSortedToBTrees(int sortedIdxCount);
+	// Moves ids from plain vector to btree
+	void moveIdsToBTree();
+
 	std::unique_ptr<base_idsetset> set_;
+	// Bitmap is shared between copies of idset and copied on write
+	std::shared_ptr<IdSetBitmap> bitmap_;
+	// Updatable sort orders of large idset for sort ids from 1
+	std::unique_ptr<std::vector<base_idsetset>> sortedSets_;
 	std::atomic<bool> usingBtree_;
 };
 
-using IdSetRef = span<IdType>;
-
 }  // namespace reindexer
@@ -0,0 +1,346 @@
+#include "core/idsetbitmap.h"
+#include <assert.h>
+#include <algorithm>
+#include <bitset>
+#include <iterator>
+
+namespace reindexer {
+
+constexpr size_t IdSetBitmap::kChunkWords;
+constexpr size_t IdSetBitmap::kMaxSparseChunkSize;
+
+static inline unsigned popCount(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcountll(v);
+#else
+	return std::bitset<64>(v).count();
+#endif
+}
+
+static inline unsigned highestBit(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+	return 63 - __builtin_clzll(v);
+#else
+	unsigned n = 63;
+	for (; !(v & (uint64_t(1) << n)); --n) {
+	}
+	return n;
+#endif
+}
+
+static inline uint16_t chunkKey(IdType id) { return uint16_t(uint32_t(id) >> 16); }
+static inline uint16_t chunkLow(IdType id) { return uint16_t(uint32_t(id) & 0xFFFF); }
+
+IdSetBitmap::IdSetBitmap(const IdType *begin, const IdType *end) {
+	while (begin != end) {
+		Chunk chunk;
+		chunk.key = chunkKey(*begin);
+		const IdType *chunkEnd = begin;
+		while (chunkEnd != end && chunkKey(*chunkEnd) == chunk.key) ++chunkEnd;
+		chunk.array.reserve(chunkEnd - begin);
+		for (; begin != chunkEnd; ++begin) chunk.array.push_back(chunkLow(*begin));
+		push(std::move(chunk));
+	}
+	chunks_.shrink_to_fit();
+}
+
+size_t IdSetBitmap::EstimateHeapSize(const IdType *begin, const IdType *end) {
+	size_t size = 0;
+	while (begin != end) {
+		const uint16_t key = chunkKey(*begin);
+		const IdType *chunkEnd = begin;
+		while (chunkEnd != end && chunkKey(*chunkEnd) == key) ++chunkEnd;
+		size += sizeof(Chunk) + std::min(size_t(chunkEnd - begin), kMaxSparseChunkSize) * sizeof(uint16_t);
+		begin = chunkEnd;
+	}
+	return size;
+}
+
+size_t IdSetBitmap::HeapSize() const {
+	size_t size = chunks_.capacity() * sizeof(ChunkPtr);
+	for (const ChunkPtr &chunk : chunks_) size += sizeof(Chunk) + chunk->HeapSize();
+	return size;
+}
+
+size_t IdSetBitmap::findChunk(uint16_t key) const {
+	return std::lower_bound(chunks_.begin(), chunks_.end(), key, [](const ChunkPtr &c, uint16_t k) { return c->key < k; }) -
+		   chunks_.begin();
+}
+
+bool IdSetBitmap::Contains(IdType id) const {
+	if (id < 0) return false;
+	const uint16_t key = chunkKey(id);
+	const size_t idx = findChunk(key);
+	return idx != chunks_.size() && chunks_[idx]->key == key && chunks_[idx]->Contains(chunkLow(id));
+}
+
+IdSetBitmap::Chunk &IdSetBitmap::mutableChunk(size_t idx) {
+	if (chunks_[idx].use_count() > 1) chunks_[idx] = std::make_shared<Chunk>(*chunks_[idx]);
+	return *chunks_[idx];
+}
+
+bool IdSetBitmap::Add(IdType id) {
+	assert(id >= 0);
+	const uint16_t key = chunkKey(id), low = chunkLow(id);
+	const size_t idx = findChunk(key);
+	if (idx == chunks_.size() || chunks_[idx]->key != key) {
+		auto chunk = std::make_shared<Chunk>();
+		chunk->key = key;
+		chunk->cardinality = 1;
+		chunk->array.push_back(low);
+		chunks_.insert(chunks_.begin() + idx, std::move(chunk));
+		++cardinality_;
+		return true;
+	}
+	if (chunks_[idx]->Contains(low)) return false;
+
+	Chunk &chunk = mutableChunk(idx);
+	if (chunk.IsDense()) {
+		chunk.bits[low >> 6] |= uint64_t(1) << (low & 63);
+		++chunk.cardinality;
+	} else {
+		chunk.array.insert(std::lower_bound(chunk.array.begin(), chunk.array.end(), low), low);
+		// Too large sparse chunk is converted to bitset
+		if (chunk.array.size() > kMaxSparseChunkSize) {
+			chunk.Normalize();
+		} else {
+			++chunk.cardinality;
+		}
+	}
+	++cardinality_;
+	return true;
+}
+
+bool IdSetBitmap::Remove(IdType id) {
+	if (id < 0) return false;
+	const uint16_t key = chunkKey(id), low = chunkLow(id);
+	const size_t idx = findChunk(key);
+	if (idx == chunks_.size() || chunks_[idx]->key != key || !chunks_[idx]->Contains(low)) return false;
+
+	--cardinality_;
+	if (chunks_[idx]->cardinality == 1) {
+		chunks_.erase(chunks_.begin() + idx);
+		return true;
+	}
+	Chunk &chunk = mutableChunk(idx);
+	if (chunk.IsDense()) {
+		chunk.bits[low >> 6] &= ~(uint64_t(1) << (low & 63));
+		// Bitset, which is not larger than array, is converted back to array
+		if (--chunk.cardinality <= kMaxSparseChunkSize) chunk.Normalize();
+	} else {
+		chunk.array.erase(std::lower_bound(chunk.array.begin(), chunk.array.end(), low));
+		--chunk.cardinality;
+	}
+	return true;
+}
+
+IdType IdSetBitmap::Next(IdType id, size_t &hint) const {
+	if (id == INT_MAX) return INT_MAX;
+	const IdType target = std::max(id + 1, 0);
+	const uint16_t key = chunkKey(target);
+	// Chunks before hint contain only ids, which are less than target
+	hint = std::lower_bound(chunks_.begin() + std::min(hint, chunks_.size()), chunks_.end(), key,
+							[](const ChunkPtr &c, uint16_t k) { return c->key < k; }) -
+		   chunks_.begin();
+	for (size_t i = hint; i < chunks_.size(); ++i) {
+		const Chunk &chunk = *chunks_[i];
+		const int low = chunk.LowerBound(chunk.key == key ? chunkLow(target) : 0);
+		if (low >= 0) {
+			hint = i;
+			return (IdType(chunk.key) << 16) + low;
+		}
+	}
+	hint = chunks_.size();
+	return INT_MAX;
+}
+
+IdType IdSetBitmap::Prev(IdType id, size_t &hint) const {
+	if (id <= 0) return INT_MIN;
+	const IdType target = id - 1;
+	const uint16_t key = chunkKey(target);
+	// Last hint chunks contain only ids, which are greater than target
+	const size_t end = chunks_.size() - std::min(hint, chunks_.size());
+	size_t i = std::upper_bound(chunks_.begin(), chunks_.begin() + end, key, [](uint16_t k, const ChunkPtr &c) { return k < c->key; }) -
+			   chunks_.begin();
+	for (; i > 0; --i) {
+		const Chunk &chunk = *chunks_[i - 1];
+		const int low = chunk.ReverseLowerBound(chunk.key == key ? chunkLow(target) : 0xFFFF);
+		if (low >= 0) {
+			hint = chunks_.size() - i;
+			return (IdType(chunk.key) << 16) + low;
+		}
+	}
+	hint = chunks_.size();
+	return INT_MIN;
+}
+
+IdSetBitmap IdSetBitmap::And(const IdSetBitmap &lhs, const IdSetBitmap &rhs) {
+	IdSetBitmap res;
+	auto l = lhs.chunks_.begin(), r = rhs.chunks_.begin();
+	while (l != lhs.chunks_.end() && r != rhs.chunks_.end()) {
+		if ((*l)->key < (*r)->key) {
+			++l;
+		} else if ((*r)->key < (*l)->key) {
+			++r;
+		} else {
+			res.push(andChunks(**l++, **r++));
+		}
+	}
+	return res;
+}
+
+IdSetBitmap IdSetBitmap::Or(const IdSetBitmap &lhs, const IdSetBitmap &rhs) {
+	IdSetBitmap res;
+	res.chunks_.reserve(std::max(lhs.chunks_.size(), rhs.chunks_.size()));
+	auto l = lhs.chunks_.begin(), r = rhs.chunks_.begin();
+	while (l != lhs.chunks_.end() || r != rhs.chunks_.end()) {
+		if (r == rhs.chunks_.end() || (l != lhs.chunks_.end() && (*l)->key < (*r)->key)) {
+			res.push(*l++);
+		} else if (l == lhs.chunks_.end() || (*r)->key < (*l)->key) {
+			res.push(*r++);
+		} else {
+			res.push(orChunks(**l++, **r++));
+		}
+	}
+	return res;
+}
+
+IdSetBitmap IdSetBitmap::AndNot(const IdSetBitmap &lhs, const IdSetBitmap &rhs) {
+	IdSetBitmap res;
+	auto r = rhs.chunks_.begin();
+	for (const ChunkPtr &l : lhs.chunks_) {
+		while (r != rhs.chunks_.end() && (*r)->key < l->key) ++r;
+		if (r != rhs.chunks_.end() && (*r)->key == l->key) {
+			res.push(andNotChunks(*l, **r));
+		} else {
+			res.push(l);
+		}
+	}
+	return res;
+}
+
+void IdSetBitmap::push(Chunk &&chunk) {
+	chunk.Normalize();
+	if (!chunk.cardinality) return;
+	cardinality_ += chunk.cardinality;
+	chunks_.push_back(std::make_shared<Chunk>(std::move(chunk)));
+}
+
+void IdSetBitmap::push(const ChunkPtr &chunk) {
+	cardinality_ += chunk->cardinality;
+	chunks_.push_back(chunk);
+}
+
+IdSetBitmap::Chunk IdSetBitmap::andChunks(const Chunk &lhs, const Chunk &rhs) {
+	Chunk res;
+	res.key = lhs.key;
+	if (lhs.IsDense() && rhs.IsDense()) {
+		res.bits.resize(kChunkWords);
+		for (size_t w = 0; w < kChunkWords; ++w) res.bits[w] = lhs.bits[w] & rhs.bits[w];
+	} else if (lhs.IsDense() || rhs.IsDense()) {
+		const Chunk &sparse = lhs.IsDense() ? rhs : lhs;
+		const Chunk &dense = lhs.IsDense() ? lhs : rhs;
+		for (uint16_t low : sparse.array) {
+			if (dense.Contains(low)) res.array.push_back(low);
+		}
+	} else {
+		std::set_intersection(lhs.array.begin(), lhs.array.end(), rhs.array.begin(), rhs.array.end(), std::back_inserter(res.array));
+	}
+	return res;
+}
+
+IdSetBitmap::Chunk IdSetBitmap::orChunks(const Chunk &lhs, const Chunk &rhs) {
+	Chunk res;
+	res.key = lhs.key;
+	if (lhs.IsDense() || rhs.IsDense()) {
+		res.bits.resize(kChunkWords);
+		for (const Chunk *chunk : {&lhs, &rhs}) {
+			if (chunk->IsDense()) {
+				for (size_t w = 0; w < kChunkWords; ++w) res.bits[w] |= chunk->bits[w];
+			} else {
+				for (uint16_t low : chunk->array) res.bits[low >> 6] |= uint64_t(1) << (low & 63);
+			}
+		}
+	} else {
+		res.array.reserve(lhs.array.size() + rhs.array.size());
+		std::set_union(lhs.array.begin(), lhs.array.end(), rhs.array.begin(), rhs.array.end(), std::back_inserter(res.array));
+	}
+	return res;
+}
+
+IdSetBitmap::Chunk IdSetBitmap::andNotChunks(const Chunk &lhs, const Chunk &rhs) {
+	Chunk res;
+	res.key = lhs.key;
+	if (lhs.IsDense()) {
+		res.bits = lhs.bits;
+		if (rhs.IsDense()) {
+			for (size_t w = 0; w < kChunkWords; ++w) res.bits[w] &= ~rhs.bits[w];
+		} else {
+			for (uint16_t low : rhs.array) res.bits[low >> 6] &= ~(uint64_t(1) << (low & 63));
+		}
+	} else if (rhs.IsDense()) {
+		for (uint16_t low : lhs.array) {
+			if (!rhs.Contains(low)) res.array.push_back(low);
+		}
+	} else {
+		std::set_difference(lhs.array.begin(), lhs.array.end(), rhs.array.begin(), rhs.array.end(), std::back_inserter(res.array));
+	}
+	return res;
+}
+
+bool IdSetBitmap::Chunk::Contains(uint16_t low) const {
+	if (IsDense()) return bits[low >> 6] & (uint64_t(1) << (low & 63));
+	return std::binary_search(array.begin(), array.end(), low);
+}
+
+int IdSetBitmap::Chunk::LowerBound(unsigned low) const {
+	if (!IsDense()) {
+		auto it = std::lower_bound(array.begin(), array.end(), low);
+		return it != array.end() ? *it : -1;
+	}
+	size_t w = low >> 6;
+	uint64_t word = bits[w] & (~uint64_t(0) << (low & 63));
+	while (!word) {
+		if (++w == kChunkWords) return -1;
+		word = bits[w];
+	}
+	return int(w * 64 + lowestBit(word));
+}
+
+int IdSetBitmap::Chunk::ReverseLowerBound(unsigned low) const {
+	if (!IsDense()) {
+		auto it = std::upper_bound(array.begin(), array.end(), low);
+		return it != array.begin() ? *(it - 1) : -1;
+	}
+	size_t w = low >> 6;
+	uint64_t word = bits[w] & (~uint64_t(0) >> (63 - (low & 63)));
+	while (!word) {
+		if (w-- == 0) return -1;
+		word = bits[w];
+	}
+	return int(w * 64 + highestBit(word));
+}
+
+void IdSetBitmap::Chunk::Normalize() {
+	if (IsDense()) {
+		cardinality = 0;
+		for (uint64_t word : bits) cardinality += popCount(word);
+		if (cardinality > kMaxSparseChunkSize) return;
+		array.reserve(cardinality);
+		for (size_t w = 0; w < kChunkWords; ++w) {
+			for (uint64_t word = bits[w]; word; word &= word - 1) array.push_back(uint16_t(w * 64 + lowestBit(word)));
+		}
+		std::vector<uint64_t>().swap(bits);
+	} else {
+		cardinality = array.size();
+		if (cardinality <= kMaxSparseChunkSize) {
+			array.shrink_to_fit();
+			return;
+		}
+		bits.resize(kChunkWords);
+		for (uint16_t low : array) bits[low >> 6] |= uint64_t(1) << (low & 63);
+		std::vector<uint16_t>().swap(array);
+	}
+}
+
+}  // namespace reindexer
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <core/type_consts.h>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace reindexer {
+
+/// Compressed bitmap of row ids (roaring bitmap like).
+/// Ids are split to chunks by high 16 bits. Sparse chunk is stored as sorted array of low 16 bits,
+/// and dense chunk - as bitset of 65536 bits. Chunks are shared between copies of bitmap and copied on write,
+/// so modification of single id costs O(chunk size) regardless of bitmap size.
+class IdSetBitmap {
+public:
+	IdSetBitmap() = default;
+	/// Builds bitmap from sorted unique ids
+	IdSetBitmap(const IdType *begin, const IdType *end);
+
+	size_t Cardinality() const { return cardinality_; }
+	bool Empty() const { return !cardinality_; }
+	size_t HeapSize() const;
+	bool Contains(IdType id) const;
+	/// Adds id. Chunk of id is copied, if it's shared with other bitmaps
+	/// @return false, if id is already in bitmap
+	bool Add(IdType id);
+	/// Removes id. Chunk of id is copied, if it's shared with other bitmaps
+	/// @return false, if there is no such id in bitmap
+	bool Remove(IdType id);
+
+	/// Searches the first id, which is greater than id
+	/// @param id - id to search from
+	/// @param hint - search state. Must be 0 before the first call. Sequential calls have to use growing ids
+	/// @return found id or INT_MAX, if there is no such id
+	IdType Next(IdType id, size_t &hint) const;
+	/// Searches the last id, which is less than id
+	/// @param id - id to search from
+	/// @param hint - search state. Must be 0 before the first call. Sequential calls have to use decreasing ids
+	/// @return found id or INT_MIN, if there is no such id
+	IdType Prev(IdType id, size_t &hint) const;
+
+	/// Calls f for each id in ascending order
+	template <typename F>
+	void ForEach(const F &f) const {
+		for (const ChunkPtr &chunk : chunks_) {
+			const IdType base = IdType(chunk->key) << 16;
+			if (chunk->IsDense()) {
+				for (size_t w = 0; w < kChunkWords; ++w) {
+					for (uint64_t bits = chunk->bits[w]; bits; bits &= bits - 1) f(base + IdType(w * 64 + lowestBit(bits)));
+				}
+			} else {
+				for (uint16_t low : chunk->array) f(base + low);
+			}
+		}
+	}
+
+	static IdSetBitmap And(const IdSetBitmap &lhs, const IdSetBitmap &rhs);
+	static IdSetBitmap Or(const IdSetBitmap &lhs, const IdSetBitmap &rhs);
+	static IdSetBitmap AndNot(const IdSetBitmap &lhs, const IdSetBitmap &rhs);
+
+	/// Heap size of bitmap, which would be built from sorted unique ids
+	static size_t EstimateHeapSize(const IdType *begin, const IdType *end);
+
+private:
+	// Chunk of 65536 ids with the same high 16 bits
+	struct Chunk {
+		bool IsDense() const { return !bits.empty(); }
+		bool Contains(uint16_t low) const;
+		// The first value >= low or -1
+		int LowerBound(unsigned low) const;
+		// The last value <= low or -1
+		int ReverseLowerBound(unsigned low) const;
+		size_t HeapSize() const { return array.capacity() * sizeof(uint16_t) + bits.capacity() * sizeof(uint64_t); }
+		// Converts chunk to the most compact representation
+		void Normalize();
+
+		uint16_t key = 0;
+		uint32_t cardinality = 0;
+		std::vector<uint16_t> array;
+		std::vector<uint64_t> bits;
+	};
+	using ChunkPtr = std::shared_ptr<Chunk>;
+
+	static constexpr size_t kChunkWords = 65536 / 64;
+	// Max size of sparse chunk. Greater chunks are stored as bitsets, which have the same memory size
+	static constexpr size_t kMaxSparseChunkSize = kChunkWords * sizeof(uint64_t) / sizeof(uint16_t);
+
+	static unsigned lowestBit(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_ctzll(v);
+#else
+		unsigned n = 0;
+		for (; !(v & 1); v >>= 1) ++n;
+		return n;
+#endif
+	}
+	static Chunk andChunks(const Chunk &lhs, const Chunk &rhs);
+	static Chunk orChunks(const Chunk &lhs, const Chunk &rhs);
+	static Chunk andNotChunks(const Chunk &lhs, const Chunk &rhs);
+	void push(Chunk &&chunk);
+	// Appends chunk of other bitmap without copy
+	void push(const ChunkPtr &chunk);
+	// Index of chunk with key or of the first chunk with greater key
+	size_t findChunk(uint16_t key) const;
+	// Chunk, which can be modified: shared chunk is replaced with its copy
+	Chunk &mutableChunk(size_t idx);
+
+	std::vector<ChunkPtr> chunks_;
+	size_t cardinality_ = 0;
+};
+
+}  // namespace reindexer
@@ -40,7 +40,7 @@ struct IdSetCacheKey {
 struct IdSetCacheVal {
 	IdSetCacheVal() : ids(nullptr) {}
 	IdSetCacheVal(const IdSet::Ptr &i) : ids(i) {}
-	size_t Size() const { return ids ? sizeof(*ids.get()) + ids->heap_size() : 0; }
+	size_t Size() const { return ids ? sizeof(*ids.get()) + ids->heap_size() + ids->BitmapSize() : 0; }
 
 	IdSet::Ptr ids;
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include "core/idset.h"
 #include "core/index/keyentry.h"
@@ -19,6 +20,7 @@ using std::string;
 using std::vector;
 
 class RdxContext;
+class WrSerializer;
 
 class Index {
 public:
@@ -50,7 +52,30 @@ public:
 	virtual bool IsOrdered() const { return false; }
 	virtual IndexMemStat GetMemStat() = 0;
 	virtual int64_t GetTTLValue() const { return 0; }
+	// Expiration time (UNIX timestamp in seconds) of the oldest item of TTL index, or 0 if there are no items
+	virtual int64_t GetMinExpirationTime() const { return 0; }
 	virtual IndexIterator::Ptr CreateIterator() const { return nullptr; }
+	// Rebuild of data, which is built lazily and may be used by selects while outdated (e.g. fulltext).
+	// Rebuild is prepared under namespace lock, built without it, and applied under namespace lock again
+	class OutdatedRebuild {
+	public:
+		virtual ~OutdatedRebuild() = default;
+		virtual void Build() = 0;
+	};
+	// Returns rebuild of outdated data, or nullptr if it's not needed yet. Called by namespace background routine under read lock
+	virtual std::unique_ptr<OutdatedRebuild> PrepareRebuild() { return nullptr; }
+	// Swaps rebuilt data with the current one, unless index was rebuilt by select since PrepareRebuild. Called under read lock
+	virtual void ApplyRebuild(OutdatedRebuild&) {}
+	class SavedState {
+	public:
+		virtual ~SavedState() = default;
+		virtual void Serialize(WrSerializer&) const = 0;
+	};
+	// Copies built internal structures of index, to restore them after restart without rebuild. Called under read lock, and the copy is
+	// serialized without it. Returns nullptr, if there is nothing to save, or structures were not changed since the last call
+	virtual std::unique_ptr<SavedState> SaveState() { return nullptr; }
+	// Restores structures, serialized by SaveState. Returns false, if state does not match to the index data
+	virtual bool LoadState(string_view) { return false; }
 
 	const PayloadType& GetPayloadType() const { return payloadType_; }
 	void UpdatePayloadType(const PayloadType payloadType) { payloadType_ = payloadType; }
@@ -69,6 +94,22 @@ public:
 	SortType SortId() const { return sortId_; }
 	virtual void SetSortedIdxCount(int sortedIdxCount) { sortedIdxCount_ = sortedIdxCount; }
 
+	// Sets positions of items in built sort orders. While they are set, sort orders of idsets are kept actual on Upsert and Delete
+	virtual void SetSortPositions(SortPositions* sortPositions) { sortPositions_ = sortPositions; }
+	// Replaces position of item in sort order with sortId in idsets of keys of the item
+	virtual void MoveSortPosition(const VariantArray& /*keys*/, SortType /*sortId*/, IdType /*from*/, IdType /*to*/) {}
+	// Checks, whether item with key at position pos keeps sort order of index. Otherwise gets bounds of positions for the item:
+	// it has to be placed after position left (which is -1, if there are no items with lesser or equal keys) and before position right
+	// (which is max of IdType, if there are no items with greater keys). Position of the item itself is ignored.
+	// Available only for ordered indexes with built sort orders
+	virtual bool GetSortPositionBounds(const Variant& /*key*/, IdType /*pos*/, IdType& /*left*/, IdType& /*right*/) const { return true; }
+	// Places item to position in sort order. kSortOrdersHole frees position
+	void SetSortOrder(IdType pos, IdType id) {
+		if (size_t(pos) >= sortOrders_.size()) sortOrders_.resize(pos + 1, kSortOrdersHole);
+		sortOrders_[pos] = id;
+		while (!sortOrders_.empty() && sortOrders_.back() == kSortOrdersHole) sortOrders_.pop_back();
+	}
+
 	PerfStatCounterMT& GetSelectPerfCounter() { return selectPerfCounter_; }
 	PerfStatCounterMT& GetCommitPerfCounter() { return commitPerfCounter_; }
 
@@ -101,6 +142,8 @@ protected:
 	KeyValueType keyType_, selectKeyType_;
 	// Count of sorted indexes in namespace to resereve additional space in idsets
 	int sortedIdxCount_ = 0;
+	// Positions of items in built sort orders, which are used to keep sort orders of idsets actual on updates
+	SortPositions* sortPositions_ = nullptr;
 };
 
 }  // namespace reindexer
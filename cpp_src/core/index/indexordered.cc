@@ -11,7 +11,7 @@ template <typename T>
 Variant IndexOrdered<T>::Upsert(const Variant &key, IdType id) {
 	if (this->cache_) this->cache_.reset();
 	if (key.Type() == KeyValueNull) {
-		this->empty_ids_.Unsorted().Add(id, IdSet::Auto, this->sortedIdxCount_);
+		this->addId(this->empty_ids_.Unsorted(), id, IdSet::Auto);
 		// Return invalid ref
 		return Variant();
 	}
@@ -23,7 +23,7 @@ Variant IndexOrdered<T>::Upsert(const Variant &key, IdType id) {
 	else
 		this->delMemStat(keyIt);
 
-	keyIt->second.Unsorted().Add(id, this->opts_.IsPK() ? IdSet::Ordered : IdSet::Auto, this->sortedIdxCount_);
+	this->addId(keyIt->second.Unsorted(), id, this->opts_.IsPK() ? IdSet::Ordered : IdSet::Auto);
 	this->tracker_.markUpdated(this->idx_map, keyIt);
 	this->addMemStat(keyIt);
 
@@ -95,13 +95,13 @@ SelectKeyResults IndexOrdered<T>::SelectKey(const VariantArray &keys, CondType c
 		IndexIterator::Ptr btreeIt(make_intrusive<BtreeIndexIterator<T>>(this->idx_map, startIt, endIt));
 		res.push_back(SingleSelectKeyResult(btreeIt));
 	} else if (sortId && this->sortId_ == sortId && !opts.distinct) {
-		assert(startIt->second.Sorted(this->sortId_).size());
-		IdType idFirst = startIt->second.Sorted(this->sortId_).front();
+		assert(!startIt->second.Unsorted().IsEmpty());
+		IdType idFirst = startIt->second.Unsorted().SortedFront(this->sortId_);
 
 		auto backIt = endIt;
 		backIt--;
-		assert(backIt->second.Sorted(this->sortId_).size());
-		IdType idLast = backIt->second.Sorted(this->sortId_).back();
+		assert(!backIt->second.Unsorted().IsEmpty());
+		IdType idLast = backIt->second.Unsorted().SortedBack(this->sortId_);
 		// sort by this index. Just give part of sorted ids;
 		res.push_back(SingleSelectKeyResult(idFirst, idLast + 1));
 	} else {
@@ -145,11 +145,12 @@ void IndexOrdered<T>::MakeSortOrders(UpdateSortedContext &ctx) {
 		if (it != SortIdUnexists) totalIds++;
 
 	this->sortId_ = ctx.getCurSortId();
-	this->sortOrders_.resize(totalIds);
+	const IdType gap = ctx.getSortOrdersGap();
+	this->sortOrders_.assign(totalIds * gap, kSortOrdersHole);
 	size_t idx = 0;
 	for (auto &keyIt : this->idx_map) {
 		// assert (keyIt.second.size());
-		for (auto id : keyIt.second.Unsorted()) {
+		keyIt.second.Unsorted().ForEach([&](IdType id) {
 			if (id >= int(ids2Sorts.size()) || ids2Sorts[id] == SortIdUnexists) {
 				logPrintf(
 					LogError,
@@ -158,23 +159,39 @@ void IndexOrdered<T>::MakeSortOrders(UpdateSortedContext &ctx) {
 				assert(0);
 			}
 			if (ids2Sorts[id] == SortIdUnfilled) {
-				ids2Sorts[id] = idx;
-				this->sortOrders_[idx++] = id;
+				ids2Sorts[id] = idx * gap;
+				this->sortOrders_[idx++ * gap] = id;
 			}
-		}
+		});
 	}
 	// fill unexist indexs
 
 	for (auto it = ids2Sorts.begin(); it != ids2Sorts.end(); ++it) {
 		if (*it == SortIdUnfilled) {
-			*it = idx;
-			this->sortOrders_[idx++] = it - ids2Sorts.begin();
+			*it = idx * gap;
+			this->sortOrders_[idx++ * gap] = it - ids2Sorts.begin();
 		}
 	}
 
 	assertf(idx == totalIds, "Internal error: Index %s is broken. totalids=%d, but indexed=%d\n", this->name_, totalIds, idx);
 }
 
+template <typename T>
+bool IndexOrdered<T>::GetSortPositionBounds(const Variant &key, IdType pos, IdType &left, IdType &right) const {
+	auto keyIt = this->idx_map.find(static_cast<ref_type>(key));
+	assertf(keyIt != this->idx_map.end(), "Key '%s' is not found in index '%s'", key.As<string>(), this->name_);
+	left = kSortOrdersHole;
+	right = std::numeric_limits<IdType>::max();
+	if (keyIt != this->idx_map.begin()) left = std::prev(keyIt)->second.Unsorted().SortedBack(this->sortId_);
+	auto nextIt = std::next(keyIt);
+	if (nextIt != this->idx_map.end()) right = nextIt->second.Unsorted().SortedFront(this->sortId_);
+	if (pos > left && pos < right) return true;
+
+	// Item is placed after other items with the same key
+	left = std::max(left, keyIt->second.Unsorted().SortedBack(this->sortId_, pos));
+	return false;
+}
+
 template <typename T>
 Index *IndexOrdered<T>::Clone() {
 	return new IndexOrdered<T>(*this);
@@ -69,7 +69,7 @@ SelectKeyResults IndexStore<T>::SelectKey(const VariantArray &keys, CondType con
 		throw Error(errParams, "The 'NOT NULL' condition is suported only by 'sparse' or 'array' indexes");
 
 	res.comparators_.push_back(Comparator(condition, KeyType(), keys, opts_.IsArray(), sopts.distinct, payloadType_, fields_,
-										  idx_data.size() ? idx_data.data() : nullptr, opts_.collateOpts_));
+										  idx_data.size() ? idx_data.data() : nullptr, idx_data.size(), opts_.collateOpts_));
 	return SelectKeyResults(res);
 }
 
@@ -1,11 +1,14 @@
 ﻿#include "fastindextext.h"
+#include <algorithm>
 #include <chrono>
+#include <climits>
 #include <memory>
 #include <thread>
 #include "core/ft/bm25.h"
 #include "core/ft/ft_fast/selecter.h"
 #include "core/ft/numtotext.h"
 #include "tools/logger.h"
+#include "tools/serializer.h"
 
 namespace reindexer {
 using std::pair;
@@ -16,6 +19,12 @@ using std::chrono::milliseconds;
 using std::chrono::high_resolution_clock;
 using std::make_shared;
 
+// Version of saved fulltext state format. Has to be incremented on any change of DataHolder structures
+const uint32_t kFtStateVersion = 1;
+
+// Empty config is stored as '{}' in namespace index definitions
+static string_view stateConfig(const string &config) { return config.empty() ? string_view("{}") : string_view(config); }
+
 template <typename T>
 Index *FastIndexText<T>::Clone() {
 	return new FastIndexText<T>(*this);
@@ -23,7 +32,7 @@ Index *FastIndexText<T>::Clone() {
 
 template <typename T>
 Variant FastIndexText<T>::Upsert(const Variant &key, IdType id) {
-	this->isBuilt_ = false;
+	this->markOutdated();
 	if (key.Type() == KeyValueNull) {
 		this->empty_ids_.Unsorted().Add(id, IdSet::Auto, 0);
 		// Return invalid ref
@@ -51,7 +60,7 @@ Variant FastIndexText<T>::Upsert(const Variant &key, IdType id) {
 
 template <typename T>
 void FastIndexText<T>::Delete(const Variant &key, IdType id) {
-	this->isBuilt_ = false;
+	this->markOutdated();
 	int delcnt = 0;
 	if (key.Type() == KeyValueNull) {
 		delcnt = this->empty_ids_.Unsorted().Erase(id);
@@ -75,6 +84,8 @@ void FastIndexText<T>::Delete(const Variant &key, IdType id) {
 			assert(keyIt->second.VDocID() < int(this->holder_.vdocs_.size()));
 			this->holder_.vdocs_[keyIt->second.VDocID()].keyEntry = nullptr;
 		}
+		// Key entry may be already referenced by the new generation of data
+		if (rebuildPending_) deletedDuringRebuild_.emplace_back(keyIt->second.get(), keyIt->second.VDocID());
 		this->idx_map.erase(keyIt);
 	} else {
 		this->addMemStat(keyIt);
@@ -87,7 +98,8 @@ void FastIndexText<T>::Delete(const Variant &key, IdType id) {
 
 template <typename T>
 IndexMemStat FastIndexText<T>::GetMemStat() {
-	auto ret = IndexUnordered<T>::GetMemStat();
+	auto ret = IndexText<T>::GetMemStat();
+	shared_lock<typename IndexText<T>::Mutex> lck(this->mtx_);
 	ret.fulltextSize = this->holder_.GetMemStat();
 	if (this->cache_ft_) ret.idsetCache = this->cache_ft_->GetMemStat();
 	return ret;
@@ -158,20 +170,25 @@ IdSet::Ptr FastIndexText<T>::Select(FtCtx::Ptr fctx, FtDSLQuery &dsl) {
 }
 template <typename T>
 void FastIndexText<T>::commitFulltext() {
-	this->holder_.StartCommit(this->tracker_.isCompleteUpdated());
+	std::unique_lock<typename IndexText<T>::Mutex> lck(this->mtx_);
+	auto &holder = this->holder_;
+	const bool completeUpdated = this->tracker_.isCompleteUpdated();
+	holder.StartCommit(completeUpdated);
 
 	auto tm0 = high_resolution_clock::now();
 
-	if (this->holder_.status_ == FullRebuild) {
-		BuildVdocs(this->idx_map);
+	if (holder.status_ == FullRebuild) {
+		BuildVdocs(holder, this->idx_map, nullptr);
 	} else {
-		BuildVdocs(this->tracker_.updated());
+		BuildVdocs(holder, this->tracker_.updated(), nullptr);
 	}
+	bindVdocs(holder, holder.vodcsOffset_);
 	auto tm1 = high_resolution_clock::now();
+	stateSaved_ = false;
 
-	DataProcessor dp(this->holder_, this->fields_.size());
+	DataProcessor dp(holder, this->fields_.size());
 	dp.Process(!this->opts_.IsDense());
-	if (this->holder_.NeedClear(this->tracker_.isCompleteUpdated())) {
+	if (holder.NeedClear(completeUpdated)) {
 		this->tracker_.clear();
 	}
 	auto tm2 = high_resolution_clock::now();
@@ -181,6 +198,206 @@ void FastIndexText<T>::commitFulltext() {
 			  duration_cast<milliseconds>(tm2 - tm1).count());
 }
 
+template <typename T>
+std::unique_ptr<typename IndexText<T>::Rebuild> FastIndexText<T>::prepareRebuild() {
+	auto tm0 = high_resolution_clock::now();
+	FastRebuild *rebuild = new FastRebuild(*GetConfig(), this->fields_.size(), !this->opts_.IsDense());
+	std::unique_ptr<typename IndexText<T>::Rebuild> ret(rebuild);
+	auto &holder = rebuild->holder;
+	rebuild->startMs = this->nowMs();
+	rebuild->updatesCount = this->updatesCount_;
+	rebuild->completeUpdated = this->tracker_.isCompleteUpdated();
+	{
+		shared_lock<typename IndexText<T>::Mutex> lck(this->mtx_);
+		rebuild->generation = this->generation_;
+		// Incremental commit starts from the current data
+		if (!this->holder_.NeedRebuild(rebuild->completeUpdated)) holder.CopyFrom(this->holder_);
+	}
+	holder.StartCommit(rebuild->completeUpdated);
+
+	auto &tracked = this->tracker_.updated();
+	rebuild->trackedKeys.assign(tracked.begin(), tracked.end());
+	if (holder.status_ == FullRebuild) {
+		BuildVdocs(holder, this->idx_map, &rebuild->keys);
+	} else {
+		BuildVdocs(holder, tracked, &rebuild->keys);
+	}
+	rebuildPending_ = true;
+	deletedDuringRebuild_.clear();
+
+	logPrintf(LogInfo, "FastIndexText::prepareRebuild elapsed %d ms, %d new vdocs",
+			  duration_cast<milliseconds>(high_resolution_clock::now() - tm0).count(), rebuild->keys.size());
+	return ret;
+}
+
+template <typename T>
+void FastIndexText<T>::FastRebuild::Build() {
+	auto tm0 = high_resolution_clock::now();
+	DataProcessor dp(holder, fieldsCount);
+	dp.Process(multithread);
+	clearTracker = holder.NeedClear(completeUpdated);
+	logPrintf(LogInfo, "FastIndexText::Rebuild elapsed %d ms", duration_cast<milliseconds>(high_resolution_clock::now() - tm0).count());
+}
+
+template <typename T>
+void FastIndexText<T>::applyRebuild(typename IndexText<T>::Rebuild &rb) {
+	auto &rebuild = static_cast<FastRebuild &>(rb);
+	auto &holder = rebuild.holder;
+
+	// Vdocs before offset are copied from the current data, and the others are new
+	const size_t offset = holder.vodcsOffset_;
+	std::sort(deletedDuringRebuild_.begin(), deletedDuringRebuild_.end());
+	for (auto &deleted : deletedDuringRebuild_) {
+		if (deleted.second != FtKeyEntryData::ndoc && size_t(deleted.second) < offset) holder.vdocs_[deleted.second].keyEntry = nullptr;
+	}
+	for (size_t i = offset; i < holder.vdocs_.size(); ++i) {
+		auto &vdoc = holder.vdocs_[i];
+		if (!vdoc.keyEntry) continue;
+		auto it = std::lower_bound(deletedDuringRebuild_.begin(), deletedDuringRebuild_.end(), std::make_pair(vdoc.keyEntry, INT_MIN));
+		if (it != deletedDuringRebuild_.end() && it->first == vdoc.keyEntry) vdoc.keyEntry = nullptr;
+	}
+	bindVdocs(holder, offset);
+	rebuildPending_ = false;
+	deletedDuringRebuild_.clear();
+
+	holder.searchers_ = std::move(this->holder_.searchers_);
+	holder.stemmers_ = std::move(this->holder_.stemmers_);
+	std::swap(this->holder_, holder);
+	this->holder_.SetConfig(GetConfig());
+	stateSaved_ = false;
+
+	if (!rebuild.clearTracker) return;
+	if (rebuild.updatesCount == this->updatesCount_) {
+		this->tracker_.clear();
+	} else if (!rebuild.completeUpdated) {
+		// Keys, which were updated during build, are committed by the next one
+		for (auto &key : rebuild.trackedKeys) this->tracker_.updated().erase(key);
+	}
+}
+
+template <typename T>
+void FastIndexText<T>::bindVdocs(DataHolder &holder, size_t from) {
+	for (size_t i = from; i < holder.vdocs_.size(); ++i) {
+		// Key entries are owned by index, holder only references them
+		if (holder.vdocs_[i].keyEntry) const_cast<FtKeyEntryData *>(holder.vdocs_[i].keyEntry)->VDocID() = i;
+	}
+}
+
+template <typename T>
+std::unique_ptr<Index::SavedState> FastIndexText<T>::SaveState() {
+	// Key entries are rebound to vdocs during build
+	std::lock_guard<std::mutex> buildLck(this->buildMtx_);
+	shared_lock<typename IndexText<T>::Mutex> lck(this->mtx_);
+	if (!this->isBuilt_ || stateSaved_) return nullptr;
+
+	auto tm0 = high_resolution_clock::now();
+	FastState *state = new FastState;
+	std::unique_ptr<Index::SavedState> ret(state);
+	state->keys.reserve(this->idx_map.size());
+	for (auto &keyIt : this->idx_map) {
+		if (keyIt.second.VDocID() == FtKeyEntryData::ndoc) return nullptr;
+		state->keys.emplace_back(keyIt.second.VDocID(), docHash(keyIt.first));
+	}
+	state->config = string(stateConfig(this->opts_.config));
+	state->fieldsCount = this->fields_.size();
+	state->holder.CopyFrom(this->holder_);
+	stateSaved_ = true;
+
+	logPrintf(LogInfo, "FastIndexText::SaveState '%s' elapsed %d ms, %d vdocs", this->name_,
+			  duration_cast<milliseconds>(high_resolution_clock::now() - tm0).count(), state->holder.vdocs_.size());
+	return ret;
+}
+
+template <typename T>
+void FastIndexText<T>::FastState::Serialize(WrSerializer &ser) const {
+	ser.PutUInt32(kFtStateVersion);
+	ser.PutVString(config);
+	ser.PutVarUint(fieldsCount);
+	holder.Serialize(ser);
+	ser.PutVarUint(keys.size());
+	for (auto &key : keys) {
+		ser.PutVarUint(key.first);
+		ser.PutUInt64(key.second);
+	}
+}
+
+template <typename T>
+bool FastIndexText<T>::LoadState(string_view data) {
+	std::lock_guard<std::mutex> buildLck(this->buildMtx_);
+	std::unique_lock<typename IndexText<T>::Mutex> lck(this->mtx_);
+	auto tm0 = high_resolution_clock::now();
+	bool loaded = false;
+	try {
+		Serializer ser(data);
+		loaded = loadState(ser);
+	} catch (const Error &err) {
+		logPrintf(LogError, "Error loading fulltext state of '%s': %s", this->name_, err.what());
+	} catch (const std::exception &e) {
+		logPrintf(LogError, "Error loading fulltext state of '%s': %s", this->name_, e.what());
+	}
+	this->outdatedSinceMs_ = 0;
+	++this->generation_;
+	if (!loaded) {
+		// It will be rebuilt on next search
+		this->holder_.status_ = FullRebuild;
+		this->holder_.Clear();
+		return false;
+	}
+
+	this->isBuilt_ = true;
+	stateSaved_ = true;
+	this->tracker_.clear();
+	this->cache_ft_->Clear();
+	logPrintf(LogInfo, "FastIndexText::LoadState '%s' elapsed %d ms, %d vdocs", this->name_,
+			  duration_cast<milliseconds>(high_resolution_clock::now() - tm0).count(), this->holder_.vdocs_.size());
+	return true;
+}
+
+template <typename T>
+bool FastIndexText<T>::loadState(Serializer &ser) {
+	if (ser.GetUInt32() != kFtStateVersion || ser.GetVString() != stateConfig(this->opts_.config) ||
+		ser.GetVarUint() != this->fields_.size()) {
+		return false;
+	}
+	auto &holder = this->holder_;
+	holder.Deserialize(ser);
+
+	const size_t keysCount = ser.GetVarUint();
+	if (keysCount != this->idx_map.size()) return false;
+	fast_hash_map<uint64_t, int> vdocByHash;
+	vdocByHash.reserve(keysCount);
+	for (size_t i = 0; i < keysCount; ++i) {
+		const size_t vdocId = ser.GetVarUint();
+		if (vdocId >= holder.vdocs_.size()) return false;
+		if (!vdocByHash.emplace(ser.GetUInt64(), int(vdocId)).second) return false;
+	}
+	if (!ser.Eof()) return false;
+
+	for (auto &keyIt : this->idx_map) {
+		auto it = vdocByHash.find(docHash(keyIt.first));
+		if (it == vdocByHash.end()) return false;
+		auto &vdoc = holder.vdocs_[it->second];
+		if (vdoc.keyEntry) return false;
+		vdoc.keyEntry = keyIt.second.get();
+		keyIt.second.VDocID() = it->second;
+	}
+	return true;
+}
+
+template <typename T>
+uint64_t FastIndexText<T>::docHash(const typename T::key_type &key) {
+	// FNV-1a hash of fields numbers and texts
+	const uint64_t kPrime = 1099511628211ULL;
+	uint64_t hash = 14695981039346656037ULL;
+	vector<unique_ptr<string>> bufStrs;
+	for (auto &field : this->Getter().getDocFields(key, bufStrs)) {
+		hash = (hash ^ field.second) * kPrime;
+		for (char c : field.first) hash = (hash ^ uint8_t(c)) * kPrime;
+		hash = (hash ^ 0xFF) * kPrime;
+	}
+	return hash;
+}
+
 // hack wothout c++14
 template <typename Map>
 typename Map::iterator get(Map & /*data*/, typename Map::iterator it) {
@@ -195,33 +412,34 @@ typename Map::iterator get(Map &data, typename UpdateTracker<Map>::hash_map::ite
 
 template <typename T>
 template <class Container>
-void FastIndexText<T>::BuildVdocs(Container &data) {
+void FastIndexText<T>::BuildVdocs(DataHolder &holder, Container &data, vector<typename T::key_type> *keys) {
 	// buffer strings, for printing non text fields
-	auto &bufStrs = this->holder_.bufStrs_;
+	auto &bufStrs = holder.bufStrs_;
 	// array with pointers to docs fields text
 	// Prepare vdocs -> addresable array all docs in the index
 
-	this->holder_.szCnt = 0;
-	auto &vdocs = this->holder_.vdocs_;
-	auto &vdocsTexts = this->holder_.vdocsTexts;
+	holder.szCnt = 0;
+	auto &vdocs = holder.vdocs_;
+	auto &vdocsTexts = holder.vdocsTexts;
 
 	vdocs.reserve(vdocs.size() + data.size());
 	vdocsTexts.reserve(data.size());
+	if (keys) keys->reserve(data.size());
 
 	auto gt = this->Getter();
 
-	auto status = this->holder_.status_;
+	auto status = holder.status_;
 
 	if (status == CreateNew) {
-		this->holder_.cur_vdoc_pos_ = vdocs.size();
+		holder.cur_vdoc_pos_ = vdocs.size();
 	} else if (status == RecommitLast) {
-		vdocs.erase(vdocs.begin() + this->holder_.cur_vdoc_pos_, vdocs.end());
+		vdocs.erase(vdocs.begin() + holder.cur_vdoc_pos_, vdocs.end());
 	}
-	this->holder_.vodcsOffset_ = vdocs.size();
+	holder.vodcsOffset_ = vdocs.size();
 
 	for (auto it = data.begin(); it != data.end(); it++) {
 		auto doc = get(this->idx_map, it);
-		doc->second.VDocID() = vdocs.size();
+		if (keys) keys->push_back(doc->first);
 		vdocsTexts.emplace_back(gt.getDocFields(doc->first, bufStrs));
 
 #ifdef REINDEX_FT_EXTRA_DEBUG
@@ -232,14 +450,19 @@ void FastIndexText<T>::BuildVdocs(Container &data) {
 #endif
 
 		if (GetConfig()->logLevel <= LogInfo) {
-			for (auto &f : vdocsTexts.back()) this->holder_.szCnt += f.first.length();
+			for (auto &f : vdocsTexts.back()) holder.szCnt += f.first.length();
 		}
 	}
 	if (status == FullRebuild) {
-		this->holder_.cur_vdoc_pos_ = vdocs.size();
+		holder.cur_vdoc_pos_ = vdocs.size();
 	}
 }
 
+template <typename T>
+int64_t FastIndexText<T>::maxOutdatedMs() const {
+	return GetConfig()->maxRebuildStalenessMs;
+}
+
 template <typename T>
 FtFastConfig *FastIndexText<T>::GetConfig() const {
 	return dynamic_cast<FtFastConfig *>(this->cfg_.get());
@@ -271,6 +494,9 @@ void FastIndexText<T>::SetOpts(const IndexOpts &opts) {
 		oldCfg.enableNumbersSearch != newCfg.enableNumbersSearch || oldCfg.extraWordSymbols != newCfg.extraWordSymbols) {
 		logPrintf(LogInfo, "FulltextIndex config changed, it will be febuilt on next search");
 		this->isBuilt_ = false;
+		this->outdatedSinceMs_ = 0;
+		// Generation, which may be built now, is dropped
+		++this->generation_;
 		this->holder_.status_ = FullRebuild;
 		this->holder_.Clear();
 		this->cache_ft_->Clear();
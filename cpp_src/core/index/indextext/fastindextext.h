@@ -26,15 +26,66 @@ public:
 	Variant Upsert(const Variant& key, IdType id) override final;
 	void Delete(const Variant& key, IdType id) override final;
 	void SetOpts(const IndexOpts& opts) override final;
+	std::unique_ptr<Index::SavedState> SaveState() override final;
+	bool LoadState(string_view data) override final;
 
 protected:
 	FtFastConfig* GetConfig() const;
 	void CreateConfig(const FtFastConfig* cfg = nullptr);
+	bool loadState(Serializer& ser);
+	// Hash of document texts, which identifies key entry in saved state
+	uint64_t docHash(const typename T::key_type& key);
 
+	// New generation of data. It has own copy of config, since config of index may be changed during build
+	class FastRebuild : public IndexText<T>::Rebuild {
+	public:
+		FastRebuild(const FtFastConfig& config, size_t fields, bool multi) : cfg(config), fieldsCount(fields), multithread(multi) {
+			holder.SetConfig(&cfg);
+		}
+		void Build() override;
+
+		FtFastConfig cfg;
+		DataHolder holder;
+		size_t fieldsCount;
+		bool multithread;
+		bool completeUpdated = false;
+		// Set by Build, if keys of update tracker were commited
+		bool clearTracker = false;
+		// Keys of the new vdocs. Texts of vdocs, which are referenced by holder, are alive until build is done
+		vector<typename T::key_type> keys;
+		// Keys of update tracker at the beginning of rebuild
+		vector<typename T::key_type> trackedKeys;
+	};
+
+	// Copy of built data to save. Commit steps are shared with the index data, since they are immutable
+	class FastState : public Index::SavedState {
+	public:
+		void Serialize(WrSerializer& ser) const override;
+
+		string config;
+		size_t fieldsCount = 0;
+		DataHolder holder;
+		// vdocs are bound to key entries by hash of documents texts: vdoc id and hash for each key
+		vector<pair<int, uint64_t>> keys;
+	};
+
+	int64_t maxOutdatedMs() const override final;
+	std::unique_ptr<typename IndexText<T>::Rebuild> prepareRebuild() override final;
+	void applyRebuild(typename IndexText<T>::Rebuild& rebuild) override final;
+	// Builds vdocs of data. Keys of vdocs are added to keys, if it's not nullptr
 	template <class Data>
-	void BuildVdocs(Data& data);
+	void BuildVdocs(DataHolder& holder, Data& data, vector<typename T::key_type>* keys);
+	// Binds key entries of vdocs of holder, starting from position from, to their vdocs
+	void bindVdocs(DataHolder& holder, size_t from);
 
 	void initSearchers();
+
+	// Set, when built data was saved to storage, and was not changed after that
+	bool stateSaved_ = false;
+	// Set, while new generation is built without namespace lock
+	bool rebuildPending_ = false;
+	// Key entries, deleted while new generation was built, with their vdocs in the current data
+	vector<pair<const FtKeyEntryData*, int>> deletedDuringRebuild_;
 };
 
 Index* FastIndexText_New(const IndexDef& idef, const PayloadType payloadType, const FieldsSet& fields);
@@ -40,6 +40,7 @@ IdSet::Ptr FuzzyIndexText<T>::Select(FtCtx::Ptr fctx, FtDSLQuery& dsl) {
 
 template <typename T>
 void FuzzyIndexText<T>::commitFulltext() {
+	std::unique_lock<typename IndexText<T>::Mutex> lck(this->mtx_);
 	this->cache_ft_->Clear();
 	vector<unique_ptr<string>> bufStrs;
 	auto gt = this->Getter();
@@ -24,11 +24,11 @@ public:
 	IdSet::Ptr Select(FtCtx::Ptr fctx, FtDSLQuery& dsl) override final;
 	void commitFulltext() override final;
 	Variant Upsert(const Variant& key, IdType id) override final {
-		this->isBuilt_ = false;
+		this->markOutdated();
 		return IndexText<T>::Upsert(key, id);
 	}
 	void Delete(const Variant& key, IdType id) override final {
-		this->isBuilt_ = false;
+		this->markOutdated();
 		IndexText<T>::Delete(key, id);
 	}
 
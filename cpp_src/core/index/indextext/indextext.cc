@@ -1,5 +1,6 @@
 
 #include "indextext.h"
+#include <chrono>
 #include <memory>
 #include "core/ft/ft_fuzzy/searchers/kblayout.h"
 #include "core/ft/ft_fuzzy/searchers/translit.h"
@@ -108,15 +109,11 @@ SelectKeyResults IndexText<T>::SelectKey(const VariantArray &keys, CondType cond
 	dsl.parse(keys[0].As<string>());
 
 	smart_lock<Mutex> lck(mtx_, rdxCtx);
-	if (!isBuilt_) {
-		// non atomic upgrade mutex to unique
+	if (!isBuilt_ && !canSelectOutdated()) {
 		lck.unlock();
-		lck = smart_lock<Mutex>(mtx_, rdxCtx, true);
-		if (!isBuilt_) {
-			commitFulltext();
-			need_put = false;
-			isBuilt_ = true;
-		}
+		build();
+		need_put = false;
+		lck = smart_lock<Mutex>(mtx_, rdxCtx);
 	}
 
 	auto mergedIds = Select(ftctx, dsl);
@@ -129,6 +126,89 @@ SelectKeyResults IndexText<T>::SelectKey(const VariantArray &keys, CondType cond
 	return r;
 }
 
+template <typename T>
+std::unique_ptr<Index::OutdatedRebuild> IndexText<T>::PrepareRebuild() {
+	const int64_t maxOutdated = maxOutdatedMs();
+	if (!maxOutdated) return nullptr;
+	std::lock_guard<std::mutex> buildLck(buildMtx_);
+	{
+		shared_lock<Mutex> lck(mtx_);
+		// Data is rebuilt in background, when it's outdated for half of allowed time, so selects are rarely waiting for rebuild
+		if (isBuilt_ || !outdatedSinceMs_ || nowMs() - outdatedSinceMs_ < maxOutdated / 2) return nullptr;
+	}
+	return prepareRebuild();
+}
+
+template <typename T>
+void IndexText<T>::ApplyRebuild(Index::OutdatedRebuild &rebuild) {
+	auto &r = static_cast<Rebuild &>(rebuild);
+	std::lock_guard<std::mutex> buildLck(buildMtx_);
+	std::unique_lock<Mutex> lck(mtx_);
+	// Data was rebuilt by select, or replaced, while this generation was built
+	if (r.generation != generation_) return;
+	applyRebuild(r);
+	const bool updated = (r.updatesCount != updatesCount_);
+	finishBuild(r.startMs);
+	if (updated) {
+		isBuilt_ = false;
+		outdatedSinceMs_ = r.startMs;
+	}
+}
+
+template <typename T>
+void IndexText<T>::build() {
+	std::lock_guard<std::mutex> buildLck(buildMtx_);
+	{
+		shared_lock<Mutex> lck(mtx_);
+		if (isBuilt_) return;
+	}
+
+	// Select is holding namespace lock, so index can't be updated during build
+	auto rebuild = maxOutdatedMs() ? prepareRebuild() : nullptr;
+	if (rebuild) {
+		rebuild->Build();
+		std::unique_lock<Mutex> lck(mtx_);
+		applyRebuild(*rebuild);
+		finishBuild(rebuild->startMs);
+		return;
+	}
+
+	const int64_t startMs = nowMs();
+	commitFulltext();
+	std::unique_lock<Mutex> lck(mtx_);
+	finishBuild(startMs);
+}
+
+template <typename T>
+void IndexText<T>::finishBuild(int64_t startMs) {
+	isBuilt_ = true;
+	outdatedSinceMs_ = 0;
+	lastBuildTimeMs_ = nowMs() - startMs;
+	++generation_;
+	cache_ft_->Clear();
+}
+
+template <typename T>
+bool IndexText<T>::canSelectOutdated() const {
+	const int64_t maxOutdated = maxOutdatedMs();
+	return maxOutdated && outdatedSinceMs_ && nowMs() - outdatedSinceMs_ <= maxOutdated;
+}
+
+template <typename T>
+int64_t IndexText<T>::nowMs() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename T>
+IndexMemStat IndexText<T>::GetMemStat() {
+	auto ret = IndexUnordered<T>::GetMemStat();
+	shared_lock<Mutex> lck(mtx_);
+	ret.fulltextBuildTimeMs = lastBuildTimeMs_;
+	ret.fulltextGeneration = generation_;
+	if (!isBuilt_ && outdatedSinceMs_) ret.fulltextGenerationLagMs = nowMs() - outdatedSinceMs_;
+	return ret;
+}
+
 template <typename T>
 FieldsGetter IndexText<T>::Getter() {
 	return FieldsGetter(this->fields_, this->payloadType_, this->KeyType());
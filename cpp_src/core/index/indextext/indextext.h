@@ -31,14 +31,51 @@ public:
 	virtual IdSet::Ptr Select(FtCtx::Ptr fctx, FtDSLQuery& dsl) = 0;
 	void SetOpts(const IndexOpts& opts) override;
 	void Commit() override final;
+	std::unique_ptr<Index::OutdatedRebuild> PrepareRebuild() override final;
+	void ApplyRebuild(Index::OutdatedRebuild& rebuild) override final;
+	IndexMemStat GetMemStat() override;
+	// Builds fulltext data in place. It's called without lock of mtx_, so implementation has to lock it exclusively to modify data used by
+	// selects
 	virtual void commitFulltext() = 0;
 	void SetSortedIdxCount(int) override final{};
+	// Fulltext idsets don't hold sort orders
+	void SetSortPositions(SortPositions*) override final {}
+	void MoveSortPosition(const VariantArray&, SortType, IdType, IdType) override final {}
 
 protected:
 	using Mutex = MarkedMutex<shared_timed_mutex, MutexMark::IndexText>;
 
+	// New generation of data, which is built aside of the current one
+	class Rebuild : public Index::OutdatedRebuild {
+	public:
+		// Generation of data and count of updates at the beginning of rebuild
+		uint64_t generation = 0;
+		uint64_t updatesCount = 0;
+		int64_t startMs = 0;
+	};
+	// Prepares new generation of data. Called under namespace lock and buildMtx_. Returns nullptr, if generations are not supported
+	virtual std::unique_ptr<Rebuild> prepareRebuild() { return nullptr; }
+	// Swaps built generation with the current data. Called under namespace lock, buildMtx_ and exclusive lock of mtx_
+	virtual void applyRebuild(Rebuild&) {}
+
 	void initSearchers();
 	FieldsGetter Getter();
+	// Builds fulltext data, if it's not built yet. Concurrent builds are serialized by buildMtx_
+	void build();
+	// Updates state after build of data. Called under exclusive lock of mtx_
+	void finishBuild(int64_t startMs);
+	// Marks built data as outdated. Outdated data still may be used by selects during maxOutdatedMs()
+	void markOutdated() {
+		++updatesCount_;
+		if (isBuilt_) {
+			isBuilt_ = false;
+			outdatedSinceMs_ = nowMs();
+		}
+	}
+	// Time, during which selects may use outdated data, while it's rebuilt in background. 0 means, that data is rebuilt by select
+	virtual int64_t maxOutdatedMs() const { return 0; }
+	bool canSelectOutdated() const;
+	static int64_t nowMs();
 
 	shared_ptr<FtIdSetCache> cache_ft_;
 	fast_hash_map<string, int> ftFields_;
@@ -46,6 +83,14 @@ protected:
 	DataHolder holder_;
 	Mutex mtx_;
 	bool isBuilt_;
+	std::mutex buildMtx_;
+	// Time of the first update after the last build. 0 if there is no data, which may be used by selects
+	int64_t outdatedSinceMs_ = 0;
+	// Count of updates of index. Updates may happen, while new generation is built without namespace lock
+	uint64_t updatesCount_ = 0;
+	// Build statistics
+	int64_t lastBuildTimeMs_ = 0;
+	uint64_t generation_ = 0;
 };
 
 }  // namespace reindexer
@@ -43,6 +43,7 @@ template <typename T>
 void IndexUnordered<T>::addMemStat(typename T::iterator it) {
 	this->memStat_.idsetPlainSize += sizeof(typename T::value_type) + it->second.Unsorted().heap_size();
 	this->memStat_.idsetBTreeSize += it->second.Unsorted().BTreeSize();
+	this->memStat_.idsetBitmapSize += it->second.Unsorted().BitmapSize();
 	this->memStat_.dataSize += heap_size(it->first);
 }
 
@@ -50,6 +51,7 @@ template <typename T>
 void IndexUnordered<T>::delMemStat(typename T::iterator it) {
 	this->memStat_.idsetPlainSize -= sizeof(typename T::value_type) + it->second.Unsorted().heap_size();
 	this->memStat_.idsetBTreeSize -= it->second.Unsorted().BTreeSize();
+	this->memStat_.idsetBitmapSize -= it->second.Unsorted().BitmapSize();
 	this->memStat_.dataSize -= heap_size(it->first);
 }
 
@@ -58,7 +60,7 @@ Variant IndexUnordered<T>::Upsert(const Variant &key, IdType id) {
 	// reset cache
 	if (cache_) cache_.reset();
 	if (key.Type() == KeyValueNull) {
-		this->empty_ids_.Unsorted().Add(id, IdSet::Auto, this->sortedIdxCount_);
+		addId(this->empty_ids_.Unsorted(), id, IdSet::Auto);
 		// Return invalid ref
 		return Variant();
 	}
@@ -70,7 +72,7 @@ Variant IndexUnordered<T>::Upsert(const Variant &key, IdType id) {
 		delMemStat(keyIt);
 	}
 
-	keyIt->second.Unsorted().Add(id, this->opts_.IsPK() ? IdSet::Ordered : IdSet::Auto, this->sortedIdxCount_);
+	addId(keyIt->second.Unsorted(), id, this->opts_.IsPK() ? IdSet::Ordered : IdSet::Auto);
 	this->tracker_.markUpdated(this->idx_map, keyIt);
 
 	addMemStat(keyIt);
@@ -87,7 +89,7 @@ void IndexUnordered<T>::Delete(const Variant &key, IdType id) {
 	if (cache_) cache_.reset();
 	int delcnt = 0;
 	if (key.Type() == KeyValueNull) {
-		delcnt = this->empty_ids_.Unsorted().Erase(id);
+		delcnt = eraseId(this->empty_ids_.Unsorted(), id);
 		assert(delcnt);
 		return;
 	}
@@ -96,7 +98,7 @@ void IndexUnordered<T>::Delete(const Variant &key, IdType id) {
 	if (keyIt == idx_map.end()) return;
 
 	delMemStat(keyIt);
-	delcnt = keyIt->second.Unsorted().Erase(id);
+	delcnt = eraseId(keyIt->second.Unsorted(), id);
 	(void)delcnt;
 	// TODO: we have to implement removal of composite indexes (doesn't work right now)
 	assertf(this->opts_.IsArray() || this->Opts().IsSparse() || delcnt, "Delete unexists id from index '%s' id=%d,key=%s", this->name_, id,
@@ -216,7 +218,9 @@ SelectKeyResults IndexUnordered<T>::SelectKey(const VariantArray &keys, CondType
 
 template <typename T>
 void IndexUnordered<T>::Commit() {
-	this->empty_ids_.Unsorted().Commit();
+	// Bitmap idsets can't be iterated by btree index iterators
+	const bool allowBitmap = !this->IsOrdered();
+	this->empty_ids_.Unsorted().Commit(allowBitmap, this->sortedIdxCount_);
 
 	if (!cache_) cache_.reset(new IdSetCache());
 
@@ -225,13 +229,16 @@ void IndexUnordered<T>::Commit() {
 	logPrintf(LogTrace, "IndexUnordered::Commit (%s) %d uniq keys, %d empty, %s", this->name_, this->idx_map.size(),
 			  this->empty_ids_.Unsorted().size(), tracker_.isCompleteUpdated() ? "complete" : "partial");
 
+	auto commitKey = [this, allowBitmap](typename T::iterator keyIt) {
+		delMemStat(keyIt);
+		keyIt->second.Unsorted().Commit(allowBitmap, this->sortedIdxCount_);
+		assert(keyIt->second.Unsorted().size());
+		addMemStat(keyIt);
+	};
 	if (tracker_.isCompleteUpdated()) {
-		for (auto &keyIt : this->idx_map) {
-			keyIt.second.Unsorted().Commit();
-			assert(keyIt.second.Unsorted().size());
-		}
+		for (auto keyIt = this->idx_map.begin(); keyIt != this->idx_map.end(); ++keyIt) commitKey(keyIt);
 	} else {
-		tracker_.commitUpdated(idx_map);
+		tracker_.commitUpdated(idx_map, commitKey);
 	}
 	tracker_.clear();
 }
@@ -240,9 +247,11 @@ template <typename T>
 void IndexUnordered<T>::UpdateSortedIds(const UpdateSortedContext &ctx) {
 	logPrintf(LogTrace, "IndexUnordered::UpdateSortedIds (%s) %d uniq keys, %d empty", this->name_, this->idx_map.size(),
 			  this->empty_ids_.Unsorted().size());
-	// For all keys in index
-	for (auto &keyIt : this->idx_map) {
-		keyIt.second.UpdateSortedIds(ctx);
+	// For all keys in index. Sort orders change memory size of idsets
+	for (auto keyIt = this->idx_map.begin(); keyIt != this->idx_map.end(); ++keyIt) {
+		delMemStat(keyIt);
+		keyIt->second.UpdateSortedIds(ctx);
+		addMemStat(keyIt);
 	}
 
 	this->empty_ids_.UpdateSortedIds(ctx);
@@ -257,7 +266,30 @@ template <typename T>
 void IndexUnordered<T>::SetSortedIdxCount(int sortedIdxCount) {
 	if (this->sortedIdxCount_ != sortedIdxCount) {
 		this->sortedIdxCount_ = sortedIdxCount;
-		for (auto &keyIt : idx_map) keyIt.second.Unsorted().ReserveForSorted(this->sortedIdxCount_);
+		for (auto keyIt = idx_map.begin(); keyIt != idx_map.end(); ++keyIt) {
+			delMemStat(keyIt);
+			keyIt->second.Unsorted().ReserveForSorted(this->sortedIdxCount_);
+			addMemStat(keyIt);
+		}
+		this->empty_ids_.Unsorted().ReserveForSorted(this->sortedIdxCount_);
+	}
+}
+
+template <typename T>
+void IndexUnordered<T>::MoveSortPosition(const VariantArray &keys, SortType sortId, IdType from, IdType to) {
+	if (cache_) cache_.reset();
+	// Several keys of array may refer to the same idset (e.g. duplicated values), but position has to be moved only once
+	h_vector<const void *, 4> moved;
+	for (const Variant &key : keys) {
+		if (key.Type() == KeyValueNull) {
+			this->empty_ids_.Unsorted().MoveSortPosition(sortId, from, to);
+			continue;
+		}
+		auto keyIt = this->idx_map.find(static_cast<ref_type>(key));
+		assertf(keyIt != this->idx_map.end(), "Key '%s' is not found in index '%s'", key.As<string>(), this->name_);
+		if (std::find(moved.begin(), moved.end(), &keyIt->second) != moved.end()) continue;
+		moved.push_back(&keyIt->second);
+		keyIt->second.Unsorted().MoveSortPosition(sortId, from, to);
 	}
 }
 
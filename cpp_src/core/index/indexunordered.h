@@ -11,6 +11,11 @@ namespace reindexer {
 
 template <typename T>
 class IndexUnordered : public IndexStore<typename T::key_type> {
+	// Sort orders of ids are stored in capacity of idsets beyond their size, so entries must be moved, not copied, on rehash of map
+	static_assert(std::is_nothrow_move_constructible<typename T::key_type>::value &&
+					  std::is_nothrow_move_constructible<typename T::mapped_type>::value,
+				  "Entries of index map must be nothrow movable");
+
 public:
 	using ref_type =
 		typename std::conditional<std::is_same<typename T::key_type, key_string>::value, string_view, typename T::key_type>::type;
@@ -28,8 +33,24 @@ public:
 	IndexMemStat GetMemStat() override;
 	size_t Size() const override final { return idx_map.size(); }
 	void SetSortedIdxCount(int sortedIdxCount) override;
+	void MoveSortPosition(const VariantArray &keys, SortType sortId, IdType from, IdType to) override;
 
 protected:
+	// Add id to idset or erase it. Sort orders of idset are kept actual, while positions of items in sort orders are set.
+	// Sort orders of large idsets are kept in btrees, so update of them costs O(sortedIdxCount * log(size))
+	template <typename IdSetT>
+	void addId(IdSetT &ids, IdType id, IdSet::EditMode editMode) {
+		if (this->sortPositions_) {
+			ids.AddSorted(id, this->sortPositions_->Get(id), this->sortedIdxCount_);
+		} else {
+			ids.Add(id, editMode, this->sortedIdxCount_);
+		}
+	}
+	template <typename IdSetT>
+	int eraseId(IdSetT &ids, IdType id) {
+		return this->sortPositions_ ? ids.EraseSorted(id, this->sortPositions_->Get(id), this->sortedIdxCount_) : ids.Erase(id);
+	}
+
 	void tryIdsetCache(const VariantArray &keys, CondType condition, SortType sortId, std::function<void(SelectKeyResult &)> selector,
 					   SelectKeyResult &res);
 	void addMemStat(typename T::iterator it);
@@ -9,37 +9,77 @@ namespace reindexer {
 
 using std::vector;
 
+// Position in sort orders, which is not occupied by any item
+const IdType kSortOrdersHole = -1;
+
 class UpdateSortedContext {
 public:
 	virtual ~UpdateSortedContext(){};
 	virtual int getSortedIdxCount() const = 0;
 	virtual SortType getCurSortId() const = 0;
+	// Distance between positions of neighbour items in built sort orders. Free positions are used to place updated items
+	virtual int getSortOrdersGap() const = 0;
 	virtual const vector<SortType>& ids2Sorts() const = 0;
 	virtual vector<SortType>& ids2Sorts() = 0;
 };
 
+// Positions of items in built sort orders, which are used to keep sort orders actual on updates of items.
+// Positions of item are stored sequentially for sort ids from 1 to sortedIdxCount
+class SortPositions {
+public:
+	void Reset(int sortedIdxCount, size_t itemsCount) {
+		sortedIdxCount_ = sortedIdxCount;
+		positions_.assign(itemsCount * sortedIdxCount, kSortOrdersHole);
+	}
+	void Clear() {
+		sortedIdxCount_ = 0;
+		positions_.clear();
+		positions_.shrink_to_fit();
+	}
+	void Reserve(size_t itemsCount) {
+		if (positions_.size() < itemsCount * sortedIdxCount_) positions_.resize(itemsCount * sortedIdxCount_, kSortOrdersHole);
+	}
+	bool Empty() const { return !sortedIdxCount_; }
+	int SortedIdxCount() const { return sortedIdxCount_; }
+	const IdType* Get(IdType id) const { return positions_.data() + size_t(id) * sortedIdxCount_; }
+	IdType& At(IdType id, SortType sortId) { return positions_[size_t(id) * sortedIdxCount_ + sortId - 1]; }
+	size_t HeapSize() const { return positions_.capacity() * sizeof(IdType); }
+
+private:
+	int sortedIdxCount_ = 0;
+	vector<IdType> positions_;
+};
+
 template <typename IdSetT>
 class KeyEntry {
 public:
 	IdSetT& Unsorted() { return ids_; }
 	const IdSetT& Unsorted() const { return ids_; }
-	IdSetRef Sorted(unsigned sortId) const {
-		assertf(ids_.capacity() >= (sortId + 1) * ids_.size(), "error ids_.capacity()=%d,sortId=%d,ids_.size()=%d", ids_.capacity(), sortId,
-				ids_.size());
-		return IdSetRef(ids_.data() + sortId * ids_.size(), ids_.size());
-	}
+	IdSetRef Sorted(unsigned sortId) const { return ids_.Sorted(sortId); }
 	void UpdateSortedIds(const UpdateSortedContext& ctx) {
-		ids_.reserve((ctx.getSortedIdxCount() + 1) * ids_.size());
+		ids_.ReserveForSorted(ctx.getSortedIdxCount(), ctx.getSortOrdersGap() > 1);
 		assert(ctx.getCurSortId());
 
+		auto position = [&ctx](IdType rowid) {
+			assertf(rowid < int(ctx.ids2Sorts().size()), "id=%d,ctx.ids2Sorts().size()=%d", rowid, ctx.ids2Sorts().size());
+			return IdType(ctx.ids2Sorts()[rowid]);
+		};
+		// Updatable sort order of large idset is kept in btree
+		if (base_idsetset* sorted = ids_.SortedBTree(ctx.getCurSortId())) {
+			vector<IdType> positions;
+			positions.reserve(ids_.size());
+			ids_.ForEach([&](IdType rowid) { positions.push_back(position(rowid)); });
+			boost::sort::pdqsort(positions.begin(), positions.end());
+			sorted->clear();
+			sorted->insert(positions.begin(), positions.end());
+			return;
+		}
+
 		auto idsAsc = Sorted(ctx.getCurSortId());
 
 		size_t idx = 0;
 		// For all ids of current key
-		for (auto rowid : ids_) {
-			assertf(rowid < int(ctx.ids2Sorts().size()), "id=%d,ctx.ids2Sorts().size()=%d", rowid, ctx.ids2Sorts().size());
-			idsAsc[idx++] = ctx.ids2Sorts()[rowid];
-		}
+		ids_.ForEach([&](IdType rowid) { idsAsc[idx++] = position(rowid); });
 		boost::sort::pdqsort(idsAsc.begin(), idsAsc.end());
 	}
 
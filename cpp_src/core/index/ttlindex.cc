@@ -11,6 +11,11 @@ int64_t TtlIndex<T>::GetTTLValue() const {
 	return expireAfter_;
 }
 
+template <typename T>
+int64_t TtlIndex<T>::GetMinExpirationTime() const {
+	return this->idx_map.empty() ? 0 : this->idx_map.begin()->first + expireAfter_;
+}
+
 Index *TtlIndex_New(const IndexDef &idef, const PayloadType payloadType, const FieldsSet &fields) {
 	if (idef.opts_.IsPK() || idef.opts_.IsDense()) {
 		return new TtlIndex<number_map<int64_t, Index::KeyEntryPlain>>(idef, payloadType, fields);
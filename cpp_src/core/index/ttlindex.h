@@ -12,6 +12,7 @@ class TtlIndex : public IndexOrdered<T> {
 public:
 	TtlIndex(const IndexDef &idef, const PayloadType payloadType, const FieldsSet &fields);
 	int64_t GetTTLValue() const override;
+	int64_t GetMinExpirationTime() const override;
 
 private:
 	/// Expiration value in seconds.
@@ -47,12 +47,12 @@ public:
 		updated_.emplace(k->first);
 	}
 
-	void commitUpdated(T &idx_map) {
+	template <typename F>
+	void commitUpdated(T &idx_map, const F &commit) {
 		for (auto valIt : updated_) {
 			auto keyIt = idx_map.find(valIt);
 			assert(keyIt != idx_map.end());
-			keyIt->second.Unsorted().Commit();
-			assert(keyIt->second.Unsorted().size());
+			commit(keyIt);
 		}
 	}
 
@@ -0,0 +1,344 @@
+#include "core/itemsloader.h"
+#include <algorithm>
+#include <atomic>
+#include "core/index/index.h"
+#include "core/namespace.h"
+#include "tools/logger.h"
+
+namespace reindexer {
+
+constexpr unsigned kLoaderMaxThreads = 8;
+constexpr size_t kLoaderBatchItems = 1024;
+constexpr size_t kLoaderBatchDataSize = 4 * 1024 * 1024;
+
+// Namespaces are loaded concurrently, so threads of all the loaders are limited together
+static std::atomic<int> loaderThreadsLimit{int(std::thread::hardware_concurrency())};
+static std::atomic<int> loaderThreadsUsed{0};
+
+static unsigned acquireLoaderThreads(unsigned count) {
+	int used = loaderThreadsUsed.load(std::memory_order_relaxed);
+	int acquired = 0;
+	do {
+		acquired = std::max(0, std::min(int(count), loaderThreadsLimit.load(std::memory_order_relaxed) - used));
+	} while (!loaderThreadsUsed.compare_exchange_weak(used, used + acquired, std::memory_order_relaxed));
+	return acquired;
+}
+
+static void releaseLoaderThreads(unsigned count) { loaderThreadsUsed.fetch_sub(count, std::memory_order_relaxed); }
+
+void ItemsLoader::SetThreadsLimit(unsigned limit) { loaderThreadsLimit.store(limit, std::memory_order_relaxed); }
+
+void ItemsLoader::Batch::clear() {
+	data.clear();
+	records.clear();
+	lsns.clear();
+	decoded.clear();
+	seq = 0;
+	errCount = 0;
+	lastErr = errOK;
+	maxLSN = -1;
+}
+
+ItemsLoader::ItemsLoader(Namespace &ns) : ns_(ns), payloadType_(ns.payloadType_), tagsMatcher_(ns.tagsMatcher_) {
+	// Each decoder, each index worker except of the calling thread and reader have their own threads
+	threadsAcquired_ = acquireLoaderThreads(2 * kLoaderMaxThreads);
+	unsigned threads = threadsAcquired_ / 2;
+	if (threads < 2) threads = 0;
+	releaseLoaderThreads(threadsAcquired_ - 2 * threads);
+	threadsAcquired_ = 2 * threads;
+	decodersCount_ = (threads > 1) ? threads : 0;
+	indexWorkersCount_ = std::max(1u, std::min(threads, unsigned(ns_.indexes_.firstCompositePos())));
+}
+
+ItemsLoader::~ItemsLoader() {
+	stop();
+	releaseLoaderThreads(threadsAcquired_);
+}
+
+ItemsLoader::Result ItemsLoader::Load(datastorage::Cursor &cursor, string_view upperBound) {
+	Result res;
+	BatchPtr batch(new Batch);
+	bool hasMore = readBatch(cursor, upperBound, *batch);
+	if (!hasMore || !decodersCount_) {
+		// Small namespace or single-threaded mode. There is no need in the pipeline
+		for (;;) {
+			decodeBatch(*batch);
+			insertBatch(*batch, res);
+			if (!hasMore) break;
+			batch->clear();
+			hasMore = readBatch(cursor, upperBound, *batch);
+		}
+		return res;
+	}
+
+	batchesRead_ = 1;
+	decodeQueue_.push_back(std::move(batch));
+	for (unsigned i = 0; i < decodersCount_ + 1; ++i) freeBatches_.emplace_back(new Batch);
+	workersErrors_.resize(indexWorkersCount_);
+	for (unsigned i = 1; i < indexWorkersCount_; ++i) threads_.emplace_back(&ItemsLoader::indexWorkerRoutine, this, i);
+	for (unsigned i = 0; i < decodersCount_; ++i) threads_.emplace_back(&ItemsLoader::decoderRoutine, this);
+	threads_.emplace_back(&ItemsLoader::readerRoutine, this, std::ref(cursor), upperBound);
+
+	for (size_t seq = 0;; ++seq) {
+		BatchPtr ready;
+		{
+			std::unique_lock<std::mutex> lck(mtx_);
+			auto it = decodedBatches_.end();
+			cv_.wait(lck, [&] {
+				it = std::find_if(decodedBatches_.begin(), decodedBatches_.end(), [seq](const BatchPtr &b) { return b->seq == seq; });
+				return it != decodedBatches_.end() || readerError_ || (readerDone_ && seq == batchesRead_);
+			});
+			if (readerError_) std::rethrow_exception(readerError_);
+			if (it == decodedBatches_.end()) break;
+			ready = std::move(*it);
+			decodedBatches_.erase(it);
+		}
+		insertBatch(*ready, res);
+		ready->clear();
+		{
+			std::lock_guard<std::mutex> lck(mtx_);
+			freeBatches_.push_back(std::move(ready));
+		}
+		cv_.notify_all();
+	}
+	stop();
+	return res;
+}
+
+bool ItemsLoader::readBatch(datastorage::Cursor &cursor, string_view upperBound, Batch &batch) {
+	for (; cursor.Valid() && cursor.GetComparator().Compare(cursor.Key(), upperBound) < 0; cursor.Next()) {
+		if (batch.records.size() >= kLoaderBatchItems || batch.data.size() >= kLoaderBatchDataSize) return true;
+
+		string_view dataSlice = cursor.Value();
+		if (dataSlice.empty()) continue;
+		if (dataSlice.size() < sizeof(int64_t)) {
+			batch.lastErr = Error(errParseBin, "Not enougth data in data slice");
+			logPrintf(LogTrace, "Error load item to '%s' from storage: '%s'", ns_.name_, batch.lastErr.what());
+			batch.errCount++;
+			continue;
+		}
+
+		// Read LSN
+		int64_t lsn = *reinterpret_cast<const int64_t *>(dataSlice.data());
+		assert(lsn >= 0);
+		batch.maxLSN = std::max(batch.maxLSN, lsn);
+		dataSlice = dataSlice.substr(sizeof(lsn));
+
+		batch.records.emplace_back(batch.data.size(), dataSlice.size());
+		batch.data.append(dataSlice.data(), dataSlice.size());
+		batch.lsns.push_back(lsn);
+	}
+	return false;
+}
+
+void ItemsLoader::decodeBatch(Batch &batch) {
+	batch.decoded.assign(batch.records.size(), false);
+	while (batch.items.size() < batch.records.size()) {
+		batch.items.emplace_back(new ItemImpl(payloadType_, tagsMatcher_));
+		batch.items.back()->Unsafe(true);
+	}
+
+	for (size_t i = 0; i < batch.records.size(); ++i) {
+		string_view dataSlice(batch.data.data() + batch.records[i].first, batch.records[i].second);
+		Error err;
+		try {
+			err = batch.items[i]->FromCJSON(dataSlice);
+		} catch (const Error &e) {
+			err = e;
+		}
+		if (!err.ok()) {
+			logPrintf(LogTrace, "Error load item to '%s' from storage: '%s'", ns_.name_, err.what());
+			batch.errCount++;
+			batch.lastErr = err;
+			continue;
+		}
+		batch.decoded[i] = true;
+	}
+}
+
+void ItemsLoader::insertBatch(Batch &batch, Result &res) {
+	res.errCount += batch.errCount;
+	if (!batch.lastErr.ok()) res.lastErr = batch.lastErr;
+	res.maxLSN = std::max(res.maxLSN, batch.maxLSN);
+	if (batch.records.empty()) return;
+
+	if (!ns_.pkFields().size()) {
+		throw Error(errLogic, "Can't load data storage of '%s' - there are no PK fields in ns", ns_.name_);
+	}
+
+	ids_.assign(batch.records.size(), -1);
+	for (size_t i = 0; i < batch.records.size(); ++i) {
+		if (!batch.decoded[i]) continue;
+		ItemImpl &item = *batch.items[i];
+		ids_[i] = ns_.items_.size();
+		ns_.items_.emplace_back(PayloadValue(item.GetPayload().RealSize(), *ns_.arena_));
+		// Index workers don't copy header of item's payload, so LSN is set to the stored payload as well
+		ns_.items_[ids_[i]].SetLSN(batch.lsns[i]);
+		item.Value().SetLSN(batch.lsns[i]);
+		res.itemsCount++;
+		res.dataSize += batch.records[i].second;
+	}
+
+	if (threads_.empty() || indexWorkersCount_ < 2) {
+		for (size_t i = 0; i < batch.records.size(); ++i) {
+			if (ids_[i] >= 0) ns_.doUpsert(batch.items[i].get(), ids_[i], false);
+		}
+	} else {
+		insertBatchParallel(batch);
+	}
+}
+
+// Same as Namespace::doUpsert for the new items, but indexes are distributed between index workers
+void ItemsLoader::insertBatchParallel(Batch &batch) {
+	auto &indexes = ns_.indexes_;
+	const int fieldsCount = indexes.firstCompositePos();
+	const size_t itemsCount = batch.records.size();
+	if (fieldsKeys_.size() < itemsCount * fieldsCount) fieldsKeys_.resize(itemsCount * fieldsCount);
+
+	// Upsert fields to dense and sparse indexes
+	runOnIndexWorkers([&](unsigned workerIdx) {
+		VariantArray skrefs;
+		for (int field = workerIdx; field < fieldsCount; field += indexWorkersCount_) {
+			Index &index = *indexes[field];
+			for (size_t i = 0; i < itemsCount; ++i) {
+				if (ids_[i] < 0) continue;
+				Payload plNew = batch.items[i]->GetPayload();
+				Namespace::upsertIndexValues(index, field, plNew, nullptr, ids_[i], skrefs, fieldsKeys_[i * fieldsCount + field]);
+			}
+		}
+	});
+
+	// Put values to payloads. Arrays may reallocate payload, so it's done after all the workers are finished
+	for (size_t i = 0; i < itemsCount; ++i) {
+		if (ids_[i] < 0) continue;
+		Payload pl(ns_.payloadType_, ns_.items_[ids_[i]]);
+		for (int field = 0; field < fieldsCount; ++field) {
+			if (!indexes[field]->Opts().IsSparse()) pl.Set(field, fieldsKeys_[i * fieldsCount + field]);
+		}
+	}
+
+	// Upsert to composite indexes
+	if (indexes.totalSize() > fieldsCount) {
+		runOnIndexWorkers([&](unsigned workerIdx) {
+			for (int field = fieldsCount + workerIdx; field < indexes.totalSize(); field += indexWorkersCount_) {
+				for (size_t i = 0; i < itemsCount; ++i) {
+					if (ids_[i] >= 0) indexes[field]->Upsert(Variant(ns_.items_[ids_[i]]), ids_[i]);
+				}
+			}
+		});
+	}
+
+	for (size_t i = 0; i < itemsCount; ++i) {
+		if (ids_[i] >= 0) ns_.repl_.dataHash ^= Payload(ns_.payloadType_, ns_.items_[ids_[i]]).GetHash();
+	}
+}
+
+void ItemsLoader::runOnIndexWorkers(const std::function<void(unsigned)> &task) {
+	{
+		std::lock_guard<std::mutex> lck(workersMtx_);
+		workersTask_ = &task;
+		workersDone_ = 0;
+		++workersPhase_;
+	}
+	workersCv_.notify_all();
+
+	// Calling thread is the worker #0
+	std::exception_ptr err;
+	try {
+		task(0);
+	} catch (...) {
+		err = std::current_exception();
+	}
+
+	std::unique_lock<std::mutex> lck(workersMtx_);
+	workersCv_.wait(lck, [this] { return workersDone_ == indexWorkersCount_ - 1; });
+	workersTask_ = nullptr;
+	for (auto &workerErr : workersErrors_) {
+		if (!err) err = workerErr;
+		workerErr = nullptr;
+	}
+	if (err) std::rethrow_exception(err);
+}
+
+void ItemsLoader::readerRoutine(datastorage::Cursor &cursor, string_view upperBound) {
+	try {
+		bool hasMore = true;
+		while (hasMore) {
+			BatchPtr batch;
+			{
+				std::unique_lock<std::mutex> lck(mtx_);
+				cv_.wait(lck, [this] { return stop_ || !freeBatches_.empty(); });
+				if (stop_) return;
+				batch = std::move(freeBatches_.back());
+				freeBatches_.pop_back();
+			}
+			hasMore = readBatch(cursor, upperBound, *batch);
+			{
+				std::lock_guard<std::mutex> lck(mtx_);
+				batch->seq = batchesRead_++;
+				decodeQueue_.push_back(std::move(batch));
+				readerDone_ = !hasMore;
+			}
+			cv_.notify_all();
+		}
+	} catch (...) {
+		std::lock_guard<std::mutex> lck(mtx_);
+		readerError_ = std::current_exception();
+	}
+	cv_.notify_all();
+}
+
+void ItemsLoader::decoderRoutine() {
+	for (;;) {
+		BatchPtr batch;
+		{
+			std::unique_lock<std::mutex> lck(mtx_);
+			cv_.wait(lck, [this] { return stop_ || !decodeQueue_.empty(); });
+			if (stop_) return;
+			batch = std::move(decodeQueue_.front());
+			decodeQueue_.pop_front();
+		}
+		decodeBatch(*batch);
+		{
+			std::lock_guard<std::mutex> lck(mtx_);
+			decodedBatches_.push_back(std::move(batch));
+		}
+		cv_.notify_all();
+	}
+}
+
+void ItemsLoader::indexWorkerRoutine(unsigned workerIdx) {
+	uint64_t phase = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lck(workersMtx_);
+			workersCv_.wait(lck, [&] { return stop_ || workersPhase_ != phase; });
+			if (stop_) return;
+			phase = workersPhase_;
+		}
+		try {
+			(*workersTask_)(workerIdx);
+		} catch (...) {
+			workersErrors_[workerIdx] = std::current_exception();
+		}
+		{
+			std::lock_guard<std::mutex> lck(workersMtx_);
+			++workersDone_;
+		}
+		workersCv_.notify_all();
+	}
+}
+
+void ItemsLoader::stop() {
+	{
+		std::lock_guard<std::mutex> lck(mtx_);
+		std::lock_guard<std::mutex> wlck(workersMtx_);
+		stop_ = true;
+	}
+	cv_.notify_all();
+	workersCv_.notify_all();
+	for (auto &th : threads_) th.join();
+	threads_.clear();
+}
+
+}  // namespace reindexer
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "core/itemimpl.h"
+#include "core/storage/idatastorage.h"
+#include "estl/string_view.h"
+
+namespace reindexer {
+
+class Namespace;
+
+/// Staged loader of namespace items from storage.
+/// Storage cursor is read by the reader thread, CJSON is decoded by the pool of decoders,
+/// and decoded items are inserted to the namespace by the calling thread with help of index workers,
+/// each of which owns its own subset of namespace indexes.
+class ItemsLoader {
+public:
+	struct Result {
+		size_t itemsCount = 0;
+		size_t dataSize = 0;
+		int errCount = 0;
+		Error lastErr;
+		int64_t maxLSN = -1;
+	};
+
+	/// Create loader. Its decoder and index worker threads are limited by the count of threads, which are not used by other loaders
+	/// (see SetThreadsLimit). If there are less than 2 such threads, items are loaded by the calling thread
+	/// @param ns - namespace to load items to. Must be locked by caller during the whole load
+	explicit ItemsLoader(Namespace &ns);
+	~ItemsLoader();
+	ItemsLoader(const ItemsLoader &) = delete;
+	ItemsLoader &operator=(const ItemsLoader &) = delete;
+
+	/// Load items from cursor, which is already positioned on the first item record
+	/// @param cursor - storage cursor
+	/// @param upperBound - key, which is greater than key of any item record
+	/// @return loading stats
+	Result Load(datastorage::Cursor &cursor, string_view upperBound);
+
+	/// Set max total count of threads of all loaders, which work concurrently. Default is hardware concurrency
+	/// @param limit - max count of threads. 0 means single-threaded load of each namespace
+	static void SetThreadsLimit(unsigned limit);
+
+private:
+	struct Batch {
+		void clear();
+
+		std::string data;
+		std::vector<std::pair<size_t, size_t>> records;
+		std::vector<int64_t> lsns;
+		std::vector<std::unique_ptr<ItemImpl>> items;
+		std::vector<bool> decoded;
+		size_t seq = 0;
+		int errCount = 0;
+		Error lastErr;
+		int64_t maxLSN = -1;
+	};
+	using BatchPtr = std::unique_ptr<Batch>;
+
+	bool readBatch(datastorage::Cursor &cursor, string_view upperBound, Batch &batch);
+	void decodeBatch(Batch &batch);
+	void insertBatch(Batch &batch, Result &res);
+	void insertBatchParallel(Batch &batch);
+	void runOnIndexWorkers(const std::function<void(unsigned)> &task);
+
+	void readerRoutine(datastorage::Cursor &cursor, string_view upperBound);
+	void decoderRoutine();
+	void indexWorkerRoutine(unsigned workerIdx);
+	void stop();
+
+	Namespace &ns_;
+	PayloadType payloadType_;
+	TagsMatcher tagsMatcher_;
+	unsigned decodersCount_;
+	unsigned indexWorkersCount_;
+	// Count of threads, acquired from the total limit
+	unsigned threadsAcquired_ = 0;
+
+	std::mutex mtx_;
+	std::condition_variable cv_;
+	bool stop_ = false;
+	bool readerDone_ = false;
+	size_t batchesRead_ = 0;
+	std::exception_ptr readerError_;
+	std::vector<BatchPtr> freeBatches_;
+	std::deque<BatchPtr> decodeQueue_;
+	std::vector<BatchPtr> decodedBatches_;
+
+	// Index workers state
+	std::mutex workersMtx_;
+	std::condition_variable workersCv_;
+	const std::function<void(unsigned)> *workersTask_ = nullptr;
+	uint64_t workersPhase_ = 0;
+	unsigned workersDone_ = 0;
+	std::vector<std::exception_ptr> workersErrors_;
+	std::vector<VariantArray> fieldsKeys_;
+	std::vector<IdType> ids_;
+
+	std::vector<std::thread> threads_;
+};
+
+}  // namespace reindexer
@@ -2,6 +2,7 @@
 #include "core/ft/ftsetcashe.h"
 #include "core/idset.h"
 #include "core/idsetcache.h"
+#include "core/preparedquerycache.h"
 #include "core/keyvalue/variant.h"
 #include "core/querycache.h"
 #include "joincache.h"
@@ -11,28 +12,53 @@ namespace reindexer {
 
 const size_t kElemSizeOverhead = 256;
 
+template <typename K, typename V, typename hash, typename equal>
+LRUCache<K, V, hash, equal>::LRUCache(size_t sizeLimit, int hitCount)
+	: cacheSizeLimit_(sizeLimit),
+	  sharedSizeLimit_(sizeLimit - sizeLimit / (2 * kDefaultCacheShardsCount) * kDefaultCacheShardsCount),
+	  sharedSizeBorrowed_(0) {
+	for (auto &shard : shards_) {
+		shard.cacheSizeLimit = sizeLimit / (2 * kDefaultCacheShardsCount);
+		shard.hitCountToCache = hitCount;
+	}
+}
+
 template <typename K, typename V, typename hash, typename equal>
 typename LRUCache<K, V, hash, equal>::Iterator LRUCache<K, V, hash, equal>::Get(const K &key) {
 	if (cacheSizeLimit_ == 0) return Iterator();
 
-	std::lock_guard<std::mutex> lk(lock_);
-
-	auto it = items_.find(key);
-	if (it == items_.end()) {
-		it = items_.emplace(key, Entry{}).first;
-		totalCacheSize_ += kElemSizeOverhead + sizeof(Entry) + key.Size();
-		it->second.lruPos = lru_.insert(lru_.end(), &it->first);
-		if (!eraseLRU()) return Iterator();
-	} else if (std::next(it->second.lruPos) != lru_.end()) {
-		lru_.splice(lru_.end(), lru_, it->second.lruPos, std::next(it->second.lruPos));
-		it->second.lruPos = std::prev(lru_.end());
+	Shard &shard = getShard(key);
+	std::lock_guard<std::mutex> lk(shard.lock);
+
+	auto it = shard.items.find(key);
+	if (it == shard.items.end()) {
+		it = shard.items.emplace(key, Entry{}).first;
+		shard.totalCacheSize += kElemSizeOverhead + sizeof(Entry) + key.Size();
+		Node *node = &*it;
+		if (shard.freePos.empty()) {
+			node->second.clockPos = shard.clock.size();
+			shard.clock.push_back(node);
+		} else {
+			node->second.clockPos = shard.freePos.back();
+			shard.freePos.pop_back();
+			shard.clock[node->second.clockPos] = node;
+		}
+		++shard.misses;
+		if (!eraseLRU(shard, node)) return Iterator();
+	} else {
+		it->second.referenced = true;
+		if (it->second.hasValue) {
+			++shard.hits;
+		} else {
+			++shard.misses;
+		}
 	}
 
-	if (++it->second.hitCount < hitCountToCache_) {
+	if (++it->second.hitCount < shard.hitCountToCache) {
 		return Iterator();
 	}
 
-	++getCount_;
+	++shard.getCount;
 
 	// logPrintf(LogInfo, "Cache::Get (cond=%d,sortId=%d,keys=%d), total in cache items=%d,size=%d", key.cond, key.sort,
 	// 		  (int)key.keys.size(), items_.size(), totalCacheSize_);
@@ -43,96 +69,150 @@ template <typename K, typename V, typename hash, typename equal>
 void LRUCache<K, V, hash, equal>::Put(const K &key, const V &v) {
 	if (cacheSizeLimit_ == 0) return;
 
-	std::lock_guard<std::mutex> lk(lock_);
-	auto it = items_.find(key);
-	if (it == items_.end()) return;
+	Shard &shard = getShard(key);
+	std::lock_guard<std::mutex> lk(shard.lock);
+	auto it = shard.items.find(key);
+	if (it == shard.items.end()) return;
 
-	totalCacheSize_ += v.Size() - it->second.val.Size();
+	shard.totalCacheSize += v.Size() - it->second.val.Size();
 	it->second.val = v;
+	it->second.hasValue = true;
 
 	// logPrintf(LogInfo, "IdSetCache::Put () add %d,left %d,fwdCnt=%d,sz=%d", endIt - begIt, left, it->second.fwdCount,
 	// 		  it->second.ids->size());
-	++putCount_;
+	++shard.putCount;
 
-	eraseLRU();
+	eraseLRU(shard, &*it);
 }
 
 template <typename K, typename V, typename hash, typename equal>
-bool LRUCache<K, V, hash, equal>::eraseLRU() {
-	typename LRUList::iterator it = lru_.begin();
+void LRUCache<K, V, hash, equal>::erase(Shard &shard, Node *node) {
+	size_t pos = node->second.clockPos;
+	shard.clock[pos] = nullptr;
+	shard.freePos.push_back(pos);
+	shard.items.erase(shard.items.find(node->first));
+	++shard.eraseCount;
+}
 
-	while (totalCacheSize_ > cacheSizeLimit_) {
-		// just to save us if totalCacheSize_ >0 and lru is empty
+template <typename K, typename V, typename hash, typename equal>
+bool LRUCache<K, V, hash, equal>::eraseLRU(Shard &shard, const Node *keep) {
+	while (!fitLimit(shard)) {
+		// just to save us if totalCacheSize >0 and cache is empty
 		// someone can make bad key or val with wrong size
-		if (lru_.empty()) {
-			clearAll();
-			logPrintf(LogError, "IdSetCache::eraseLRU () Cache restarted because wrong cache size totalCacheSize_=%d", totalCacheSize_);
+		if (shard.items.empty()) {
+			clearAll(shard);
+			logPrintf(LogError, "IdSetCache::eraseLRU () Cache restarted because wrong cache size totalCacheSize_=%d", shard.totalCacheSize);
+			return false;
+		}
+		// Entry, which is being added right now, is the only one in shard, and it doesn't fit to limit even alone
+		if (keep && shard.items.size() == 1) {
+			clearAll(shard);
 			return false;
 		}
-		auto mIt = items_.find(**it);
-		assert(mIt != items_.end());
 
-		size_t oldSize = sizeof(Entry) + kElemSizeOverhead + mIt->first.Size() + mIt->second.val.Size();
+		if (shard.hand >= shard.clock.size()) shard.hand = 0;
+		Node *node = shard.clock[shard.hand++];
+		if (!node || node == keep) continue;
+		// Give second chance to entries, which were requested after the last pass of clock hand
+		if (node->second.referenced) {
+			node->second.referenced = false;
+			continue;
+		}
+
+		size_t oldSize = sizeof(Entry) + kElemSizeOverhead + node->first.Size() + node->second.val.Size();
 
-		if (oldSize > totalCacheSize_) {
-			clearAll();
+		if (oldSize > shard.totalCacheSize) {
+			clearAll(shard);
 			logPrintf(LogError, "IdSetCache::eraseLRU () Cache restarted because wrong cache size totalCacheSize_=%d,oldSize=%d",
-					  totalCacheSize_, oldSize);
+					  shard.totalCacheSize, oldSize);
 			return false;
 		}
 
-		totalCacheSize_ = totalCacheSize_ - oldSize;
-		items_.erase(mIt);
-		it = lru_.erase(it);
-		++eraseCount_;
+		shard.totalCacheSize -= oldSize;
+		erase(shard, node);
 	}
 
-	if (eraseCount_ && putCount_ * 16 > getCount_) {
-		logPrintf(LogWarning, "IdSetCache::eraseLRU () cache invalidates too fast eraseCount=%d,putCount=%d,getCount=%d", eraseCount_,
-				  putCount_, eraseCount_);
-		eraseCount_ = 0;
-		hitCountToCache_ *= 2;
-		putCount_ = 0;
-		getCount_ = 0;
+	if (shard.eraseCount && shard.putCount * 16 > shard.getCount) {
+		logPrintf(LogWarning, "IdSetCache::eraseLRU () cache invalidates too fast eraseCount=%d,putCount=%d,getCount=%d", shard.eraseCount,
+				  shard.putCount, shard.getCount);
+		shard.eraseCount = 0;
+		shard.hitCountToCache *= 2;
+		shard.putCount = 0;
+		shard.getCount = 0;
+	}
+	return !shard.items.empty();
+}
+template <typename K, typename V, typename hash, typename equal>
+bool LRUCache<K, V, hash, equal>::fitLimit(Shard &shard) {
+	const size_t excess = shard.totalCacheSize > shard.cacheSizeLimit ? shard.totalCacheSize - shard.cacheSizeLimit : 0;
+	if (excess <= shard.borrowed) {
+		sharedSizeBorrowed_.fetch_sub(shard.borrowed - excess, std::memory_order_relaxed);
+		shard.borrowed = excess;
+		return true;
 	}
-	return !lru_.empty();
+	const size_t need = excess - shard.borrowed;
+	size_t borrowed = sharedSizeBorrowed_.load(std::memory_order_relaxed);
+	do {
+		if (borrowed + need > sharedSizeLimit_) return false;
+	} while (!sharedSizeBorrowed_.compare_exchange_weak(borrowed, borrowed + need, std::memory_order_relaxed));
+	shard.borrowed = excess;
+	return true;
 }
+
 template <typename K, typename V, typename hash, typename equal>
 bool LRUCache<K, V, hash, equal>::Clear() {
-	std::lock_guard<std::mutex> lk(lock_);
-	return clearAll();
+	bool res = false;
+	for (auto &shard : shards_) {
+		std::lock_guard<std::mutex> lk(shard.lock);
+		res = clearAll(shard) || res;
+	}
+	return res;
 }
 
 template <typename K, typename V, typename hash, typename equal>
-bool LRUCache<K, V, hash, equal>::clearAll() {
-	bool res = !items_.empty();
-	totalCacheSize_ = 0;
-	std::unordered_map<K, Entry, hash, equal>().swap(items_);
-	LRUList().swap(lru_);
-	getCount_ = 0;
-	putCount_ = 0;
-	eraseCount_ = 0;
+bool LRUCache<K, V, hash, equal>::clearAll(Shard &shard) {
+	bool res = !shard.items.empty();
+	shard.totalCacheSize = 0;
+	sharedSizeBorrowed_.fetch_sub(shard.borrowed, std::memory_order_relaxed);
+	shard.borrowed = 0;
+	ItemsMap().swap(shard.items);
+	std::vector<Node *>().swap(shard.clock);
+	std::vector<size_t>().swap(shard.freePos);
+	shard.hand = 0;
+	shard.getCount = 0;
+	shard.putCount = 0;
+	shard.eraseCount = 0;
 	return res;
 }
 
 template <typename K, typename V, typename hash, typename equal>
 LRUCacheMemStat LRUCache<K, V, hash, equal>::GetMemStat() {
-	std::lock_guard<std::mutex> lk(lock_);
 	LRUCacheMemStat ret;
-	ret.totalSize = totalCacheSize_;
-	ret.itemsCount = items_.size();
+	ret.shards.reserve(kDefaultCacheShardsCount);
+	for (auto &shard : shards_) {
+		std::lock_guard<std::mutex> lk(shard.lock);
+		LRUCacheMemStat::ShardStat shardStat;
+		shardStat.totalSize = shard.totalCacheSize;
+		shardStat.itemsCount = shard.items.size();
+		shardStat.hitsCount = shard.hits;
+		shardStat.missesCount = shard.misses;
+		ret.shards.push_back(shardStat);
+
+		ret.totalSize += shard.totalCacheSize;
+		ret.itemsCount += shard.items.size();
+		ret.hitsCount += shard.hits;
+		ret.missesCount += shard.misses;
+		ret.hitCountLimit = std::max(ret.hitCountLimit, size_t(shard.hitCountToCache));
+	}
 	ret.emptyCount = 0;
-	// for (auto &item : items_) {
-	// 	if (item.second.val.Empty()) ret.emptyCount++;
-	// }
-
-	ret.hitCountLimit = hitCountToCache_;
 
 	return ret;
 };
 template class LRUCache<IdSetCacheKey, IdSetCacheVal, hash_idset_cache_key, equal_idset_cache_key>;
 template class LRUCache<IdSetCacheKey, FtIdSetCacheVal, hash_idset_cache_key, equal_idset_cache_key>;
 template class LRUCache<QueryCacheKey, QueryCacheVal, HashQueryCacheKey, EqQueryCacheKey>;
+template class LRUCache<QueryCacheKey, QueryResultsCacheVal, HashQueryCacheKey, EqQueryCacheKey>;
 template class LRUCache<JoinCacheKey, JoinCacheVal, hash_join_cache_key, equal_join_cache_key>;
+template class LRUCache<PreparedQueryCacheKey, PreparedQueryCacheVal, HashPreparedQueryCacheKey, EqPreparedQueryCacheKey>;
 
 }  // namespace reindexer
@@ -2,21 +2,25 @@
 
 #include <estl/fast_hash_set.h>
 #include <atomic>
-#include <list>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 #include "namespacestat.h"
 
 namespace reindexer {
 
 const size_t kDefaultCacheSizeLimit = 1024 * 1024 * 128;
 const int kDefaultHitCountToCache = 2;
+const size_t kDefaultCacheShardsCount = 16;
 
+// Cache is split to independent shards, selected by key's hash. Each shard has its own lock
+// and evicts entries with CLOCK (second chance) algorithm, so lookup does not reorder any list.
+// Half of size limit is split between shards, and the other half is shared: shard borrows from it, when its own part is exceeded.
+// So entries, which are bigger than the part of shard, can be cached as well
 template <typename K, typename V, typename hash, typename equal>
 class LRUCache {
 public:
-	LRUCache(size_t sizeLimit = kDefaultCacheSizeLimit, int hitCount = kDefaultHitCountToCache)
-		: totalCacheSize_(0), cacheSizeLimit_(sizeLimit), hitCountToCache_(hitCount) {}
+	LRUCache(size_t sizeLimit = kDefaultCacheSizeLimit, int hitCount = kDefaultHitCountToCache);
 	struct Iterator {
 		Iterator(bool k = false, const V &v = V()) : valid(k), val(v) {}
 		Iterator(const Iterator &other) = delete;
@@ -43,26 +47,50 @@ public:
 	bool Clear();
 
 protected:
-	bool eraseLRU();
-
-	bool clearAll();
-
-	typedef std::list<const K *> LRUList;
-
 	struct Entry {
 		V val;
-		typename LRUList::iterator lruPos;
+		size_t clockPos = 0;
 		int hitCount = 0;
+		bool referenced = false;
+		bool hasValue = false;
 	};
+	typedef std::unordered_map<K, Entry, hash, equal> ItemsMap;
+	typedef typename ItemsMap::value_type Node;
 
-	std::unordered_map<K, Entry, hash, equal> items_;
-	LRUList lru_;
-	std::mutex lock_;
-	size_t totalCacheSize_;
-	size_t cacheSizeLimit_;
-	int hitCountToCache_;
+	struct Shard {
+		ItemsMap items;
+		// CLOCK ring. Empty slots are nullptr and listed in freePos
+		std::vector<Node *> clock;
+		std::vector<size_t> freePos;
+		size_t hand = 0;
+		size_t totalCacheSize = 0;
+		size_t cacheSizeLimit = 0;
+		// Size, borrowed from the shared part of size limit
+		size_t borrowed = 0;
+		int hitCountToCache = 0;
+		int getCount = 0, putCount = 0, eraseCount = 0;
+		uint64_t hits = 0, misses = 0;
+		std::mutex lock;
+	};
 
-	int getCount_ = 0, putCount_ = 0, eraseCount_ = 0;
+	Shard &getShard(const K &k) {
+		size_t h = hash()(k);
+		h ^= (h >> 16) ^ (h >> 24);
+		return shards_[h % kDefaultCacheShardsCount];
+	}
+
+	bool eraseLRU(Shard &shard, const Node *keep = nullptr);
+	void erase(Shard &shard, Node *node);
+	// Borrow or return shared size, so shard's size is within its part of limit and borrowed size. Returns false, if it's impossible
+	bool fitLimit(Shard &shard);
+
+	bool clearAll(Shard &shard);
+
+	Shard shards_[kDefaultCacheShardsCount];
+	size_t cacheSizeLimit_;
+	// Shared part of size limit and its borrowed size
+	size_t sharedSizeLimit_;
+	std::atomic<size_t> sharedSizeBorrowed_;
 };
 
 }  // namespace reindexer
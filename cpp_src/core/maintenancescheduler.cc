@@ -0,0 +1,236 @@
+#include "core/maintenancescheduler.h"
+#include <algorithm>
+#include "tools/errors.h"
+#include "tools/logger.h"
+
+namespace reindexer {
+
+// Delay before the next run of task, which is failed with exception
+constexpr std::chrono::milliseconds kFailedTaskRetryDelay(1000);
+
+static const char *maintenanceTaskName(MaintenanceTaskType type) {
+	switch (type) {
+		case MaintenanceFlush:
+			return "flush";
+		case MaintenanceExpireItems:
+			return "expire_items";
+		case MaintenanceOptimize:
+			return "optimize";
+		default:
+			return "unknown";
+	}
+}
+
+static uint64_t elapsedUs(MaintenanceScheduler::Clock::time_point from, MaintenanceScheduler::Clock::time_point to) {
+	return to > from ? std::chrono::duration_cast<std::chrono::microseconds>(to - from).count() : 0;
+}
+
+bool MaintenanceScheduler::DueOrder::operator()(const TaskPtr &lhs, const TaskPtr &rhs) const {
+	if (lhs->due != rhs->due) return lhs->due < rhs->due;
+	return lhs.get() < rhs.get();
+}
+
+bool MaintenanceScheduler::PriorityOrder::operator()(const TaskPtr &lhs, const TaskPtr &rhs) const {
+	if (lhs->type != rhs->type) return lhs->type < rhs->type;
+	if (lhs->due != rhs->due) return lhs->due < rhs->due;
+	return lhs.get() < rhs.get();
+}
+
+MaintenanceScheduler::MaintenanceScheduler(unsigned workersCount) {
+	workers_.reserve(workersCount);
+	for (unsigned i = 0; i < workersCount; ++i) workers_.emplace_back([this]() { workerRoutine(); });
+}
+
+MaintenanceScheduler::~MaintenanceScheduler() { Stop(); }
+
+void MaintenanceScheduler::Add(const void *owner, MaintenanceTaskType type, Routine routine) {
+	{
+		std::lock_guard<std::mutex> lck(mtx_);
+		if (stop_) return;
+		TaskPtr &task = tasks_[owner][type];
+		if (task) return;
+		task = std::make_shared<Task>();
+		task->owner = owner;
+		task->type = type;
+		task->routine = std::move(routine);
+		task->due = Clock::now();
+		waiting_.insert(task);
+	}
+	cv_.notify_one();
+}
+
+void MaintenanceScheduler::removeTasks(std::array<TaskPtr, MaintenanceTasksCount> &tasks, std::vector<TaskPtr> &removed) {
+	for (TaskPtr &task : tasks) {
+		if (!task) continue;
+		task->removed = true;
+		if (!task->running) {
+			waiting_.erase(task);
+			ready_.erase(task);
+		}
+		removed.push_back(std::move(task));
+	}
+}
+
+void MaintenanceScheduler::Remove(const void *owner) {
+	// Routines may hold the last references to their owners, so they are destroyed without lock
+	std::vector<TaskPtr> removed;
+	std::lock_guard<std::mutex> lck(mtx_);
+	auto it = tasks_.find(owner);
+	if (it == tasks_.end()) return;
+	removeTasks(it->second, removed);
+	tasks_.erase(it);
+}
+
+void MaintenanceScheduler::RemoveExcept(const std::vector<const void *> &owners) {
+	std::vector<TaskPtr> removed;
+	std::lock_guard<std::mutex> lck(mtx_);
+	for (auto it = tasks_.begin(); it != tasks_.end();) {
+		if (std::find(owners.begin(), owners.end(), it->first) == owners.end()) {
+			removeTasks(it->second, removed);
+			it = tasks_.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void MaintenanceScheduler::Parallel(unsigned count, const std::function<void(unsigned)> &func) {
+	auto batch = std::make_shared<ParallelBatch>(func, count);
+	unsigned helpers = 0;
+	if (count > 1) {
+		std::lock_guard<std::mutex> lck(mtx_);
+		if (!stop_) {
+			helpers = std::min<unsigned>(count - 1, workers_.size());
+			for (unsigned i = 0; i < helpers; ++i) batches_.push_back(batch);
+		}
+	}
+	for (unsigned i = 0; i < helpers; ++i) cv_.notify_one();
+
+	batch->Run();
+	if (helpers) {
+		std::lock_guard<std::mutex> lck(mtx_);
+		batches_.erase(std::remove(batches_.begin(), batches_.end(), batch), batches_.end());
+	}
+	batch->Wait();
+	if (batch->error) std::rethrow_exception(batch->error);
+}
+
+void MaintenanceScheduler::Stop() {
+	{
+		std::lock_guard<std::mutex> lck(mtx_);
+		if (stop_) return;
+		stop_ = true;
+	}
+	cv_.notify_all();
+	for (auto &worker : workers_) worker.join();
+
+	std::unordered_map<const void *, std::array<TaskPtr, MaintenanceTasksCount>> tasks;
+	std::lock_guard<std::mutex> lck(mtx_);
+	waiting_.clear();
+	ready_.clear();
+	batches_.clear();
+	tasks.swap(tasks_);
+}
+
+void MaintenanceScheduler::promoteDueTasks(Clock::time_point now) {
+	while (!waiting_.empty() && (*waiting_.begin())->due <= now) {
+		ready_.insert(*waiting_.begin());
+		waiting_.erase(waiting_.begin());
+	}
+}
+
+void MaintenanceScheduler::workerRoutine() {
+	std::unique_lock<std::mutex> lck(mtx_);
+	while (!stop_) {
+		if (!batches_.empty()) {
+			auto batch = std::move(batches_.front());
+			batches_.pop_front();
+			lck.unlock();
+			batch->Run();
+			batch.reset();
+			lck.lock();
+			continue;
+		}
+
+		promoteDueTasks(Clock::now());
+		if (ready_.empty()) {
+			if (waiting_.empty()) {
+				cv_.wait(lck);
+			} else {
+				cv_.wait_until(lck, (*waiting_.begin())->due);
+			}
+			continue;
+		}
+
+		TaskPtr task = *ready_.begin();
+		ready_.erase(ready_.begin());
+		task->running = true;
+		lck.unlock();
+
+		const auto start = Clock::now();
+		std::chrono::milliseconds delay = kFailedTaskRetryDelay;
+		try {
+			delay = task->routine();
+		} catch (const Error &err) {
+			logPrintf(LogWarning, "Maintenance task '%s' failed: %s", maintenanceTaskName(task->type), err.what());
+		} catch (const std::exception &e) {
+			logPrintf(LogWarning, "Maintenance task '%s' failed: %s", maintenanceTaskName(task->type), e.what());
+		} catch (...) {
+			logPrintf(LogWarning, "Maintenance task '%s' failed", maintenanceTaskName(task->type));
+		}
+		const auto finish = Clock::now();
+
+		lck.lock();
+		task->running = false;
+		const uint64_t latencyUs = elapsedUs(task->due, start), runTimeUs = elapsedUs(start, finish);
+		task->runsCount++;
+		task->totalLatencyUs += latencyUs;
+		task->maxLatencyUs = std::max(task->maxLatencyUs, latencyUs);
+		task->totalRunTimeUs += runTimeUs;
+		task->maxRunTimeUs = std::max(task->maxRunTimeUs, runTimeUs);
+		if (!task->removed) {
+			task->due = finish + std::max(delay, std::chrono::milliseconds(0));
+			waiting_.insert(std::move(task));
+		} else {
+			// Routine may hold the last reference to its owner
+			lck.unlock();
+			task.reset();
+			lck.lock();
+		}
+	}
+}
+
+MaintenanceStat MaintenanceScheduler::GetStat(const void *owner) const {
+	MaintenanceStat stat;
+	const auto now = Clock::now();
+	std::lock_guard<std::mutex> lck(mtx_);
+	stat.queueDepth = ready_.size();
+	for (auto it = waiting_.begin(); it != waiting_.end() && (*it)->due <= now; ++it) stat.queueDepth++;
+
+	auto it = tasks_.find(owner);
+	if (it == tasks_.end()) return stat;
+	for (const TaskPtr &task : it->second) {
+		if (!task) continue;
+		MaintenanceTaskStat taskStat;
+		taskStat.type = maintenanceTaskName(task->type);
+		taskStat.totalCount = task->runsCount;
+		taskStat.avgLatencyUs = task->runsCount ? task->totalLatencyUs / task->runsCount : 0;
+		taskStat.maxLatencyUs = task->maxLatencyUs;
+		taskStat.avgRunTimeUs = task->runsCount ? task->totalRunTimeUs / task->runsCount : 0;
+		taskStat.maxRunTimeUs = task->maxRunTimeUs;
+		stat.tasks.emplace_back(std::move(taskStat));
+	}
+	return stat;
+}
+
+void MaintenanceScheduler::ResetStat(const void *owner) {
+	std::lock_guard<std::mutex> lck(mtx_);
+	auto it = tasks_.find(owner);
+	if (it == tasks_.end()) return;
+	for (const TaskPtr &task : it->second) {
+		if (!task) continue;
+		task->runsCount = task->totalLatencyUs = task->maxLatencyUs = task->totalRunTimeUs = task->maxRunTimeUs = 0;
+	}
+}
+
+}  // namespace reindexer
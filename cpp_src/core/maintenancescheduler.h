@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "core/namespacestat.h"
+#include "core/parallelbatch.h"
+
+namespace reindexer {
+
+/// Types of background maintenance tasks in order of their priority
+enum MaintenanceTaskType {
+	/// Flush of updates to storage
+	MaintenanceFlush = 0,
+	/// Removal of items, expired by TTL indexes
+	MaintenanceExpireItems,
+	/// Build of sort orders, rebuild of outdated indexes, compaction of items
+	MaintenanceOptimize,
+	MaintenanceTasksCount
+};
+
+/// Persistent pool of workers, which run periodic background maintenance tasks (e.g. of namespaces).
+/// Each task is run, when it is due, and returns delay until its next run. If several tasks are due, they are run in order of
+/// their priority: by type first (see MaintenanceTaskType), and then by time, they are overdue for.
+/// Task is never run concurrently with itself, but tasks of the same owner may be run concurrently.
+/// Workers are also used to run parallel parts of tasks (see Parallel). Parallel parts of user requests are run by WorkerPool instead.
+class MaintenanceScheduler {
+public:
+	using Clock = std::chrono::steady_clock;
+	/// Task routine. Returns delay until the next run of task
+	using Routine = std::function<std::chrono::milliseconds()>;
+
+	/// Create scheduler and start its workers
+	/// @param workersCount - count of worker threads
+	explicit MaintenanceScheduler(unsigned workersCount);
+	~MaintenanceScheduler();
+	MaintenanceScheduler(const MaintenanceScheduler &) = delete;
+	MaintenanceScheduler &operator=(const MaintenanceScheduler &) = delete;
+
+	/// Add task and make it due immediately. Does nothing, if owner already has task of this type
+	/// @param owner - owner of task, e.g. namespace. Routine has to keep owner alive
+	/// @param type - type of task
+	/// @param routine - task routine
+	void Add(const void *owner, MaintenanceTaskType type, Routine routine);
+	/// Remove tasks of owner. Running tasks are finished, but they are not run anymore
+	void Remove(const void *owner);
+	/// Remove tasks of all the owners, except listed ones
+	void RemoveExcept(const std::vector<const void *> &owners);
+	/// Call func(0), ..., func(count - 1) in parallel by the calling thread and free workers. The calls are finished on return.
+	/// Exception of any call is rethrown to the caller
+	void Parallel(unsigned count, const std::function<void(unsigned)> &func);
+	/// Stop workers. Running tasks are finished, the rest are not run anymore
+	void Stop();
+
+	/// Get statistics of tasks of owner
+	MaintenanceStat GetStat(const void *owner) const;
+	/// Reset statistics of tasks of owner
+	void ResetStat(const void *owner);
+
+private:
+	struct Task {
+		const void *owner;
+		MaintenanceTaskType type;
+		Routine routine;
+		Clock::time_point due;
+		bool running = false;
+		bool removed = false;
+		uint64_t runsCount = 0;
+		uint64_t totalLatencyUs = 0;
+		uint64_t maxLatencyUs = 0;
+		uint64_t totalRunTimeUs = 0;
+		uint64_t maxRunTimeUs = 0;
+	};
+	using TaskPtr = std::shared_ptr<Task>;
+	struct DueOrder {
+		bool operator()(const TaskPtr &lhs, const TaskPtr &rhs) const;
+	};
+	struct PriorityOrder {
+		bool operator()(const TaskPtr &lhs, const TaskPtr &rhs) const;
+	};
+
+	void workerRoutine();
+	void promoteDueTasks(Clock::time_point now);
+	void removeTasks(std::array<TaskPtr, MaintenanceTasksCount> &tasks, std::vector<TaskPtr> &removed);
+
+	mutable std::mutex mtx_;
+	std::condition_variable cv_;
+	bool stop_ = false;
+	// Tasks by owners
+	std::unordered_map<const void *, std::array<TaskPtr, MaintenanceTasksCount>> tasks_;
+	// Tasks, which are waiting for their due time, ordered by it
+	std::set<TaskPtr, DueOrder> waiting_;
+	// Due tasks, ordered by priority
+	std::set<TaskPtr, PriorityOrder> ready_;
+	// Parallel parts of running tasks. They are run before any other task
+	std::deque<std::shared_ptr<ParallelBatch>> batches_;
+	std::vector<std::thread> workers_;
+};
+
+}  // namespace reindexer
@@ -7,7 +7,10 @@
 #include <thread>
 #include "cjson/jsonbuilder.h"
 #include "core/index/index.h"
+#include "core/itemsloader.h"
+#include "core/maintenancescheduler.h"
 #include "core/nsselecter/nsselecter.h"
+#include "core/nsselecter/querypreprocessor.h"
 #include "core/payload/payloadiface.h"
 #include "core/query/expressionevaluator.h"
 #include "core/rdxcontext.h"
@@ -36,6 +39,7 @@ using std::defer_lock;
 #define kStorageTagsPrefix "tags"
 #define kStorageMetaPrefix "meta"
 #define kStorageCachePrefix "cache"
+#define kStorageIndexStatePrefix "idxstate"
 #define kTupleName "-tuple"
 
 static const string kPKIndexName = "#pk";
@@ -48,8 +52,24 @@ const int kWALStatementItemsThreshold = 5;
 namespace reindexer {
 
 constexpr int64_t kStorageSerialInitial = 1;
+// Saved states of indexes are splitted to records of limited size
+constexpr size_t kIndexStateChunkSize = 16 * 1024 * 1024;
 constexpr uint8_t kSysRecordsBackupCount = 8;
 constexpr uint8_t kSysRecordsFirstWriteCopies = 3;
+// Distance between positions of neighbour items in built sort orders. Free positions are used to place updated items
+constexpr IdType kSortOrdersGap = 2;
+// Bounds of width of sort order window, which is spread to make room for updated item, if there is no free position for it
+constexpr IdType kMinSortOrdersRebalanceWindow = 64;
+constexpr IdType kMaxSortOrdersRebalanceWindow = 1 << 15;
+// Periods of background maintenance of namespace
+constexpr std::chrono::milliseconds kStorageFlushPeriod(100);
+constexpr std::chrono::milliseconds kOptimizationCheckPeriod(100);
+// Items are checked for expiration, when the oldest of them expires, but not less often than this
+constexpr std::chrono::milliseconds kMaxExpirationCheckPeriod(1000);
+// Count of items, which are compacted under single namespace lock
+constexpr size_t kCompactionStepItems = 10000;
+// Changed states of indexes are saved by background routine not more often than this. On close of storage they are saved anyway
+constexpr std::chrono::minutes kIndexesStateSavePeriod(5);
 
 Namespace::IndexesStorage::IndexesStorage(const Namespace &ns) : ns_(ns) {}
 
@@ -63,12 +83,15 @@ Namespace::Namespace(const Namespace &src) : indexes_(*this), observers_(src.obs
 
 Namespace::Namespace(const string &name, UpdatesObservers &observers)
 	: indexes_(*this),
+	  arena_(new PayloadArena),
 	  name_(name),
 	  payloadType_(name),
 	  tagsMatcher_(payloadType_),
 	  unflushedCount_{0},
 	  sortOrdersBuilt_(false),
 	  queryCache_(make_shared<QueryCache>()),
+	  resultsCache_(make_shared<QueryResultsCache>(0)),
+	  indexesVersion_(0),
 	  joinCache_(make_shared<JoinCache>()),
 	  enablePerfCounters_(false),
 	  observers_(&observers),
@@ -90,28 +113,37 @@ void Namespace::CopyContentsFrom(const Namespace &src) {
 	indexesNames_ = src.indexesNames_;
 	items_ = src.items_;
 	free_ = src.free_;
+	arena_ = src.arena_;
 	name_ = src.name_;
 	payloadType_ = src.payloadType_;
 	tagsMatcher_ = src.tagsMatcher_;
 	storage_ = src.storage_;
 	updates_ = src.updates_;
 	unflushedCount_.store(src.unflushedCount_.load(std::memory_order_acquire), std::memory_order_release);  // 0
-	sortOrdersBuilt_ = src.sortOrdersBuilt_.load();															// false
+	// Copies of idsets don't keep sort orders, so they have to be rebuilt
+	sortOrdersBuilt_ = false;
 	meta_ = src.meta_;
 	dbpath_ = src.dbpath_;
 	queryCache_ = src.queryCache_;
+	resultsCache_ = src.resultsCache_;
+	generations_ = src.generations_;
+	indexesVersion_ = src.indexesVersion_.load();
 	joinCache_ = src.joinCache_;
 
 	enablePerfCounters_ = src.enablePerfCounters_.load();
 	config_ = src.config_;
-	wal_ = src.wal_;
+	// Copy gets only new records, which are merged to the source's WAL on swap
+	wal_ = src.wal_.Fork();
 	repl_ = src.repl_;
 	storageLoaded_ = src.storageLoaded_.load();
-	lastUpdateTime_.store(src.lastUpdateTime_.load(std::memory_order_acquire), std::memory_order_release);
+	// Built sort orders of source are lost, so they will be rebuilt after optimization timeout
+	lastUpdateTime_.store(src.sortOrdersBuilt_ ? getTimeNow("msec"_sv) : src.lastUpdateTime_.load(std::memory_order_acquire),
+						  std::memory_order_release);
 	itemsCount_ = src.itemsCount_.load();
 	sparseIndexesCount_ = src.sparseIndexesCount_;
 	krefs = src.krefs;
 	skrefs = src.skrefs;
+	sysRecordsVersions_ = src.sysRecordsVersions_;
 
 	storageOpts_ = src.storageOpts_;
 	for (auto &idxIt : src.indexes_) indexes_.push_back(unique_ptr<Index>(idxIt->Clone()));
@@ -133,7 +165,11 @@ void Namespace::onConfigUpdated(DBConfigProvider &configProvider, const RdxConte
 	enablePerfCounters_ = configProvider.GetProfilingConfig().perfStats;
 
 	WLock lk(mtx_, &ctx);
+	if (config_.resultsCacheSize != configData.resultsCacheSize) {
+		resultsCache_ = make_shared<QueryResultsCache>(std::max<int64_t>(configData.resultsCacheSize, 0));
+	}
 	config_ = configData;
+	wal_.SetLimits(config_.walSize, config_.walMaxBytes);
 	storageOpts_.LazyLoad(configData.lazyLoad);
 	storageOpts_.noQueryIdleThresholdSec = configData.noQueryIdleThreshold;
 
@@ -293,10 +329,15 @@ void Namespace::DropIndex(const IndexDef &indexDef, const RdxContext &ctx) {
 	WLock wlock(mtx_, &ctx);
 	dropIndex(indexDef);
 	saveIndexesToStorage();
+	removeIndexStateFromStorage(indexDef.name_);
 	addToWAL(indexDef, WalIndexDrop);
 }
 
+static std::atomic<uint64_t> indexesVersionCounter{0};
+
 void Namespace::dropIndex(const IndexDef &index) {
+	indexesVersion_ = ++indexesVersionCounter;
+	resetSortOrders();
 	auto itIdxName = indexesNames_.find(index.name_);
 	if (itIdxName == indexesNames_.end()) {
 		const char *errMsg = "Cannot remove index %s: doesn't exist";
@@ -417,6 +458,8 @@ void Namespace::verifyUpdateIndex(const IndexDef &indexDef) const {
 }
 
 void Namespace::addIndex(const IndexDef &indexDef) {
+	indexesVersion_ = ++indexesVersionCounter;
+	resetSortOrders();
 	string indexName = indexDef.name_;
 
 	auto idxNameIt = indexesNames_.find(indexName);
@@ -482,6 +525,8 @@ void Namespace::addIndex(const IndexDef &indexDef) {
 }
 
 void Namespace::updateIndex(const IndexDef &indexDef) {
+	indexesVersion_ = ++indexesVersionCounter;
+	resetSortOrders();
 	const string &indexName = indexDef.name_;
 
 	IndexDef foundIndex = getIndexDefinition(indexName);
@@ -665,9 +710,44 @@ void Namespace::Update(const Query &query, QueryResults &result, const RdxContex
 
 void Namespace::Upsert(Item &item, const RdxContext &ctx, bool store, bool noLock) { modifyItem(item, ctx, store, ModeUpsert, noLock); }
 
-void Namespace::Delete(Item &item, const RdxContext &ctx, bool noLock) {
-	ItemImpl *ritem = item.impl_;
+void Namespace::UpsertBulk(std::vector<Item> &items, const RdxContext &ctx) {
+	PerfStatCalculatorMT calc(updatePerfCounter_, enablePerfCounters_);
+	WLock lock(mtx_, defer_lock, &ctx);
+	cancelCommit_ = true;  // -V519
+	lock.lock();
+	cancelCommit_ = false;  // -V519
+	calc.LockHit();
+	for (Item &item : items) doModifyItem(item, ctx, true, ModeUpsert);
+}
+
+void Namespace::ModifyBulk(std::vector<Item> &items, const std::vector<ItemModifyMode> &modes, std::vector<Error> &statuses,
+						   const RdxContext &ctx) {
+	if (modes.size() != items.size()) {
+		throw Error(errParams, "Count of modes %d is not equal to count of items %d", modes.size(), items.size());
+	}
+	statuses.assign(items.size(), Error());
 
+	PerfStatCalculatorMT calc(updatePerfCounter_, enablePerfCounters_);
+	WLock lock(mtx_, defer_lock, &ctx);
+	cancelCommit_ = true;  // -V519
+	lock.lock();
+	cancelCommit_ = false;  // -V519
+	calc.LockHit();
+
+	for (size_t i = 0; i < items.size(); ++i) {
+		try {
+			if (modes[i] == ModeDelete) {
+				doDeleteItem(items[i], ctx);
+			} else {
+				doModifyItem(items[i], ctx, true, modes[i]);
+			}
+		} catch (const Error &err) {
+			statuses[i] = err;
+		}
+	}
+}
+
+void Namespace::Delete(Item &item, const RdxContext &ctx, bool noLock) {
 	PerfStatCalculatorMT calc(updatePerfCounter_, enablePerfCounters_);
 
 	WLock lock(mtx_, defer_lock, &ctx);
@@ -679,6 +759,12 @@ void Namespace::Delete(Item &item, const RdxContext &ctx, bool noLock) {
 	}
 	calc.LockHit();
 
+	doDeleteItem(item, ctx);
+}
+
+void Namespace::doDeleteItem(Item &item, const RdxContext &ctx) {
+	ItemImpl *ritem = item.impl_;
+
 	checkApplySlaveUpdate(item.GetLSN());
 
 	updateTagsMatcherFromItem(ritem);
@@ -725,6 +811,8 @@ void Namespace::doDelete(IdType id) {
 		unflushedCount_.fetch_add(1, std::memory_order_release);
 	}
 
+	SortOrdersUpdater sortOrdersUpdater(*this, id, false);
+
 	// erase last item
 	VariantArray skrefs;
 	int field;
@@ -748,7 +836,8 @@ void Namespace::doDelete(IdType id) {
 		field %= indexes_.firstCompositePos();
 
 		Index &index = *indexes_[field];
-		if (index.Opts().IsSparse()) {
+		const bool isIndexSparse = index.Opts().IsSparse();
+		if (isIndexSparse) {
 			assert(index.Fields().getTagsPathsLength() > 0);
 			pl.GetByJsonPath(index.Fields().getTagsPath(0), skrefs, index.KeyType());
 		} else {
@@ -756,13 +845,13 @@ void Namespace::doDelete(IdType id) {
 		}
 		// Delete value from index
 		for (auto key : skrefs) index.Delete(key, id);
-		// If no krefs delete empty value from index
-		if (!skrefs.size()) index.Delete(Variant(), id);
+		// If no krefs delete empty value from index. Sparse indexes don't hold empty values
+		if (!skrefs.size() && !isIndexSparse) index.Delete(Variant(), id);
 	} while (++field != borderIdx);
 
 	// free PayloadValue
 	items_[id].Free();
-	markUpdated();
+	markUpdated(nullptr, sortOrdersUpdater.Commit());
 	free_.push_back(id);
 	if (free_.size() == items_.size()) {
 		free_.resize(0);
@@ -855,6 +944,7 @@ void Namespace::Truncate(const RdxContext &ctx, int64_t lsn, bool noLock) {
 	WALRecord wrec(WalUpdateQuery, (ser << "TRUNCATE " << name_).Slice());
 	if (!repl_.slaveMode) lsn = wal_.Add(wrec);
 	observers_->OnWALUpdate(lsn, name_, wrec);
+	markUpdated();
 }
 
 ReplicationState Namespace::GetReplState(const RdxContext &ctx) const {
@@ -865,6 +955,7 @@ ReplicationState Namespace::GetReplState(const RdxContext &ctx) const {
 ReplicationState Namespace::getReplState() const {
 	ReplicationState ret = repl_;
 	ret.dataCount = items_.size() - free_.size();
+	ret.dataIdsCount = items_.size();
 	if (!repl_.slaveMode) ret.lastLsn = wal_.LSNCounter() - 1;
 	return ret;
 }
@@ -889,12 +980,74 @@ Transaction Namespace::NewTransaction(const RdxContext &ctx) {
 }
 
 void Namespace::CommitTransaction(Transaction &tx, const RdxContext &ctx) {
+	if (needNamespaceCopy(tx, ctx)) {
+		commitTransactionOnCopy(tx, ctx);
+		return;
+	}
+
 	PerfStatCalculatorMT calc(updatePerfCounter_, enablePerfCounters_);
 	cancelCommit_ = true;  // -V519
 	WLock lck(mtx_, &ctx);
 	cancelCommit_ = false;  // -V519
 	calc.LockHit();
 
+	applyTransactionSteps(tx, ctx);
+}
+
+bool Namespace::needNamespaceCopy(const Transaction &tx, const RdxContext &ctx) const {
+	RLock lck(mtx_, &ctx);
+	if (isSystem() || config_.startCopyPoliticsCount <= 0) return false;
+	return tx.GetSteps().size() >= size_t(config_.startCopyPoliticsCount);
+}
+
+// Applies large transaction to the copy of namespace and swaps it with the current contents.
+// Other writers are blocked by the mutex gate during the whole commit, but selects are still served by the old contents.
+// Exclusive lock is held only while swapping
+void Namespace::commitTransactionOnCopy(Transaction &tx, const RdxContext &ctx) {
+	PerfStatCalculatorMT calc(updatePerfCounter_, enablePerfCounters_);
+	cancelCommit_ = true;  // -V519
+	contexted_unique_lock<Mutex::Gate, const RdxContext> gateLck(mtx_.gate(), &ctx);
+	cancelCommit_ = false;  // -V519
+	calc.LockHit();
+
+	unique_ptr<Namespace> nsCopy;
+	// Copy shares storage with the current contents, so nothing has to be written from it, unless it's swapped successfully.
+	// After the swap it holds the old contents, which must not be flushed on destruction as well
+	struct StorageDetach {
+		~StorageDetach() {
+			if (!ns) return;
+			ns->storage_.reset();
+			ns->updates_.reset();
+			ns->unflushedCount_.store(0, std::memory_order_release);
+		}
+		unique_ptr<Namespace> &ns;
+	} storageDetach{nsCopy};
+	{
+		RLock lck(mtx_, &ctx);
+		logPrintf(LogTrace, "Namespace::CommitTransaction creating copy for (%s), %d steps", name_, tx.GetSteps().size());
+		// Pending updates must get to storage before updates from the copy
+		doFlushStorage();
+		nsCopy.reset(new Namespace(*this));
+	}
+	if (nsCopy->storage_) nsCopy->updates_.reset(nsCopy->storage_->GetUpdatesCollection());
+	// Selects on the current contents may still fill caches, so the copy gets its own ones
+	nsCopy->queryCache_ = make_shared<QueryCache>();
+	nsCopy->resultsCache_ = make_shared<QueryResultsCache>(std::max<int64_t>(nsCopy->config_.resultsCacheSize, 0));
+	nsCopy->joinCache_ = make_shared<JoinCache>();
+
+	nsCopy->applyTransactionSteps(tx, ctx);
+
+	{
+		// Gate is already owned, so lock the underlying mutex directly
+		unique_lock<Mutex::Base> lck(mtx_);
+		swapContents(*nsCopy);
+		// Indexes are replaced by the copies
+		indexesVersion_ = ++indexesVersionCounter;
+	}
+	logPrintf(LogTrace, "Namespace::CommitTransaction copy for (%s) has been swapped", name_);
+}
+
+void Namespace::applyTransactionSteps(Transaction &tx, const RdxContext &ctx) {
 	RdxActivityContext *const actCtx = ctx.Activity();
 	for (auto &step : tx.GetSteps()) {
 		if (step.query_) {
@@ -912,7 +1065,53 @@ void Namespace::CommitTransaction(Transaction &tx, const RdxContext &ctx) {
 	}
 }
 
-void Namespace::doUpsert(ItemImpl *ritem, IdType id, bool doUpdate) {
+template <typename T>
+static void swapAtomic(std::atomic<T> &lhs, std::atomic<T> &rhs) {
+	rhs.store(lhs.exchange(rhs.load(std::memory_order_acquire), std::memory_order_acq_rel), std::memory_order_release);
+}
+
+// Swaps data of namespaces. NOT THREADSAFE!
+void Namespace::swapContents(Namespace &other) {
+	using std::swap;
+	indexes_.swap(other.indexes_);
+	swap(indexesNames_, other.indexesNames_);
+	items_.swap(other.items_);
+	swap(free_, other.free_);
+	swap(arena_, other.arena_);
+	swap(payloadType_, other.payloadType_);
+	swap(tagsMatcher_, other.tagsMatcher_);
+	swap(storage_, other.storage_);
+	swap(updates_, other.updates_);
+	swapAtomic(unflushedCount_, other.unflushedCount_);
+	swapAtomic(sortOrdersBuilt_, other.sortOrdersBuilt_);
+	swap(sortPositions_, other.sortPositions_);
+	swap(meta_, other.meta_);
+	swap(queryCache_, other.queryCache_);
+	swap(resultsCache_, other.resultsCache_);
+	swap(generations_, other.generations_);
+	swapAtomic(indexesVersion_, other.indexesVersion_);
+	swap(joinCache_, other.joinCache_);
+	swap(sparseIndexesCount_, other.sparseIndexesCount_);
+	swap(sysRecordsVersions_, other.sysRecordsVersions_);
+	swap(config_, other.config_);
+	// WAL of copy contains only its own records
+	wal_.Merge(std::move(other.wal_));
+	swap(repl_, other.repl_);
+	swapAtomic(storageLoaded_, other.storageLoaded_);
+	swapAtomic(lastUpdateTime_, other.lastUpdateTime_);
+	swapAtomic(itemsCount_, other.itemsCount_);
+}
+
+// Check if values of index were changed by update of item
+static bool valuesChanged(const VariantArray &oldValues, const VariantArray &newValues) {
+	if (oldValues.size() != newValues.size()) return true;
+	for (size_t i = 0; i < oldValues.size(); ++i) {
+		if (oldValues[i].Type() != newValues[i].Type() || oldValues[i] != newValues[i]) return true;
+	}
+	return false;
+}
+
+void Namespace::doUpsert(ItemImpl *ritem, IdType id, bool doUpdate, IndexesMask *updatedIndexes) {
 	// Upsert fields to indexes
 	assert(items_.exists(id));
 	auto &plData = items_[id];
@@ -942,48 +1141,11 @@ void Namespace::doUpsert(ItemImpl *ritem, IdType id, bool doUpdate) {
 	do {
 		field %= indexes_.firstCompositePos();
 		Index &index = *indexes_[field];
-		bool isIndexSparse = index.Opts().IsSparse();
-		assert(!isIndexSparse || (isIndexSparse && index.Fields().getTagsPathsLength() > 0));
-
-		if (isIndexSparse) {
-			assert(index.Fields().getTagsPathsLength() > 0);
-			try {
-				plNew.GetByJsonPath(index.Fields().getTagsPath(0), skrefs, index.KeyType());
-			} catch (const Error &) {
-				skrefs.resize(0);
-			}
-		} else {
-			plNew.Get(field, skrefs);
-		}
-
-		if (index.Opts().GetCollateMode() == CollateUTF8)
-			for (auto &key : skrefs) key.EnsureUTF8();
-
-		// Check for update
-		if (doUpdate) {
-			if (isIndexSparse) {
-				try {
-					pl.GetByJsonPath(index.Fields().getTagsPath(0), krefs, index.KeyType());
-				} catch (const Error &) {
-					krefs.resize(0);
-				}
-			} else {
-				pl.Get(field, krefs, index.Opts().IsArray());
-			}
-			for (auto key : krefs) index.Delete(key, id);
-			if (!krefs.size()) index.Delete(Variant(), id);
-		}
-		// Put value to index
-		krefs.resize(0);
-		krefs.reserve(skrefs.size());
-		for (auto key : skrefs) krefs.push_back(index.Upsert(key, id));
-
-		if (!isIndexSparse) {
-			// Put value to payload
-			pl.Set(field, krefs);
-			// If no krefs doUpsert empty value to index
-			if (!skrefs.size()) index.Upsert(Variant(), id);
-		}
+		bool changed = false;
+		upsertIndexValues(index, field, plNew, doUpdate ? &pl : nullptr, id, skrefs, krefs, updatedIndexes ? &changed : nullptr);
+		if (changed) updatedIndexes->set(field);
+		// Put value to payload
+		if (!index.Opts().IsSparse()) pl.Set(field, krefs);
 	} while (++field != borderIdx);
 
 	// Upsert to composite indexes
@@ -994,6 +1156,50 @@ void Namespace::doUpsert(ItemImpl *ritem, IdType id, bool doUpdate) {
 	ritem->RealValue() = plData;
 }
 
+// Upserts values of field of new payload to dense or sparse index. Values of old payload, if it's set, are deleted from index first.
+// Keys, stored in index, are returned in krefs. May be called concurrently for different indexes
+void Namespace::upsertIndexValues(Index &index, int field, Payload &plNew, Payload *plOld, IdType id, VariantArray &skrefs,
+								  VariantArray &krefs, bool *changed) {
+	const bool isIndexSparse = index.Opts().IsSparse();
+	assert(!isIndexSparse || index.Fields().getTagsPathsLength() > 0);
+
+	if (isIndexSparse) {
+		try {
+			plNew.GetByJsonPath(index.Fields().getTagsPath(0), skrefs, index.KeyType());
+		} catch (const Error &) {
+			skrefs.resize(0);
+		}
+	} else {
+		plNew.Get(field, skrefs);
+	}
+
+	if (index.Opts().GetCollateMode() == CollateUTF8)
+		for (auto &key : skrefs) key.EnsureUTF8();
+
+	// Check for update
+	if (plOld) {
+		if (isIndexSparse) {
+			try {
+				plOld->GetByJsonPath(index.Fields().getTagsPath(0), krefs, index.KeyType());
+			} catch (const Error &) {
+				krefs.resize(0);
+			}
+		} else {
+			plOld->Get(field, krefs, index.Opts().IsArray());
+		}
+		if (changed) *changed = valuesChanged(krefs, skrefs);
+		for (auto key : krefs) index.Delete(key, id);
+		// Sparse indexes don't hold empty values
+		if (!krefs.size() && !isIndexSparse) index.Delete(Variant(), id);
+	}
+	// Put value to index
+	krefs.resize(0);
+	krefs.reserve(skrefs.size());
+	for (auto key : skrefs) krefs.push_back(index.Upsert(key, id));
+	// If no krefs upsert empty value to index
+	if (!isIndexSparse && !skrefs.size()) index.Upsert(Variant(), id);
+}
+
 void Namespace::ReplaceTagsMatcher(const TagsMatcher &tm, const RdxContext &ctx) {
 	assert(!items_.size() && repl_.slaveMode);
 	cancelCommit_ = true;
@@ -1070,6 +1276,7 @@ void Namespace::updateFieldsFromQuery(IdType itemId, const Query &q, bool store)
 		}
 	}
 
+	SortOrdersUpdater sortOrdersUpdater(*this, itemId, false);
 	PayloadValue &pv = items_[itemId];
 	Payload pl(payloadType_, pv);
 	repl_.dataHash ^= pl.GetHash();
@@ -1079,9 +1286,11 @@ void Namespace::updateFieldsFromQuery(IdType itemId, const Query &q, bool store)
 		indexes_[field]->Delete(Variant(pv), itemId);
 	}
 
+	IndexesMask updatedIndexes;
 	for (const UpdateEntry &updateField : q.updateFields_) {
 		int fieldIdx = 0;
 		bool isIndexedField = getIndexByName(updateField.column, fieldIdx);
+		updatedIndexes.set(fieldIdx);
 
 		Index &index = *indexes_[fieldIdx];
 		bool isIndexSparse = index.Opts().IsSparse();
@@ -1119,6 +1328,7 @@ void Namespace::updateFieldsFromQuery(IdType itemId, const Query &q, bool store)
 			item.SetField(updateField.column, values);
 			Variant tupleValue = indexes_[0]->Upsert(item.GetField(0), itemId);
 			pl.Set(0, {tupleValue});
+			updatedIndexes.set(0);
 		}
 	}
 
@@ -1147,14 +1357,10 @@ void Namespace::updateFieldsFromQuery(IdType itemId, const Query &q, bool store)
 		writeToStorage(pk.Slice(), data.Slice());
 	}
 
-	markUpdated();
+	markUpdated(&updatedIndexes, sortOrdersUpdater.Commit());
 }
 
 void Namespace::modifyItem(Item &item, const RdxContext &ctx, bool store, int mode, bool noLock) {
-	checkApplySlaveUpdate(item.GetLSN());
-
-	// Item to doUpsert
-	ItemImpl *itemImpl = item.impl_;
 	WLock lock(mtx_, defer_lock, &ctx);
 	PerfStatCalculatorMT calc(updatePerfCounter_, enablePerfCounters_);
 
@@ -1165,6 +1371,14 @@ void Namespace::modifyItem(Item &item, const RdxContext &ctx, bool store, int mo
 	}
 	calc.LockHit();
 
+	doModifyItem(item, ctx, store, mode);
+}
+
+void Namespace::doModifyItem(Item &item, const RdxContext &ctx, bool store, int mode) {
+	checkApplySlaveUpdate(item.GetLSN());
+
+	// Item to doUpsert
+	ItemImpl *itemImpl = item.impl_;
 	updateTagsMatcherFromItem(itemImpl);
 	auto newPl = itemImpl->GetPayload();
 
@@ -1177,6 +1391,8 @@ void Namespace::modifyItem(Item &item, const RdxContext &ctx, bool store, int mo
 	}
 
 	IdType id = exists ? realItem.first : createItem(newPl.RealSize());
+	IndexesMask updatedIndexes;
+	bool sortOrdersUpdated = false;
 	setFieldsBasedOnPrecepts(itemImpl);
 
 	int64_t lsn = item.GetLSN();
@@ -1190,7 +1406,9 @@ void Namespace::modifyItem(Item &item, const RdxContext &ctx, bool store, int mo
 	if (!isEmptyAfterStorageReload()) {
 		item.setLSN(lsn);
 		item.setID(id);
-		doUpsert(itemImpl, id, exists);
+		SortOrdersUpdater sortOrdersUpdater(*this, id, !exists);
+		doUpsert(itemImpl, id, exists, exists ? &updatedIndexes : nullptr);
+		sortOrdersUpdated = sortOrdersUpdater.Commit();
 	}
 
 	if (storage_ && store) {
@@ -1213,7 +1431,7 @@ void Namespace::modifyItem(Item &item, const RdxContext &ctx, bool store, int mo
 
 	observers_->OnModifyItem(lsn, name_, item.impl_, mode);
 
-	markUpdated();
+	markUpdated(exists && !isEmptyAfterStorageReload() ? &updatedIndexes : nullptr, sortOrdersUpdated);
 }
 
 // find id by PK. NOT THREAD SAFE!
@@ -1243,7 +1461,7 @@ pair<IdType, bool> Namespace::findByPK(ItemImpl *ritem, const RdxContext &ctx) {
 	return {-1, false};
 }
 
-void Namespace::optimizeIndexes(const RdxContext &ctx) {
+void Namespace::optimizeIndexes(MaintenanceScheduler &workers, const RdxContext &ctx) {
 	// This is read lock only atomics based implementation of rebuild indexes
 	// If sortOrdersBuilt_ is true, then indexes are completely built
 	// In this case reset sortOrdersBuilt_ to false and/or any idset's and sort orders builds are allowed only protected by write lock
@@ -1251,6 +1469,9 @@ void Namespace::optimizeIndexes(const RdxContext &ctx) {
 	int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 	auto lastUpdateTime = lastUpdateTime_.load(std::memory_order_acquire);
 
+	// Indexes must not be changed, while transaction copies them or writer is waiting for lock
+	unique_lock<Mutex::Gate> gateLck(mtx_.gate(), std::try_to_lock);
+	if (!gateLck.owns_lock()) return;
 	RLock lck(mtx_, &ctx);
 	if (!lastUpdateTime || !config_.optimizationTimeout || now - lastUpdateTime < config_.optimizationTimeout) {
 		return;
@@ -1276,40 +1497,73 @@ void Namespace::optimizeIndexes(const RdxContext &ctx) {
 
 	int i = 1;
 	int maxIndexWorkers = std::min(int(std::thread::hardware_concurrency()), config_.optimizationSortWorkers);
+	// Sort orders, which can be updated in place, are built with gaps, and positions of items are saved for updates
+	const bool updatable = sortOrdersUpdatable();
+	if (updatable) sortPositions_.Reset(getSortedIdxCount(), items_.size());
 	for (auto &idxIt : indexes_) {
 		if (idxIt->IsOrdered() && maxIndexWorkers != 0) {
-			NSUpdateSortedContext sortCtx(*this, i++);
+			NSUpdateSortedContext sortCtx(*this, i++, updatable ? kSortOrdersGap : 1);
 			idxIt->MakeSortOrders(sortCtx);
-			// Build in multiple threads
-			unique_ptr<thread[]> thrs(new thread[maxIndexWorkers]);
-			auto indexes = &this->indexes_;
-
-			for (int i = 0; i < maxIndexWorkers; i++) {
-				thrs[i] = std::thread(
-					[&](int i) {
-						for (int j = i; j < int(indexes->size()) && !cancelCommit_; j += maxIndexWorkers)
-							indexes->at(j)->UpdateSortedIds(sortCtx);
-					},
-					i);
+			// Build in parallel by maintenance workers
+			workers.Parallel(maxIndexWorkers, [&](unsigned i) {
+				for (int j = i; j < int(indexes_.size()) && !cancelCommit_; j += maxIndexWorkers) indexes_[j]->UpdateSortedIds(sortCtx);
+			});
+
+			if (updatable) {
+				const auto &ids2Sorts = sortCtx.ids2Sorts();
+				for (IdType id = 0; id < IdType(ids2Sorts.size()); ++id) {
+					sortPositions_.At(id, sortCtx.getCurSortId()) = (ids2Sorts[id] == SortIdUnexists) ? kSortOrdersHole : IdType(ids2Sorts[id]);
+				}
 			}
-			for (int i = 0; i < maxIndexWorkers; i++) thrs[i].join();
 		}
 		if (cancelCommit_) break;
 	}
 	sortOrdersBuilt_ = !cancelCommit_ && maxIndexWorkers;
+	if (!sortOrdersBuilt_) sortPositions_.Clear();
 	if (!cancelCommit_) {
 		lastUpdateTime_.store(0, std::memory_order_release);
 	}
 	logPrintf(LogTrace, "Namespace::optimizeIndexes(%s) leave %s", name_, cancelCommit_ ? "(cancelled by concurent update)" : "");
 }
 
+// Outdated data of indexes is prepared under read lock, built without namespace lock, and swapped under read lock again.
+// So writers are blocked only while snapshot of data is taken and while it's swapped
+void Namespace::rebuildOutdatedIndexes(const RdxContext &ctx) {
+	vector<pair<int, unique_ptr<Index::OutdatedRebuild>>> rebuilds;
+	uint64_t indexesVersion;
+	{
+		// Don't take snapshot, while transaction is running or writer is waiting for lock
+		unique_lock<Mutex::Gate> gateLck(mtx_.gate(), std::try_to_lock);
+		if (!gateLck.owns_lock()) return;
+		RLock lck(mtx_, &ctx);
+		for (int i = 0; i < int(indexes_.size()) && !cancelCommit_; ++i) {
+			auto rebuild = indexes_[i]->PrepareRebuild();
+			if (rebuild) rebuilds.emplace_back(i, std::move(rebuild));
+		}
+		indexesVersion = indexesVersion_;
+	}
+	if (rebuilds.empty()) return;
+
+	for (auto &rebuild : rebuilds) rebuild.second->Build();
+
+	RLock lck(mtx_, &ctx);
+	// Indexes were changed or replaced by transaction during build, so rebuilt data may not match them
+	if (indexesVersion != indexesVersion_) return;
+	for (auto &rebuild : rebuilds) indexes_[rebuild.first]->ApplyRebuild(*rebuild.second);
+}
+
 uint32_t Namespace::GetItemsCount() { return itemsCount_.load(); }
 
-void Namespace::markUpdated() {
+void Namespace::markUpdated(const IndexesMask *updatedIndexes, bool sortOrdersUpdated) {
 	itemsCount_ = items_.size();
-	sortOrdersBuilt_ = false;
+	if (!sortOrdersUpdated) resetSortOrders();
 	queryCache_->Clear();
 	joinCache_->Clear();
+	if (updatedIndexes) {
+		generations_.IndexesChanged(*updatedIndexes);
+	} else {
+		generations_.ItemsChanged();
+	}
 	lastUpdateTime_.store(
 		std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count(),
 		std::memory_order_release);
@@ -1323,7 +1577,7 @@ void Namespace::updateSelectTime() {
 int64_t Namespace::getLastSelectTime() const { return lastSelectTime_; }
 
 void Namespace::Select(QueryResults &result, SelectCtx &params, const RdxContext &ctx) {
-	if (params.query.entries.Size() == 1 && params.query.entries.IsEntry(0) && params.query.entries[0].index == kLSNIndexName) {
+	if (params.query.entries.Size() && params.query.entries.IsEntry(0) && params.query.entries[0].index == kLSNIndexName) {
 		WALSelecter selecter(this);
 		selecter(result, params);
 	} else {
@@ -1332,6 +1586,25 @@ void Namespace::Select(QueryResults &result, SelectCtx &params, const RdxContext
 	}
 }
 
+PreparedQuery::Plan::Ptr Namespace::BuildQueryPlan(const Query &tmpl, const RdxContext &ctx) {
+	RLock lck(mtx_, &ctx);
+	Query query(tmpl);
+	for (size_t i = 0; i < query.entries.Size(); ++i) {
+		if (!query.entries.IsEntry(i)) continue;
+		QueryEntry &entry = query.entries[i];
+		if (!getIndexByName(entry.index, entry.idxNo)) entry.idxNo = IndexValueType::SetByJsonPath;
+	}
+	for (SortingEntry &sortingEntry : query.sortingEntries_) {
+		if (!getIndexByName(sortingEntry.column, sortingEntry.index)) sortingEntry.index = IndexValueType::SetByJsonPath;
+	}
+	auto plan = QueryPreprocessor(this, &query.entries).BuildPlan(query);
+	for (SortingEntry &sortingEntry : plan->sortBy) {
+		if (!getIndexByName(sortingEntry.column, sortingEntry.index)) sortingEntry.index = IndexValueType::SetByJsonPath;
+	}
+	plan->indexesVersion = indexesVersion_;
+	return plan;
+}
+
 IndexDef Namespace::getIndexDefinition(size_t i) const {
 	assert(i < indexes_.size());
 	IndexDef indexDef;
@@ -1377,6 +1650,7 @@ NamespaceMemStat Namespace::GetMemStat(const RdxContext &ctx) {
 	ret.name = name_;
 	ret.joinCache = joinCache_->GetMemStat();
 	ret.queryCache = queryCache_->GetMemStat();
+	ret.resultsCache = resultsCache_->GetMemStat();
 
 	ret.itemsCount = items_.size() - free_.size();
 	for (auto &item : items_) {
@@ -1387,19 +1661,22 @@ NamespaceMemStat Namespace::GetMemStat(const RdxContext &ctx) {
 	ret.replication.walSize = wal_.heap_size();
 
 	ret.emptyItemsCount = free_.size();
+	ret.arena = arena_->GetMemStat();
 
-	ret.Total.dataSize = ret.dataSize + items_.capacity() * sizeof(PayloadValue);
-	ret.Total.cacheSize = ret.joinCache.totalSize + ret.queryCache.totalSize;
+	ret.Total.dataSize = ret.dataSize + items_.capacity() * sizeof(PayloadValue) + (ret.arena.totalSize - ret.arena.usedSize);
+	ret.Total.cacheSize = ret.joinCache.totalSize + ret.queryCache.totalSize + ret.resultsCache.totalSize;
 
 	ret.indexes.reserve(indexes_.size());
 	for (auto &idx : indexes_) {
 		auto istat = idx->GetMemStat();
-		istat.sortOrdersSize = idx->IsOrdered() ? (items_.size() * sizeof(IdType)) : 0;
-		ret.Total.indexesSize += istat.idsetPlainSize + istat.idsetBTreeSize + istat.sortOrdersSize + istat.fulltextSize + istat.columnSize;
+		istat.sortOrdersSize = idx->IsOrdered() ? (idx->SortOrders().size() * sizeof(IdType)) : 0;
+		ret.Total.indexesSize += istat.idsetPlainSize + istat.idsetBTreeSize + istat.idsetBitmapSize + istat.sortOrdersSize +
+								 istat.fulltextSize + istat.columnSize;
 		ret.Total.dataSize += istat.dataSize;
 		ret.Total.cacheSize += istat.idsetCache.totalSize;
 		ret.indexes.push_back(istat);
 	}
+	ret.Total.indexesSize += sortPositions_.HeapSize();
 
 	ret.storageOK = storage_ != nullptr;
 	ret.storagePath = dbpath_;
@@ -1566,7 +1843,7 @@ void Namespace::saveIndexesToStorage() {
 	saveReplStateToStorage();
 }
 
-void Namespace::saveReplStateToStorage() {
+void Namespace::saveReplStateToStorage(bool direct) {
 	if (!storage_) return;
 
 	logPrintf(LogTrace, "Namespace::saveReplStateToStorage (%s)", name_);
@@ -1576,7 +1853,7 @@ void Namespace::saveReplStateToStorage() {
 	JsonBuilder builder(ser);
 	getReplState().GetJSON(builder);
 	builder.End();
-	writeSysRecToStorage(ser.Slice(), kStorageReplStatePrefix, sysRecordsVersions_.replVersion, true);
+	writeSysRecToStorage(ser.Slice(), kStorageReplStatePrefix, sysRecordsVersions_.replVersion, direct);
 }
 
 bool Namespace::needToLoadData(const RdxContext &ctx) const {
@@ -1624,6 +1901,8 @@ void Namespace::EnableStorage(const string &path, StorageOpts opts, StorageType
 
 	storageOpts_ = opts;
 	updates_.reset(storage_->GetUpdatesCollection());
+	flushBatch_.reset();
+	flushRetry_ = false;
 	dbpath_ = dbpath;
 }
 
@@ -1646,63 +1925,28 @@ void Namespace::LoadFromStorage(const RdxContext &ctx) {
 
 	StorageOpts opts;
 	opts.FillCache(false);
-	size_t ldcount = 0;
 	logPrintf(LogTrace, "Loading items to '%s' from storage", name_);
 	unique_ptr<datastorage::Cursor> dbIter(storage_->GetCursor(opts));
-	ItemImpl item(payloadType_, tagsMatcher_);
-	item.Unsafe(true);
-	int errCount = 0;
-	int64_t maxLSN = -1;
-	Error lastErr = errOK;
 
 	uint64_t dataHash = repl_.dataHash;
 	repl_.dataHash = 0;
-	for (dbIter->Seek(kStorageItemPrefix);
-		 dbIter->Valid() && dbIter->GetComparator().Compare(dbIter->Key(), string_view(kStorageItemPrefix "\xFF")) < 0; dbIter->Next()) {
-		string_view dataSlice = dbIter->Value();
-		if (dataSlice.size() > 0) {
-			if (!pkFields().size()) {
-				throw Error(errLogic, "Can't load data storage of '%s' - there are no PK fields in ns", name_);
-			}
-			if (dataSlice.size() < sizeof(int64_t)) {
-				lastErr = Error(errParseBin, "Not enougth data in data slice");
-				logPrintf(LogTrace, "Error load item to '%s' from storage: '%s'", name_, lastErr.what());
-				errCount++;
-				continue;
-			}
-
-			// Read LSN
-			int64_t lsn = *reinterpret_cast<const int64_t *>(dataSlice.data());
-			assert(lsn >= 0);
-			maxLSN = std::max(maxLSN, lsn);
-			dataSlice = dataSlice.substr(sizeof(lsn));
-
-			auto err = item.FromCJSON(dataSlice);
-			if (!err.ok()) {
-				logPrintf(LogTrace, "Error load item to '%s' from storage: '%s'", name_, err.what());
-				errCount++;
-				lastErr = err;
-				continue;
-			}
-
-			IdType id = items_.size();
-			items_.emplace_back(PayloadValue(item.GetPayload().RealSize()));
-			item.Value().SetLSN(lsn);
-
-			doUpsert(&item, id, false);
-			ldcount += dataSlice.size();
-		}
+	dbIter->Seek(kStorageItemPrefix);
+	ItemsLoader::Result res;
+	{
+		ItemsLoader loader(*this);
+		res = loader.Load(*dbIter, string_view(kStorageItemPrefix "\xFF"));
 	}
-	if (!repl_.slaveMode) initWAL(maxLSN);
+	if (!repl_.slaveMode) initWAL(res.maxLSN);
 
 	logPrintf(LogInfo, "[%s] Done loading storage. %d items loaded (%d errors %s), lsn #%ld%s, total size=%dM, dataHash=%ld", name_,
-			  items_.size(), errCount, lastErr.what(), repl_.lastLsn, repl_.slaveMode ? " (slave)" : "", ldcount / (1024 * 1024),
+			  items_.size(), res.errCount, res.lastErr.what(), repl_.lastLsn, repl_.slaveMode ? " (slave)" : "", res.dataSize / (1024 * 1024),
 			  repl_.dataHash);
 	storageLoaded_ = true;
 	if (dataHash != repl_.dataHash) {
 		logPrintf(LogError, "[%s] Warning dataHash mismatch %lu != %lu", name_, dataHash, repl_.dataHash);
 		unflushedCount_.fetch_add(1, std::memory_order_release);
 	}
+	loadIndexesStateFromStorage();
 
 	markUpdated();
 }
@@ -1721,8 +1965,7 @@ void Namespace::initWAL(int64_t maxLSN) {
 	logPrintf(LogInfo, "[%s] WAL initalized lsn #%ld", name_, repl_.lastLsn);
 }
 
-void Namespace::removeExpiredItems(RdxActivityContext *ctx) {
-	const RdxContext rdxCtx{ctx};
+void Namespace::removeExpiredItems(const RdxContext &rdxCtx) {
 	WLock wlock(mtx_, &rdxCtx);
 	if (repl_.slaveMode) {
 		return;
@@ -1737,26 +1980,282 @@ void Namespace::removeExpiredItems(RdxActivityContext *ctx) {
 	}
 }
 
-void Namespace::BackgroundRoutine(RdxActivityContext *ctx) {
+// Items are moved by steps of limited size, and namespace lock is released between them, so readers and writers are not blocked for the
+// whole compaction. Items, allocated between steps, are placed out of the evacuated slabs anyway
+void Namespace::compactItems(const RdxContext &ctx) {
+	if (!arena_->NeedsCompaction()) return;
+	PayloadArena::Ptr arena;
+	{
+		WLock wlock(mtx_, &ctx);
+		arena = arena_;
+		if (!arena->BeginCompaction()) return;
+	}
+	size_t moved = 0;
+	try {
+		for (size_t pos = 0;;) {
+			WLock wlock(mtx_, &ctx);
+			// Namespace data may be replaced between steps
+			if (arena_ != arena) break;
+			const size_t end = std::min(items_.size(), pos + kCompactionStepItems);
+			for (; pos < end; ++pos) {
+				if (items_[pos].Compact(*arena)) ++moved;
+			}
+			if (pos >= items_.size()) break;
+		}
+	} catch (...) {
+		arena->EndCompaction();
+		throw;
+	}
+	arena->EndCompaction();
+	logPrintf(LogTrace, "Namespace::compactItems(%s) moved %d items", name_, moved);
+}
+
+int64_t Namespace::itemsExpirationTime() const {
+	int64_t expiration = 0;
+	for (const std::unique_ptr<Index> &index : indexes_) {
+		if (index->Type() != IndexTtl) continue;
+		const int64_t indexExpiration = index->GetMinExpirationTime();
+		if (indexExpiration && (!expiration || indexExpiration < expiration)) expiration = indexExpiration;
+	}
+	return expiration;
+}
+
+std::chrono::milliseconds Namespace::BackgroundFlush(const RdxContext &ctx) {
 	flushStorage(ctx);
-	optimizeIndexes(ctx);
-	removeExpiredItems(ctx);
+	return kStorageFlushPeriod;
+}
+
+std::chrono::milliseconds Namespace::BackgroundExpireItems(const RdxContext &ctx) {
+	auto getExpiration = [&]() {
+		RLock rlock(mtx_, &ctx);
+		return repl_.slaveMode ? 0 : itemsExpirationTime();
+	};
+	int64_t expiration = getExpiration();
+	const int64_t nowMs =
+		std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	// Item expires, when its TTL value plus expiration delay is less than current time in seconds
+	if (expiration && expiration < nowMs / 1000) {
+		removeExpiredItems(ctx);
+		expiration = getExpiration();
+	}
+	if (!expiration) return kMaxExpirationCheckPeriod;
+	const int64_t delayMs = (expiration + 1) * 1000 - nowMs;
+	return std::chrono::milliseconds(std::min<int64_t>(std::max<int64_t>(delayMs, 0), kMaxExpirationCheckPeriod.count()));
+}
+
+std::chrono::milliseconds Namespace::BackgroundOptimize(MaintenanceScheduler &workers, const RdxContext &ctx) {
+	if (bulkLoads_.load(std::memory_order_acquire)) return kOptimizationCheckPeriod;
+	tryToReload(ctx);
+	optimizeIndexes(workers, ctx);
+	rebuildOutdatedIndexes(ctx);
+	compactItems(ctx);
+	saveIndexesState(false, ctx);
+	return kOptimizationCheckPeriod;
+}
+
+bool Namespace::flushStorage(const RdxContext &ctx) {
+	std::unique_lock<std::mutex> flushLck;
+	shared_ptr<datastorage::IDataStorage> storage;
+	bool sync;
+	{
+		RLock rlock(mtx_, &ctx);
+		flushLck = std::unique_lock<std::mutex>(flush_mtx_);
+		if (!prepareFlush(storage, sync)) return false;
+	}
+	// Batch is written without namespace lock, so writers are not blocked by storage
+	writeFlushBatch(*storage, sync);
+	return true;
 }
 
-void Namespace::flushStorage(const RdxContext &ctx) {
-	RLock rlock(mtx_, &ctx);
-	if (storage_) {
-		if (unflushedCount_.load(std::memory_order_acquire) > 0) {
-			std::unique_lock<std::mutex> lck(storage_mtx_);
-			Error status = storage_->Write(StorageOpts().FillCache(), *(updates_.get()));
-			if (!status.ok()) throw Error(errLogic, "Error write ns '%s' to storage: %s", name_, status.what());
-			unflushedCount_.store(0, std::memory_order_release);
-			updates_->Clear();
-			saveReplStateToStorage();
+void Namespace::doFlushStorage() {
+	std::unique_lock<std::mutex> flushLck(flush_mtx_);
+	shared_ptr<datastorage::IDataStorage> storage;
+	bool sync;
+	if (prepareFlush(storage, sync)) writeFlushBatch(*storage, sync);
+}
+
+bool Namespace::prepareFlush(shared_ptr<datastorage::IDataStorage> &storage, bool &sync) {
+	if (!storage_) return false;
+	std::unique_lock<std::mutex> durableLck(durable_mtx_);
+	sync = requestedDurableLsn_ > durableLsn_;
+	durableLck.unlock();
+	if (!flushRetry_) {
+		if (unflushedCount_.load(std::memory_order_acquire) == 0 && !sync) return false;
+		if (!flushBatch_) flushBatch_.reset(storage_->GetUpdatesCollection());
+		// Replication state is written in the same batch with the updates, which it describes
+		saveReplStateToStorage(false);
+		std::unique_lock<std::mutex> lck(storage_mtx_);
+		std::swap(updates_, flushBatch_);
+		unflushedCount_.store(0, std::memory_order_release);
+		flushBatchLsn_ = getReplState().lastLsn;
+	}
+	storage = storage_;
+	durableLck.lock();
+	flushInProgress_ = true;
+	return true;
+}
+
+void Namespace::writeFlushBatch(datastorage::IDataStorage &storage, bool sync) {
+	Error status = storage.Write(StorageOpts().FillCache().Sync(sync), *flushBatch_);
+	flushRetry_ = !status.ok();
+	if (status.ok()) flushBatch_->Clear();
+	{
+		std::lock_guard<std::mutex> lck(durable_mtx_);
+		flushInProgress_ = false;
+		if (status.ok() && sync) durableLsn_ = std::max(durableLsn_, flushBatchLsn_);
+	}
+	durable_cv_.notify_all();
+	if (!status.ok()) throw Error(errLogic, "Error write ns '%s' to storage: %s", name_, status.what());
+}
+
+void Namespace::WaitDurable(int64_t lsn, const RdxContext &ctx) {
+	{
+		RLock rlock(mtx_, &ctx);
+		if (!storage_) return;
+		const int64_t lastLsn = getReplState().lastLsn;
+		if (lsn < 0 || lsn > lastLsn) lsn = lastLsn;
+	}
+	std::unique_lock<std::mutex> lck(durable_mtx_);
+	requestedDurableLsn_ = std::max(requestedDurableLsn_, lsn);
+	while (durableLsn_ < lsn) {
+		if (flushInProgress_) {
+			// Running flush may be not synced, or may not contain the required updates, so the next one is checked after it
+			durable_cv_.wait(lck);
+			continue;
+		}
+		lck.unlock();
+		// Nothing is flushed only if storage was closed
+		const bool flushed = flushStorage(ctx);
+		lck.lock();
+		if (!flushed) break;
+	}
+}
+
+// States of indexes are copied under read lock, and then they are serialized and written without it (as flush batch is)
+void Namespace::saveIndexesState(bool force, const RdxContext &ctx) {
+	using std::chrono::duration_cast;
+	using std::chrono::milliseconds;
+	const int64_t nowMs = duration_cast<milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	const int64_t lastSaveMs = indexesStateSaveMs_.load(std::memory_order_acquire);
+	if (!force && lastSaveMs && nowMs - lastSaveMs < duration_cast<milliseconds>(kIndexesStateSavePeriod).count()) return;
+
+	vector<std::pair<string, std::unique_ptr<Index::SavedState>>> states;
+	std::unique_lock<std::mutex> flushLck;
+	shared_ptr<datastorage::IDataStorage> storage;
+	bool flush, sync;
+	uint64_t dataHash;
+	size_t itemsCount;
+	{
+		RLock rlock(mtx_, &ctx);
+		if (!storage_ || !storageLoaded_) return;
+		for (const std::unique_ptr<Index> &index : indexes_) {
+			auto state = index->SaveState();
+			if (state) states.emplace_back(index->Name(), std::move(state));
+		}
+		if (states.empty()) return;
+		// State is valid only with the same items in storage
+		flushLck = std::unique_lock<std::mutex>(flush_mtx_);
+		flush = prepareFlush(storage, sync);
+		storage = storage_;
+		dataHash = repl_.dataHash;
+		itemsCount = items_.size() - free_.size();
+	}
+	indexesStateSaveMs_.store(nowMs, std::memory_order_release);
+	if (flush) writeFlushBatch(*storage, sync);
+	for (auto &state : states) {
+		WrSerializer ser;
+		state.second->Serialize(ser);
+		writeIndexStateToStorage(*storage, state.first, ser.Slice(), dataHash, itemsCount);
+	}
+}
+
+void Namespace::writeIndexStateToStorage(datastorage::IDataStorage &storage, const string &indexName, string_view data, uint64_t dataHash,
+										 size_t itemsCount) {
+	const string key = kStorageIndexStatePrefix "." + indexName;
+	std::unique_lock<std::mutex> lck(storage_mtx_);
+	uint64_t oldChunksCount = 0;
+	string header;
+	if (storage.Read(StorageOpts(), key, header).ok()) {
+		try {
+			Serializer ser(header);
+			ser.GetUInt64();
+			ser.GetVarUint();
+			oldChunksCount = ser.GetVarUint();
+		} catch (const Error &) {
+		}
+	}
+	// Header is removed first, so partially written state will never be loaded
+	storage.Delete(StorageOpts(), key);
+
+	uint64_t chunksCount = 0;
+	for (size_t pos = 0; pos < data.size(); pos += kIndexStateChunkSize, ++chunksCount) {
+		Error err = storage.Write(StorageOpts(), key + "#" + std::to_string(chunksCount), data.substr(pos, kIndexStateChunkSize));
+		if (!err.ok()) {
+			logPrintf(LogError, "[%s] Error saving state of index '%s' to storage: %s", name_, indexName, err.what());
+			return;
+		}
+	}
+	for (uint64_t i = chunksCount; i < oldChunksCount; ++i) storage.Delete(StorageOpts(), key + "#" + std::to_string(i));
+
+	WrSerializer ser;
+	ser.PutUInt64(dataHash);
+	ser.PutVarUint(itemsCount);
+	ser.PutVarUint(chunksCount);
+	Error err = storage.Write(StorageOpts().Sync(), key, ser.Slice());
+	if (!err.ok()) {
+		logPrintf(LogError, "[%s] Error saving state of index '%s' to storage: %s", name_, indexName, err.what());
+		return;
+	}
+	logPrintf(LogInfo, "[%s] State of index '%s' saved to storage (%dKB)", name_, indexName, data.size() / 1024);
+}
+
+void Namespace::loadIndexesStateFromStorage() {
+	for (const std::unique_ptr<Index> &index : indexes_) {
+		const string key = kStorageIndexStatePrefix "." + index->Name();
+		string header;
+		if (!storage_->Read(StorageOpts().FillCache(false), key, header).ok()) continue;
+		try {
+			Serializer ser(header);
+			const uint64_t dataHash = ser.GetUInt64();
+			const uint64_t itemsCount = ser.GetVarUint();
+			const uint64_t chunksCount = ser.GetVarUint();
+			if (dataHash != repl_.dataHash || itemsCount != items_.size() - free_.size()) {
+				logPrintf(LogInfo, "[%s] Saved state of index '%s' is outdated", name_, index->Name());
+				continue;
+			}
+			string data, chunk;
+			for (uint64_t i = 0; i < chunksCount; ++i) {
+				Error err = storage_->Read(StorageOpts().FillCache(false), key + "#" + std::to_string(i), chunk);
+				if (!err.ok()) throw err;
+				data.append(chunk);
+			}
+			if (index->LoadState(data)) {
+				logPrintf(LogInfo, "[%s] State of index '%s' loaded from storage", name_, index->Name());
+			}
+		} catch (const Error &err) {
+			logPrintf(LogError, "[%s] Error loading state of index '%s' from storage: %s", name_, index->Name(), err.what());
 		}
 	}
 }
 
+void Namespace::removeIndexStateFromStorage(const string &indexName) {
+	if (!storage_) return;
+	const string key = kStorageIndexStatePrefix "." + indexName;
+	std::unique_lock<std::mutex> lck(storage_mtx_);
+	string header;
+	if (!storage_->Read(StorageOpts(), key, header).ok()) return;
+	storage_->Delete(StorageOpts(), key);
+	try {
+		Serializer ser(header);
+		ser.GetUInt64();
+		ser.GetVarUint();
+		const uint64_t chunksCount = ser.GetVarUint();
+		for (uint64_t i = 0; i < chunksCount; ++i) storage_->Delete(StorageOpts(), key + "#" + std::to_string(i));
+	} catch (const Error &err) {
+		logPrintf(LogError, "[%s] Error removing state of index '%s' from storage: %s", name_, indexName, err.what());
+	}
+}
+
 void Namespace::DeleteStorage(const RdxContext &ctx) {
 	WLock lck(mtx_, &ctx);
 	deleteStorage();
@@ -1764,7 +2263,10 @@ void Namespace::DeleteStorage(const RdxContext &ctx) {
 
 void Namespace::CloseStorage(const RdxContext &ctx) {
 	flushStorage(ctx);
+	saveIndexesState(true, ctx);
 	WLock lck(mtx_, &ctx);
+	std::lock_guard<std::mutex> flushLck(flush_mtx_);
+	flushBatch_.reset();
 	dbpath_.clear();
 	storage_.reset();
 }
@@ -1782,7 +2284,7 @@ bool Namespace::tryToReload(const RdxContext &ctx) {
 }
 
 void Namespace::reloadStorage() {
-	unique_lock<shared_timed_mutex> lk(mtx_);
+	unique_lock<Mutex> lk(mtx_);
 	items_.clear();
 	for (auto it = indexesNames_.begin(); it != indexesNames_.end();) {
 		payloadType_.Drop(it->first);
@@ -1790,6 +2292,7 @@ void Namespace::reloadStorage() {
 	}
 	indexes_.clear();
 	free_.clear();
+	resetSortOrders();
 	IndexDef tupleIndexDef(kTupleName, {}, IndexStrStore, IndexOpts());
 	addIndex(tupleIndexDef);
 	loadIndexesFromStorage();
@@ -1914,6 +2417,179 @@ int Namespace::getSortedIdxCount() const {
 void Namespace::updateSortedIdxCount() {
 	int sortedIdxCount = getSortedIdxCount();
 	for (auto &idx : indexes_) idx->SetSortedIdxCount(sortedIdxCount);
+	if (!sortPositions_.Empty() && sortPositions_.SortedIdxCount() != sortedIdxCount) resetSortOrders();
+}
+
+// Sort orders are updated in place, only if each item has exactly one key in each ordered index
+bool Namespace::sortOrdersUpdatable() const {
+	for (auto &idx : indexes_) {
+		if (idx->IsOrdered() && (idx->Opts().IsArray() || idx->Opts().IsSparse())) return false;
+	}
+	return true;
+}
+
+void Namespace::resetSortOrders() {
+	sortOrdersBuilt_ = false;
+	sortPositions_.Clear();
+}
+
+// Gets keys of item in index. Empty value of non sparse index is represented by null key
+void Namespace::getIndexKeys(Payload &pl, int field, VariantArray &keys) const {
+	const Index &index = *indexes_[field];
+	if (field >= indexes_.firstCompositePos()) {
+		keys.resize(0);
+		keys.push_back(Variant(*pl.Value()));
+		return;
+	}
+	if (index.Opts().IsSparse()) {
+		pl.GetByJsonPath(index.Fields().getTagsPath(0), keys, index.KeyType());
+	} else {
+		pl.Get(field, keys, index.Opts().IsArray());
+		if (keys.empty()) keys.push_back(Variant());
+	}
+}
+
+// Moves updated or inserted item to the proper positions in sort orders
+bool Namespace::updateSortPositions(IdType id) {
+	Payload pl(payloadType_, items_[id]);
+	VariantArray keys;
+	const size_t maxSortOrdersSize = 2 * kSortOrdersGap * (items_.size() - free_.size()) + kMinSortOrdersRebalanceWindow;
+	for (int field = 0; field < indexes_.totalSize(); ++field) {
+		Index &index = *indexes_[field];
+		if (!index.IsOrdered()) continue;
+		getIndexKeys(pl, field, keys);
+		if (keys.size() != 1 || keys[0].Type() == KeyValueNull) return false;
+
+		const IdType pos = sortPositions_.At(id, index.SortId());
+		IdType left, right;
+		if (index.GetSortPositionBounds(keys[0], pos, left, right)) continue;
+
+		IdType newPos;
+		if (right == std::numeric_limits<IdType>::max()) {
+			newPos = left + kSortOrdersGap;
+		} else if (right - left > 1) {
+			newPos = left + (right - left) / 2;
+		} else {
+			newPos = rebalanceSortOrder(index, id, left);
+			if (newPos == kSortOrdersHole) return false;
+		}
+		if (size_t(pos) < index.SortOrders().size() && index.SortOrders()[pos] == id) index.SetSortOrder(pos, kSortOrdersHole);
+		index.SetSortOrder(newPos, id);
+		moveSortPosition(id, index.SortId(), pos, newPos);
+		// Free positions are left behind moved items, so too sparse sort order has to be rebuilt
+		if (index.SortOrders().size() > maxSortOrdersSize) return false;
+	}
+	return true;
+}
+
+// Frees positions of deleted item in sort orders
+void Namespace::releaseSortPositions(IdType id) {
+	for (auto &index : indexes_) {
+		if (!index->IsOrdered()) continue;
+		IdType &pos = sortPositions_.At(id, index->SortId());
+		if (size_t(pos) < index->SortOrders().size() && index->SortOrders()[pos] == id) index->SetSortOrder(pos, kSortOrdersHole);
+		pos = kSortOrdersHole;
+	}
+}
+
+// Spreads items evenly in the window of sort order around position left, to make room for item id right after it.
+// Window is doubled until it is sparse enough. Returns new position of item or kSortOrdersHole, if there is no such window
+IdType Namespace::rebalanceSortOrder(Index &sortIndex, IdType id, IdType left) {
+	struct Move {
+		IdType id, from, to;
+	};
+	const vector<IdType> &sortOrders = sortIndex.SortOrders();
+	for (IdType width = kMinSortOrdersRebalanceWindow; width <= kMaxSortOrdersRebalanceWindow; width *= 2) {
+		const IdType begin = std::max(IdType(0), left + 1 - width / 2);
+		// Window may exceed sort order, positions after its end are free
+		const IdType end = std::min(begin + width, IdType(sortOrders.size()));
+		size_t count = 0;
+		for (IdType pos = begin; pos < end; ++pos) {
+			if (sortOrders[pos] != kSortOrdersHole && sortOrders[pos] != id) ++count;
+		}
+		if ((count + 1) * 4 > size_t(width) * 3) continue;
+
+		vector<Move> moves;
+		moves.reserve(count);
+		size_t itemIdx = 0;
+		for (IdType pos = begin; pos < end; ++pos) {
+			if (sortOrders[pos] == kSortOrdersHole || sortOrders[pos] == id) continue;
+			if (pos <= left) ++itemIdx;
+			moves.push_back({sortOrders[pos], pos, kSortOrdersHole});
+		}
+		auto slot = [&](size_t idx) { return begin + IdType((2 * idx + 1) * size_t(width) / (2 * (count + 1))); };
+		for (size_t i = 0; i < moves.size(); ++i) moves[i].to = slot(i < itemIdx ? i : i + 1);
+
+		for (auto &move : moves) {
+			if (move.from != move.to) sortIndex.SetSortOrder(move.from, kSortOrdersHole);
+		}
+		auto apply = [&](const Move &move) {
+			sortIndex.SetSortOrder(move.to, move.id);
+			moveSortPosition(move.id, sortIndex.SortId(), move.from, move.to);
+		};
+		// Sort orders kept in btrees can't hold the same position twice, so target position has to be free, when item is moved there:
+		// items are moved to the left in ascending order, and to the right in descending order
+		for (auto &move : moves) {
+			if (move.to < move.from) apply(move);
+		}
+		for (auto it = moves.rbegin(); it != moves.rend(); ++it) {
+			if (it->to > it->from) apply(*it);
+		}
+		return slot(itemIdx);
+	}
+	return kSortOrdersHole;
+}
+
+// Replaces position of item in sort order in idsets of all indexes
+void Namespace::moveSortPosition(IdType id, SortType sortId, IdType from, IdType to) {
+	sortPositions_.At(id, sortId) = to;
+	Payload pl(payloadType_, items_[id]);
+	VariantArray keys;
+	// Tuple (field 0) isn't indexed
+	for (int field = 1; field < indexes_.totalSize(); ++field) {
+		getIndexKeys(pl, field, keys);
+		if (!keys.empty()) indexes_[field]->MoveSortPosition(keys, sortId, from, to);
+	}
+}
+
+Namespace::SortOrdersUpdater::SortOrdersUpdater(Namespace &ns, IdType id, bool newItem)
+	: ns_(ns), id_(id), active_(ns.sortOrdersBuilt_ && !ns.sortPositions_.Empty()) {
+	if (!active_) return;
+	ns_.sortPositions_.Reserve(ns_.items_.size());
+	if (newItem) {
+		// New item is placed to the end of sort orders, until its keys are known
+		for (auto &index : ns_.indexes_) {
+			if (!index->IsOrdered()) continue;
+			const IdType pos = index->SortOrders().size();
+			index->SetSortOrder(pos, id_);
+			ns_.sortPositions_.At(id_, index->SortId()) = pos;
+		}
+	}
+	for (auto &index : ns_.indexes_) index->SetSortPositions(&ns_.sortPositions_);
+}
+
+Namespace::SortOrdersUpdater::~SortOrdersUpdater() {
+	if (!active_) return;
+	release();
+	ns_.resetSortOrders();
+}
+
+bool Namespace::SortOrdersUpdater::Commit() {
+	if (!active_) return false;
+	release();
+	bool updated = true;
+	if (ns_.items_.exists(id_)) {
+		updated = ns_.updateSortPositions(id_);
+	} else {
+		ns_.releaseSortPositions(id_);
+	}
+	active_ = false;
+	if (!updated) ns_.resetSortOrders();
+	return updated;
+}
+
+void Namespace::SortOrdersUpdater::release() {
+	for (auto &index : ns_.indexes_) index->SetSortPositions(nullptr);
 }
 
 IdType Namespace::createItem(size_t realSize) {
@@ -1923,16 +2599,19 @@ IdType Namespace::createItem(size_t realSize) {
 		free_.pop_back();
 		assert(id < IdType(items_.size()));
 		assert(items_[id].IsFree());
-		items_[id] = PayloadValue(realSize);
+		items_[id] = PayloadValue(realSize, *arena_);
 	} else {
 		id = items_.size();
-		items_.emplace_back(PayloadValue(realSize));
+		items_.emplace_back(PayloadValue(realSize, *arena_));
 	}
 	return id;
 }
 
 void Namespace::deleteStorage() {
+	std::lock_guard<std::mutex> flushLck(flush_mtx_);
 	if (storage_) {
+		flushBatch_.reset();
+		flushRetry_ = false;
 		storage_->Destroy(dbpath_);
 		dbpath_.clear();
 		storage_.reset();
@@ -1943,6 +2622,8 @@ void Namespace::doRename(Namespace::Ptr dst, const std::string &newName, const s
 	std::string dbpath;
 	flushStorage(ctx);
 	WLock srcLck(mtx_, &ctx);
+	// Storage is reopened, so it can't be written by background flush
+	std::lock_guard<std::mutex> flushLck(flush_mtx_);
 	if (dst) {
 		dst->mtx_.lock();
 		dbpath = dst->dbpath_;
@@ -2037,9 +2718,7 @@ int64_t Namespace::GetSerial(const string &field) {
 }
 
 void Namespace::FillResult(QueryResults &result, IdSet::Ptr ids) const {
-	for (auto &id : *ids) {
-		result.Add({id, items_[id], 0, 0});
-	}
+	ids->ForEach([&](IdType id) { result.Add({id, items_[id], 0, 0}); });
 }
 
 void Namespace::GetFromJoinCache(JoinCacheRes &ctx) const {
@@ -1,7 +1,10 @@
 ﻿#pragma once
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include "core/cjson/tagsmatcher.h"
 #include "core/dbconfig.h"
@@ -13,8 +16,10 @@
 #include "index/keyentry.h"
 #include "joincache.h"
 #include "namespacedef.h"
+#include "payload/payloadarena.h"
 #include "payload/payloadiface.h"
 #include "perfstatcounter.h"
+#include "query/preparedquery.h"
 #include "querycache.h"
 #include "replicator/updatesobserver.h"
 #include "replicator/waltracker.h"
@@ -34,6 +39,7 @@ using std::vector;
 using reindexer::datastorage::StorageType;
 
 class Index;
+class MaintenanceScheduler;
 struct SelectCtx;
 struct JoinPreResult;
 class QueryResults;
@@ -45,7 +51,40 @@ class RdxContext;
 class RdxActivityContext;
 
 class Namespace {
-	using Mutex = MarkedMutex<shared_timed_mutex, MutexMark::Namespace>;
+	// Namespace mutex with additional gate for the exclusive owners.
+	// While the gate is held, other writers are blocked, but readers are still able to acquire shared lock.
+	// Used to apply large transactions on the namespace copy without blocking selects
+	class Mutex : public MarkedMutex<shared_timed_mutex, MutexMark::Namespace> {
+	public:
+		using Base = MarkedMutex<shared_timed_mutex, MutexMark::Namespace>;
+		using Gate = MarkedMutex<std::timed_mutex, MutexMark::Namespace>;
+
+		void lock() {
+			gate_.lock();
+			Base::lock();
+		}
+		bool try_lock() {
+			if (!gate_.try_lock()) return false;
+			if (Base::try_lock()) return true;
+			gate_.unlock();
+			return false;
+		}
+		template <typename Rep, typename Period>
+		bool try_lock_for(const std::chrono::duration<Rep, Period> &timeout) {
+			if (!gate_.try_lock_for(timeout)) return false;
+			if (Base::try_lock_for(timeout)) return true;
+			gate_.unlock();
+			return false;
+		}
+		void unlock() {
+			Base::unlock();
+			gate_.unlock();
+		}
+		Gate &gate() { return gate_; }
+
+	private:
+		Gate gate_;
+	};
 
 protected:
 	friend class NsSelecter;
@@ -53,19 +92,21 @@ protected:
 	friend class WALSelecter;
 	friend class NsSelectFuncInterface;
 	friend class ReindexerImpl;
+	friend class ItemsLoader;
 	friend QueryPreprocessor;
 	friend SelectIteratorContainer;
 
 	class NSUpdateSortedContext : public UpdateSortedContext {
 	public:
-		NSUpdateSortedContext(const Namespace &ns, SortType curSortId)
-			: ns_(ns), sorted_indexes_(ns_.getSortedIdxCount()), curSortId_(curSortId) {
+		NSUpdateSortedContext(const Namespace &ns, SortType curSortId, int sortOrdersGap)
+			: ns_(ns), sorted_indexes_(ns_.getSortedIdxCount()), curSortId_(curSortId), sortOrdersGap_(sortOrdersGap) {
 			ids2Sorts_.reserve(ns.items_.size());
 			for (IdType i = 0; i < IdType(ns_.items_.size()); i++)
 				ids2Sorts_.push_back(ns_.items_[i].IsFree() ? SortIdUnexists : SortIdUnfilled);
 		}
 		int getSortedIdxCount() const override { return sorted_indexes_; }
 		SortType getCurSortId() const override { return curSortId_; }
+		int getSortOrdersGap() const override { return sortOrdersGap_; }
 		const vector<SortType> &ids2Sorts() const override { return ids2Sorts_; }
 		vector<SortType> &ids2Sorts() override { return ids2Sorts_; }
 
@@ -73,9 +114,30 @@ protected:
 		const Namespace &ns_;
 		const int sorted_indexes_;
 		const IdType curSortId_;
+		const int sortOrdersGap_;
 		vector<SortType> ids2Sorts_;
 	};
 
+	// Keeps built sort orders actual, while item is modified: idsets of indexes are updated in place, and then item is moved to the proper
+	// positions in sort orders. If modification is not finished by Commit, sort orders are reset and will be rebuilt by optimizeIndexes
+	class SortOrdersUpdater {
+	public:
+		SortOrdersUpdater(Namespace &ns, IdType id, bool newItem);
+		SortOrdersUpdater(const SortOrdersUpdater &) = delete;
+		SortOrdersUpdater &operator=(const SortOrdersUpdater &) = delete;
+		~SortOrdersUpdater();
+		// Finishes modification (or deletion) of item
+		// @return true, if sort orders are still built
+		bool Commit();
+
+	private:
+		void release();
+
+		Namespace &ns_;
+		const IdType id_;
+		bool active_;
+	};
+
 	class IndexesStorage : public vector<unique_ptr<Index>> {
 	public:
 		using Base = vector<unique_ptr<Index>>;
@@ -135,20 +197,37 @@ public:
 	void Update(Item &item, const RdxContext &ctx, bool store = true);
 	void Update(const Query &query, QueryResults &result, const RdxContext &ctx, int64_t lsn = -1, bool noLock = false);
 	void Upsert(Item &item, const RdxContext &ctx, bool store = true, bool noLock = false);
+	// Upsert items under the single lock acquisition
+	void UpsertBulk(std::vector<Item> &items, const RdxContext &ctx);
+	// Modify items with per-item modes under the single lock acquisition. Result of each item modification is returned in statuses
+	void ModifyBulk(std::vector<Item> &items, const std::vector<ItemModifyMode> &modes, std::vector<Error> &statuses, const RdxContext &ctx);
+	// Bulk load (e.g. of replication snapshot) is in progress, so indexes are not optimized until its end
+	void BeginBulkLoad() { bulkLoads_.fetch_add(1, std::memory_order_acq_rel); }
+	void EndBulkLoad() { bulkLoads_.fetch_sub(1, std::memory_order_acq_rel); }
 
 	void Delete(Item &item, const RdxContext &ctx, bool noLock = false);
 	void Delete(const Query &query, QueryResults &result, const RdxContext &ctx, int64_t lsn = -1, bool noLock = false);
 	void Truncate(const RdxContext &ctx, int64_t lsn = -1, bool noLock = false);
 
 	void Select(QueryResults &result, SelectCtx &params, const RdxContext &);
+	// Build plan of prepared query for current indexes: resolve its entries to indexes, merge and substitute them, and detect sort order
+	PreparedQuery::Plan::Ptr BuildQueryPlan(const Query &tmpl, const RdxContext &ctx);
+	// Version of indexes. It's changed on each change of indexes, and is unique among all the namespaces
+	uint64_t IndexesVersion() const { return indexesVersion_.load(std::memory_order_acquire); }
 	NamespaceDef GetDefinition(const RdxContext &ctx);
 	NamespaceMemStat GetMemStat(const RdxContext &);
 	NamespacePerfStat GetPerfStat(const RdxContext &);
 	void ResetPerfStat(const RdxContext &);
 	vector<string> EnumMeta(const RdxContext &ctx);
 
-	void BackgroundRoutine(RdxActivityContext *);
+	// Background maintenance routines, which are run by MaintenanceScheduler. Each of them returns delay until its next run
+	std::chrono::milliseconds BackgroundFlush(const RdxContext &);
+	std::chrono::milliseconds BackgroundExpireItems(const RdxContext &);
+	std::chrono::milliseconds BackgroundOptimize(MaintenanceScheduler &workers, const RdxContext &);
 	void CloseStorage(const RdxContext &);
+	// Wait until changes up to lsn are written to storage with sync. If lsn < 0, waits for all the changes, made before the call.
+	// Concurrent waiters share the same synced write (group commit)
+	void WaitDurable(int64_t lsn, const RdxContext &);
 
 	Transaction NewTransaction(const RdxContext &ctx);
 	void CommitTransaction(Transaction &tx, const RdxContext &ctx);
@@ -193,20 +272,39 @@ protected:
 	void saveIndexesToStorage();
 	Error loadLatestSysRecord(string_view baseSysTag, uint64_t &version, string &content);
 	bool loadIndexesFromStorage();
-	void saveReplStateToStorage();
+	void saveReplStateToStorage(bool direct = true);
 	void loadReplStateFromStorage();
+	// Saves changed states of indexes. Unless force is set, they are saved not more often than once per kIndexesStateSavePeriod
+	void saveIndexesState(bool force, const RdxContext &);
+	void loadIndexesStateFromStorage();
+	void writeIndexStateToStorage(datastorage::IDataStorage &storage, const string &indexName, string_view data, uint64_t dataHash,
+								  size_t itemsCount);
+	void removeIndexStateFromStorage(const string &indexName);
 	bool isEmptyAfterStorageReload() const;
 
 	void initWAL(int64_t maxLSN);
 
-	void markUpdated();
-	void doUpsert(ItemImpl *ritem, IdType id, bool doUpdate);
+	/// Invalidate caches and mark namespace as updated
+	/// @param updatedIndexes - Indexes, which values were changed by update of existing items, or nullptr, if items were inserted or deleted
+	/// @param sortOrdersUpdated - Built sort orders were kept actual by SortOrdersUpdater, otherwise they are reset
+	void markUpdated(const IndexesMask *updatedIndexes = nullptr, bool sortOrdersUpdated = false);
+	bool needNamespaceCopy(const Transaction &tx, const RdxContext &ctx) const;
+	void commitTransactionOnCopy(Transaction &tx, const RdxContext &ctx);
+	void applyTransactionSteps(Transaction &tx, const RdxContext &ctx);
+	void swapContents(Namespace &other);
+	void doUpsert(ItemImpl *ritem, IdType id, bool doUpdate, IndexesMask *updatedIndexes = nullptr);
+	static void upsertIndexValues(Index &index, int field, Payload &plNew, Payload *plOld, IdType id, VariantArray &skrefs,
+								  VariantArray &krefs, bool *changed = nullptr);
 	void modifyItem(Item &item, const RdxContext &ctx, bool store = true, int mode = ModeUpsert, bool noLock = false);
+	// Modify/delete item. Namespace must be already locked
+	void doModifyItem(Item &item, const RdxContext &ctx, bool store, int mode);
+	void doDeleteItem(Item &item, const RdxContext &ctx);
 	void updateFieldsFromQuery(IdType itemId, const Query &q, bool store = true);
 	void updateTagsMatcherFromItem(ItemImpl *ritem);
 	void updateItems(PayloadType oldPlType, const FieldsSet &changedFields, int deltaFields);
 	void doDelete(IdType id);
-	void optimizeIndexes(const RdxContext &);
+	void optimizeIndexes(MaintenanceScheduler &workers, const RdxContext &);
+	void rebuildOutdatedIndexes(const RdxContext &);
 	void insertIndex(Index *newIndex, int idxNo, const string &realName);
 	void addIndex(const IndexDef &indexDef);
 	void addCompositeIndex(const IndexDef &indexDef);
@@ -216,7 +314,9 @@ protected:
 	void dropIndex(const IndexDef &index);
 	void addToWAL(const IndexDef &indexDef, WALRecType type);
 	VariantArray preprocessUpdateFieldValues(const UpdateEntry &updateEntry, IdType itemId);
-	void removeExpiredItems(RdxActivityContext *);
+	void removeExpiredItems(const RdxContext &);
+	int64_t itemsExpirationTime() const;
+	void compactItems(const RdxContext &);
 
 	void recreateCompositeIndexes(int startIdx, int endIdx);
 	void onConfigUpdated(DBConfigProvider &configProvider, const RdxContext &ctx);
@@ -225,12 +325,22 @@ protected:
 	IndexDef getIndexDefinition(size_t) const;
 
 	string getMeta(const string &key);
-	void flushStorage(const RdxContext &);
+	bool flushStorage(const RdxContext &);
+	void doFlushStorage();
+	bool prepareFlush(shared_ptr<datastorage::IDataStorage> &storage, bool &sync);
+	void writeFlushBatch(datastorage::IDataStorage &storage, bool sync);
 	void putMeta(const string &key, const string_view &data);
 
 	pair<IdType, bool> findByPK(ItemImpl *ritem, const RdxContext &);
 	int getSortedIdxCount() const;
 	void updateSortedIdxCount();
+	bool sortOrdersUpdatable() const;
+	void resetSortOrders();
+	void getIndexKeys(Payload &pl, int field, VariantArray &keys) const;
+	bool updateSortPositions(IdType id);
+	void releaseSortPositions(IdType id);
+	IdType rebalanceSortOrder(Index &sortIndex, IdType id, IdType left);
+	void moveSortPosition(IdType id, SortType sortId, IdType from, IdType to);
 	void setFieldsBasedOnPrecepts(ItemImpl *ritem);
 
 	void PutToJoinCache(JoinCacheRes &res, std::shared_ptr<JoinPreResult> preResult) const;
@@ -257,6 +367,8 @@ protected:
 	// All items with data
 	Items items_;
 	vector<IdType> free_;
+	// Allocator of items data
+	PayloadArena::Ptr arena_;
 	// Namespace name
 	string name_;
 	// Payload types
@@ -272,14 +384,37 @@ protected:
 	mutable Mutex mtx_;
 	std::mutex storage_mtx_;
 
+	// Group commit of storage updates. Writers accumulate updates in updates_, while the previous batch is written from flushBatch_
+	// without namespace lock. Flushes are serialized by flush_mtx_. Lock order is mtx_, flush_mtx_, storage_mtx_
+	std::mutex flush_mtx_;
+	datastorage::UpdatesCollection::Ptr flushBatch_;
+	// LSN of the last update in flushBatch_
+	int64_t flushBatchLsn_ = -1;
+	// flushBatch_ wasn't written due to error, and has to be written again before the next batch
+	bool flushRetry_ = false;
+	// Time of the last save of indexes states (ms of steady clock), 0 - states were not saved yet
+	std::atomic<int64_t> indexesStateSaveMs_{0};
+	std::mutex durable_mtx_;
+	std::condition_variable durable_cv_;
+	int64_t durableLsn_ = -1;
+	int64_t requestedDurableLsn_ = -1;
+	bool flushInProgress_ = false;
+
 	// Commit phases state
 	std::atomic<bool> sortOrdersBuilt_;
+	// Count of bulk loads in progress
+	std::atomic<int> bulkLoads_{0};
+	// Positions of items in built sort orders. It's empty, if sort orders can't be updated in place
+	SortPositions sortPositions_;
 
 	unordered_map<string, string> meta_;
 
 	string dbpath_;
 
 	shared_ptr<QueryCache> queryCache_;
+	shared_ptr<QueryResultsCache> resultsCache_;
+	DataGenerations generations_;
+	std::atomic<uint64_t> indexesVersion_;
 
 	int sparseIndexesCount_ = 0;
 	VariantArray krefs, skrefs;
@@ -35,6 +35,14 @@ void NamespaceMemStat::GetJSON(WrSerializer &ser) {
 		auto obj = builder.Object("query_cache");
 		queryCache.GetJSON(obj);
 	}
+	{
+		auto obj = builder.Object("results_cache");
+		resultsCache.GetJSON(obj);
+	}
+	{
+		auto obj = builder.Object("arena");
+		arena.GetJSON(obj);
+	}
 
 	auto arr = builder.Array("indexes");
 	for (auto &index : indexes) {
@@ -48,6 +56,26 @@ void LRUCacheMemStat::GetJSON(JsonBuilder &builder) {
 	builder.Put("items_count", itemsCount);
 	builder.Put("empty_count", emptyCount);
 	builder.Put("hit_count_limit", hitCountLimit);
+	builder.Put("hits_count", hitsCount);
+	builder.Put("misses_count", missesCount);
+
+	auto arr = builder.Array("shards");
+	for (auto &shard : shards) {
+		auto obj = arr.Object();
+		obj.Put("total_size", shard.totalSize);
+		obj.Put("items_count", shard.itemsCount);
+		obj.Put("hits_count", shard.hitsCount);
+		obj.Put("misses_count", shard.missesCount);
+	}
+}
+
+void PayloadArenaMemStat::GetJSON(JsonBuilder &builder) {
+	builder.Put("regions_count", regionsCount);
+	builder.Put("slabs_count", slabsCount);
+	builder.Put("blocks_count", blocksCount);
+	builder.Put("total_size", totalSize);
+	builder.Put("used_size", usedSize);
+	builder.Put("fragmentation", totalSize ? double(totalSize - usedSize) / totalSize : 0.0);
 }
 
 void IndexMemStat::GetJSON(JsonBuilder &builder) {
@@ -55,11 +83,16 @@ void IndexMemStat::GetJSON(JsonBuilder &builder) {
 	if (dataSize) builder.Put("data_size", dataSize);
 	if (idsetBTreeSize) builder.Put("idset_btree_size", idsetBTreeSize);
 	if (idsetPlainSize) builder.Put("idset_plain_size", idsetPlainSize);
+	if (idsetBitmapSize) builder.Put("idset_bitmap_size", idsetBitmapSize);
 	if (sortOrdersSize) builder.Put("sort_orders_size", sortOrdersSize);
 	if (fulltextSize) builder.Put("fulltext_size", fulltextSize);
+	if (fulltextBuildTimeMs) builder.Put("fulltext_build_time_ms", fulltextBuildTimeMs);
+	if (fulltextGeneration) builder.Put("fulltext_generation", fulltextGeneration);
+	if (fulltextGenerationLagMs) builder.Put("fulltext_generation_lag_ms", fulltextGenerationLagMs);
 	if (columnSize) builder.Put("column_size", columnSize);
 
-	if (idsetCache.totalSize || idsetCache.itemsCount || idsetCache.emptyCount || idsetCache.hitCountLimit) {
+	if (idsetCache.totalSize || idsetCache.itemsCount || idsetCache.emptyCount || idsetCache.hitCountLimit || idsetCache.hitsCount ||
+		idsetCache.missesCount) {
 		auto obj = builder.Object("idset_cache");
 		idsetCache.GetJSON(obj);
 	}
@@ -92,6 +125,11 @@ void NamespacePerfStat::GetJSON(WrSerializer &ser) {
 		selects.GetJSON(obj);
 	}
 
+	{
+		auto obj = builder.Object("maintenance");
+		maintenance.GetJSON(obj);
+	}
+
 	auto arr = builder.Array("indexes");
 
 	for (unsigned i = 0; i < indexes.size(); i++) {
@@ -100,6 +138,24 @@ void NamespacePerfStat::GetJSON(WrSerializer &ser) {
 	}
 }
 
+void MaintenanceTaskStat::GetJSON(JsonBuilder &builder) {
+	builder.Put("type", type);
+	builder.Put("total_count", totalCount);
+	builder.Put("avg_latency_us", avgLatencyUs);
+	builder.Put("max_latency_us", maxLatencyUs);
+	builder.Put("avg_run_time_us", avgRunTimeUs);
+	builder.Put("max_run_time_us", maxRunTimeUs);
+}
+
+void MaintenanceStat::GetJSON(JsonBuilder &builder) {
+	builder.Put("queue_depth", queueDepth);
+	auto arr = builder.Array("tasks");
+	for (auto &task : tasks) {
+		auto obj = arr.Object();
+		task.GetJSON(obj);
+	}
+}
+
 void IndexPerfStat::GetJSON(JsonBuilder &builder) {
 	builder.Put("name", name);
 	{
@@ -122,6 +178,7 @@ void ReplicationState::GetJSON(JsonBuilder &builder) {
 	builder.Put("incarnation_counter", incarnationCounter);
 	builder.Put("data_hash", dataHash);
 	builder.Put("data_count", dataCount);
+	builder.Put("data_ids_count", dataIdsCount);
 	builder.Put("updated_unix_nano", int64_t(updatedUnixNano));
 }
 
@@ -139,12 +196,28 @@ void ReplicationState::FromJSON(span<char> json) {
 		incarnationCounter = root["incarnation_counter"].As<int>();
 		dataHash = root["data_hash"].As<uint64_t>();
 		dataCount = root["data_count"].As<int>();
+		dataIdsCount = root["data_ids_count"].As<int>(-1);
 		updatedUnixNano = root["updated_unix_nano"].As<int64_t>();
 	} catch (const gason::Exception &ex) {
 		throw Error(errParseJson, "ReplicationState: %s", ex.what());
 	}
 }
 
+void ReplicationSyncStat::GetJSON(WrSerializer &ser) {
+	JsonBuilder builder(ser);
+	builder.Put("name", name);
+	builder.Put("sync_type", syncType);
+	builder.Put("in_progress", inProgress);
+	builder.Put("items_total", itemsTotal);
+	builder.Put("items_synced", itemsSynced);
+	builder.Put("chunks_total", chunksTotal);
+	builder.Put("chunks_done", chunksDone);
+	builder.Put("start_time_unix_nano", startTimeUnixNano);
+	builder.Put("duration_ms", durationMs);
+	builder.Put("error_code", lastError.code());
+	builder.Put("error_message", lastError.what());
+}
+
 void ReplicationStat::GetJSON(JsonBuilder &builder) {
 	ReplicationState::GetJSON(builder);
 	if (!slaveMode) {
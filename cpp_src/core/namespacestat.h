@@ -16,10 +16,20 @@ class JsonBuilder;
 struct LRUCacheMemStat {
 	void GetJSON(JsonBuilder &builder);
 
+	struct ShardStat {
+		size_t totalSize = 0;
+		size_t itemsCount = 0;
+		uint64_t hitsCount = 0;
+		uint64_t missesCount = 0;
+	};
+
 	size_t totalSize = 0;
 	size_t itemsCount = 0;
 	size_t emptyCount = 0;
 	size_t hitCountLimit = 0;
+	uint64_t hitsCount = 0;
+	uint64_t missesCount = 0;
+	std::vector<ShardStat> shards;
 };
 
 struct IndexMemStat {
@@ -29,8 +39,12 @@ struct IndexMemStat {
 	size_t dataSize = 0;
 	size_t idsetBTreeSize = 0;
 	size_t idsetPlainSize = 0;
+	size_t idsetBitmapSize = 0;
 	size_t sortOrdersSize = 0;
 	size_t fulltextSize = 0;
+	int64_t fulltextBuildTimeMs = 0;
+	uint64_t fulltextGeneration = 0;
+	int64_t fulltextGenerationLagMs = 0;
 	size_t columnSize = 0;
 	LRUCacheMemStat idsetCache;
 };
@@ -55,6 +69,8 @@ struct ReplicationState {
 	uint64_t dataHash = 0;
 	// Data count
 	int dataCount = 0;
+	// Count of item ids, including ids of free items. Ids of all the items are less than it
+	int dataIdsCount = -1;
 	// Data updated
 	uint64_t updatedUnixNano = 0;
 };
@@ -65,6 +81,36 @@ struct ReplicationStat : public ReplicationState {
 	size_t walSize = 0;
 };
 
+// Progress of sync of namespace by replicator of slave
+struct ReplicationSyncStat {
+	void GetJSON(WrSerializer &ser);
+
+	std::string name;
+	// Type of the last sync: "wal", "forced" or "snapshot"
+	std::string syncType;
+	bool inProgress = false;
+	// Count of items in master namespace at start of sync
+	int64_t itemsTotal = 0;
+	// Count of items and WAL records, applied to slave namespace
+	int64_t itemsSynced = 0;
+	// Chunks of bulk snapshot
+	int64_t chunksTotal = 0;
+	int64_t chunksDone = 0;
+	int64_t startTimeUnixNano = 0;
+	int64_t durationMs = 0;
+	Error lastError;
+};
+
+struct PayloadArenaMemStat {
+	void GetJSON(JsonBuilder &builder);
+
+	size_t regionsCount = 0;
+	size_t slabsCount = 0;
+	size_t blocksCount = 0;
+	size_t totalSize = 0;
+	size_t usedSize = 0;
+};
+
 struct NamespaceMemStat {
 	void GetJSON(WrSerializer &ser);
 
@@ -83,6 +129,8 @@ struct NamespaceMemStat {
 	ReplicationStat replication;
 	LRUCacheMemStat joinCache;
 	LRUCacheMemStat queryCache;
+	LRUCacheMemStat resultsCache;
+	PayloadArenaMemStat arena;
 	std::vector<IndexMemStat> indexes;
 };
 
@@ -110,12 +158,31 @@ struct IndexPerfStat {
 	PerfStat commits;
 };
 
+struct MaintenanceTaskStat {
+	void GetJSON(JsonBuilder &builder);
+	std::string type;
+	size_t totalCount = 0;
+	// Latency is delay between due time of task and start of its run
+	size_t avgLatencyUs = 0;
+	size_t maxLatencyUs = 0;
+	size_t avgRunTimeUs = 0;
+	size_t maxRunTimeUs = 0;
+};
+
+struct MaintenanceStat {
+	void GetJSON(JsonBuilder &builder);
+	// Count of due maintenance tasks of all namespaces, which are waiting for free worker
+	size_t queueDepth = 0;
+	std::vector<MaintenanceTaskStat> tasks;
+};
+
 struct NamespacePerfStat {
 	void GetJSON(WrSerializer &ser);
 	std::string name;
 	PerfStat updates;
 	PerfStat selects;
 	std::vector<IndexPerfStat> indexes;
+	MaintenanceStat maintenance;
 };
 
 }  // namespace reindexer
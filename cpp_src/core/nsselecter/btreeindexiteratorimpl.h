@@ -83,6 +83,8 @@ public:
 
 	template <typename TIdSet>
 	void detectCurrentIdsetType(const TIdSet& idset) {
+		// Ordered indexes never pack idsets to bitmaps, so plain vector always holds ids
+		assert(!idset.Bitmap());
 		if (std::is_same<TIdSet, IdSet>() && !idset.IsCommited()) {
 			currentIdsetType_ = IdsetType::Btree;
 		} else {
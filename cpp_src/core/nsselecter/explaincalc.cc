@@ -13,8 +13,8 @@ namespace reindexer {
 
 void ExplainCalc::LogDump(int logLevel) {
 	if (logLevel >= LogInfo) {
-		logPrintf(LogInfo, "Got %d items in %d µs [prepare %d µs, select %d µs, postprocess %d µs loop %d µs], sortindex %s", count_,
-				  to_us(total_), to_us(prepare_), to_us(select_), to_us(postprocess_), to_us(loop_), sortIndex_);
+		logPrintf(LogInfo, "Got %d items in %d µs [prepare %d µs, select %d µs, postprocess %d µs loop %d µs], sortindex %s, workers %d",
+				  count_, to_us(total_), to_us(prepare_), to_us(select_), to_us(postprocess_), to_us(loop_), sortIndex_, workers_);
 	}
 
 	if (logLevel >= LogTrace) {
@@ -28,10 +28,11 @@ void ExplainCalc::LogDump(int logLevel) {
 		if (jselectors_) {
 			for (auto &js : *jselectors_) {
 				if (js.Type() == JoinType::LeftJoin || js.Type() == JoinType::Merge) {
-					logPrintf(LogInfo, "%s %s: called %d", SQLEncoder::JoinTypeName(js.Type()), js.RightNs().GetName(), js.Called());
+					logPrintf(LogInfo, "%s %s: %s, called %d", SQLEncoder::JoinTypeName(js.Type()), js.RightNs().GetName(),
+							  JoinStrategyName(js.Strategy()), js.Called());
 				} else {
-					logPrintf(LogInfo, "%s %s: called %d, matched %d", SQLEncoder::JoinTypeName(js.Type()), js.RightNs().GetName(), js.Called(),
-							  js.Matched());
+					logPrintf(LogInfo, "%s %s: %s, called %d, matched %d", SQLEncoder::JoinTypeName(js.Type()), js.RightNs().GetName(),
+							  JoinStrategyName(js.Strategy()), js.Called(), js.Matched());
 				}
 			}
 		}
@@ -48,6 +49,7 @@ string ExplainCalc::GetJSON() {
 		json.Put("postprocess_us", to_us(postprocess_));
 		json.Put("loop_us", to_us(loop_));
 		json.Put("sort_index", sortIndex_);
+		if (workers_ > 1) json.Put("workers", workers_);
 		auto jsonSelArr = json.Array("selectors");
 
 		if (selectors_) {
@@ -59,6 +61,7 @@ string ExplainCalc::GetJSON() {
 				auto jsonSel = jsonSelArr.Object();
 				jsonSel.Put("field", js.RightNs().GetName());
 				jsonSel.Put("method", JoinTypeName(js.Type()));
+				jsonSel.Put("join_strategy", JoinStrategyName(js.Strategy()));
 				jsonSel.Put("matched", js.Matched());
 			}
 		}
@@ -116,6 +119,19 @@ const char *ExplainCalc::JoinTypeName(JoinType type) {
 	}
 }
 
+const char *ExplainCalc::JoinStrategyName(JoinStrategy strategy) {
+	switch (strategy) {
+		case JoinStrategy::NestedLoop:
+			return "nested_loop";
+		case JoinStrategy::Hash:
+			return "hash";
+		case JoinStrategy::Batched:
+			return "batched";
+		default:
+			return "<unknown>";
+	}
+}
+
 void reindexer::ExplainCalc::StartTiming() {
 	if (enabled_) lap();
 }
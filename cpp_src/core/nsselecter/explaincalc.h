@@ -11,6 +11,7 @@ namespace reindexer {
 
 class SelectIteratorContainer;
 class JoinedSelector;
+enum class JoinStrategy;
 typedef std::vector<JoinedSelector> JoinedSelectors;
 
 class ExplainCalc {
@@ -31,6 +32,7 @@ public:
 	void SetIterations(int iters);
 
 	void PutCount(int cnt) { count_ = cnt; }
+	void PutWorkersCount(unsigned cnt) { workers_ = cnt; }
 	void PutSortIndex(string_view index);
 	void PutSelectors(SelectIteratorContainer *qres);
 	void PutJoinedSelectors(JoinedSelectors *jselectors);
@@ -42,6 +44,7 @@ protected:
 	duration lap();
 	static int to_us(const duration &d);
 	static const char *JoinTypeName(JoinType jtype);
+	static const char *JoinStrategyName(JoinStrategy strategy);
 
 protected:
 	time_point last_point_, pause_point_;
@@ -52,6 +55,7 @@ protected:
 	JoinedSelectors *jselectors_ = nullptr;
 	int iters_ = 0;
 	int count_;
+	unsigned workers_ = 1;
 	bool enabled_;
 	bool started_;
 };
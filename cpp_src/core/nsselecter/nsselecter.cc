@@ -1,12 +1,26 @@
 #include "nsselecter.h"
+#include <functional>
+#include <thread>
 #include "core/namespace.h"
+#include "core/workerpool.h"
+#include "estl/fast_hash_set.h"
 #include "explaincalc.h"
 #include "querypreprocessor.h"
+#include "sortkeys.h"
 #include "tools/logger.h"
 
 constexpr int kMinIterationsForInnerJoinOptimization = 100;
 constexpr size_t kMaxIterationsScaleForInnerJoinOptimization = 100;
 constexpr int kMaxIterationsForIdsetPreresult = 10000;
+constexpr int kMinIterationsForParallelSelect = 200000;
+constexpr int kMinIterationsPerSelectWorker = 50000;
+constexpr unsigned kMaxSelectWorkers = 16;
+// Parallel part of select loop checks cancellation of query after each this count of rows
+constexpr int kSelectPartCancelCheckPeriod = 4096;
+constexpr size_t kMinItemsForColumnScan = 1024;
+constexpr size_t kJoinBatchSize = 1024;
+// Minimal count of items, which are sorted by normalized sort keys instead of comparison of payloads
+constexpr int kMinItemsForSortKeys = 64;
 
 namespace reindexer {
 
@@ -16,8 +30,57 @@ bool JoinedSelector::Process(IdType rowId, int nsId, ConstPayload payload, bool
 		matched_++;
 		return true;
 	}
-	QueryResults joinItemR;
 
+	setJoinValues(payload);
+	return strategy_ == JoinStrategy::Hash ? processHash(rowId, nsId, match) : processNestedLoop(rowId, nsId, match);
+}
+
+void JoinedSelector::ProcessBatch(const std::vector<IdType> &rowIds, int nsId) {
+	assert(strategy_ == JoinStrategy::Batched);
+	called_ += rowIds.size();
+
+	// Collect values of the first join condition of all the left items
+	const QueryEntry &keyEntry = itemQuery_.entries[0];
+	const KeyValueType keyType = rightNs_->indexes_[keyEntry.idxNo]->KeyType();
+	fast_hash_set<Variant> keys;
+	for (IdType rowId : rowIds) {
+		setJoinValues(ConstPayload(leftNs_->payloadType_, leftNs_->items_[rowId]));
+		for (const Variant &v : keyEntry.values) {
+			if (v.Type() != KeyValueNull) keys.insert(v.convert(keyType));
+		}
+	}
+	if (keys.empty()) return;
+
+	// Select right items for the whole batch at once
+	Query batchQuery(rightNs_->name_);
+	batchQuery.Debug(itemQuery_.debugLevel);
+	batchQuery.sortingEntries_ = itemQuery_.sortingEntries_;
+	QueryEntry batchEntry(CondSet, keyEntry.index, keyEntry.idxNo);
+	batchEntry.values.reserve(keys.size());
+	for (const Variant &key : keys) batchEntry.values.push_back(key);
+	batchQuery.entries.Append(OpAnd, std::move(batchEntry));
+
+	QueryResults batchResult;
+	SelectCtx ctx(batchQuery);
+	ctx.preResult = preResult_;
+	ctx.skipIndexesLookup = true;
+	ctx.functions = &selectFunctions_;
+	rightNs_->Select(batchResult, ctx, rdxCtx_);
+
+	std::vector<IdType> rightRowIds;
+	rightRowIds.reserve(batchResult.Count());
+	for (auto &itemRef : batchResult.Items()) rightRowIds.push_back(itemRef.id);
+	buildHashTable(std::move(rightRowIds));
+
+	// Scatter selected items to the left items
+	for (IdType rowId : rowIds) {
+		setJoinValues(ConstPayload(leftNs_->payloadType_, leftNs_->items_[rowId]));
+		probeHashTable(rowId, nsId, true);
+	}
+	hashTable_.reset();
+}
+
+void JoinedSelector::setJoinValues(ConstPayload payload) {
 	// Put values to join conditions
 	size_t index = 0;
 	for (auto &je : joinQuery_.joinEntries_) {
@@ -32,8 +95,12 @@ bool JoinedSelector::Process(IdType rowId, int nsId, ConstPayload payload, bool
 		}
 		++index;
 	}
+}
+
+bool JoinedSelector::processNestedLoop(IdType rowId, int nsId, bool match) {
 	itemQuery_.Limit(match ? joinQuery_.count : 0);
 
+	QueryResults joinItemR;
 	bool found = false;
 	bool matchedAtLeastOnce = false;
 	JoinCacheRes joinResLong;
@@ -69,23 +136,177 @@ bool JoinedSelector::Process(IdType rowId, int nsId, ConstPayload payload, bool
 		}
 		rightNs_->PutToJoinCache(joinResLong, val);
 	}
-	if (match && found) {
-		if (nsId >= static_cast<int>(result_.joined_.size())) {
-			result_.joined_.resize(nsId + 1);
-		}
-		joins::NamespaceResults &nsJoinRes = result_.joined_[nsId];
-		nsJoinRes.SetJoinedSelectorsCount(joinedSelectorsCount_);
-		nsJoinRes.Insert(rowId, joinedFieldIdx_, std::move(joinItemR));
-	}
+	if (match && found) addJoinedItems(rowId, nsId, std::move(joinItemR));
 	if (matchedAtLeastOnce) ++matched_;
 	return matchedAtLeastOnce;
 }
 
+bool JoinedSelector::processHash(IdType rowId, int nsId, bool match) {
+	if (!hashTable_) {
+		// Few left items (e.g. selected by primary key) are joined cheaper by nested loop, than by building of the whole table
+		if (size_t(called_) <= hashBuildThreshold_) return processNestedLoop(rowId, nsId, match);
+		rightNs_->GetIndsideFromJoinCache(joinRes_);
+		if (joinRes_.needPut) {
+			rightNs_->PutToJoinCache(joinRes_, preResult_);
+		}
+		std::vector<IdType> rightRowIds = selectHashJoinRowIds();
+		// Keep order of rowIds as in nested loop join
+		std::sort(rightRowIds.begin(), rightRowIds.end());
+		buildHashTable(std::move(rightRowIds));
+	}
+	return probeHashTable(rowId, nsId, match);
+}
+
+std::vector<IdType> JoinedSelector::selectHashJoinRowIds() {
+	std::vector<IdType> rightRowIds;
+	if (preResult_->mode == JoinPreResult::ModeEmpty) {
+		rightRowIds.reserve(rightNs_->items_.size() - rightNs_->free_.size());
+		for (IdType id = 0; id < IdType(rightNs_->items_.size()); ++id) {
+			if (!rightNs_->items_[id].IsFree()) rightRowIds.push_back(id);
+		}
+	} else if (preResult_->mode == JoinPreResult::ModeIdSet) {
+		rightRowIds.reserve(preResult_->ids.size());
+		preResult_->ids.ForEach([&rightRowIds](IdType id) { rightRowIds.push_back(id); });
+	} else {
+		// Select right items by iterators of preresult
+		Query query(rightNs_->name_);
+		SelectCtx ctx(query);
+		ctx.preResult = preResult_;
+		ctx.skipIndexesLookup = true;
+		ctx.functions = &selectFunctions_;
+		QueryResults qr;
+		rightNs_->Select(qr, ctx, rdxCtx_);
+		rightRowIds.reserve(qr.Count());
+		for (auto &itemRef : qr.Items()) rightRowIds.push_back(itemRef.id);
+	}
+	return rightRowIds;
+}
+
+void JoinedSelector::buildHashTable(std::vector<IdType> &&rowIds) {
+	hashRowIds_ = std::move(rowIds);
+	hashTable_.reset(new HashJoinTable);
+	hashTable_->reserve(hashRowIds_.size());
+	const int keyIdxNo = itemQuery_.entries[0].idxNo;
+	VariantArray values;
+	for (int pos = 0; pos < int(hashRowIds_.size()); ++pos) {
+		const PayloadValue &item = rightNs_->items_[hashRowIds_[pos]];
+		if (item.IsFree()) continue;
+		ConstPayload(rightNs_->payloadType_, item).Get(keyIdxNo, values);
+		for (Variant &v : values) {
+			if (v.Type() == KeyValueNull) continue;
+			auto &bucket = (*hashTable_)[std::move(v)];
+			// Array field may contain same value several times
+			if (bucket.empty() || bucket.back() != pos) bucket.push_back(pos);
+		}
+	}
+}
+
+bool JoinedSelector::probeHashTable(IdType rowId, int nsId, bool match) {
+	// Candidates are found by values of the first join condition, and checked by the rest of conditions
+	const QueryEntry &keyEntry = itemQuery_.entries[0];
+	const KeyValueType keyType = rightNs_->indexes_[keyEntry.idxNo]->KeyType();
+	h_vector<int, 16> candidates;
+	size_t bucketsCount = 0;
+	for (const Variant &v : keyEntry.values) {
+		if (v.Type() == KeyValueNull) continue;
+		auto it = hashTable_->find(v.convert(keyType));
+		if (it == hashTable_->end()) continue;
+		candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+		++bucketsCount;
+	}
+	if (bucketsCount > 1) {
+		// Same item may be found by several values, keep order of items as in the right namespace select
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+	}
+
+	const size_t limit = match ? joinQuery_.count : 1;
+	QueryResults joinItemR;
+	VariantArray buffer;
+	size_t found = 0;
+	for (int pos : candidates) {
+		if (found >= limit) break;
+		const IdType rightRowId = hashRowIds_[pos];
+		if (!matchRightItem(rightRowId, buffer)) continue;
+		if (match) joinItemR.Add({rightRowId, rightNs_->items_[rightRowId], 0, 0});
+		++found;
+	}
+
+	if (match && found) addJoinedItems(rowId, nsId, std::move(joinItemR));
+	if (found) ++matched_;
+	return found;
+}
+
+bool JoinedSelector::matchRightItem(IdType rightRowId, VariantArray &buffer) const {
+	const ConstPayload pl(rightNs_->payloadType_, rightNs_->items_[rightRowId]);
+	for (size_t i = 1; i < itemQuery_.entries.Size(); ++i) {
+		const QueryEntry &qe = itemQuery_.entries[i];
+		const KeyValueType keyType = rightNs_->indexes_[qe.idxNo]->KeyType();
+		pl.Get(qe.idxNo, buffer);
+		bool matched = false;
+		for (const Variant &leftValue : qe.values) {
+			if (leftValue.Type() == KeyValueNull) continue;
+			const Variant key = leftValue.convert(keyType);
+			for (const Variant &rightValue : buffer) {
+				if (rightValue.Type() != KeyValueNull && rightValue == key) {
+					matched = true;
+					break;
+				}
+			}
+			if (matched) break;
+		}
+		if (!matched) return false;
+	}
+	return true;
+}
+
+void JoinedSelector::addJoinedItems(IdType rowId, int nsId, QueryResults &&joinItemR) {
+	if (nsId >= static_cast<int>(result_.joined_.size())) {
+		result_.joined_.resize(nsId + 1);
+	}
+	joins::NamespaceResults &nsJoinRes = result_.joined_[nsId];
+	nsJoinRes.SetJoinedSelectorsCount(joinedSelectorsCount_);
+	nsJoinRes.Insert(rowId, joinedFieldIdx_, std::move(joinItemR));
+}
+
+bool JoinedSelector::IsEqualityJoin(const Query &itemQuery, const Namespace &rightNs) {
+	if (itemQuery.entries.Empty()) return false;
+	// Entries of item query are built from the join conditions, so all of them are leafs
+	bool applicable = true;
+	itemQuery.entries.ForeachEntry([&rightNs, &applicable](const QueryEntry &qe, OpType op) {
+		// Join conditions on sparse and composite indexes, or on non indexed fields, are checked by nested loop only
+		if (op != OpAnd || (qe.condition != CondEq && qe.condition != CondSet) || qe.idxNo < 0 ||
+			qe.idxNo >= rightNs.payloadType_.NumFields()) {
+			applicable = false;
+			return;
+		}
+		const Index &index = *rightNs.indexes_[qe.idxNo];
+		if (isFullText(index.Type())) {
+			applicable = false;
+			return;
+		}
+		switch (index.KeyType()) {
+			case KeyValueInt:
+			case KeyValueInt64:
+			case KeyValueDouble:
+			case KeyValueBool:
+				break;
+			case KeyValueString:
+				// Hash of string doesn't respect collation
+				if (index.Opts().GetCollateMode() != CollateNone) applicable = false;
+				break;
+			default:
+				applicable = false;
+		}
+	});
+	return applicable;
+}
+
 template <bool byJsonPath>
 void JoinedSelector::readValues(VariantArray &values, const Index &leftIndex, int rightIdxNo, const std::string &rightIndex) const {
 	const KeyValueType leftIndexType = leftIndex.SelectKeyType();
-	for (IdType rowId : preResult_->ids) {
-		if (rightNs_->items_[rowId].IsFree()) continue;
+	preResult_->ids.ForEach([&](IdType rowId) {
+		if (rightNs_->items_[rowId].IsFree()) return;
 		const ConstPayload pl{rightNs_->payloadType_, rightNs_->items_[rowId]};
 		VariantArray buffer;
 		if (byJsonPath) {
@@ -94,7 +315,7 @@ void JoinedSelector::readValues(VariantArray &values, const Index &leftIndex, in
 			pl.Get(rightIdxNo, buffer);
 		}
 		for (Variant &v : buffer) values.push_back(v.convert(leftIndexType));
-	}
+	});
 }
 
 void JoinedSelector::AppendSelectIteratorOfJoinIndexData(SelectIteratorContainer &iterators, int *maxIterations, unsigned sortId,
@@ -143,21 +364,30 @@ void JoinedSelector::AppendSelectIteratorOfJoinIndexData(SelectIteratorContainer
 	optimized_ = optimized == joinQuery_.joinEntries_.size();
 }
 
-static int GetMaxIterations(const SelectIteratorContainer &iterators) {
-	int maxIterations = std::numeric_limits<int>::max();
-	iterators.ForeachIterator([&maxIterations](const SelectIterator &it, OpType) {
-		int cur = it.GetMaxIterations();
-		if (it.comparators_.empty() && cur && cur < maxIterations) maxIterations = cur;
-	});
-	return maxIterations;
-}
-
 void NsSelecter::operator()(QueryResults &result, SelectCtx &ctx, const RdxContext &rdxCtx) {
 	ctx.sortingContext.enableSortOrders = ns_->sortOrdersBuilt_;
 	if (ns_->config_.logLevel > ctx.query.debugLevel) {
 		const_cast<Query *>(&ctx.query)->debugLevel = ns_->config_.logLevel;
 	}
 
+	QueryCacheKey resultsKey;
+	IndexesMask resultsDeps;
+	bool needPutResults = false;
+	if (getResultsCacheDeps(ctx, result, resultsDeps)) {
+		WrSerializer ser;
+		ctx.query.Serialize(ser, SkipJoinQueries | SkipMergeQueries);
+		resultsKey = QueryCacheKey(ser);
+		auto cached = ns_->resultsCache_->Get(resultsKey);
+		if (cached.valid && cached.val.data) {
+			if (ns_->generations_.IsActual(cached.val.data->generation, cached.val.data->deps)) {
+				putCachedResults(*cached.val.data, ctx, result);
+				return;
+			}
+			ns_->resultsCache_->MarkOutdated();
+		}
+		needPutResults = cached.valid;
+	}
+
 	ExplainCalc explain(ctx.query.explain_ || ctx.query.debugLevel >= LogInfo);
 	explain.StartTiming();
 
@@ -179,22 +409,27 @@ void NsSelecter::operator()(QueryResults &result, SelectCtx &ctx, const RdxConte
 		}
 	}
 
+	// Where entries and sort order of prepared query are built by its plan. Entries are resolved again, if indexes were changed after
+	// planning
+	const PreparedQuery::Plan *plan = (ctx.plan && ctx.plan->indexesVersion == ns_->indexesVersion_) ? ctx.plan : nullptr;
 	QueryPreprocessor qPreproc(ns_, const_cast<QueryEntries *>(&ctx.query.entries));
-	QueryEntries tmpWhereEntries(ctx.skipIndexesLookup ? QueryEntries() : qPreproc.LookupQueryIndexes());
+	QueryEntries tmpWhereEntries(ctx.skipIndexesLookup ? QueryEntries()
+													   : plan ? qPreproc.BindPlan(*plan) : qPreproc.LookupQueryIndexes(ctx.plan != nullptr));
 	if (!ctx.skipIndexesLookup) {
 		qPreproc.SetQueryEntries(&tmpWhereEntries);
 	}
 
-	const bool isFt = qPreproc.ContainsFullTextIndexes();
-	if (!ctx.skipIndexesLookup && !isFt) qPreproc.SubstituteCompositeIndexes();
+	const bool isFt = plan ? plan->isFt : qPreproc.ContainsFullTextIndexes();
+	if (!ctx.skipIndexesLookup && !isFt && !plan) qPreproc.SubstituteCompositeIndexes();
 	qPreproc.ConvertWhereValues();
 
 	// DO NOT use deducted sort order in the following cases:
 	// - query contains explicity specified sort order
 	// - query contains FullText query.
 	bool disableOptimizeSortOrder = !ctx.query.sortingEntries_.empty() || ctx.preResult;
-	SortingEntries sortBy = (isFt || disableOptimizeSortOrder) ? ctx.query.sortingEntries_ : qPreproc.DetectOptimalSortOrder();
-	prepareSortingIndexes(sortBy);
+	SortingEntries sortBy = (isFt || disableOptimizeSortOrder) ? ctx.query.sortingEntries_
+															   : plan ? plan->sortBy : qPreproc.DetectOptimalSortOrder();
+	prepareSortingIndexes(sortBy, plan != nullptr);
 
 	if (ctx.preResult) {
 		// For building join preresult always use ASC sort orders
@@ -238,7 +473,7 @@ void NsSelecter::operator()(QueryResults &result, SelectCtx &ctx, const RdxConte
 	SelectIteratorContainer qres(ns_->payloadType_, &ctx);
 	if (ctx.preResult && ctx.preResult->mode == JoinPreResult::ModeIdSet) {
 		SelectKeyResult res;
-		res.push_back(SingleSelectKeyResult(ctx.preResult->ids));
+		res.push_back(SingleSelectKeyResult(ctx.preResult->ids.Sorted(0)));
 		static string pr = "-preresult";
 		qres.Append(OpAnd, SelectIterator(res, false, pr));
 	} else if (ctx.preResult && ctx.preResult->mode == JoinPreResult::ModeIterators) {
@@ -254,9 +489,19 @@ void NsSelecter::operator()(QueryResults &result, SelectCtx &ctx, const RdxConte
 	qres.PrepareIteratorsForSelectLoop(qPreproc.GetQueryEntries(), 0, qPreproc.GetQueryEntries().Size(), ctx.query.equalPositions_,
 									   ctx.sortingContext.sortId(), isFt, *ns_, fnc_, ft_ctx_, rdxCtx);
 
+	qres.MergeBitmapIdsets();
+
+	// Column scan checks all the rows at once, so it's useless if loop may stop early by limit.
+	// Rows of column are indexed by rowId, so it can't be used in sort orders mode
+	if (!isFt && !qres.HasIdsets() && ns_->items_.size() >= kMinItemsForColumnScan &&
+		(ctx.isForceAll || ctx.query.count == UINT_MAX || needCalcTotal) && !ctx.sortingContext.isOptimizationEnabled() &&
+		!(ctx.sortingContext.isIndexOrdered() && ctx.sortingContext.enableSortOrders)) {
+		qres.ApplyColumnScan(ns_->items_.size());
+	}
+
 	explain.SetSelectTime();
 
-	int maxIterations = GetMaxIterations(qres);
+	int maxIterations = qres.GetMaxIterations();
 	if (ctx.preResult) {
 		if (ctx.preResult->mode == JoinPreResult::ModeBuild) {
 			// Building pre result for next joins
@@ -341,6 +586,9 @@ void NsSelecter::operator()(QueryResults &result, SelectCtx &ctx, const RdxConte
 	LoopCtx lctx(ctx);
 	lctx.qres = &qres;
 	lctx.calcTotal = needCalcTotal;
+	lctx.workersCount = getWorkersCount(qres, ctx, isFt, maxIterations);
+	lctx.topK = getTopKLimit(ctx, result);
+	if (lctx.topK) lctx.comparator.reset(new ItemComparator(*ns_, ctx));
 	if (isFt) result.haveProcent = true;
 	if (reverse && hasComparators) selectLoop<true, true>(lctx, result, rdxCtx);
 	if (!reverse && hasComparators) selectLoop<false, true>(lctx, result, rdxCtx);
@@ -354,6 +602,7 @@ void NsSelecter::operator()(QueryResults &result, SelectCtx &ctx, const RdxConte
 	explain.PutSelectors(&qres);
 	explain.PutJoinedSelectors(ctx.joinedSelectors);
 	explain.SetIterations(maxIterations);
+	explain.PutWorkersCount(lctx.workersCount);
 
 	if (ctx.query.debugLevel >= LogInfo) {
 		logPrintf(LogInfo, "%s", ctx.query.GetSQL());
@@ -368,6 +617,7 @@ void NsSelecter::operator()(QueryResults &result, SelectCtx &ctx, const RdxConte
 		logPrintf(LogTrace, "[%s] put totalCount value into query cache: %d ", ns_->name_, result.totalCount);
 		ns_->queryCache_->Put(ckey, {static_cast<size_t>(result.totalCount)});
 	}
+	if (needPutResults) putResultsToCache(resultsKey, resultsDeps, result);
 	if (ctx.preResult && ctx.preResult->mode == JoinPreResult::ModeBuild) {
 		ctx.preResult->mode = JoinPreResult::ModeIdSet;
 		if (ctx.query.debugLevel >= LogInfo) {
@@ -377,6 +627,80 @@ void NsSelecter::operator()(QueryResults &result, SelectCtx &ctx, const RdxConte
 	}
 }
 
+bool NsSelecter::getResultsCacheDeps(const SelectCtx &ctx, const QueryResults &result, IndexesMask &deps) const {
+	if (ns_->config_.resultsCacheSize <= 0) return false;
+	// Results of joins, merged queries and fulltext search depend on the other namespaces and on the search context
+	if (ctx.preResult || (ctx.joinedSelectors && !ctx.joinedSelectors->empty()) || !ctx.query.mergeQueries_.empty() ||
+		!ctx.query.joinQueries_.empty() || ctx.nsid || result.Count() || ctx.reqMatchedOnceFlag ||
+		ctx.query.explain_) {
+		return false;
+	}
+
+	bool cacheable = true;
+	ctx.query.entries.ForeachEntry([&](const QueryEntry &entry, OpType) {
+		if (!addResultsCacheDeps(entry.index, deps)) cacheable = false;
+	});
+	for (const auto &sortingEntry : ctx.query.sortingEntries_) {
+		if (!addResultsCacheDeps(sortingEntry.column, deps)) return false;
+	}
+	for (const auto &aggregation : ctx.query.aggregations_) {
+		for (const auto &field : aggregation.fields_) {
+			if (!addResultsCacheDeps(field, deps)) return false;
+		}
+	}
+	return cacheable;
+}
+
+bool NsSelecter::addResultsCacheDeps(const string &field, IndexesMask &deps) const {
+	int idx;
+	if (!ns_->getIndexByName(field, idx)) {
+		// Values of non indexed fields are stored in tuple
+		deps.set(0);
+		return true;
+	}
+	const Index &index = *ns_->indexes_[idx];
+	if (isFullText(index.Type())) return false;
+	if (idx < ns_->indexes_.firstCompositePos()) {
+		deps.set(idx);
+		return true;
+	}
+	for (int f : index.Fields()) {
+		if (f == IndexValueType::SetByJsonPath) {
+			deps.set(0);
+		} else {
+			deps.set(f);
+		}
+	}
+	return true;
+}
+
+void NsSelecter::putCachedResults(const QueryResultsCacheVal::Data &cached, const SelectCtx &ctx, QueryResults &result) {
+	if (ctx.contextCollectingMode) {
+		result.addNSContext(ns_->payloadType_, ns_->tagsMatcher_, FieldsSet(ns_->tagsMatcher_, ctx.query.selectFilter_));
+	}
+	result.Items().reserve(cached.ids.size());
+	for (IdType id : cached.ids) {
+		result.Add({id, ns_->items_[id], 0, ctx.nsid}, ns_->payloadType_);
+	}
+	result.aggregationResults.insert(result.aggregationResults.end(), cached.aggregationResults.begin(),
+									 cached.aggregationResults.end());
+	result.totalCount += cached.totalCount;
+	if (ctx.query.debugLevel >= LogTrace) {
+		logPrintf(LogTrace, "[%s] using results from cache: %d items", ns_->name_, cached.ids.size());
+	}
+}
+
+void NsSelecter::putResultsToCache(const QueryCacheKey &key, const IndexesMask &deps, const QueryResults &result) {
+	auto data = std::make_shared<QueryResultsCacheVal::Data>();
+	data->ids.reserve(result.Count());
+	for (const auto &item : result.Items()) data->ids.push_back(item.id);
+	data->aggregationResults = result.aggregationResults;
+	data->totalCount = result.totalCount;
+	data->generation = ns_->generations_.current;
+	data->deps = deps;
+	ns_->resultsCache_->Put(key, {std::move(data)});
+}
+
 void NsSelecter::applyForcedSort(ItemRefVector &queryResult, const SelectCtx &ctx) {
 	if (ctx.query.sortingEntries_[0].desc) {
 		applyForcedSortDesc(queryResult, ctx);
@@ -516,70 +840,128 @@ void NsSelecter::applyForcedSortDesc(ItemRefVector &queryResult, const SelectCtx
 	}
 }
 
-void NsSelecter::applyGeneralSort(ConstItemIterator itFirst, ConstItemIterator itLast, ConstItemIterator itEnd, const SelectCtx &ctx) {
-	if (ctx.query.mergeQueries_.size() > 1) {
-		throw Error(errLogic, "Sorting cannot be applied to merged queries.");
-	}
-
-	if (ctx.sortingContext.entries.empty()) return;
-
-	FieldsSet fields;
-	auto &payloadType = ns_->payloadType_;
+NsSelecter::ItemComparator::ItemComparator(const Namespace &ns, const SelectCtx &ctx)
+	: payloadType_(ns.payloadType_), sortingContext_(ctx.sortingContext) {
 	bool multiSort = ctx.sortingContext.entries.size() > 1;
-	h_vector<const CollateOpts *, 1> collateOpts;
 
 	for (size_t i = 0; i < ctx.sortingContext.entries.size(); ++i) {
 		const auto &sortingCtx = ctx.sortingContext.entries[i];
 		int fieldIdx = sortingCtx.data->index;
-		if (fieldIdx == IndexValueType::SetByJsonPath || ns_->indexes_[fieldIdx]->Opts().IsSparse()) {
+		if (fieldIdx == IndexValueType::SetByJsonPath || ns.indexes_[fieldIdx]->Opts().IsSparse()) {
 			TagsPath tagsPath;
 			if (fieldIdx != IndexValueType::SetByJsonPath) {
-				const FieldsSet &fs = ns_->indexes_[fieldIdx]->Fields();
+				const FieldsSet &fs = ns.indexes_[fieldIdx]->Fields();
 				assert(fs.getTagsPathsLength() > 0);
 				tagsPath = fs.getTagsPath(0);
 			} else {
-				tagsPath = ns_->tagsMatcher_.path2tag(sortingCtx.data->column);
+				tagsPath = ns.tagsMatcher_.path2tag(sortingCtx.data->column);
 			}
-			if (fields.contains(tagsPath)) {
+			if (fields_.contains(tagsPath)) {
 				throw Error(errQueryExec, "Can't sort by 2 equal indexes: %s", sortingCtx.data->column);
 			}
-			fields.push_back(tagsPath);
+			fields_.push_back(tagsPath);
 		} else {
-			if (ns_->indexes_[fieldIdx]->Opts().IsArray()) {
+			if (ns.indexes_[fieldIdx]->Opts().IsArray()) {
 				throw Error(errQueryExec, "Sorting cannot be applied to array field.");
 			}
-			if (fieldIdx >= ns_->indexes_.firstCompositePos()) {
+			if (fieldIdx >= ns.indexes_.firstCompositePos()) {
 				if (multiSort) {
 					throw Error(errQueryExec, "Multicolumn sorting cannot be applied to composite fields: %s", sortingCtx.data->column);
 				}
-				fields = ns_->indexes_[fieldIdx]->Fields();
+				fields_ = ns.indexes_[fieldIdx]->Fields();
 			} else {
-				if (fields.contains(fieldIdx)) {
+				if (fields_.contains(fieldIdx)) {
 					throw Error(errQueryExec, "You cannot sort by 2 same indexes: %s", sortingCtx.data->column);
 				}
-				fields.push_back(fieldIdx);
+				fields_.push_back(fieldIdx);
 			}
 		}
-		collateOpts.push_back(ctx.sortingContext.entries[i].opts);
+		collateOpts_.push_back(ctx.sortingContext.entries[i].opts);
 	}
+}
 
-	std::partial_sort(itFirst, itLast, itEnd, [&payloadType, &fields, &collateOpts, &ctx](const ItemRef &lhs, const ItemRef &rhs) {
-		size_t firstDifferentFieldIdx = 0;
-		int cmpRes = ConstPayload(payloadType, lhs.value).Compare(rhs.value, fields, firstDifferentFieldIdx, collateOpts);
-		assert(ctx.sortingContext.entries.size());
-		if (ctx.sortingContext.entries.size() == 1) firstDifferentFieldIdx = 0;
-		assertf(firstDifferentFieldIdx < ctx.sortingContext.entries.size(), "firstDifferentFieldIdx fail %d,%d -> %d",
-				int(firstDifferentFieldIdx), int(ctx.sortingContext.entries.size()), int(fields.size()));
+bool NsSelecter::ItemComparator::Less(const PayloadValue &lhs, IdType lhsId, const PayloadValue &rhs, IdType rhsId) const {
+	size_t firstDifferentFieldIdx = 0;
+	int cmpRes = ConstPayload(payloadType_, lhs).Compare(rhs, fields_, firstDifferentFieldIdx, collateOpts_);
+	assert(sortingContext_.entries.size());
+	if (sortingContext_.entries.size() == 1) firstDifferentFieldIdx = 0;
+	assertf(firstDifferentFieldIdx < sortingContext_.entries.size(), "firstDifferentFieldIdx fail %d,%d -> %d", int(firstDifferentFieldIdx),
+			int(sortingContext_.entries.size()), int(fields_.size()));
 
-		// If values are equal, then sort by row ID, to give consistent results
-		if (cmpRes == 0) cmpRes = (lhs.id > rhs.id) ? 1 : ((lhs.id < rhs.id) ? -1 : 0);
+	// If values are equal, then sort by row ID, to give consistent results
+	if (cmpRes == 0) cmpRes = (lhsId > rhsId) ? 1 : ((lhsId < rhsId) ? -1 : 0);
 
-		if (ctx.sortingContext.entries[firstDifferentFieldIdx].data->desc) {
-			return (cmpRes > 0);
-		} else {
-			return (cmpRes < 0);
-		}
-	});
+	if (sortingContext_.entries[firstDifferentFieldIdx].data->desc) {
+		return (cmpRes > 0);
+	} else {
+		return (cmpRes < 0);
+	}
+}
+
+bool NsSelecter::ItemComparator::SortByKeys(ItemRefVector::iterator first, ItemRefVector::iterator middle,
+											ItemRefVector::iterator last) const {
+	// Sparse and json path fields are compared by relaxed compare of values arrays, so they are not encoded to keys
+	h_vector<SortKeys::Field, 4> keyFields;
+	for (size_t i = 0; i < fields_.size(); ++i) {
+		if (fields_[i] == IndexValueType::SetByJsonPath) return false;
+		const CollateOpts *opts = collateOpts_.size() == 1 ? collateOpts_[0] : collateOpts_[i];
+		if (!SortKeys::IsSupported(payloadType_.Field(fields_[i]), opts ? *opts : CollateOpts())) return false;
+		// Fields of composite index are sorted by the single sort entry
+		const auto &entry = sortingContext_.entries[sortingContext_.entries.size() == 1 ? 0 : i];
+		keyFields.push_back({fields_[i], opts, entry.data->desc});
+	}
+	return SortKeys(payloadType_, keyFields, sortingContext_.entries.back().data->desc).PartialSort(first, middle, last);
+}
+
+void NsSelecter::applyGeneralSort(ConstItemIterator itFirst, ConstItemIterator itLast, ConstItemIterator itEnd, const SelectCtx &ctx) {
+	if (ctx.query.mergeQueries_.size() > 1) {
+		throw Error(errLogic, "Sorting cannot be applied to merged queries.");
+	}
+
+	if (ctx.sortingContext.entries.empty()) return;
+
+	const ItemComparator comparator(*ns_, ctx);
+	if (itEnd - itFirst < kMinItemsForSortKeys || !comparator.SortByKeys(itFirst, itLast, itEnd)) {
+		std::partial_sort(itFirst, itLast, itEnd, std::cref(comparator));
+	}
+}
+
+size_t NsSelecter::getTopKLimit(const SelectCtx &ctx, const QueryResults &result) const {
+	// Heap is used instead of sorting of all the matched items, when items can't be sorted by sort orders.
+	// Result may already contain items of the other namespaces of merged query, which are sorted together
+	SortingOptions sortingOptions(ctx.query, ctx.sortingContext);
+	if (!sortingOptions.usingGeneralAlgorithm || sortingOptions.forcedMode || !ctx.isForceAll || !ctx.query.mergeQueries_.empty() ||
+		result.Count()) {
+		return 0;
+	}
+	// Aggregations and building of join preresult don't collect items
+	if (!ctx.query.aggregations_.empty() || (ctx.preResult && ctx.preResult->mode == JoinPreResult::ModeBuild)) return 0;
+	if (ctx.query.count == 0 || ctx.query.count == UINT_MAX) return 0;
+	return size_t(ctx.query.start) + ctx.query.count;
+}
+
+void NsSelecter::pushTopItem(ItemRefVector &heap, const LoopCtx &ctx, const PayloadValue &pv, IdType rowId, uint8_t proc,
+							 uint8_t nsid) const {
+	const auto &comparator = std::cref(*ctx.comparator);
+	if (heap.size() < ctx.topK) {
+		heap.push_back({rowId, pv, proc, nsid});
+		std::push_heap(heap.begin(), heap.end(), comparator);
+		return;
+	}
+	// Most of items are rejected here, without copy of payload
+	if (!ctx.comparator->Less(pv, rowId, heap.front().value, heap.front().id)) return;
+	std::pop_heap(heap.begin(), heap.end(), comparator);
+	heap.back() = ItemRef(rowId, pv, proc, nsid);
+	std::push_heap(heap.begin(), heap.end(), comparator);
+}
+
+void NsSelecter::addTopItems(LoopCtx &ctx, QueryResults &result) {
+	ItemRefVector &heap = ctx.topItems;
+	std::sort_heap(heap.begin(), heap.end(), std::cref(*ctx.comparator));
+	for (size_t i = ctx.sctx.query.start; i < heap.size(); ++i) {
+		result.Add(heap[i], ns_->payloadType_);
+	}
+	heap.clear();
 }
 
 void NsSelecter::setLimitAndOffset(ItemRefVector &queryResult, size_t offset, size_t limit) {
@@ -595,11 +977,26 @@ void NsSelecter::setLimitAndOffset(ItemRefVector &queryResult, size_t offset, si
 
 void NsSelecter::processLeftJoins(QueryResults &qr, SelectCtx &sctx) {
 	if (!checkIfThereAreLeftJoins(sctx)) return;
-	for (auto it : qr) {
-		IdType rowid = it.GetItemRef().id;
-		ConstPayload pl(ns_->payloadType_, ns_->items_[rowid]);
-		for (auto &joinedSelector : *sctx.joinedSelectors)
-			if (joinedSelector.Type() == JoinType::LeftJoin) joinedSelector.Process(rowid, sctx.nsid, pl, true);
+	std::vector<IdType> batch;
+	for (auto &joinedSelector : *sctx.joinedSelectors) {
+		if (joinedSelector.Type() != JoinType::LeftJoin) continue;
+		if (joinedSelector.Strategy() == JoinStrategy::Batched) {
+			batch.reserve(std::min(qr.Count(), kJoinBatchSize));
+			for (auto it : qr) {
+				batch.push_back(it.GetItemRef().id);
+				if (batch.size() == kJoinBatchSize) {
+					joinedSelector.ProcessBatch(batch, sctx.nsid);
+					batch.clear();
+				}
+			}
+			if (!batch.empty()) joinedSelector.ProcessBatch(batch, sctx.nsid);
+			batch.clear();
+		} else {
+			for (auto it : qr) {
+				IdType rowid = it.GetItemRef().id;
+				joinedSelector.Process(rowid, sctx.nsid, ConstPayload(ns_->payloadType_, ns_->items_[rowid]), true);
+			}
+		}
 	}
 }
 
@@ -615,6 +1012,10 @@ bool NsSelecter::checkIfThereAreLeftJoins(SelectCtx &sctx) const {
 
 template <bool reverse, bool hasComparators>
 void NsSelecter::selectLoop(LoopCtx &ctx, QueryResults &result, const RdxContext &rdxCtx) {
+	if (ctx.workersCount > 1) {
+		selectLoopParallel<reverse, hasComparators>(ctx, result, rdxCtx);
+		return;
+	}
 	const auto selectLoopWard = rdxCtx.BeforeSelectLoop();
 	unsigned start = 0;
 	unsigned count = UINT_MAX;
@@ -659,6 +1060,8 @@ void NsSelecter::selectLoop(LoopCtx &ctx, QueryResults &result, const RdxContext
 					"FirstIterator: %s, firstSortIndex: %s, firstSortIndex size: %d, rowId: %d", firstIterator.name.c_str(),
 					firstSortIndex->Name().c_str(), static_cast<int>(firstSortIndex->SortOrders().size()), rowId);
 			properRowId = firstSortIndex->SortOrders()[rowId];
+			// Sort orders, which are updated in place, contain free positions
+			if (properRowId == kSortOrdersHole) continue;
 		}
 
 		assert(static_cast<size_t>(properRowId) < ns_->items_.size());
@@ -705,6 +1108,8 @@ void NsSelecter::selectLoop(LoopCtx &ctx, QueryResults &result, const RdxContext
 			}
 			if (start) {
 				--start;
+			} else if (ctx.topK) {
+				pushTopItem(ctx.topItems, ctx, pv, properRowId, proc, sctx.nsid);
 			} else if (count) {
 				addSelectResult(proc, rowId, properRowId, sctx, aggregators, result);
 				--count;
@@ -716,7 +1121,132 @@ void NsSelecter::selectLoop(LoopCtx &ctx, QueryResults &result, const RdxContext
 		}
 	}
 
-	sortResults(sctx, result, sortingOptions, multisortLimitLeft);
+	finishSelectLoop(ctx, result, aggregators, sortingOptions, multisortLimitLeft, calcTotal);
+}
+
+// Shared pool of workers, which run parts of parallel select loops of all the queries together with the calling threads
+static WorkerPool &selectWorkers() {
+	static WorkerPool workers(std::max(1u, std::min(std::thread::hardware_concurrency(), kMaxSelectWorkers)) - 1);
+	return workers;
+}
+
+template <bool reverse, bool hasComparators>
+void NsSelecter::selectLoopParallel(LoopCtx &ctx, QueryResults &result, const RdxContext &rdxCtx) {
+	const auto selectLoopWard = rdxCtx.BeforeSelectLoop();
+	SelectCtx &sctx = ctx.sctx;
+	SelectIteratorContainer &qres = *ctx.qres;
+
+	unsigned start = 0;
+	unsigned count = UINT_MAX;
+	if (!sctx.isForceAll) {
+		start = sctx.query.start;
+		count = sctx.query.count;
+	}
+	auto aggregators = getAggregators(sctx.query);
+	bool calcTotal = ctx.calcTotal && (qres.Size() > 1 || hasComparators || (qres.IsIterator(0) && qres[0].size() > 1));
+	// Each part has to find not more than start + count items, because all of the skipped items may be found in it
+	const size_t limit = (count == UINT_MAX) ? std::numeric_limits<size_t>::max() : size_t(start) + count;
+
+	SortingOptions sortingOptions(sctx.query, sctx.sortingContext);
+	const Index *const firstSortIndex =
+		(sctx.sortingContext.isIndexOrdered() && sctx.sortingContext.enableSortOrders) ? sctx.sortingContext.sortIndex() : nullptr;
+	const IdType rowsCount = firstSortIndex ? firstSortIndex->SortOrders().size() : ns_->items_.size();
+
+	// Parts are ordered in the direction of iteration, so concatenation of their results keeps the order of serial loop
+	const unsigned workersCount = ctx.workersCount;
+	const IdType partSize = (rowsCount + workersCount - 1) / workersCount;
+	std::vector<LoopPartResult> parts(workersCount);
+	std::vector<SelectIteratorContainer> partsIterators;
+	partsIterators.reserve(workersCount);
+	for (unsigned i = 0; i < workersCount; ++i) {
+		parts[i].aggregators = getAggregators(sctx.query);
+		partsIterators.emplace_back(qres);
+	}
+
+	auto partRoutine = [&](unsigned i) {
+		try {
+			const unsigned partNo = reverse ? workersCount - 1 - i : i;
+			const IdType from = std::min(rowsCount, IdType(partNo * partSize));
+			const IdType to = std::min(rowsCount, IdType(from + partSize));
+			if (from < to) selectLoopPart<reverse, hasComparators>(ctx, partsIterators[i], from, to, limit, calcTotal, rdxCtx, parts[i]);
+		} catch (...) {
+			parts[i].error = std::current_exception();
+		}
+	};
+	selectWorkers().Parallel(workersCount, partRoutine);
+
+	for (auto &part : parts) {
+		if (part.error) std::rethrow_exception(part.error);
+	}
+
+	size_t matched = 0;
+	for (auto &part : parts) {
+		matched += part.matched;
+		for (auto &item : part.items) {
+			if (ctx.topK) {
+				pushTopItem(ctx.topItems, ctx, item.value, item.id, item.proc, item.nsid);
+			} else if (start) {
+				--start;
+			} else if (count) {
+				result.Add(item, ns_->payloadType_);
+				--count;
+			}
+		}
+		for (size_t i = 0; i < aggregators.size(); ++i) aggregators[i].Merge(std::move(part.aggregators[i]));
+	}
+	if (matched) sctx.matchedAtLeastOnce = true;
+	if (calcTotal) result.totalCount += matched;
+
+	finishSelectLoop(ctx, result, aggregators, sortingOptions, 0, calcTotal);
+}
+
+template <bool reverse, bool hasComparators>
+void NsSelecter::selectLoopPart(const LoopCtx &ctx, SelectIteratorContainer &qres, IdType from, IdType to, size_t limit, bool calcTotal,
+								const RdxContext &rdxCtx, LoopPartResult &res) {
+	const SelectCtx &sctx = ctx.sctx;
+	const Index *const firstSortIndex =
+		(sctx.sortingContext.isIndexOrdered() && sctx.sortingContext.enableSortOrders) ? sctx.sortingContext.sortIndex() : nullptr;
+
+	qres.ForeachIterator([](SelectIterator &it) { it.Start(reverse); });
+	SelectIterator &firstIterator = qres[0];
+	bool finish = false;
+	IdType rowId = reverse ? to - 1 : from;
+	int rowsBeforeCancelCheck = kSelectPartCancelCheckPeriod;
+	while (firstIterator.Next(rowId) && !finish) {
+		rowId = firstIterator.Val();
+		if (reverse ? rowId < from : rowId >= to) break;
+		if (!--rowsBeforeCancelCheck) {
+			ThrowOnCancel(rdxCtx);
+			rowsBeforeCancelCheck = kSelectPartCancelCheckPeriod;
+		}
+		const IdType properRowId = firstSortIndex ? firstSortIndex->SortOrders()[rowId] : rowId;
+		if (properRowId == kSortOrdersHole) continue;
+
+		assert(static_cast<size_t>(properRowId) < ns_->items_.size());
+		PayloadValue &pv = ns_->items_[properRowId];
+		if (pv.IsFree()) continue;
+		if (qres.Process<reverse, hasComparators>(pv, &finish, &rowId, properRowId, res.matched < limit)) {
+			if (res.aggregators.size()) {
+				for (auto &aggregator : res.aggregators) aggregator.Aggregate(pv);
+			} else if (ctx.topK) {
+				pushTopItem(res.items, ctx, pv, properRowId, 0, sctx.nsid);
+			} else if (res.matched < limit) {
+				res.items.push_back({properRowId, pv, 0, sctx.nsid});
+			}
+			++res.matched;
+			if (res.matched >= limit && !calcTotal && res.aggregators.empty()) break;
+		}
+	}
+}
+
+void NsSelecter::finishSelectLoop(LoopCtx &ctx, QueryResults &result, h_vector<Aggregator, 4> &aggregators,
+								  const SortingOptions &sortingOptions, size_t multisortLimitLeft, bool calcTotal) {
+	SelectCtx &sctx = ctx.sctx;
+	if (ctx.topK) {
+		addTopItems(ctx, result);
+	} else {
+		sortResults(sctx, result, sortingOptions, multisortLimitLeft);
+	}
 	processLeftJoins(result, sctx);
 
 	for (auto &aggregator : aggregators) {
@@ -726,13 +1256,31 @@ void NsSelecter::selectLoop(LoopCtx &ctx, QueryResults &result, const RdxContext
 	// Get total count for simple query with 1 condition and 1 idset
 	if (ctx.calcTotal && !calcTotal) {
 		if (!sctx.query.entries.Empty()) {
-			result.totalCount = qres[0].GetMaxIterations();
+			result.totalCount = (*ctx.qres)[0].GetMaxIterations();
 		} else {
 			result.totalCount = ns_->items_.size() - ns_->free_.size();
 		}
 	}
 }
 
+unsigned NsSelecter::getWorkersCount(const SelectIteratorContainer &qres, const SelectCtx &ctx, bool isFt, int maxIterations) const {
+	if (!ctx.query.parallel_ || maxIterations < kMinIterationsForParallelSelect) return 1;
+	// Joins, join preresults, distinct, fulltext and btree index iterators keep shared state while iterating
+	if (isFt || ctx.preResult || ctx.reqMatchedOnceFlag || ctx.sortingContext.isOptimizationEnabled()) return 1;
+	// Window of aggregated items depends on the order of iteration
+	if (!ctx.query.aggregations_.empty() && !ctx.isForceAll && (ctx.query.start || ctx.query.count != UINT_MAX)) return 1;
+	if (!ctx.isForceAll && ctx.query.count == 0) return 1;
+	if (SortingOptions(ctx.query, ctx.sortingContext).multiColumnByBtreeIndex) return 1;
+	bool parallelizable = true;
+	qres.ForeachIterator([&parallelizable](const SelectIterator &it, OpType) {
+		if (it.distinct || !it.joinIndexes.empty()) parallelizable = false;
+	});
+	if (!parallelizable) return 1;
+
+	unsigned workersCount = std::min(std::thread::hardware_concurrency(), kMaxSelectWorkers);
+	return std::max(1u, std::min(workersCount, unsigned(maxIterations / kMinIterationsPerSelectWorker)));
+}
+
 void NsSelecter::sortResults(reindexer::SelectCtx &sctx, QueryResults &result, const SortingOptions &sortingOptions,
 							 size_t multisortLimitLeft) {
 	if (sortingOptions.postLoopSortingRequired()) {
@@ -868,9 +1416,10 @@ void NsSelecter::prepareSortingContext(const SortingEntries &sortBy, SelectCtx &
 	}
 }
 
-void NsSelecter::prepareSortingIndexes(SortingEntries &sortingBy) {
+void NsSelecter::prepareSortingIndexes(SortingEntries &sortingBy, bool indexesResolved) {
 	for (SortingEntry &sortingEntry : sortingBy) {
 		assert(!sortingEntry.column.empty());
+		if (indexesResolved && sortingEntry.index != IndexValueType::NotSet) continue;
 		sortingEntry.index = IndexValueType::SetByJsonPath;
 		ns_->getIndexByName(sortingEntry.column, sortingEntry.index);
 	}
@@ -1,8 +1,12 @@
 #pragma once
+#include <exception>
 #include "core/aggregator.h"
 #include "core/index/index.h"
 #include "core/joincache.h"
+#include "core/query/preparedquery.h"
+#include "core/querycache.h"
 #include "core/nsselecter/selectiteratorcontainer.h"
+#include "estl/fast_hash_map.h"
 #include "sortingcontext.h"
 
 namespace reindexer {
@@ -18,11 +22,22 @@ struct JoinPreResult {
 	bool btreeIndexOptimizationEnabled = true;
 };
 
+/// Execution strategy of joined query
+enum class JoinStrategy {
+	/// Select from right namespace for each left item
+	NestedLoop,
+	/// Build hash table on the right namespace join field once, and probe it for each left item
+	Hash,
+	/// Select from right namespace once for the batch of left items, and scatter results to the left items
+	Batched,
+};
+
 class JoinedSelector {
 public:
 	JoinedSelector(JoinType joinType, std::shared_ptr<Namespace> leftNs, std::shared_ptr<Namespace> rightNs, JoinCacheRes &&joinRes,
 				   Query &&itemQuery, QueryResults &result, const JoinedQuery &joinQuery, JoinPreResult::Ptr preResult,
-				   size_t joinedFieldIdx, SelectFunctionsHolder &selectFunctions, int joinedSelectorsCount, const RdxContext &rdxCtx)
+				   size_t joinedFieldIdx, SelectFunctionsHolder &selectFunctions, int joinedSelectorsCount, const RdxContext &rdxCtx,
+				   JoinStrategy strategy = JoinStrategy::NestedLoop, size_t hashBuildThreshold = 0)
 		: joinType_(joinType),
 		  called_(0),
 		  matched_(0),
@@ -37,7 +52,9 @@ public:
 		  selectFunctions_(selectFunctions),
 		  joinedSelectorsCount_(joinedSelectorsCount),
 		  rdxCtx_(rdxCtx),
-		  optimized_(false) {}
+		  optimized_(false),
+		  strategy_(strategy),
+		  hashBuildThreshold_(hashBuildThreshold) {}
 
 	JoinedSelector(JoinedSelector &&) = default;
 
@@ -46,16 +63,37 @@ public:
 	JoinedSelector &operator=(JoinedSelector &&) = delete;
 
 	bool Process(IdType, int nsId, ConstPayload, bool match);
+	/// Process join for the batch of left items. Used by left join with batched strategy
+	/// @param rowIds - rowIds of left items
+	/// @param nsId - id of left namespace in results
+	void ProcessBatch(const std::vector<IdType> &rowIds, int nsId);
 	JoinType Type() const { return joinType_; }
 	const Namespace &RightNs() const { return *rightNs_; }
 	int Called() const { return called_; }
 	int Matched() const { return matched_; }
+	/// Strategy of join. Hash join, which has not built its hash table (see hashBuildThreshold_), is reported as nested loop
+	JoinStrategy Strategy() const { return (strategy_ == JoinStrategy::Hash && !hashTable_) ? JoinStrategy::NestedLoop : strategy_; }
 	void AppendSelectIteratorOfJoinIndexData(SelectIteratorContainer &, int *maxIterations, unsigned sortId, SelectFunction::Ptr,
 											 const RdxContext &);
+	/// Check if join conditions allow hash or batched join: all of them are equalities on plain indexes of the right namespace
+	/// @param itemQuery - query with join conditions on the right namespace
+	/// @param rightNs - right namespace
+	static bool IsEqualityJoin(const Query &itemQuery, const Namespace &rightNs);
 
 private:
+	/// Positions of right items in hashRowIds_ by values of the first join field
+	using HashJoinTable = fast_hash_map<Variant, h_vector<int, 1>>;
+
 	template <bool byJsonPath>
 	void readValues(VariantArray &values, const Index &leftIndex, int rightIdxNo, const std::string &rightIndex) const;
+	void setJoinValues(ConstPayload payload);
+	bool processNestedLoop(IdType rowId, int nsId, bool match);
+	bool processHash(IdType rowId, int nsId, bool match);
+	std::vector<IdType> selectHashJoinRowIds();
+	void buildHashTable(std::vector<IdType> &&rowIds);
+	bool probeHashTable(IdType rowId, int nsId, bool match);
+	bool matchRightItem(IdType rightRowId, VariantArray &buffer) const;
+	void addJoinedItems(IdType rowId, int nsId, QueryResults &&joinItemR);
 
 	JoinType joinType_;
 	int called_, matched_;
@@ -71,6 +109,14 @@ private:
 	int joinedSelectorsCount_;
 	const RdxContext &rdxCtx_;
 	bool optimized_;
+	JoinStrategy strategy_;
+	/// Count of probes of hash join, which are processed by nested loop before the hash table is built
+	size_t hashBuildThreshold_;
+	/// Right namespace items by values of the first join field. Built lazily on the first probe of hash join,
+	/// or for each batch of batched join
+	std::unique_ptr<HashJoinTable> hashTable_;
+	/// RowIds of right items in order of join results
+	std::vector<IdType> hashRowIds_;
 };
 
 typedef vector<JoinedSelector> JoinedSelectors;
@@ -84,6 +130,8 @@ struct SelectCtx {
 	JoinPreResult::Ptr preResult;
 	SortingContext sortingContext;
 	uint8_t nsid = 0;
+	/// Plan of prepared query. Its entries and sort order are used, if it's built for the current version of namespace indexes
+	const PreparedQuery::Plan *plan = nullptr;
 	bool isForceAll = false;
 	bool skipIndexesLookup = false;
 	bool matchedAtLeastOnce = false;
@@ -98,21 +146,62 @@ public:
 	void operator()(QueryResults &result, SelectCtx &ctx, const RdxContext &);
 
 private:
+	/// Comparator of items by sorting entries of query
+	class ItemComparator {
+	public:
+		ItemComparator(const Namespace &ns, const SelectCtx &ctx);
+		bool operator()(const ItemRef &lhs, const ItemRef &rhs) const { return Less(lhs.value, lhs.id, rhs.value, rhs.id); }
+		bool Less(const PayloadValue &lhs, IdType lhsId, const PayloadValue &rhs, IdType rhsId) const;
+		/// Partially sort items by normalized sort keys, if values of sort fields can be encoded to keys
+		/// @return false, if items were not sorted
+		bool SortByKeys(ItemRefVector::iterator first, ItemRefVector::iterator middle, ItemRefVector::iterator last) const;
+
+	private:
+		const PayloadType &payloadType_;
+		const SortingContext &sortingContext_;
+		FieldsSet fields_;
+		h_vector<const CollateOpts *, 1> collateOpts_;
+	};
+
 	struct LoopCtx {
 		LoopCtx(SelectCtx &ctx) : sctx(ctx) {}
 		SelectIteratorContainer *qres = nullptr;
 		bool calcTotal = false;
+		unsigned workersCount = 1;
 		SelectCtx &sctx;
+		/// Count of the best items (offset + limit), which are kept in the heap by select loop of sorted query, or 0
+		size_t topK = 0;
+		std::unique_ptr<ItemComparator> comparator;
+		/// Heap of the best items, the worst one is on the top
+		ItemRefVector topItems;
+	};
+	// Result of select loop over the part of rowIds range
+	struct LoopPartResult {
+		ItemRefVector items;
+		h_vector<Aggregator, 4> aggregators;
+		size_t matched = 0;
+		std::exception_ptr error;
 	};
 
 	template <bool reverse, bool haveComparators>
 	void selectLoop(LoopCtx &ctx, QueryResults &result, const RdxContext &);
+	template <bool reverse, bool haveComparators>
+	void selectLoopParallel(LoopCtx &ctx, QueryResults &result, const RdxContext &);
+	template <bool reverse, bool haveComparators>
+	void selectLoopPart(const LoopCtx &ctx, SelectIteratorContainer &qres, IdType from, IdType to, size_t limit, bool calcTotal,
+						const RdxContext &rdxCtx, LoopPartResult &res);
+	void finishSelectLoop(LoopCtx &ctx, QueryResults &result, h_vector<Aggregator, 4> &aggregators, const SortingOptions &sortingOptions,
+						  size_t multisortLimitLeft, bool calcTotal);
+	unsigned getWorkersCount(const SelectIteratorContainer &qres, const SelectCtx &ctx, bool isFt, int maxIterations) const;
 	void applyForcedSort(ItemRefVector &result, const SelectCtx &ctx);
 	void applyForcedSortDesc(ItemRefVector &result, const SelectCtx &ctx);
 
 	using ItemIterator = ItemRefVector::iterator;
 	using ConstItemIterator = const ItemIterator &;
 	void applyGeneralSort(ConstItemIterator itFirst, ConstItemIterator itLast, ConstItemIterator itEnd, const SelectCtx &ctx);
+	size_t getTopKLimit(const SelectCtx &ctx, const QueryResults &result) const;
+	void pushTopItem(ItemRefVector &heap, const LoopCtx &ctx, const PayloadValue &pv, IdType rowId, uint8_t proc, uint8_t nsid) const;
+	void addTopItems(LoopCtx &ctx, QueryResults &result);
 
 	void addSelectResult(uint8_t proc, IdType rowId, IdType properRowId, const SelectCtx &sctx, h_vector<Aggregator, 4> &aggregators,
 						 QueryResults &result);
@@ -121,7 +210,7 @@ private:
 	int getCompositeIndex(const FieldsSet &fieldsmask);
 	void setLimitAndOffset(ItemRefVector &result, size_t offset, size_t limit);
 	void prepareSortingContext(const SortingEntries &sortBy, SelectCtx &ctx, bool isFt);
-	void prepareSortingIndexes(SortingEntries &sortBy);
+	void prepareSortingIndexes(SortingEntries &sortBy, bool indexesResolved);
 	void getSortIndexValue(const SortingContext::Entry *sortCtx, IdType rowId, VariantArray &value);
 	void processLeftJoins(QueryResults &qr, SelectCtx &sctx);
 	bool checkIfThereAreLeftJoins(SelectCtx &sctx) const;
@@ -129,6 +218,12 @@ private:
 
 	bool isSortOptimizatonEffective(const QueryEntries &qe, SelectCtx &ctx, const RdxContext &rdxCtx);
 
+	/// Check if results of query can be stored in query results cache, and get indexes, which results depend on
+	bool getResultsCacheDeps(const SelectCtx &ctx, const QueryResults &result, IndexesMask &deps) const;
+	bool addResultsCacheDeps(const string &field, IndexesMask &deps) const;
+	void putCachedResults(const QueryResultsCacheVal::Data &cached, const SelectCtx &ctx, QueryResults &result);
+	void putResultsToCache(const QueryCacheKey &key, const IndexesMask &deps, const QueryResults &result);
+
 	Namespace *ns_;
 	SelectFunction::Ptr fnc_;
 	FtCtx::Ptr ft_ctx_;
@@ -6,25 +6,25 @@
 
 namespace reindexer {
 
-QueryEntries QueryPreprocessor::LookupQueryIndexes() const {
+QueryEntries QueryPreprocessor::LookupQueryIndexes(bool resetIndexes) const {
 	QueryEntries result;
 	result.Reserve(queries_->Size());
-	lookupQueryIndexes(&result, queries_->cbegin(), queries_->cend());
+	lookupQueryIndexes(&result, queries_->cbegin(), queries_->cend(), resetIndexes);
 	return result;
 }
 
-void QueryPreprocessor::lookupQueryIndexes(QueryEntries *dst, QueryEntries::const_iterator srcBegin,
-										   QueryEntries::const_iterator srcEnd) const {
+void QueryPreprocessor::lookupQueryIndexes(QueryEntries *dst, QueryEntries::const_iterator srcBegin, QueryEntries::const_iterator srcEnd,
+										   bool resetIndexes) const {
 	int iidx[maxIndexes];
 	for (int &i : iidx) i = -1;
 	for (auto it = srcBegin; it != srcEnd; ++it) {
 		if (!it->IsLeaf()) {
 			dst->OpenBracket(it->Op);
-			lookupQueryIndexes(dst, it->cbegin(it), it->cend(it));
+			lookupQueryIndexes(dst, it->cbegin(it), it->cend(it), resetIndexes);
 			dst->CloseBracket();
 		} else {
 			QueryEntry entry = it->Value();
-			if (entry.idxNo == IndexValueType::NotSet) {
+			if (entry.idxNo == IndexValueType::NotSet || resetIndexes) {
 				if (!ns_.getIndexByName(entry.index, entry.idxNo)) {
 					entry.idxNo = IndexValueType::SetByJsonPath;
 				}
@@ -106,21 +106,17 @@ size_t QueryPreprocessor::substituteCompositeIndexes(size_t from, size_t to) con
 		if ((found >= 0) && !isFullText(ns_.indexes_[found]->Type())) {
 			// composite idx found: replace conditions
 			h_vector<std::pair<int, VariantArray>, 4> values;
-			CondType condition = CondEq;
 			for (size_t i = first; i <= cur; i = queries_->Next(i)) {
 				if (ns_.indexes_[found]->Fields().contains((*queries_)[i].idxNo)) {
 					values.emplace_back((*queries_)[i].idxNo, std::move((*queries_)[i].values));
-					if (values.back().second.size() > 1) condition = CondSet;
 				} else {
 					queries_->SetOperation(queries_->GetOperation(i), first);
 					(*queries_)[first] = (*queries_)[i];
 					first = queries_->Next(first);
 				}
 			}
-			QueryEntry ce(condition, ns_.indexes_[found]->Name(), found);
-			createCompositeKeyValues(values, ns_.payloadType_, nullptr, ce.values, 0);
 			queries_->SetOperation(OpAnd, first);
-			(*queries_)[first] = ce;
+			(*queries_)[first] = createCompositeEntry(found, std::move(values));
 			deleted += (queries_->Next(cur) - queries_->Next(first));
 			queries_->Erase(queries_->Next(first), queries_->Next(cur));
 			cur = first;
@@ -131,6 +127,74 @@ size_t QueryPreprocessor::substituteCompositeIndexes(size_t from, size_t to) con
 	return deleted;
 }
 
+QueryEntry QueryPreprocessor::createCompositeEntry(int idxNo, h_vector<std::pair<int, VariantArray>, 4> &&values) const {
+	QueryEntry ce(CondEq, ns_.indexes_[idxNo]->Name(), idxNo);
+	for (auto &v : values) {
+		if (v.second.size() > 1) ce.condition = CondSet;
+		// Composite keys are built on bind from values of the same template entries
+		if (planning_) ce.values.insert(ce.values.end(), v.second.begin(), v.second.end());
+	}
+	if (!planning_) createCompositeKeyValues(values, ns_.payloadType_, nullptr, ce.values, 0);
+	return ce;
+}
+
+std::shared_ptr<PreparedQuery::Plan> QueryPreprocessor::BuildPlan(const Query &query) {
+	QueryEntries positions(query.entries);
+	for (size_t i = 0; i < positions.Size(); ++i) {
+		if (!positions.IsEntry(i)) continue;
+		positions[i].values.clear();
+		positions[i].values.push_back(Variant(int(i)));
+	}
+
+	planning_ = true;
+	SetQueryEntries(&positions);
+	auto plan = std::make_shared<PreparedQuery::Plan>(query, LookupQueryIndexes());
+	SetQueryEntries(&plan->entries);
+	plan->isFt = ContainsFullTextIndexes();
+	if (!plan->isFt) {
+		SubstituteCompositeIndexes();
+		plan->sortBy = DetectOptimalSortOrder();
+	}
+	planning_ = false;
+	return plan;
+}
+
+QueryEntries QueryPreprocessor::BindPlan(const PreparedQuery::Plan &plan) const {
+	QueryEntries result(plan.entries);
+	for (size_t i = 0; i < result.Size(); ++i) {
+		if (result.IsEntry(i)) result[i] = bindPlanEntry(result[i]);
+	}
+	return result;
+}
+
+QueryEntry QueryPreprocessor::bindPlanEntry(const QueryEntry &planned) const {
+	assert(!planned.values.empty());
+	QueryEntry entry = (*queries_)[int(planned.values[0])];
+	if (entry.idxNo == planned.idxNo) {
+		for (size_t i = 1; i < planned.values.size(); ++i) {
+			QueryEntry rhs = (*queries_)[int(planned.values[i])];
+			mergeQueryEntries(&entry, &rhs);
+		}
+		return entry;
+	}
+
+	// Entry of composite index: merge conditions on each of its fields, and build composite keys from their values
+	h_vector<QueryEntry, 4> fieldsEntries;
+	fieldsEntries.emplace_back(std::move(entry));
+	for (size_t i = 1; i < planned.values.size(); ++i) {
+		QueryEntry rhs = (*queries_)[int(planned.values[i])];
+		auto it = std::find_if(fieldsEntries.begin(), fieldsEntries.end(), [&rhs](const QueryEntry &e) { return e.idxNo == rhs.idxNo; });
+		if (it != fieldsEntries.end()) {
+			mergeQueryEntries(&*it, &rhs);
+		} else {
+			fieldsEntries.emplace_back(std::move(rhs));
+		}
+	}
+	h_vector<std::pair<int, VariantArray>, 4> values;
+	for (QueryEntry &fieldEntry : fieldsEntries) values.emplace_back(fieldEntry.idxNo, std::move(fieldEntry.values));
+	return createCompositeEntry(planned.idxNo, std::move(values));
+}
+
 void QueryPreprocessor::convertWhereValues(QueryEntry *qe) const {
 	bool isIndexField = (qe->idxNo != IndexValueType::SetByJsonPath);
 	KeyValueType keyType = isIndexField ? ns_.indexes_[qe->idxNo]->SelectKeyType() : detectQueryEntryIndexType(*qe);
@@ -186,6 +250,19 @@ const Index *QueryPreprocessor::findMaxIndex(QueryEntries::const_iterator begin,
 }
 
 bool QueryPreprocessor::mergeQueryEntries(QueryEntry *lhs, QueryEntry *rhs) const {
+	if (planning_) {
+		// Values are intersected on bind, so positions of both entries are kept
+		if ((lhs->condition == CondEq || lhs->condition == CondSet) && (rhs->condition == CondEq || rhs->condition == CondSet)) {
+			lhs->condition = CondSet;
+		} else if (lhs->condition == CondAny) {
+			lhs->condition = rhs->condition;
+		} else if (rhs->condition != CondAny) {
+			return false;
+		}
+		lhs->values.insert(lhs->values.end(), rhs->values.begin(), rhs->values.end());
+		lhs->distinct |= rhs->distinct;
+		return true;
+	}
 	if ((lhs->condition == CondEq || lhs->condition == CondSet) && (rhs->condition == CondEq || rhs->condition == CondSet)) {
 		// intersect 2 queryenries on same index
 
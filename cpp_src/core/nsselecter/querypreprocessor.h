@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/query/preparedquery.h"
 #include "core/query/queryentry.h"
 #include "estl/h_vector.h"
 
@@ -15,24 +16,35 @@ public:
 	void SetQueryEntries(QueryEntries *queries) { queries_ = queries; }
 	const QueryEntries &GetQueryEntries() const { return *queries_; }
 
-	QueryEntries LookupQueryIndexes() const;
+	/// @param resetIndexes - Resolve indexes of entries, even if they are already set
+	QueryEntries LookupQueryIndexes(bool resetIndexes = false) const;
 	bool ContainsFullTextIndexes() const;
 	void SubstituteCompositeIndexes() const { substituteCompositeIndexes(0, queries_->Size()); }
 	void ConvertWhereValues() const { convertWhereValues(queries_->begin(), queries_->end()); }
 	SortingEntries DetectOptimalSortOrder() const;
+	/// Build plan of prepared query from its template, which entries are resolved to indexes: merge conditions on the same index,
+	/// substitute composite indexes and detect sort order. Operations are applied to positions of template entries instead of values
+	std::shared_ptr<PreparedQuery::Plan> BuildPlan(const Query &query);
+	/// Build where entries of prepared query by its plan: merge and substitute bound values of template entries the same way
+	QueryEntries BindPlan(const PreparedQuery::Plan &plan) const;
 
 private:
-	void lookupQueryIndexes(QueryEntries *dst, QueryEntries::const_iterator srcBegin, QueryEntries::const_iterator srcEnd) const;
+	void lookupQueryIndexes(QueryEntries *dst, QueryEntries::const_iterator srcBegin, QueryEntries::const_iterator srcEnd,
+							bool resetIndexes) const;
 	size_t substituteCompositeIndexes(size_t from, size_t to) const;
 	KeyValueType detectQueryEntryIndexType(const QueryEntry &) const;
 	bool mergeQueryEntries(QueryEntry *lhs, QueryEntry *rhs) const;
 	int getCompositeIndex(const FieldsSet &) const;
+	QueryEntry createCompositeEntry(int idxNo, h_vector<std::pair<int, VariantArray>, 4> &&values) const;
+	QueryEntry bindPlanEntry(const QueryEntry &planned) const;
 	void convertWhereValues(QueryEntries::iterator begin, QueryEntries::iterator end) const;
 	void convertWhereValues(QueryEntry *) const;
 	const Index *findMaxIndex(QueryEntries::const_iterator begin, QueryEntries::const_iterator end) const;
 
 	Namespace &ns_;
 	QueryEntries *queries_;
+	// Plan of prepared query is being built: values of entries are positions of template entries
+	bool planning_ = false;
 };
 
 }  // namespace reindexer
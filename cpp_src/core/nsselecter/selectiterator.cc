@@ -43,6 +43,10 @@ void SelectIterator::Start(bool reverse) {
 					it->setend_ = it->set_->end();
 					it->itset_ = it->setbegin_;
 				}
+			} else if (it->useBitmap_) {
+				assert(it->bitmap_);
+				it->bitmapHint_ = 0;
+				it->bitmapVal_ = reverse ? it->bitmap_->Prev(INT_MAX, it->bitmapHint_) : it->bitmap_->Next(INT_MIN, it->bitmapHint_);
 			} else {
 				if (isReverse_) {
 					it->rbegin_ = it->ids_.rbegin();
@@ -66,9 +70,9 @@ void SelectIterator::Start(bool reverse) {
 		type_ = Unsorted;
 
 	} else if (size() == 1 && !isReverse_) {
-		type_ = begin()->isRange_ ? SingleRange : SingleIdset;
+		type_ = begin()->isRange_ ? SingleRange : (begin()->useBitmap_ ? SingleBitmap : SingleIdset);
 	} else if (size() == 1) {
-		type_ = begin()->isRange_ ? RevSingleRange : RevSingleIdset;
+		type_ = begin()->isRange_ ? RevSingleRange : (begin()->useBitmap_ ? RevSingleBitmap : RevSingleIdset);
 	}
 	if (size() == 0) {
 		type_ = OnlyComparator;
@@ -89,6 +93,14 @@ bool SelectIterator::nextFwd(IdType minHint) {
 					lastIt_ = it;
 				}
 			}
+		} else if (it->useBitmap_) {
+			if (it->bitmapVal_ != INT_MAX) {
+				if (it->bitmapVal_ <= lastVal_) it->bitmapVal_ = it->bitmap_->Next(lastVal_, it->bitmapHint_);
+				if (it->bitmapVal_ < minVal) {
+					minVal = it->bitmapVal_;
+					lastIt_ = it;
+				}
+			}
 		} else {
 			if (it->isRange_ && it->rIt_ != it->rEnd_) {
 				it->rIt_ = min(it->rEnd_, max(it->rIt_, lastVal_ + 1));
@@ -124,6 +136,14 @@ bool SelectIterator::nextRev(IdType maxHint) {
 				maxVal = *it->ritset_;
 				lastIt_ = it;
 			}
+		} else if (it->useBitmap_) {
+			if (it->bitmapVal_ != INT_MIN) {
+				if (it->bitmapVal_ >= lastVal_) it->bitmapVal_ = it->bitmap_->Prev(lastVal_, it->bitmapHint_);
+				if (it->bitmapVal_ > maxVal) {
+					maxVal = it->bitmapVal_;
+					lastIt_ = it;
+				}
+			}
 		} else if (it->isRange_ && it->rrIt_ != it->rrEnd_) {
 			it->rrIt_ = max(it->rrEnd_, min(it->rrIt_, lastVal_ - 1));
 
@@ -185,6 +205,23 @@ bool SelectIterator::nextRevSingleIdset(IdType maxHint) {
 	return !(lastVal_ == INT_MIN);
 }
 
+// Single bitmap next implementation
+bool SelectIterator::nextFwdSingleBitmap(IdType minHint) {
+	if (minHint > lastVal_) lastVal_ = minHint - 1;
+	auto it = begin();
+	if (it->bitmapVal_ <= lastVal_) it->bitmapVal_ = it->bitmap_->Next(lastVal_, it->bitmapHint_);
+	lastVal_ = it->bitmapVal_;
+	return !(lastVal_ == INT_MAX);
+}
+
+bool SelectIterator::nextRevSingleBitmap(IdType maxHint) {
+	if (maxHint < lastVal_) lastVal_ = maxHint + 1;
+	auto it = begin();
+	if (it->bitmapVal_ >= lastVal_) it->bitmapVal_ = it->bitmap_->Prev(lastVal_, it->bitmapHint_);
+	lastVal_ = it->bitmapVal_;
+	return !(lastVal_ == INT_MIN);
+}
+
 // Single range next implementation
 bool SelectIterator::nextFwdSingleRange(IdType minHint) {
 	if (minHint > lastVal_) lastVal_ = minHint - 1;
@@ -240,6 +277,8 @@ void SelectIterator::ExcludeLastSet() {
 		if (lastIt_->useBtree_) {
 			lastIt_->itset_ = lastIt_->setend_;
 			lastIt_->ritset_ = lastIt_->setrend_;
+		} else if (lastIt_->useBitmap_) {
+			lastIt_->bitmapVal_ = isReverse_ ? INT_MIN : INT_MAX;
 		} else {
 			lastIt_->it_ = lastIt_->end_;
 			lastIt_->rit_ = lastIt_->rend_;
@@ -306,6 +345,10 @@ const char *SelectIterator::TypeName() const {
 			return "RevSingleRange";
 		case RevSingleIdset:
 			return "RevSingleIdset";
+		case SingleBitmap:
+			return "SingleBitmap";
+		case RevSingleBitmap:
+			return "RevSingleBitmap";
 		case OnlyComparator:
 			return "OnlyComparator";
 		case Unsorted:
@@ -322,6 +365,7 @@ string SelectIterator::Dump() const {
 
 	for (auto &it : *this) {
 		if (it.useBtree_) ret += "btree;";
+		if (it.useBitmap_) ret += "bitmap;";
 		if (it.isRange_) ret += "range;";
 		if (it.bsearch_) ret += "bsearch;";
 		ret += ",";
@@ -15,6 +15,8 @@ public:
 		SingleIdset,
 		RevSingleRange,
 		RevSingleIdset,
+		SingleBitmap,
+		RevSingleBitmap,
 		OnlyComparator,
 		Unsorted,
 		UnbuiltSortOrdersIndex,
@@ -54,6 +56,12 @@ public:
 			case RevSingleIdset:
 				res = nextRevSingleIdset(minHint);
 				break;
+			case SingleBitmap:
+				res = nextFwdSingleBitmap(minHint);
+				break;
+			case RevSingleBitmap:
+				res = nextRevSingleBitmap(minHint);
+				break;
 			case OnlyComparator:
 				return false;
 			case Unsorted:
@@ -76,7 +84,7 @@ public:
 	/// Current rowId index since the beginning
 	/// of current SingleKeyValue object.
 	int Pos() const {
-		assert(!lastIt_->useBtree_ && (type_ != UnbuiltSortOrdersIndex));
+		assert(!lastIt_->useBtree_ && !lastIt_->useBitmap_ && (type_ != UnbuiltSortOrdersIndex));
 		return lastIt_->it_ - lastIt_->begin_ - 1;
 	}
 
@@ -139,6 +147,8 @@ protected:
 	bool nextFwdSingleIdset(IdType minHint);
 	bool nextRevSingleRange(IdType minHint);
 	bool nextRevSingleIdset(IdType minHint);
+	bool nextFwdSingleBitmap(IdType minHint);
+	bool nextRevSingleBitmap(IdType minHint);
 	bool nextUnbuiltSortOrders();
 	bool nextUnsorted();
 
@@ -119,6 +119,15 @@ bool SelectIteratorContainer::isIdset(const_iterator it, const_iterator end) {
 		   (++it == end || it->Op != OpOr);
 }
 
+int SelectIteratorContainer::GetMaxIterations() const {
+	int maxIterations = std::numeric_limits<int>::max();
+	ForeachIterator([&maxIterations](const SelectIterator &it, OpType) {
+		int cur = it.GetMaxIterations();
+		if (it.comparators_.empty() && cur && cur < maxIterations) maxIterations = cur;
+	});
+	return maxIterations;
+}
+
 bool SelectIteratorContainer::HasIdsets() const {
 	for (const_iterator it = cbegin(), end = cend(); it != end; ++it) {
 		if (isIdset(it, end)) return true;
@@ -126,6 +135,62 @@ bool SelectIteratorContainer::HasIdsets() const {
 	return false;
 }
 
+bool SelectIteratorContainer::ApplyColumnScan(size_t rowsCount) {
+	for (iterator it = begin(), end = this->end(); it != end; ++it) {
+		if (it->Op != OpAnd || !it->IsLeaf()) continue;
+		iterator next = it;
+		if (++next != end && next->Op == OpOr) continue;
+		SelectIterator &selIter = it->Value();
+		if (selIter.distinct || !selIter.joinIndexes.empty() || !selIter.empty() || selIter.comparators_.size() != 1) continue;
+
+		IdSet::Ptr ids = make_intrusive<intrusive_atomic_rc_wrapper<IdSet>>();
+		if (!selIter.comparators_[0].ScanColumn(rowsCount, *ids)) continue;
+		selIter.comparators_.clear();
+		selIter.push_back(SingleSelectKeyResult(ids));
+		return true;
+	}
+	return false;
+}
+
+void SelectIteratorContainer::MergeBitmapIdsets() {
+	h_vector<size_t, 4> andPositions, notPositions;
+	for (size_t i = 0, size = Size(); i < size; i = Next(i)) {
+		const OpType op = GetOperation(i);
+		if ((op != OpAnd && op != OpNot) || !IsValue(i) || (Next(i) < size && GetOperation(Next(i)) == OpOr)) continue;
+		const SelectIterator &selIter = operator[](i);
+		if (selIter.distinct || !selIter.joinIndexes.empty() || !selIter.comparators_.empty() || selIter.size() != 1 ||
+			!selIter[0].Bitmap())
+			continue;
+		(op == OpAnd ? andPositions : notPositions).push_back(i);
+	}
+	if (andPositions.empty() || andPositions.size() + notPositions.size() < 2) return;
+
+	SelectIterator &first = operator[](andPositions[0]);
+	IdSetBitmap merged;
+	const IdSetBitmap *cur = first[0].Bitmap();
+	for (size_t i = 1; i < andPositions.size(); ++i) {
+		const SelectIterator &selIter = operator[](andPositions[i]);
+		merged = IdSetBitmap::And(*cur, *selIter[0].Bitmap());
+		cur = &merged;
+		first.name += " and " + selIter.name;
+	}
+	for (size_t pos : notPositions) {
+		const SelectIterator &selIter = operator[](pos);
+		merged = IdSetBitmap::AndNot(*cur, *selIter[0].Bitmap());
+		cur = &merged;
+		first.name += " and not " + selIter.name;
+	}
+	IdSet::Ptr ids = make_intrusive<intrusive_atomic_rc_wrapper<IdSet>>();
+	ids->SetBitmap(std::move(merged));
+	first.clear();
+	first.push_back(SingleSelectKeyResult(ids));
+
+	andPositions.erase(andPositions.begin());
+	for (size_t pos : notPositions) andPositions.push_back(pos);
+	std::sort(andPositions.begin(), andPositions.end(), std::greater<size_t>());
+	for (size_t pos : andPositions) Erase(pos, pos + 1);
+}
+
 void SelectIteratorContainer::CheckFirstQuery() {
 	for (auto it = begin(); it != end(); ++it) {
 		if (isIdset(it, cend())) {
@@ -160,7 +225,7 @@ SelectKeyResults SelectIteratorContainer::processQueryEntry(const QueryEntry &qe
 	SelectKeyResults selectResults;
 	SelectKeyResult comparisonResult;
 	comparisonResult.comparators_.push_back(
-		Comparator(qe.condition, KeyValueUndefined, qe.values, false, qe.distinct, ns.payloadType_, fields, nullptr, CollateOpts()));
+		Comparator(qe.condition, KeyValueUndefined, qe.values, false, qe.distinct, ns.payloadType_, fields, nullptr, 0, CollateOpts()));
 	selectResults.push_back(comparisonResult);
 	return selectResults;
 }
@@ -20,7 +20,14 @@ public:
 	void ForeachIterator(const std::function<void(SelectIterator &)> &func) { ForeachValue(func); }
 
 	void SortByCost(int expectedIterations);
+	// Estimate count of iterations of select loop by the smallest idset
+	int GetMaxIterations() const;
 	bool HasIdsets() const;
+	// Replace the first suitable comparator over index store column with idset, built by batched column scan
+	// @return true, if comparator was replaced
+	bool ApplyColumnScan(size_t rowsCount);
+	// Merge bitmap idsets of top level AND and NOT conditions into single bitmap with bitmaps intersection
+	void MergeBitmapIdsets();
 	// Check NOT or comparator must not be 1st
 	void CheckFirstQuery();
 	// Let iterators choose most effecive algorith
@@ -0,0 +1,164 @@
+#include "sortkeys.h"
+#include <string.h>
+#include <algorithm>
+#include <cctype>
+#include "core/keyvalue/variant.h"
+#include "core/payload/payloadiface.h"
+#include "tools/customlocal.h"
+#include "utf8cpp/utf8.h"
+
+namespace reindexer {
+
+// Size of the key prefix, which is stored in the sort entry, and is compared without indirection
+static const size_t kSortKeyPrefixSize = sizeof(uint64_t);
+
+template <typename T>
+static void putBigEndian(T v, std::string &key) {
+	for (int shift = (sizeof(T) - 1) * 8; shift >= 0; shift -= 8) key.push_back(char(uint8_t(v >> shift)));
+}
+
+// Bytes of string are escaped, so the encoded string is never a prefix of another one: 0x00 -> 0x00 0xFF, end of string -> 0x00 0x00
+static void putEscapedByte(uint8_t b, std::string &key) {
+	key.push_back(char(b));
+	if (b == 0) key.push_back(char(0xFF));
+}
+
+static bool encodeString(string_view str, const CollateOpts &opts, std::string &key) {
+	switch (opts.mode) {
+		case CollateNone:
+			for (char ch : str) putEscapedByte(uint8_t(ch), key);
+			break;
+		case CollateASCII:
+			// collateCompare compares lower cased chars as signed values
+			for (char ch : str) {
+				const int lower = tolower(ch);
+				if (lower < -128 || lower > 127) return false;
+				putEscapedByte(uint8_t(lower + 128), key);
+			}
+			break;
+		case CollateUTF8: {
+			// collateCompare compares lower cased code points, and strings with equal code points by size in bytes.
+			// So the order is the same, only if lower cased code point has the same size in UTF-8, as the original one
+			const char *it = str.data(), *end = str.data() + str.size();
+			while (it < end) {
+				const char *chStart = it;
+				const wchar_t lower = ToLower(wchar_t(utf8::unchecked::next(it)));
+				if (it > end || lower < 0 || lower >= 0xFFFFFF) return false;
+				const int lowerSize = lower < 0x80 ? 1 : lower < 0x800 ? 2 : lower < 0x10000 ? 3 : 4;
+				if (lowerSize != it - chStart) return false;
+				// Code point is stored in 3 bytes, and is never equal to the end of string
+				const uint32_t cp = uint32_t(lower) + 1;
+				key.push_back(char(uint8_t(cp >> 16)));
+				key.push_back(char(uint8_t(cp >> 8)));
+				key.push_back(char(uint8_t(cp)));
+			}
+			// End of string is 3 zero bytes
+			key.push_back(0);
+			break;
+		}
+		default:
+			return false;
+	}
+	key.push_back(0);
+	key.push_back(0);
+	return true;
+}
+
+bool SortKeys::IsSupported(const PayloadFieldType &field, const CollateOpts &opts) {
+	if (field.IsArray()) return false;
+	switch (field.Type()) {
+		case KeyValueInt:
+		case KeyValueInt64:
+		case KeyValueDouble:
+		case KeyValueBool:
+			return true;
+		case KeyValueString:
+			return opts.mode == CollateNone || opts.mode == CollateASCII || opts.mode == CollateUTF8;
+		default:
+			return false;
+	}
+}
+
+bool SortKeys::Encode(const Variant &value, const CollateOpts &opts, bool desc, std::string &key) {
+	const size_t pos = key.size();
+	switch (value.Type()) {
+		case KeyValueInt:
+			putBigEndian(uint32_t(int(value)) ^ 0x80000000u, key);
+			break;
+		case KeyValueInt64:
+			putBigEndian(uint64_t(int64_t(value)) ^ 0x8000000000000000ull, key);
+			break;
+		case KeyValueBool:
+			key.push_back(bool(value) ? 1 : 0);
+			break;
+		case KeyValueDouble: {
+			double d = double(value);
+			// NaN is not ordered, and -0.0 is equal to 0.0
+			if (d != d) return false;
+			if (d == 0.0) d = 0.0;
+			uint64_t bits;
+			memcpy(&bits, &d, sizeof(bits));
+			bits = (bits & 0x8000000000000000ull) ? ~bits : (bits | 0x8000000000000000ull);
+			putBigEndian(bits, key);
+			break;
+		}
+		case KeyValueString:
+			if (!encodeString(string_view(value), opts, key)) return false;
+			break;
+		default:
+			return false;
+	}
+	// Encoded values are prefix free, so the inverted value gives reverse order
+	if (desc) {
+		for (size_t i = pos; i < key.size(); ++i) key[i] = ~key[i];
+	}
+	return true;
+}
+
+bool SortKeys::PartialSort(ItemRefVector::iterator first, ItemRefVector::iterator middle, ItemRefVector::iterator last) {
+	struct Entry {
+		uint64_t prefix;
+		uint32_t offset;
+		uint32_t size;
+		uint32_t pos;
+	};
+	const size_t count = last - first;
+	std::vector<Entry> entries;
+	entries.reserve(count);
+	std::string keys;
+	keys.reserve(count * (kSortKeyPrefixSize + sizeof(IdType)));
+
+	for (size_t i = 0; i < count; ++i) {
+		const size_t offset = keys.size();
+		ConstPayload pl(payloadType_, first[i].value);
+		for (const auto &field : fields_) {
+			if (!Encode(pl.Field(field.idx).Get(), field.opts ? *field.opts : CollateOpts(), field.desc, keys)) return false;
+		}
+		// Row id makes keys unique, so the order of items is consistent
+		putBigEndian(uint32_t(first[i].id) ^ (idDesc_ ? 0x7FFFFFFFu : 0x80000000u), keys);
+		entries.push_back({0, uint32_t(offset), uint32_t(keys.size() - offset), uint32_t(i)});
+	}
+	for (auto &entry : entries) {
+		for (size_t i = 0; i < kSortKeyPrefixSize; ++i) {
+			entry.prefix = (entry.prefix << 8) | (i < entry.size ? uint8_t(keys[entry.offset + i]) : 0);
+		}
+	}
+
+	const char *data = keys.data();
+	std::partial_sort(entries.begin(), entries.begin() + (middle - first), entries.end(), [data](const Entry &lhs, const Entry &rhs) {
+		if (lhs.prefix != rhs.prefix) return lhs.prefix < rhs.prefix;
+		// Keys are prefix free, so keys with equal prefixes are longer, than prefix
+		if (lhs.size <= kSortKeyPrefixSize || rhs.size <= kSortKeyPrefixSize) return lhs.size < rhs.size;
+		const size_t size = std::min(lhs.size, rhs.size) - kSortKeyPrefixSize;
+		const int res = memcmp(data + lhs.offset + kSortKeyPrefixSize, data + rhs.offset + kSortKeyPrefixSize, size);
+		return res ? res < 0 : lhs.size < rhs.size;
+	});
+
+	std::vector<ItemRef> items;
+	items.reserve(count);
+	for (const auto &entry : entries) items.emplace_back(std::move(first[entry.pos]));
+	std::move(items.begin(), items.end(), first);
+	return true;
+}
+
+}  // namespace reindexer
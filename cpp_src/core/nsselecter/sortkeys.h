@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include "core/indexopts.h"
+#include "core/payload/payloadtype.h"
+#include "core/queryresults/itemref.h"
+
+namespace reindexer {
+
+class Variant;
+
+/// Normalized sort keys of items.
+/// Key of item is the byte string, which is comparable by memcmp. It contains values of sort fields, encoded with applied collation
+/// and sort direction, and row id of item. So items are sorted without decoding of payloads on each comparison
+class SortKeys {
+public:
+	/// Sort field of key
+	struct Field {
+		int idx;
+		const CollateOpts *opts;
+		bool desc;
+	};
+
+	/// Create keys builder
+	/// @param payloadType - Payload type of items
+	/// @param fields - Sort fields, in order of sort priority
+	/// @param idDesc - Order of row ids of items with equal sort fields
+	SortKeys(const PayloadType &payloadType, const h_vector<Field, 4> &fields, bool idDesc)
+		: payloadType_(payloadType), fields_(fields), idDesc_(idDesc) {}
+
+	/// Check if values of field can be encoded to keys. Array fields, numeric and custom collations are not supported
+	static bool IsSupported(const PayloadFieldType &field, const CollateOpts &opts);
+	/// Append encoded value to key
+	/// @param value - Value of field
+	/// @param opts - Collate opts of value
+	/// @param desc - Descending order of value
+	/// @param key - Key to append to
+	/// @return false, if value can't be encoded, e.g. NaN, or string which changes its length on case folding
+	static bool Encode(const Variant &value, const CollateOpts &opts, bool desc, std::string &key);
+
+	/// Partially sort items by keys: [first, middle) will contain the smallest items in sorted order
+	/// @return false, if some of values can't be encoded, and items were not sorted
+	bool PartialSort(ItemRefVector::iterator first, ItemRefVector::iterator middle, ItemRefVector::iterator last);
+
+private:
+	const PayloadType &payloadType_;
+	h_vector<Field, 4> fields_;
+	bool idDesc_;
+};
+
+}  // namespace reindexer
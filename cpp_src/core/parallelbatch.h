@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+namespace reindexer {
+
+/// Parts of parallel call func(0), ..., func(count - 1). Parts are taken by any count of threads, which call Run.
+/// First exception of parts is kept to be rethrown by the caller
+struct ParallelBatch {
+	ParallelBatch(const std::function<void(unsigned)> &f, unsigned c) : func(f), count(c) {}
+
+	// Calls func for parts, which are not taken by other threads yet
+	void Run() {
+		for (unsigned i = next++; i < count; i = next++) {
+			try {
+				func(i);
+			} catch (...) {
+				std::lock_guard<std::mutex> lck(mtx);
+				if (!error) error = std::current_exception();
+			}
+			std::lock_guard<std::mutex> lck(mtx);
+			if (++done == count) cv.notify_all();
+		}
+	}
+	void Wait() {
+		std::unique_lock<std::mutex> lck(mtx);
+		cv.wait(lck, [this]() { return done == count; });
+	}
+
+	// func is referenced only while there are parts to call, so caller of Parallel keeps it alive
+	const std::function<void(unsigned)> &func;
+	const unsigned count;
+	std::atomic<unsigned> next{0};
+	unsigned done = 0;
+	std::exception_ptr error;
+	std::mutex mtx;
+	std::condition_variable cv;
+};
+
+}  // namespace reindexer
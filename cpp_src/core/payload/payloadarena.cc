@@ -0,0 +1,384 @@
+#include "payloadarena.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <memory>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace reindexer {
+
+constexpr size_t PayloadArena::kSlabSize;
+constexpr size_t PayloadArena::kRegionSlabs;
+constexpr size_t PayloadArena::kMaxBlockSize;
+
+struct PayloadArena::Region {
+	uint8_t *memory;
+	// Bits of free slabs
+	uint64_t freeMask;
+	// Neighbours in the list of regions with free slabs
+	Region *prev;
+	Region *next;
+};
+
+struct PayloadArena::Slab {
+	PayloadArena *arena;
+	Region *region;
+	// Neighbours in the list of partial slabs of size class
+	Slab *prev;
+	Slab *next;
+	// List of freed blocks. Pointer to the next free block is stored in the block itself
+	uint8_t *freeList;
+	// Offset of the first never allocated block
+	uint32_t bumpOffset;
+	uint32_t blockSize;
+	uint32_t blocksCount;
+	uint32_t usedCount;
+	uint8_t sizeClass;
+	bool inPartial;
+	bool evacuated;
+};
+
+// Blocks begin after slab header and are aligned by 16 bytes
+static constexpr uint32_t kSlabHeaderSize = 64;
+
+// Slab is considered sparse, if less than 1/kSparseSlabRatio of its blocks are used
+static constexpr uint32_t kSparseSlabRatio = 2;
+// Compaction is started, when wasted memory exceeds 1/kCompactionWasteRatio of slabs size and kMinCompactionWaste
+static constexpr size_t kCompactionWasteRatio = 4;
+static constexpr size_t kMinCompactionWaste = 1 << 20;
+
+// Size classes: step 16 bytes up to 128, and 4 classes per each power of 2 up to kMaxBlockSize
+static const std::vector<uint32_t> &classSizes() {
+	static const std::vector<uint32_t> sizes = [] {
+		std::vector<uint32_t> ret;
+		for (uint32_t size = 32; size <= 128; size += 16) ret.push_back(size);
+		for (uint32_t base = 128; base < PayloadArena::kMaxBlockSize; base *= 2) {
+			for (uint32_t step = 1; step <= 4; ++step) ret.push_back(base + base / 4 * step);
+		}
+		return ret;
+	}();
+	return sizes;
+}
+
+// Size class of the block size, rounded up by 16 bytes
+static unsigned sizeClassOf(size_t size) {
+	static const std::vector<uint8_t> table = [] {
+		const auto &sizes = classSizes();
+		std::vector<uint8_t> ret(PayloadArena::kMaxBlockSize / 16 + 1);
+		unsigned cls = 0;
+		for (size_t i = 0; i < ret.size(); ++i) {
+			while (sizes[cls] < i * 16) ++cls;
+			ret[i] = cls;
+		}
+		return ret;
+	}();
+	return table[(size + 15) / 16];
+}
+
+static constexpr size_t kRegionSize = PayloadArena::kRegionSlabs * PayloadArena::kSlabSize;
+static constexpr uint64_t kAllSlabsFree = ~uint64_t(0);
+static_assert(PayloadArena::kRegionSlabs == 64, "Free slabs of region are stored in 64 bits mask");
+
+static void *allocRegionMemory() {
+	void *p = nullptr;
+#ifdef _WIN32
+	p = _aligned_malloc(kRegionSize, PayloadArena::kSlabSize);
+#else
+	if (posix_memalign(&p, PayloadArena::kSlabSize, kRegionSize)) p = nullptr;
+#endif
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+static void freeRegionMemory(void *p) {
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+static unsigned lowestBit(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(v);
+#else
+	unsigned n = 0;
+	for (; !(v & 1); v >>= 1) ++n;
+	return n;
+#endif
+}
+
+PayloadArena::PayloadArena() : classes_(classSizes().size()), usedSize_(0), blocksCount_(0), refcount_(0) {}
+
+PayloadArena::~PayloadArena() {
+	// All the blocks are freed here, so only empty slabs are left in the partial lists, and the regions are empty
+	for (auto &cls : classes_) {
+		while (cls.partial) freeSlab(cls.partial);
+	}
+	assert(!slabsCount_);
+	while (freeRegions_) {
+		Region *region = freeRegions_;
+		unlinkRegion(region);
+		freeRegionMemory(region->memory);
+		delete region;
+	}
+}
+
+PayloadArena::Slab *PayloadArena::slabOf(const uint8_t *block) {
+	return reinterpret_cast<Slab *>(reinterpret_cast<uintptr_t>(block) & ~uintptr_t(kSlabSize - 1));
+}
+
+PayloadArena *PayloadArena::Of(const uint8_t *block) { return slabOf(block)->arena; }
+
+void PayloadArena::pushPartial(Slab *slab) {
+	assert(!slab->inPartial);
+	SizeClass &cls = classes_[slab->sizeClass];
+	slab->prev = nullptr;
+	slab->next = cls.partial;
+	if (cls.partial) cls.partial->prev = slab;
+	cls.partial = slab;
+	slab->inPartial = true;
+}
+
+void PayloadArena::removePartial(Slab *slab) {
+	assert(slab->inPartial);
+	SizeClass &cls = classes_[slab->sizeClass];
+	if (slab->prev) {
+		slab->prev->next = slab->next;
+	} else {
+		cls.partial = slab->next;
+	}
+	if (slab->next) slab->next->prev = slab->prev;
+	slab->prev = slab->next = nullptr;
+	slab->inPartial = false;
+}
+
+void PayloadArena::linkRegion(Region *region) {
+	region->prev = nullptr;
+	region->next = freeRegions_;
+	if (freeRegions_) freeRegions_->prev = region;
+	freeRegions_ = region;
+}
+
+void PayloadArena::unlinkRegion(Region *region) {
+	if (region->prev) {
+		region->prev->next = region->next;
+	} else {
+		freeRegions_ = region->next;
+	}
+	if (region->next) region->next->prev = region->prev;
+	region->prev = region->next = nullptr;
+}
+
+uint8_t *PayloadArena::allocSlabMemory(Region *&region) {
+	region = freeRegions_;
+	if (!region) {
+		std::unique_ptr<Region> newRegion(new Region);
+		newRegion->memory = static_cast<uint8_t *>(allocRegionMemory());
+		newRegion->freeMask = kAllSlabsFree;
+		region = newRegion.release();
+		linkRegion(region);
+		regionsCount_++;
+	}
+	const unsigned idx = lowestBit(region->freeMask);
+	region->freeMask &= ~(uint64_t(1) << idx);
+	if (!region->freeMask) unlinkRegion(region);
+	slabsCount_++;
+	return region->memory + idx * kSlabSize;
+}
+
+void PayloadArena::freeSlabMemory(Region *region, uint8_t *memory) {
+	if (!region->freeMask) linkRegion(region);
+	region->freeMask |= uint64_t(1) << ((memory - region->memory) / kSlabSize);
+	slabsCount_--;
+	// Empty region is freed, unless it's the only region with free slabs: it's kept to avoid reallocations
+	if (region->freeMask == kAllSlabsFree && (region->prev || region->next)) {
+		unlinkRegion(region);
+		freeRegionMemory(region->memory);
+		delete region;
+		regionsCount_--;
+	}
+}
+
+PayloadArena::Slab *PayloadArena::newSlab(unsigned sizeClass) {
+	static_assert(sizeof(Slab) <= kSlabHeaderSize && kSlabHeaderSize % 16 == 0, "Wrong size of slab header");
+	Region *region;
+	uint8_t *memory;
+	{
+		std::lock_guard<std::mutex> lck(mtx_);
+		memory = allocSlabMemory(region);
+	}
+	Slab *slab = new (memory) Slab;
+	slab->arena = this;
+	slab->region = region;
+	slab->prev = slab->next = nullptr;
+	slab->freeList = nullptr;
+	slab->bumpOffset = kSlabHeaderSize;
+	slab->blockSize = classSizes()[sizeClass];
+	slab->blocksCount = (kSlabSize - kSlabHeaderSize) / slab->blockSize;
+	slab->usedCount = 0;
+	slab->sizeClass = sizeClass;
+	slab->inPartial = false;
+	slab->evacuated = false;
+	classes_[sizeClass].slabsCount++;
+	return slab;
+}
+
+void PayloadArena::freeSlab(Slab *slab) {
+	assert(!slab->usedCount);
+	if (slab->inPartial) removePartial(slab);
+	classes_[slab->sizeClass].slabsCount--;
+	Region *region = slab->region;
+	slab->~Slab();
+	std::lock_guard<std::mutex> lck(mtx_);
+	freeSlabMemory(region, reinterpret_cast<uint8_t *>(slab));
+}
+
+uint8_t *PayloadArena::Alloc(size_t &size) {
+	if (size > kMaxBlockSize) return nullptr;
+	const unsigned sizeClass = sizeClassOf(size);
+	SizeClass &cls = classes_[sizeClass];
+
+	uint8_t *block;
+	{
+		std::lock_guard<std::mutex> lck(cls.mtx);
+		Slab *slab = cls.partial;
+		if (!slab) {
+			slab = newSlab(sizeClass);
+			pushPartial(slab);
+		}
+
+		if (slab->freeList) {
+			block = slab->freeList;
+			slab->freeList = *reinterpret_cast<uint8_t **>(block);
+		} else {
+			block = reinterpret_cast<uint8_t *>(slab) + slab->bumpOffset;
+			slab->bumpOffset += slab->blockSize;
+		}
+		if (++slab->usedCount == slab->blocksCount) removePartial(slab);
+		size = slab->blockSize;
+	}
+
+	usedSize_.fetch_add(size, std::memory_order_relaxed);
+	blocksCount_.fetch_add(1, std::memory_order_relaxed);
+	intrusive_ptr_add_ref(this);
+	return block;
+}
+
+void PayloadArena::Free(uint8_t *block) {
+	Slab *slab = slabOf(block);
+	PayloadArena *arena = slab->arena;
+	// Size class of slab is not changed, while it has allocated blocks
+	SizeClass &cls = arena->classes_[slab->sizeClass];
+	const size_t blockSize = slab->blockSize;
+	{
+		std::lock_guard<std::mutex> lck(cls.mtx);
+		*reinterpret_cast<uint8_t **>(block) = slab->freeList;
+		slab->freeList = block;
+
+		// Evacuated slabs are returned to the partial lists, when compaction is done
+		if (!slab->evacuated) {
+			if (slab->usedCount == slab->blocksCount) arena->pushPartial(slab);
+			// Last empty slab of size class is kept to avoid reallocations
+			if (!--slab->usedCount && cls.slabsCount > 1) arena->freeSlab(slab);
+		} else {
+			slab->usedCount--;
+		}
+	}
+	arena->usedSize_.fetch_sub(blockSize, std::memory_order_relaxed);
+	arena->blocksCount_.fetch_sub(1, std::memory_order_relaxed);
+	intrusive_ptr_release(arena);
+}
+
+size_t PayloadArena::waste() const {
+	const size_t totalSize = slabsCount_ * kSlabSize;
+	const size_t usedSize = usedSize_.load(std::memory_order_relaxed);
+	// Counters are updated without lock, so they may be inconsistent for a while
+	return totalSize > usedSize ? totalSize - usedSize : 0;
+}
+
+bool PayloadArena::NeedsCompaction() const {
+	std::lock_guard<std::mutex> lck(mtx_);
+	const size_t w = waste();
+	return !compacting_ && w >= kMinCompactionWaste && w >= slabsCount_ * kSlabSize / kCompactionWasteRatio &&
+		   w >= wasteAfterCompaction_ + kMinCompactionWaste;
+}
+
+bool PayloadArena::BeginCompaction() {
+	{
+		std::lock_guard<std::mutex> lck(mtx_);
+		if (compacting_) return false;
+		assert(evacuated_.empty());
+		compacting_ = true;
+	}
+	std::vector<Slab *> evacuated;
+	for (auto &cls : classes_) {
+		std::lock_guard<std::mutex> lck(cls.mtx);
+		// Moving of blocks from the only sparse slab of size class will not free any memory
+		size_t sparseCount = 0;
+		for (Slab *slab = cls.partial; slab && sparseCount < 2; slab = slab->next) {
+			if (slab->usedCount * kSparseSlabRatio < slab->blocksCount) sparseCount++;
+		}
+		if (sparseCount < 2) continue;
+
+		for (Slab *slab = cls.partial, *next; slab; slab = next) {
+			next = slab->next;
+			if (slab->usedCount * kSparseSlabRatio >= slab->blocksCount) continue;
+			removePartial(slab);
+			if (!slab->usedCount) {
+				freeSlab(slab);
+				continue;
+			}
+			slab->evacuated = true;
+			evacuated.push_back(slab);
+		}
+	}
+
+	std::lock_guard<std::mutex> lck(mtx_);
+	evacuated_ = std::move(evacuated);
+	compacting_ = !evacuated_.empty();
+	if (!compacting_) wasteAfterCompaction_ = waste();
+	return compacting_;
+}
+
+bool PayloadArena::IsEvacuated(const uint8_t *block) const {
+	const Slab *slab = slabOf(block);
+	// Flag is changed only by the owner, which is performing compaction
+	return slab->arena == this && slab->evacuated;
+}
+
+void PayloadArena::EndCompaction() {
+	std::vector<Slab *> evacuated;
+	{
+		std::lock_guard<std::mutex> lck(mtx_);
+		evacuated.swap(evacuated_);
+	}
+	for (Slab *slab : evacuated) {
+		std::lock_guard<std::mutex> lck(classes_[slab->sizeClass].mtx);
+		slab->evacuated = false;
+		// Blocks, which are shared with another owners, are left in place
+		if (slab->usedCount) {
+			pushPartial(slab);
+		} else {
+			freeSlab(slab);
+		}
+	}
+	std::lock_guard<std::mutex> lck(mtx_);
+	compacting_ = false;
+	wasteAfterCompaction_ = waste();
+}
+
+PayloadArenaMemStat PayloadArena::GetMemStat() const {
+	std::lock_guard<std::mutex> lck(mtx_);
+	PayloadArenaMemStat ret;
+	ret.regionsCount = regionsCount_;
+	ret.slabsCount = slabsCount_;
+	ret.blocksCount = blocksCount_.load(std::memory_order_relaxed);
+	ret.totalSize = slabsCount_ * kSlabSize;
+	ret.usedSize = usedSize_.load(std::memory_order_relaxed);
+	return ret;
+}
+
+}  // namespace reindexer
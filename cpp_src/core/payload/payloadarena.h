@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "core/namespacestat.h"
+#include "estl/intrusive_ptr.h"
+
+namespace reindexer {
+
+// Slab allocator for payload values of namespace items.
+// Memory is allocated by aligned slabs, each slab is divided into blocks of one size class,
+// so slab of the block is found by block's address.
+// Slabs are carved from large regions, so each region of kRegionSlabs slabs takes a single system allocation (and memory mapping).
+// Each size class has its own lock, so allocations and frees of blocks of different sizes don't contend.
+// Blocks may outlive the namespace (e.g. being held by query results), so each allocated block holds a reference to the arena.
+class PayloadArena {
+public:
+	using Ptr = intrusive_ptr<PayloadArena>;
+
+	static constexpr size_t kSlabSize = 64 * 1024;
+	// Count of slabs in region (4MB)
+	static constexpr size_t kRegionSlabs = 64;
+	// Payloads of bigger size are allocated by operator new
+	static constexpr size_t kMaxBlockSize = 4096;
+
+	PayloadArena();
+	PayloadArena(const PayloadArena &) = delete;
+	PayloadArena &operator=(const PayloadArena &) = delete;
+	~PayloadArena();
+
+	// Allocates block of at least size bytes, and sets size to actual size of block.
+	// Returns nullptr, if size is too big for slabs
+	uint8_t *Alloc(size_t &size);
+	// Frees block, allocated by any arena
+	static void Free(uint8_t *block);
+	// Returns arena, which owns block
+	static PayloadArena *Of(const uint8_t *block);
+
+	// Compaction moves blocks from sparse slabs to the dense ones, so the sparse slabs can be freed.
+	// Blocks can't be moved by the arena itself - their owner moves blocks, allocated in evacuated slabs, between BeginCompaction and
+	// EndCompaction
+	bool NeedsCompaction() const;
+	// Marks sparse slabs as evacuated: new blocks will not be allocated there. Returns false, if there is nothing to compact
+	bool BeginCompaction();
+	// Returns true, if block is allocated by this arena in the evacuated slab
+	bool IsEvacuated(const uint8_t *block) const;
+	void EndCompaction();
+
+	PayloadArenaMemStat GetMemStat() const;
+
+private:
+	struct Slab;
+	struct Region;
+	struct SizeClass {
+		// Guards slabs of size class
+		std::mutex mtx;
+		// Slabs with free blocks
+		Slab *partial = nullptr;
+		size_t slabsCount = 0;
+	};
+
+	static Slab *slabOf(const uint8_t *block);
+	// The following methods are called under lock of size class of slab
+	void pushPartial(Slab *slab);
+	void removePartial(Slab *slab);
+	Slab *newSlab(unsigned sizeClass);
+	void freeSlab(Slab *slab);
+	// Take free slab memory from region and return it back. Called under mtx_
+	uint8_t *allocSlabMemory(Region *&region);
+	void freeSlabMemory(Region *region, uint8_t *memory);
+	void linkRegion(Region *region);
+	void unlinkRegion(Region *region);
+	// Size of free memory in slabs. Called under mtx_
+	size_t waste() const;
+
+	friend void intrusive_ptr_add_ref(PayloadArena *arena) { arena->refcount_.fetch_add(1, std::memory_order_relaxed); }
+	friend void intrusive_ptr_release(PayloadArena *arena) {
+		if (arena->refcount_.fetch_sub(1, std::memory_order_acq_rel) == 1) delete arena;
+	}
+
+	std::vector<SizeClass> classes_;
+	// Guards regions and compaction state. It's taken after lock of size class, if both are needed
+	mutable std::mutex mtx_;
+	// Regions with free slabs
+	Region *freeRegions_ = nullptr;
+	size_t regionsCount_ = 0;
+	size_t slabsCount_ = 0;
+	std::vector<Slab *> evacuated_;
+	// Wasted size after the last compaction, which didn't free all the sparse slabs
+	size_t wasteAfterCompaction_ = 0;
+	bool compacting_ = false;
+	std::atomic<size_t> usedSize_;
+	std::atomic<size_t> blocksCount_;
+	// References of the owners and of the allocated blocks
+	std::atomic<int> refcount_;
+};
+
+}  // namespace reindexer
@@ -1,11 +1,12 @@
 #include "payloadvalue.h"
 #include <chrono>
+#include "payloadarena.h"
 #include "string.h"
 #include "tools/errors.h"
 namespace reindexer {
 
 PayloadValue::PayloadValue(size_t size, const uint8_t *ptr, size_t cap) : p_(nullptr) {
-	p_ = alloc((cap != 0) ? cap : size);
+	p_ = alloc((cap != 0) ? cap : size, nullptr);
 
 	if (ptr)
 		memcpy(Ptr(), ptr, size);
@@ -13,6 +14,11 @@ PayloadValue::PayloadValue(size_t size, const uint8_t *ptr, size_t cap) : p_(nul
 		memset(Ptr(), 0, size);
 }
 
+PayloadValue::PayloadValue(size_t size, PayloadArena &arena) : p_(nullptr) {
+	p_ = alloc(size, &arena);
+	memset(Ptr(), 0, size);
+}
+
 PayloadValue::PayloadValue(const PayloadValue &other) : p_(other.p_) {
 	if (p_) {
 		header()->refcount.fetch_add(1, std::memory_order_relaxed);
@@ -21,11 +27,20 @@ PayloadValue::PayloadValue(const PayloadValue &other) : p_(other.p_) {
 
 PayloadValue::~PayloadValue() { release(); }
 
-uint8_t *PayloadValue::alloc(size_t cap) {
-	auto pn = reinterpret_cast<uint8_t *>(operator new(cap + sizeof(dataHeader)));
+uint8_t *PayloadValue::alloc(size_t cap, PayloadArena *arena) {
+	size_t size = cap + sizeof(dataHeader);
+	uint8_t *pn = arena ? arena->Alloc(size) : nullptr;
+	const bool inArena = (pn != nullptr);
+	if (inArena) {
+		// Use the whole block, so it can be resized in place
+		cap = size - sizeof(dataHeader);
+	} else {
+		pn = reinterpret_cast<uint8_t *>(operator new(size));
+	}
 	dataHeader *nheader = reinterpret_cast<dataHeader *>(pn);
 	new (nheader) dataHeader();
 	nheader->cap = cap;
+	nheader->inArena = inArena;
 	if (p_) {
 		nheader->lsn = header()->lsn;
 	} else
@@ -35,12 +50,19 @@ uint8_t *PayloadValue::alloc(size_t cap) {
 
 void PayloadValue::release() {
 	if (p_ && header()->refcount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		const bool inArena = header()->inArena;
 		header()->~dataHeader();
-		delete p_;
+		if (inArena) {
+			PayloadArena::Free(p_);
+		} else {
+			delete p_;
+		}
 	}
 	p_ = nullptr;
 }
 
+PayloadArena *PayloadValue::arena() const { return (p_ && header()->inArena) ? PayloadArena::Of(p_) : nullptr; }
+
 void PayloadValue::Clone(size_t size) {
 	// If we have exclusive data - just up lsn
 	if (p_ && header()->refcount.load() == 1) {
@@ -48,7 +70,7 @@ void PayloadValue::Clone(size_t size) {
 	}
 	assert(size || p_);
 
-	auto pn = alloc(p_ ? header()->cap : size);
+	auto pn = alloc(p_ ? header()->cap : size, arena());
 	if (p_) {
 		// Make new data & copy
 		memcpy(pn + sizeof(dataHeader), Ptr(), header()->cap);
@@ -67,7 +89,7 @@ void PayloadValue::Resize(size_t oldSize, size_t newSize) {
 
 	if (newSize <= header()->cap) return;
 
-	auto pn = alloc(newSize);
+	auto pn = alloc(newSize, arena());
 	memcpy(pn + sizeof(dataHeader), Ptr(), oldSize);
 	memset(pn + sizeof(dataHeader) + oldSize, 0, newSize - oldSize);
 
@@ -76,4 +98,16 @@ void PayloadValue::Resize(size_t oldSize, size_t newSize) {
 	p_ = pn;
 }
 
+bool PayloadValue::Compact(PayloadArena &arena) {
+	if (!p_ || !header()->inArena || !arena.IsEvacuated(p_)) return false;
+	// Shared data can't be moved: other owners hold pointer to it
+	if (header()->refcount.load(std::memory_order_acquire) != 1) return false;
+
+	auto pn = alloc(header()->cap, &arena);
+	memcpy(pn + sizeof(dataHeader), Ptr(), header()->cap);
+	release();
+	p_ = pn;
+	return true;
+}
+
 }  // namespace reindexer
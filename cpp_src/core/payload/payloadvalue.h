@@ -6,16 +6,20 @@
 
 namespace reindexer {
 
+class PayloadArena;
+
 // The full item's payload object. It must be speed & size optimized
 class PayloadValue {
 public:
 	typedef std::atomic<int32_t> refcounter;
 	struct dataHeader {
-		dataHeader() : refcount(1), cap(0), lsn(-1) {}
+		dataHeader() : refcount(1), cap(0), inArena(0), lsn(-1) {}
 
 		~dataHeader() { assert(refcount.load() == 0); }
 		refcounter refcount;
-		unsigned cap;
+		unsigned cap : 31;
+		// Data is allocated by PayloadArena
+		unsigned inArena : 1;
 		int64_t lsn;
 	};
 
@@ -23,6 +27,8 @@ public:
 	PayloadValue(const PayloadValue &);
 	// Alloc payload store with size, and copy data from another array
 	PayloadValue(size_t size, const uint8_t *ptr = nullptr, size_t cap = 0);
+	// Alloc zeroed payload store with size in arena
+	PayloadValue(size_t size, PayloadArena &arena);
 	~PayloadValue();
 	PayloadValue &operator=(const PayloadValue &other) {
 		if (&other != this) {
@@ -43,10 +49,12 @@ public:
 		return *this;
 	}
 
-	// Clone if data is shared for copy-on-write.
+	// Clone if data is shared for copy-on-write. Data allocated in arena is cloned to the same arena
 	void Clone(size_t size = 0);
 	// Resize
 	void Resize(size_t oldSize, size_t newSize);
+	// Move exclusive data out of the evacuated slab of arena. Returns true, if data was moved
+	bool Compact(PayloadArena &arena);
 	// Get data pointer
 	uint8_t *Ptr() const { return p_ + sizeof(dataHeader); }
 	void SetLSN(int64_t lsn) { header()->lsn = lsn; }
@@ -57,8 +65,9 @@ public:
 	const uint8_t *get() const { return p_; }
 
 protected:
-	uint8_t *alloc(size_t cap);
+	uint8_t *alloc(size_t cap, PayloadArena *arena);
 	void release();
+	PayloadArena *arena() const;
 
 	dataHeader *header() { return reinterpret_cast<dataHeader *>(p_); }
 	const dataHeader *header() const { return reinterpret_cast<dataHeader *>(p_); }
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <functional>
+#include "core/lrucache.h"
+#include "core/query/preparedquery.h"
+
+namespace reindexer {
+
+struct PreparedQueryCacheKey {
+	PreparedQueryCacheKey() = default;
+	PreparedQueryCacheKey(string_view s) : sql(s.data(), s.size()) {}
+	size_t Size() const { return sizeof(PreparedQueryCacheKey) + sql.size(); }
+
+	string sql;
+};
+
+struct PreparedQueryCacheVal {
+	PreparedQueryCacheVal() = default;
+	PreparedQueryCacheVal(const PreparedQuery::Ptr &q) : query(q) {}
+	size_t Size() const { return query ? sizeof(PreparedQuery) : 0; }
+
+	PreparedQuery::Ptr query;
+};
+
+struct EqPreparedQueryCacheKey {
+	bool operator()(const PreparedQueryCacheKey &lhs, const PreparedQueryCacheKey &rhs) const { return lhs.sql == rhs.sql; }
+};
+
+struct HashPreparedQueryCacheKey {
+	size_t operator()(const PreparedQueryCacheKey &k) const { return std::hash<string>()(k.sql); }
+};
+
+// Prepared queries by their sql templates. Template is cached on the first request, and least recently used ones are evicted on overflow
+class PreparedQueryCache
+	: public LRUCache<PreparedQueryCacheKey, PreparedQueryCacheVal, HashPreparedQueryCacheKey, EqPreparedQueryCacheKey> {
+public:
+	PreparedQueryCache(size_t sizeLimit) : LRUCache(sizeLimit, 1) {}
+};
+
+}  // namespace reindexer
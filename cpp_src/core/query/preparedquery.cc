@@ -0,0 +1,36 @@
+#include "preparedquery.h"
+
+namespace reindexer {
+
+PreparedQuery::Ptr PreparedQuery::FromSQL(string_view sql) {
+	std::shared_ptr<PreparedQuery> prepared(new PreparedQuery);
+	SQLParser(prepared->query_, &prepared->placeholders_).Parse(sql);
+	if (prepared->query_.type_ != QuerySelect) {
+		throw Error(errParams, "Only SELECT queries can be prepared");
+	}
+	return prepared;
+}
+
+PreparedQuery::Plan::Ptr PreparedQuery::GetPlan() const {
+	std::lock_guard<std::mutex> lck(mtx_);
+	return plan_;
+}
+
+void PreparedQuery::SetPlan(Plan::Ptr plan) const {
+	std::lock_guard<std::mutex> lck(mtx_);
+	plan_ = std::move(plan);
+}
+
+Query PreparedQuery::Bind(const Plan &plan, const VariantArray &args) const {
+	if (args.size() != placeholders_.size()) {
+		throw Error(errParams, "Prepared query expects %d values of placeholders, but %d values were passed", placeholders_.size(),
+					args.size());
+	}
+	Query q(plan.query);
+	for (size_t i = 0; i < placeholders_.size(); ++i) {
+		q.entries[placeholders_[i].entry].values[placeholders_[i].value] = args[i];
+	}
+	return q;
+}
+
+}  // namespace reindexer
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include "core/query/query.h"
+#include "core/query/sql/sqlparser.h"
+
+namespace reindexer {
+
+/// Query template with placeholders '?' in place of values of where conditions, e.g. "SELECT * FROM ns WHERE id = ? AND price > ?".
+/// Template is parsed once, and its plan is built once per version of namespace indexes. Plans of templates with different versions
+/// are never mixed, so the plan is invalidated by any change of indexes.
+/// *Thread safety*: PreparedQuery is immutable, except its plan, which is replaced atomically
+class PreparedQuery {
+public:
+	using Ptr = std::shared_ptr<const PreparedQuery>;
+
+	/// Plan of query for the specific version of namespace indexes
+	struct Plan {
+		using Ptr = std::shared_ptr<const Plan>;
+		Plan(const Query &q, QueryEntries &&e) : query(q), entries(std::move(e)) {}
+		/// Template query with where entries resolved to indexes of namespace
+		Query query;
+		/// Where entries after merge of conditions on the same index and substitution of composite indexes. Values of each entry are
+		/// positions of template entries, which values are merged into it on bind
+		QueryEntries entries;
+		/// Sort order, detected by conditions of query. It's used, if query has no explicit sort order
+		SortingEntries sortBy;
+		/// Query has full text conditions, so composite indexes are not substituted, and sort order is not detected
+		bool isFt = false;
+		/// Version of namespace indexes, which plan is built for
+		uint64_t indexesVersion = 0;
+	};
+
+	/// Parse sql query template. Only "SELECT" semantic is supported, and placeholders are allowed only in where conditions of main query
+	/// @param sql - SQL query template
+	/// @return prepared query
+	static Ptr FromSQL(string_view sql);
+
+	/// Get template query. Values of placeholders are null
+	const Query &GetQuery() const { return query_; }
+	/// Get count of placeholders in template
+	size_t PlaceholdersCount() const { return placeholders_.size(); }
+
+	/// Get current plan of query
+	/// @return plan, or nullptr if query was not planned yet
+	Plan::Ptr GetPlan() const;
+	/// Replace plan of query
+	void SetPlan(Plan::Ptr plan) const;
+
+	/// Bind values to placeholders of planned query
+	/// @param plan - Plan of query
+	/// @param args - Values of placeholders, in order of their appearance in template
+	/// @return Query with bound values
+	Query Bind(const Plan &plan, const VariantArray &args) const;
+
+private:
+	PreparedQuery() = default;
+
+	Query query_;
+	SQLPlaceholders placeholders_;
+	mutable std::mutex mtx_;
+	mutable Plan::Ptr plan_;
+};
+
+}  // namespace reindexer
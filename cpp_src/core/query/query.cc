@@ -158,6 +158,9 @@ void Query::deserialize(Serializer &ser, bool &hasJoinConditions) {
 			case QueryExplain:
 				explain_ = true;
 				break;
+			case QueryParallel:
+				parallel_ = true;
+				break;
 			case QuerySelectFunction:
 				selectFunctions_.push_back(string(ser.GetVString()));
 				break;
@@ -268,6 +271,10 @@ void Query::Serialize(WrSerializer &ser, uint8_t mode) const {
 		ser.PutVarUint(QueryExplain);
 	}
 
+	if (parallel_) {
+		ser.PutVarUint(QueryParallel);
+	}
+
 	for (const UpdateEntry &field : updateFields_) {
 		ser.PutVarUint(QueryUpdateField);
 		ser.PutVString(field.column);
@@ -66,6 +66,15 @@ public:
 		return *this;
 	}
 
+	/// Allow to execute query's select loop by several threads
+	/// Loop is parallelized only for big enough namespaces and queries without joins, distinct and fulltext
+	/// @param on - signaling on/off
+	/// @return Query object ready to be executed
+	Query &Parallel(bool on = true) {
+		parallel_ = on;
+		return *this;
+	}
+
 	/// Adds a condition with a single value. Analog to sql Where clause.
 	/// @param idx - index used in condition clause.
 	/// @param cond - type of condition.
@@ -361,6 +370,7 @@ public:
 	unsigned count = UINT_MAX;				/// Number of rows from result set.
 	int debugLevel = 0;						/// Debug level.
 	bool explain_ = false;					/// Explain query if true
+	bool parallel_ = false;					/// Allow parallel execution of select loop
 	CalcTotalMode calcTotal = ModeNoTotal;  /// Calculation mode.
 	QueryType type_ = QuerySelect;			/// Query type
 	OpType nextOp_ = OpAnd;					/// Next operation constant.
@@ -7,7 +7,7 @@
 
 namespace reindexer {
 
-SQLParser::SQLParser(Query &query) : query_(query) {}
+SQLParser::SQLParser(Query &query, SQLPlaceholders *placeholders) : query_(query), placeholders_(placeholders) {}
 
 int SQLParser::Parse(const string_view &q) {
 	tokenizer parser(q);
@@ -435,6 +435,15 @@ int SQLParser::truncateParse(tokenizer &parser) {
 	return 0;
 }
 
+Variant SQLParser::parseWhereValue(const token &tok, tokenizer &parser, const QueryEntry &entry) {
+	if (placeholders_ && tok.type == TokenSymbol && tok.text() == "?"_sv) {
+		// Entry is appended to query right after parsing of its values
+		placeholders_->push_back({query_.entries.Size(), entry.values.size()});
+		return Variant();
+	}
+	return token2kv(tok, parser);
+}
+
 int SQLParser::parseWhere(tokenizer &parser) {
 	token tok;
 	OpType nextOp = OpAnd;
@@ -516,14 +525,14 @@ int SQLParser::parseWhere(tokenizer &parser) {
 					for (;;) {
 						tok = parser.next_token();
 						if (tok.text() == ")"_sv && tok.type == TokenSymbol) break;
-						entry.values.push_back(token2kv(tok, parser));
+						entry.values.push_back(parseWhereValue(tok, parser, entry));
 						tok = parser.next_token();
 						if (tok.text() == ")"_sv) break;
 						if (tok.text() != ","_sv)
 							throw Error(errParseSQL, "Expected ')' or ',', but found '%s' in query, %s", tok.text(), parser.where());
 					}
 				} else {
-					entry.values.push_back(token2kv(tok, parser));
+					entry.values.push_back(parseWhereValue(tok, parser, entry));
 				}
 				query_.entries.Append(nextOp, std::move(entry));
 				nextOp = OpAnd;
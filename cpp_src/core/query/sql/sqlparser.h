@@ -10,11 +10,24 @@ namespace reindexer {
 
 class Query;
 class JoinedQuery;
+struct QueryEntry;
 struct SortingEntries;
 struct UpdateEntry;
+
+/// Placeholder '?' of value in sql query template
+struct SQLPlaceholder {
+	/// Position of where entry in query entries
+	size_t entry;
+	/// Position of value in entry
+	size_t value;
+};
+using SQLPlaceholders = h_vector<SQLPlaceholder, 4>;
+
 class SQLParser {
 public:
-	explicit SQLParser(Query &q);
+	/// @param q - Query to initialize
+	/// @param placeholders - Output placeholders of values of where entries. If nullptr, then placeholders are not allowed in query
+	explicit SQLParser(Query &q, SQLPlaceholders *placeholders = nullptr);
 
 	/// Parses pure sql select query and initializes Query object data members as a result.
 	/// @param q - sql query.
@@ -83,6 +96,9 @@ protected:
 	/// Parse where entries
 	int parseWhere(tokenizer &parser);
 
+	/// Parse value of where entry, or placeholder of value
+	Variant parseWhereValue(const token &tok, tokenizer &parser, const QueryEntry &entry);
+
 	/// Parse order by
 	int parseOrderBy(tokenizer &parser, SortingEntries &, h_vector<Variant, 0> &forcedSortOrder);
 
@@ -104,6 +120,7 @@ protected:
 	static CondType getCondType(string_view cond);
 	SqlParsingCtx ctx_;
 	Query &query_;
+	SQLPlaceholders *placeholders_;
 };
 
 }  // namespace reindexer
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <bitset>
 #include "core/lrucache.h"
+#include "core/payload/fieldsset.h"
 #include "core/query/query.h"
+#include "core/queryresults/aggregationresult.h"
 #include "estl/h_vector.h"
 #include "tools/serializer.h"
 #include "vendor/murmurhash/MurmurHash3.h"
@@ -59,4 +64,74 @@ struct QueryCache : LRUCache<QueryCacheKey, QueryCacheVal, HashQueryCacheKey, Eq
 	QueryCache(size_t sizeLimit = kDefaultCacheSizeLimit, int hitCount = kDefaultHitCountToCache) : LRUCache(sizeLimit, hitCount) {}
 };
 
+/// Mask of indexes by their numbers
+using IndexesMask = std::bitset<maxIndexes>;
+
+/// Generations of namespace data changes.
+/// Insert and delete of items invalidate all the query results, and update of existing items invalidates only results of queries,
+/// which depend on the changed indexes. Values of non indexed fields are tracked as values of tuple index
+struct DataGenerations {
+	void ItemsChanged() { items = ++current; }
+	void IndexesChanged(const IndexesMask &changed) {
+		++current;
+		for (size_t i = 0; i < indexes.size(); ++i) {
+			if (changed.test(i)) indexes[i] = current;
+		}
+	}
+	bool IsActual(uint64_t generation, const IndexesMask &deps) const {
+		if (items > generation) return false;
+		for (size_t i = 0; i < indexes.size(); ++i) {
+			if (deps.test(i) && indexes[i] > generation) return false;
+		}
+		return true;
+	}
+
+	/// Generation of the last change
+	uint64_t current = 0;
+	/// Generation of the last insert or delete of items, or change of namespace structure
+	uint64_t items = 0;
+	/// Generations of the last changes of index values by update of existing items
+	std::array<uint64_t, maxIndexes> indexes = {};
+};
+
+struct QueryResultsCacheVal {
+	struct Data {
+		/// Row ids of items in order of query results
+		std::vector<IdType> ids;
+		std::vector<AggregationResult> aggregationResults;
+		int totalCount = 0;
+		/// Generation of namespace data, results were selected from
+		uint64_t generation = 0;
+		/// Indexes, which results depend on
+		IndexesMask deps;
+	};
+
+	size_t Size() const {
+		return data ? sizeof(Data) + data->ids.capacity() * sizeof(IdType) + data->aggregationResults.capacity() * sizeof(AggregationResult)
+					: 0;
+	}
+
+	std::shared_ptr<const Data> data;
+};
+
+/// Cache of query results: row ids of selected items, aggregation results and total count.
+/// Entries are not cleared on namespace update, but are checked by data generations on lookup
+struct QueryResultsCache : LRUCache<QueryCacheKey, QueryResultsCacheVal, HashQueryCacheKey, EqQueryCacheKey> {
+	QueryResultsCache(size_t sizeLimit, int hitCount = kDefaultHitCountToCache) : LRUCache(sizeLimit, hitCount) {}
+
+	/// Count lookup, which has found outdated results
+	void MarkOutdated() { outdatedCount_.fetch_add(1, std::memory_order_relaxed); }
+	/// Get memory stats. Lookups of outdated results are counted as misses
+	LRUCacheMemStat GetMemStat() {
+		LRUCacheMemStat stat = LRUCache::GetMemStat();
+		const uint64_t outdated = std::min<uint64_t>(outdatedCount_.load(std::memory_order_relaxed), stat.hitsCount);
+		stat.hitsCount -= outdated;
+		stat.missesCount += outdated;
+		return stat;
+	}
+
+private:
+	std::atomic<uint64_t> outdatedCount_{0};
+};
+
 }  // namespace reindexer
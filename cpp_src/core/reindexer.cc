@@ -28,6 +28,10 @@ Error Reindexer::Insert(string_view nsName, Item& item) { return impl_->Insert(n
 Error Reindexer::Update(string_view nsName, Item& item) { return impl_->Update(nsName, item, ctx_); }
 Error Reindexer::Upsert(string_view nsName, Item& item) { return impl_->Upsert(nsName, item, ctx_); }
 Error Reindexer::Delete(string_view nsName, Item& item) { return impl_->Delete(nsName, item, ctx_); }
+Error Reindexer::ModifyItems(string_view nsName, std::vector<Item>& items, const std::vector<ItemModifyMode>& modes,
+							 std::vector<Error>& statuses) {
+	return impl_->ModifyItems(nsName, items, modes, statuses, ctx_);
+}
 Item Reindexer::NewItem(string_view nsName) { return impl_->NewItem(nsName, ctx_); }
 Transaction Reindexer::NewTransaction(string_view nsName) { return impl_->NewTransaction(nsName, ctx_); }
 Error Reindexer::CommitTransaction(Transaction& tr) { return impl_->CommitTransaction(tr, ctx_); }
@@ -38,8 +42,13 @@ Error Reindexer::EnumMeta(string_view nsName, vector<string>& keys) { return imp
 Error Reindexer::Delete(const Query& q, QueryResults& result) { return impl_->Delete(q, result, ctx_); }
 Error Reindexer::Select(string_view query, QueryResults& result) { return impl_->Select(query, result, ctx_); }
 Error Reindexer::Select(const Query& q, QueryResults& result) { return impl_->Select(q, result, ctx_); }
+Error Reindexer::Prepare(string_view query, PreparedQuery::Ptr& prepared) { return impl_->Prepare(query, prepared, ctx_); }
+Error Reindexer::Select(const PreparedQuery& prepared, const VariantArray& args, QueryResults& result) {
+	return impl_->Select(prepared, args, result, ctx_);
+}
 Error Reindexer::Update(const Query& query, QueryResults& result) { return impl_->Update(query, result, ctx_); }
 Error Reindexer::Commit(string_view nsName) { return impl_->Commit(nsName); }
+Error Reindexer::WaitDurable(string_view nsName, int64_t lsn) { return impl_->WaitDurable(nsName, lsn, ctx_); }
 Error Reindexer::AddIndex(string_view nsName, const IndexDef& idx) { return impl_->AddIndex(nsName, idx, ctx_); }
 Error Reindexer::UpdateIndex(string_view nsName, const IndexDef& idx) { return impl_->UpdateIndex(nsName, idx, ctx_); }
 Error Reindexer::DropIndex(string_view nsName, const IndexDef& index) { return impl_->DropIndex(nsName, index, ctx_); }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/namespacedef.h"
+#include "core/query/preparedquery.h"
 #include "core/query/query.h"
 #include "core/queryresults/queryresults.h"
 #include "core/rdxcontext.h"
@@ -112,6 +113,13 @@ public:
 	/// @param nsName - Name of namespace
 	/// @param item - Item, obtained by call to NewItem of the same namespace
 	Error Delete(string_view nsName, Item &item);
+	/// Insert, update, upsert or delete several items of namespace under the single lock acquisition
+	/// May be used with completion
+	/// @param nsName - Name of namespace
+	/// @param items - Items, obtained by call to NewItem of the same namespace
+	/// @param modes - Modification mode of each item
+	/// @param statuses - Result of each item modification. Returned error is set only if whole batch is failed
+	Error ModifyItems(string_view nsName, std::vector<Item> &items, const std::vector<ItemModifyMode> &modes, std::vector<Error> &statuses);
 	/// Delete all items froms namespace, which matches provided Query
 	/// @param query - Query with conditions
 	/// @param result - QueryResults with IDs of deleted items
@@ -126,10 +134,28 @@ public:
 	/// @param query - Query object with query attributes
 	/// @param result - QueryResults with found items
 	Error Select(const Query &query, QueryResults &result);
+	/// Prepare SQL query template with placeholders '?' in place of values of WHERE conditions
+	/// Template is parsed once, and its plan is reused until indexes of namespace are changed. Prepared queries are cached by templates
+	/// May be used with completion
+	/// @param query - SQL query template. Only "SELECT" semantic is supported
+	/// @param prepared - Prepared query. It can be executed many times with different values of placeholders
+	Error Prepare(string_view query, PreparedQuery::Ptr &prepared);
+	/// Execute prepared query and return results
+	/// May be used with completion
+	/// @param prepared - Prepared query
+	/// @param args - Values of placeholders, in order of their appearance in template
+	/// @param result - QueryResults with found items
+	Error Select(const PreparedQuery &prepared, const VariantArray &args, QueryResults &result);
 	/// Flush changes to storage
 	/// Cancelation context doesn't affect this call
 	/// @param nsName - Name of namespace
 	Error Commit(string_view nsName);
+	/// Wait until changes of namespace are durably written to storage (synced to disk)
+	/// Concurrent calls share the same synced write. Cancelation context doesn't affect waiting for write
+	/// @param nsName - Name of namespace
+	/// @param lsn - LSN of the last change to wait for (e.g. item.GetLSN() after modification). If lsn < 0, waits for all the changes,
+	/// made before the call
+	Error WaitDurable(string_view nsName, int64_t lsn = -1);
 	/// Allocate new item for namespace
 	/// @param nsName - Name of namespace
 	/// @return Item ready for filling and futher Upsert/Insert/Delete/Update call
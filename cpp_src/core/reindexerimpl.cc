@@ -28,11 +28,28 @@ constexpr char kMemStatsNamespace[] = "#memstats";
 constexpr char kNamespacesNamespace[] = "#namespaces";
 constexpr char kConfigNamespace[] = "#config";
 constexpr char kActivityStatsNamespace[] = "#activitystats";
+constexpr char kReplicationStatsNamespace[] = "#replicationstats";
 constexpr char kStoragePlaceholderFilename[] = ".reindexer.storage";
 constexpr char kReplicationConfFilename[] = "replication.conf";
 
+// Maximum count of right namespace items to build hash table of hash join
+constexpr size_t kMaxHashJoinItems = 100000;
+// Approximate ratio between cost of right namespace select for one left item, and cost of putting one item to hash table
+constexpr size_t kHashJoinBuildCostRatio = 32;
+// Size limit of prepared queries cache
+constexpr size_t kPreparedQueriesCacheSizeLimit = 4 * 1024 * 1024;
+// Maximum count of workers of background maintenance of namespaces
+constexpr unsigned kMaxMaintenanceWorkers = 8;
+
+static unsigned maintenanceWorkersCount() { return std::max(2u, std::min(std::thread::hardware_concurrency(), kMaxMaintenanceWorkers)); }
+
 ReindexerImpl::ReindexerImpl()
-	: replicator_(new Replicator(this)), hasReplConfigLoadError_(false), storageType_(StorageType::LevelDB), autorepairEnabled_(false) {
+	: maintenance_(maintenanceWorkersCount()),
+	  replicator_(new Replicator(this)),
+	  hasReplConfigLoadError_(false),
+	  preparedQueries_(kPreparedQueriesCacheSizeLimit),
+	  storageType_(StorageType::LevelDB),
+	  autorepairEnabled_(false) {
 	stopBackgroundThread_ = false;
 	configProvider_.setHandler(ProfilingConf, std::bind(&ReindexerImpl::onProfiligConfigLoad, this));
 	backgroundThread_ = std::thread([this]() { this->backgroundRoutine(); });
@@ -41,6 +58,16 @@ ReindexerImpl::ReindexerImpl()
 ReindexerImpl::~ReindexerImpl() {
 	stopBackgroundThread_ = true;
 	backgroundThread_.join();
+	maintenance_.Stop();
+	// Flush updates, which were made after the last run of flush tasks
+	static const RdxContext dummyCtx;
+	for (auto &nspair : getNamespaces(dummyCtx)) {
+		try {
+			nspair.second->BackgroundFlush(dummyCtx);
+		} catch (const Error &err) {
+			logPrintf(LogWarning, "Flush of namespace '%s' failed: %s", nspair.first, err.what());
+		}
+	}
 	replicator_->Stop();
 }
 
@@ -304,6 +331,7 @@ Error ReindexerImpl::closeNamespace(string_view nsName, const RdxContext& ctx, b
 		ns.reset();
 		return err;
 	}
+	maintenance_.Remove(ns.get());
 	// Here will called destructor
 	ns.reset();
 	return errOK;
@@ -432,6 +460,25 @@ Error ReindexerImpl::Upsert(string_view nsName, Item& item, const InternalRdxCon
 	return err;
 }
 
+Error ReindexerImpl::ModifyItems(string_view nsName, std::vector<Item>& items, const std::vector<ItemModifyMode>& modes,
+								 std::vector<Error>& statuses, const InternalRdxContext& ctx) {
+	Error err;
+	try {
+		WrSerializer ser;
+		const auto rdxCtx = ctx.CreateRdxContext(
+			ctx.NeedTraceActivity() ? (ser << "MODIFY " << items.size() << " ITEMS OF " << nsName).Slice() : ""_sv, activities_);
+		auto ns = getNamespace(nsName, rdxCtx);
+		ns->ModifyBulk(items, modes, statuses, rdxCtx);
+		for (size_t i = 0; i < items.size(); ++i) {
+			if (statuses[i].ok() && modes[i] != ModeDelete) updateToSystemNamespace(nsName, items[i], rdxCtx);
+		}
+	} catch (const Error& e) {
+		err = e;
+	}
+	if (ctx.Compl()) ctx.Compl()(err);
+	return err;
+}
+
 Item ReindexerImpl::NewItem(string_view nsName, const InternalRdxContext& ctx) {
 	try {
 		WrSerializer ser;
@@ -584,7 +631,45 @@ struct ItemRefLess {
 	}
 };
 
-Error ReindexerImpl::Select(const Query& q, QueryResults& result, const InternalRdxContext& ctx) {
+Error ReindexerImpl::Select(const Query& q, QueryResults& result, const InternalRdxContext& ctx) { return select(q, result, nullptr, ctx); }
+
+Error ReindexerImpl::Prepare(string_view query, PreparedQuery::Ptr& prepared, const InternalRdxContext& ctx) {
+	Error err = errOK;
+	try {
+		PreparedQueryCacheKey key(query);
+		auto cached = preparedQueries_.Get(key);
+		if (cached.valid && cached.val.query) {
+			prepared = cached.val.query;
+		} else {
+			prepared = PreparedQuery::FromSQL(query);
+			// Prepared queries are shared, so evicted ones stay valid for their holders
+			if (cached.valid) preparedQueries_.Put(key, prepared);
+		}
+	} catch (const Error& e) {
+		err = e;
+	}
+	if (ctx.Compl()) ctx.Compl()(err);
+	return err;
+}
+
+Error ReindexerImpl::Select(const PreparedQuery& prepared, const VariantArray& args, QueryResults& result, const InternalRdxContext& ctx) {
+	try {
+		const auto rdxCtx = ctx.CreateRdxContext(""_sv, activities_);
+		PreparedQuery::Plan::Ptr plan = prepared.GetPlan();
+		auto ns = getNamespace(prepared.GetQuery()._namespace, rdxCtx);
+		if (!plan || plan->indexesVersion != ns->IndexesVersion()) {
+			plan = ns->BuildQueryPlan(prepared.GetQuery(), rdxCtx);
+			prepared.SetPlan(plan);
+		}
+		const Query q = prepared.Bind(*plan, args);
+		return select(q, result, plan.get(), ctx);
+	} catch (const Error& err) {
+		if (ctx.Compl()) ctx.Compl()(err);
+		return err;
+	}
+}
+
+Error ReindexerImpl::select(const Query& q, QueryResults& result, const PreparedQuery::Plan* plan, const InternalRdxContext& ctx) {
 	try {
 		WrSerializer ser;
 		const auto rdxCtx = ctx.CreateRdxContext(ctx.NeedTraceActivity() ? q.GetSQL(ser).Slice() : "", activities_, result);
@@ -627,7 +712,7 @@ Error ReindexerImpl::Select(const Query& q, QueryResults& result, const Internal
 			result.joined_.resize(1 + q.mergeQueries_.size());
 		}
 
-		doSelect(q, result, locks, func, rdxCtx);
+		doSelect(q, result, locks, func, rdxCtx, plan);
 		func.Process(result);
 	} catch (const Error& err) {
 		if (ctx.Compl()) ctx.Compl()(err);
@@ -696,15 +781,43 @@ JoinedSelectors ReindexerImpl::prepareJoinedSelectors(const Query& q, QueryResul
 			jItemQ.entries.Append(je.op_, std::move(qe));
 		}
 
+		// Choose join strategy by cardinality of both sides: hash table is built once for all the right items,
+		// and nested loop selects right items for each left item
+		JoinStrategy strategy = JoinStrategy::NestedLoop;
+		size_t hashBuildThreshold = 0;
+		if (JoinedSelector::IsEqualityJoin(jItemQ, *jns)) {
+			size_t rightCount = jns->GetItemsCount();
+			if (preResult->mode == JoinPreResult::ModeIdSet) {
+				rightCount = preResult->ids.size();
+			} else if (preResult->mode == JoinPreResult::ModeIterators) {
+				rightCount = std::min<size_t>(rightCount, preResult->iterators.GetMaxIterations());
+			}
+			// Count of left items, which are joined, is known only during select, since it depends on the left query conditions.
+			// So it is just limited here, and hash table is built lazily, after count of probes, which pays off its building
+			size_t leftCount = ns->GetItemsCount();
+			if (jq.joinType == JoinType::LeftJoin && q.count != UINT_MAX) {
+				// Left join is processed for the result items only
+				leftCount = std::min<size_t>(leftCount, size_t(q.start) + q.count);
+			}
+			if (jItemQ.sortingEntries_.empty() && rightCount <= kMaxHashJoinItems && rightCount <= leftCount * kHashJoinBuildCostRatio) {
+				strategy = JoinStrategy::Hash;
+				hashBuildThreshold = rightCount / kHashJoinBuildCostRatio;
+			} else if (jq.joinType == JoinType::LeftJoin) {
+				// Left join is processed after select of left items, so it can select right items for the batch of them
+				strategy = JoinStrategy::Batched;
+			}
+		}
+
 		joinedSelectors.push_back({jq.joinType, ns, std::move(jns), std::move(joinRes), std::move(jItemQ), result, jq, preResult,
-								   joinedFieldIdx, func, joinedSelectorsCount, rdxCtx});
+								   joinedFieldIdx, func, joinedSelectorsCount, rdxCtx, strategy, hashBuildThreshold});
 		ThrowOnCancel(rdxCtx);
 	}
 	return joinedSelectors;
 }
 
 template <typename T>
-void ReindexerImpl::doSelect(const Query& q, QueryResults& result, NsLocker<T>& locks, SelectFunctionsHolder& func, const RdxContext& ctx) {
+void ReindexerImpl::doSelect(const Query& q, QueryResults& result, NsLocker<T>& locks, SelectFunctionsHolder& func, const RdxContext& ctx,
+							 const PreparedQuery::Plan* plan) {
 	auto ns = locks.Get(q._namespace);
 	if (!ns) {
 		throw Error(errParams, "Namespace '%s' is not exists", q._namespace);
@@ -713,6 +826,7 @@ void ReindexerImpl::doSelect(const Query& q, QueryResults& result, NsLocker<T>&
 		JoinedSelectors joinedSelectors = prepareJoinedSelectors(q, result, locks, func, ctx);
 		SelectCtx selCtx(q);
 		selCtx.joinedSelectors = joinedSelectors.size() ? &joinedSelectors : nullptr;
+		selCtx.plan = plan;
 		selCtx.contextCollectingMode = true;
 		selCtx.functions = &func;
 		selCtx.nsid = 0;
@@ -776,7 +890,8 @@ void ReindexerImpl::doSelect(const Query& q, QueryResults& result, NsLocker<T>&
 	result.lockResults();
 }
 
-template void ReindexerImpl::doSelect(const Query&, QueryResults&, NsLocker<RdxContext>&, SelectFunctionsHolder&, const RdxContext&);
+template void ReindexerImpl::doSelect(const Query&, QueryResults&, NsLocker<RdxContext>&, SelectFunctionsHolder&, const RdxContext&,
+									 const PreparedQuery::Plan*);
 
 Error ReindexerImpl::Commit(string_view /*_namespace*/) {
 	try {
@@ -789,6 +904,17 @@ Error ReindexerImpl::Commit(string_view /*_namespace*/) {
 	return errOK;
 }
 
+Error ReindexerImpl::WaitDurable(string_view nsName, int64_t lsn, const InternalRdxContext& ctx) {
+	try {
+		WrSerializer ser;
+		const auto rdxCtx = ctx.CreateRdxContext(ctx.NeedTraceActivity() ? (ser << "WAIT DURABLE " << nsName).Slice() : ""_sv, activities_);
+		getNamespace(nsName, rdxCtx)->WaitDurable(lsn, rdxCtx);
+	} catch (const Error& err) {
+		return err;
+	}
+	return errOK;
+}
+
 Namespace::Ptr ReindexerImpl::getNamespace(string_view nsName, const RdxContext& ctx) {
 	SLock lock(mtx_, &ctx);
 	auto nsIt = namespaces_.find(nsName);
@@ -904,19 +1030,21 @@ Error ReindexerImpl::EnumNamespaces(vector<NamespaceDef>& defs, bool bEnumAll, c
 
 void ReindexerImpl::backgroundRoutine() {
 	static const RdxContext dummyCtx;
-	auto nsFlush = [&]() {
-		auto nsarray = getNamespacesNames(dummyCtx);
-		for (auto name : nsarray) {
-			try {
-				auto ns = getNamespace(name, dummyCtx);
-				ns->tryToReload(dummyCtx);
-				ns->BackgroundRoutine(nullptr);
-			} catch (Error err) {
-				logPrintf(LogWarning, "flusherThread() failed: %s", err.what());
-			} catch (...) {
-				logPrintf(LogWarning, "flusherThread() failed with ns: %s", name);
-			}
+	auto scheduleMaintenance = [&]() {
+		// Namespaces are maintained by workers of scheduler. Tasks of each namespace are added once and are rescheduled by themselves,
+		// while namespace exists
+		auto nsarray = getNamespaces(dummyCtx);
+		std::vector<const void *> owners;
+		owners.reserve(nsarray.size());
+		for (auto &nspair : nsarray) {
+			Namespace::Ptr ns = nspair.second;
+			owners.push_back(ns.get());
+			maintenance_.Add(ns.get(), MaintenanceFlush, [ns]() { return ns->BackgroundFlush(dummyCtx); });
+			maintenance_.Add(ns.get(), MaintenanceExpireItems, [ns]() { return ns->BackgroundExpireItems(dummyCtx); });
+			maintenance_.Add(ns.get(), MaintenanceOptimize, [this, ns]() { return ns->BackgroundOptimize(maintenance_, dummyCtx); });
 		}
+		maintenance_.RemoveExcept(owners);
+
 		std::string yamlReplConf;
 		bool replConfigWasModified = replConfigFileChecker_.ReadIfFileWasModified(yamlReplConf);
 		if (replConfigWasModified) {
@@ -930,11 +1058,9 @@ void ReindexerImpl::backgroundRoutine() {
 	};
 
 	while (!stopBackgroundThread_) {
-		nsFlush();
+		scheduleMaintenance();
 		std::this_thread::sleep_for(std::chrono::milliseconds(100));
 	}
-
-	nsFlush();
 }
 
 void ReindexerImpl::createSystemNamespaces() {
@@ -960,6 +1086,13 @@ void ReindexerImpl::createSystemNamespaces() {
 					 .AddIndex("blocked", "-", "bool", IndexOpts().Dense())
 					 .AddIndex("description", "-", "string", IndexOpts().Sparse()));
 
+	AddNamespace(NamespaceDef(kReplicationStatsNamespace, StorageOpts())
+					 .AddIndex("name", "hash", "string", IndexOpts().PK())
+					 .AddIndex("sync_type", "-", "string", IndexOpts().Dense())
+					 .AddIndex("in_progress", "-", "bool", IndexOpts().Dense())
+					 .AddIndex("items_total", "-", "int64", IndexOpts().Dense())
+					 .AddIndex("items_synced", "-", "int64", IndexOpts().Dense()));
+
 	AddNamespace(NamespaceDef(kQueriesPerfStatsNamespace, StorageOpts())
 					 .AddIndex("query", "hash", "string", IndexOpts().PK())
 					 .AddIndex("total_queries_count", "-", "int64", IndexOpts().Dense())
@@ -1017,6 +1150,7 @@ std::vector<string> defDBConfig = {
 			"cluster_id":2,
 			"force_sync_on_logic_error": false,
 			"force_sync_on_wrong_data_hash": false,
+			"snapshot_chunk_size": 0,
 			"namespaces":[]
 		}
     })json",
@@ -1150,7 +1284,10 @@ void ReindexerImpl::updateToSystemNamespace(string_view nsName, Item& item, cons
 	} else if (nsName == kQueriesPerfStatsNamespace) {
 		queriesStatTracker_.Reset();
 	} else if (nsName == kPerfStatsNamespace) {
-		for (auto& ns : getNamespaces(ctx)) ns.second->ResetPerfStat(ctx);
+		for (auto& ns : getNamespaces(ctx)) {
+			ns.second->ResetPerfStat(ctx);
+			maintenance_.ResetStat(ns.second.get());
+		}
 	}
 }
 
@@ -1212,6 +1349,7 @@ void ReindexerImpl::syncSystemNamespaces(string_view name, const RdxContext& ctx
 	if (profilingCfg.perfStats && (name.empty() || name == kPerfStatsNamespace)) {
 		forEachNS(getNamespace(kPerfStatsNamespace, ctx), false, [&](std::pair<string, Namespace::Ptr>& nspair) {
 			auto stats = nspair.second->GetPerfStat(ctx);
+			stats.maintenance = maintenance_.GetStat(nspair.second.get());
 			bool notRenamed = (stats.name == nspair.first);
 			if (notRenamed) stats.GetJSON(ser);
 			return notRenamed;
@@ -1273,6 +1411,25 @@ void ReindexerImpl::syncSystemNamespaces(string_view name, const RdxContext& ctx
 			activityNs->Upsert(i, activityCtx, true, true);
 		}
 	}
+
+	if (name.empty() || name == kReplicationStatsNamespace) {
+		auto data = replicator_->GetSyncStats();
+		std::vector<Item> items;
+		items.reserve(data.size());
+		auto replicationNs = getNamespace(kReplicationStatsNamespace, ctx);
+		for (auto& stat : data) {
+			ser.Reset();
+			stat.GetJSON(ser);
+			items.push_back(replicationNs->NewItem(ctx));
+			auto err = items.back().FromJSON(ser.Slice());
+			if (!err.ok()) throw err;
+		}
+		const Namespace::WLock lock(replicationNs->mtx_, &ctx);
+		replicationNs->Truncate(ctx, -1, true);
+		for (Item& i : items) {
+			replicationNs->Upsert(i, activityCtx, true, true);
+		}
+	}
 }
 
 void ReindexerImpl::onProfiligConfigLoad() {
@@ -5,8 +5,10 @@
 #include <string>
 #include <thread>
 
+#include "core/maintenancescheduler.h"
 #include "core/namespace.h"
 #include "core/nsselecter/nsselecter.h"
+#include "core/preparedquerycache.h"
 #include "core/rdxcontext.h"
 #include "dbconfig.h"
 #include "estl/fast_hash_map.h"
@@ -53,10 +55,16 @@ public:
 	Error Update(const Query &query, QueryResults &result, const InternalRdxContext &ctx = InternalRdxContext());
 	Error Upsert(string_view nsName, Item &item, const InternalRdxContext &ctx = InternalRdxContext());
 	Error Delete(string_view nsName, Item &item, const InternalRdxContext &ctx = InternalRdxContext());
+	Error ModifyItems(string_view nsName, std::vector<Item> &items, const std::vector<ItemModifyMode> &modes, std::vector<Error> &statuses,
+					  const InternalRdxContext &ctx = InternalRdxContext());
 	Error Delete(const Query &query, QueryResults &result, const InternalRdxContext &ctx = InternalRdxContext());
 	Error Select(string_view query, QueryResults &result, const InternalRdxContext &ctx = InternalRdxContext());
 	Error Select(const Query &query, QueryResults &result, const InternalRdxContext &ctx = InternalRdxContext());
+	Error Prepare(string_view query, PreparedQuery::Ptr &prepared, const InternalRdxContext &ctx = InternalRdxContext());
+	Error Select(const PreparedQuery &prepared, const VariantArray &args, QueryResults &result,
+				 const InternalRdxContext &ctx = InternalRdxContext());
 	Error Commit(string_view nsName);
+	Error WaitDurable(string_view nsName, int64_t lsn, const InternalRdxContext &ctx = InternalRdxContext());
 	Item NewItem(string_view nsName, const InternalRdxContext &ctx = InternalRdxContext());
 
 	Transaction NewTransaction(string_view nsName, const InternalRdxContext &ctx = InternalRdxContext());
@@ -117,8 +125,10 @@ protected:
 		bool locked_ = false;
 		const Context &context_;
 	};
+	Error select(const Query &q, QueryResults &result, const PreparedQuery::Plan *plan, const InternalRdxContext &ctx);
 	template <typename T>
-	void doSelect(const Query &q, QueryResults &result, NsLocker<T> &locks, SelectFunctionsHolder &func, const RdxContext &ctx);
+	void doSelect(const Query &q, QueryResults &result, NsLocker<T> &locks, SelectFunctionsHolder &func, const RdxContext &ctx,
+				  const PreparedQuery::Plan *plan = nullptr);
 	template <typename T>
 	JoinedSelectors prepareJoinedSelectors(const Query &q, QueryResults &result, NsLocker<T> &locks, SelectFunctionsHolder &func,
 										   const RdxContext &ctx);
@@ -147,8 +157,10 @@ protected:
 	Mutex mtx_;
 	string storagePath_;
 
+	// Background thread adds maintenance tasks of new namespaces to scheduler, and watches replication config file
 	std::thread backgroundThread_;
 	std::atomic<bool> stopBackgroundThread_;
+	MaintenanceScheduler maintenance_;
 
 	QueriesStatTracer queriesStatTracker_;
 	UpdatesObservers observers_;
@@ -159,6 +171,8 @@ protected:
 
 	ActivityContainer activities_;
 
+	PreparedQueryCache preparedQueries_;
+
 	StorageMutex storageMtx_;
 	StorageType storageType_;
 	bool autorepairEnabled_;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <climits>
 #include <memory>
 
@@ -26,7 +27,13 @@ public:
 	}
 	template <typename KeyEntryT>
 	explicit SingleSelectKeyResult(const KeyEntryT &ids, SortType sortId) {
-		if (ids.Unsorted().IsCommited()) {
+		if (ids.Unsorted().Bitmap() && !sortId) {
+			bitmap_ = ids.Unsorted().Bitmap();
+			useBitmap_ = true;
+		} else if (const base_idsetset *sorted = ids.Unsorted().SortedBTree(sortId)) {
+			set_ = sorted;
+			useBtree_ = true;
+		} else if (ids.Unsorted().IsCommited()) {
 			ids_ = ids.Sorted(sortId);
 		} else {
 			assert(ids.Unsorted().BTree());
@@ -35,17 +42,22 @@ public:
 			useBtree_ = true;
 		}
 	}
-	explicit SingleSelectKeyResult(IdSet::Ptr ids) : tempIds_(ids), ids_(*ids) {}
+	explicit SingleSelectKeyResult(IdSet::Ptr ids)
+		: tempIds_(ids), ids_(ids->Bitmap() ? IdSetRef() : ids->Sorted(0)), bitmap_(ids->Bitmap()), useBitmap_(bitmap_) {}
 	explicit SingleSelectKeyResult(const IdSetRef &ids) : ids_(ids) {}
 	explicit SingleSelectKeyResult(IdType rBegin, IdType rEnd) : rBegin_(rBegin), rEnd_(rEnd), isRange_(true) {}
 	SingleSelectKeyResult(const SingleSelectKeyResult &other)
 		: tempIds_(other.tempIds_),
 		  ids_(other.ids_),
 		  set_(other.set_),
+		  bitmap_(other.bitmap_),
+		  bitmapVal_(other.bitmapVal_),
+		  bitmapHint_(other.bitmapHint_),
 		  indexForwardIter_(other.indexForwardIter_),
 		  bsearch_(other.bsearch_),
 		  isRange_(other.isRange_),
-		  useBtree_(other.useBtree_) {
+		  useBtree_(other.useBtree_),
+		  useBitmap_(other.useBitmap_) {
 		if (isRange_) {
 			rBegin_ = other.rBegin_;
 			rEnd_ = other.rEnd_;
@@ -70,10 +82,14 @@ public:
 			tempIds_ = other.tempIds_;
 			ids_ = other.ids_;
 			set_ = other.set_;
+			bitmap_ = other.bitmap_;
+			bitmapVal_ = other.bitmapVal_;
+			bitmapHint_ = other.bitmapHint_;
 			indexForwardIter_ = other.indexForwardIter_;
 			bsearch_ = other.bsearch_;
 			isRange_ = other.isRange_;
 			useBtree_ = other.useBtree_;
+			useBitmap_ = other.useBitmap_;
 			if (isRange_) {
 				rBegin_ = other.rBegin_;
 				rEnd_ = other.rEnd_;
@@ -96,11 +112,17 @@ public:
 		return *this;
 	}
 
+	const IdSetBitmap *Bitmap() const { return useBitmap_ ? bitmap_ : nullptr; }
+
 	IdSet::Ptr tempIds_;
 	IdSetRef ids_;
 
 protected:
 	const base_idsetset *set_ = nullptr;
+	const IdSetBitmap *bitmap_ = nullptr;
+	// Current id and search state of bitmap iteration
+	IdType bitmapVal_ = 0;
+	size_t bitmapHint_ = 0;
 
 	union {
 		IdSetRef::const_iterator begin_;
@@ -135,6 +157,7 @@ protected:
 	bool bsearch_ = false;
 	bool isRange_ = false;
 	bool useBtree_ = false;
+	bool useBitmap_ = false;
 };
 
 /// Stores results of selecting data for 1 certain key,
@@ -158,6 +181,8 @@ public:
 				cnt += std::abs(r.rEnd_ - r.rBegin_);
 			} else if (r.useBtree_) {
 				cnt += r.set_->size();
+			} else if (r.useBitmap_) {
+				cnt += r.bitmap_->Cardinality();
 			} else {
 				cnt += r.ids_.size();
 			}
@@ -176,11 +201,25 @@ public:
 	IdSet::Ptr mergeIdsets() {
 		auto mergedIds = make_intrusive<intrusive_atomic_rc_wrapper<IdSet>>();
 
+		if (size() > 1 && std::all_of(begin(), end(), [](const SingleSelectKeyResult &r) { return r.useBitmap_; })) {
+			// All the idsets are bitmaps, so merge them with bitmaps union
+			IdSetBitmap merged = IdSetBitmap::Or(*begin()->bitmap_, *(begin() + 1)->bitmap_);
+			for (auto it = begin() + 2; it != end(); it++) merged = IdSetBitmap::Or(merged, *it->bitmap_);
+			mergedIds->SetBitmap(std::move(merged));
+			clear();
+			push_back(SingleSelectKeyResult(mergedIds));
+			return mergedIds;
+		}
+
 		size_t expectSize = 0;
 		for (auto it = begin(); it != end(); it++) {
 			if (it->useBtree_) {
 				it->itset_ = it->set_->begin();
 				expectSize += it->set_->size();
+			} else if (it->useBitmap_) {
+				it->bitmapHint_ = 0;
+				it->bitmapVal_ = it->bitmap_->Next(INT_MIN, it->bitmapHint_);
+				expectSize += it->bitmap_->Cardinality();
 			} else {
 				it->it_ = it->ids_.begin();
 				expectSize += it->ids_.size();
@@ -188,14 +227,16 @@ public:
 		}
 		mergedIds->reserve(expectSize);
 
-		for (;;) {
-			const int min = mergedIds->size() ? mergedIds->back() : INT_MIN;
+		for (int min = INT_MIN;;) {
 			int curMin = INT_MAX;
 			for (auto it = begin(); it != end(); it++) {
 				if (it->useBtree_) {
 					for (; it->itset_ != it->set_->end() && *it->itset_ <= min; it->itset_++) {
 					};
 					if (it->itset_ != it->set_->end() && *it->itset_ < curMin) curMin = *it->itset_;
+				} else if (it->useBitmap_) {
+					if (it->bitmapVal_ <= min) it->bitmapVal_ = it->bitmap_->Next(min, it->bitmapHint_);
+					if (it->bitmapVal_ < curMin) curMin = it->bitmapVal_;
 				} else {
 					for (; it->it_ != it->ids_.end() && *it->it_ <= min; it->it_++) {
 					};
@@ -204,6 +245,7 @@ public:
 			}
 			if (curMin == INT_MAX) break;
 			mergedIds->Add(curMin, IdSet::Unordered, 0);
+			min = curMin;
 		};
 		mergedIds->shrink_to_fit();
 		clear();
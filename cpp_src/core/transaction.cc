@@ -42,5 +42,6 @@ void Transaction::Modify(Query &&query) {
 Item Transaction::NewItem() { return impl_->NewItem(); }
 
 vector<TransactionStep> &Transaction::GetSteps() { return impl_->steps_; }
+const vector<TransactionStep> &Transaction::GetSteps() const { return impl_->steps_; }
 
 }  // namespace reindexer
@@ -35,6 +35,7 @@ public:
 	friend class ReindexerImpl;
 
 	vector<TransactionStep> &GetSteps();
+	const vector<TransactionStep> &GetSteps() const;
 
 protected:
 	std::unique_ptr<TransactionImpl> impl_;
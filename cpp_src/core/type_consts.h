@@ -60,6 +60,7 @@ typedef enum QueryItemType {
 	QueryOpenBracket,
 	QueryCloseBracket,
 	QueryJoinCondition,
+	QueryParallel,
 } QueryItemType;
 
 typedef enum QuerySerializeMode {
@@ -105,7 +106,8 @@ enum ErrorCode {
 	errNoWAL = 17,
 	errDataHashMismatch = 18,
 	errTimeout = 19,
-	errCanceled = 20
+	errCanceled = 20,
+	errOverloaded = 21
 
 };
 
@@ -0,0 +1,96 @@
+#include "core/workerpool.h"
+#include <algorithm>
+#include "tools/errors.h"
+#include "tools/logger.h"
+
+namespace reindexer {
+
+WorkerPool::WorkerPool(unsigned workersCount) {
+	workers_.reserve(workersCount);
+	for (unsigned i = 0; i < workersCount; ++i) workers_.emplace_back([this]() { workerRoutine(); });
+}
+
+WorkerPool::~WorkerPool() { Stop(); }
+
+void WorkerPool::Parallel(unsigned count, const std::function<void(unsigned)> &func) {
+	auto batch = std::make_shared<ParallelBatch>(func, count);
+	unsigned helpers = 0;
+	if (count > 1) {
+		std::lock_guard<std::mutex> lck(mtx_);
+		if (!stop_) {
+			helpers = std::min<unsigned>(count - 1, workers_.size());
+			for (unsigned i = 0; i < helpers; ++i) batches_.push_back(batch);
+		}
+	}
+	for (unsigned i = 0; i < helpers; ++i) cv_.notify_one();
+
+	batch->Run();
+	if (helpers) {
+		std::lock_guard<std::mutex> lck(mtx_);
+		batches_.erase(std::remove(batches_.begin(), batches_.end(), batch), batches_.end());
+	}
+	batch->Wait();
+	if (batch->error) std::rethrow_exception(batch->error);
+}
+
+bool WorkerPool::Run(Task task) {
+	{
+		std::lock_guard<std::mutex> lck(mtx_);
+		if (stop_ || workers_.empty()) return false;
+		tasks_.emplace_back(std::move(task));
+	}
+	cv_.notify_one();
+	return true;
+}
+
+void WorkerPool::Stop() {
+	{
+		std::lock_guard<std::mutex> lck(mtx_);
+		if (stop_) return;
+		stop_ = true;
+	}
+	cv_.notify_all();
+	for (auto &worker : workers_) worker.join();
+
+	// Tasks may hold the last references to objects, which are destroyed without lock
+	std::deque<Task> tasks;
+	std::lock_guard<std::mutex> lck(mtx_);
+	batches_.clear();
+	tasks.swap(tasks_);
+}
+
+void WorkerPool::workerRoutine() {
+	std::unique_lock<std::mutex> lck(mtx_);
+	while (!stop_) {
+		if (!batches_.empty()) {
+			auto batch = std::move(batches_.front());
+			batches_.pop_front();
+			lck.unlock();
+			batch->Run();
+			batch.reset();
+			lck.lock();
+			continue;
+		}
+		if (tasks_.empty()) {
+			cv_.wait(lck);
+			continue;
+		}
+
+		Task task = std::move(tasks_.front());
+		tasks_.pop_front();
+		lck.unlock();
+		try {
+			task();
+		} catch (const Error &err) {
+			logPrintf(LogWarning, "Worker task failed: %s", err.what());
+		} catch (const std::exception &e) {
+			logPrintf(LogWarning, "Worker task failed: %s", e.what());
+		} catch (...) {
+			logPrintf(LogWarning, "Worker task failed");
+		}
+		task = nullptr;
+		lck.lock();
+	}
+}
+
+}  // namespace reindexer
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "core/parallelbatch.h"
+
+namespace reindexer {
+
+/// Bounded pool of workers, which run compute parts of user requests (e.g. parts of parallel select loops, parse and apply of bulk
+/// modifications). Unlike MaintenanceScheduler it has no periodic tasks, so requests are not delayed by background maintenance.
+/// Pool is usually shared by all the requests of one kind, so count of threads, used by them, doesn't grow with count of requests.
+class WorkerPool {
+public:
+	using Task = std::function<void()>;
+
+	/// Create pool and start its workers
+	/// @param workersCount - count of worker threads
+	explicit WorkerPool(unsigned workersCount);
+	~WorkerPool();
+	WorkerPool(const WorkerPool &) = delete;
+	WorkerPool &operator=(const WorkerPool &) = delete;
+
+	/// Call func(0), ..., func(count - 1) in parallel by the calling thread and free workers. The calls are finished on return.
+	/// Exception of any call is rethrown to the caller
+	void Parallel(unsigned count, const std::function<void(unsigned)> &func);
+	/// Enqueue task to be run by worker. Parts of parallel calls are run before queued tasks
+	/// @return false, if pool has no workers, or it is stopped. Task is not run in this case
+	bool Run(Task task);
+	/// Stop workers. Running tasks are finished, the queued ones are not run anymore
+	void Stop();
+	/// Count of worker threads
+	unsigned WorkersCount() const { return workers_.size(); }
+
+private:
+	void workerRoutine();
+
+	std::mutex mtx_;
+	std::condition_variable cv_;
+	bool stop_ = false;
+	std::deque<std::shared_ptr<ParallelBatch>> batches_;
+	std::deque<Task> tasks_;
+	std::vector<std::thread> workers_;
+};
+
+}  // namespace reindexer
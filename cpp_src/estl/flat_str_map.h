@@ -1,5 +1,7 @@
 #pragma once
+#include <cstring>
 #include <memory>
+#include <stdexcept>
 #include <vector>
 #include "estl/string_view.h"
 #include "hopscotch/hopscotch_map.h"
@@ -220,7 +222,45 @@ public:
 		multi_.shrink_to_fit();
 	}
 
+	// Serializes map. Ser has to provide PutSlice(string_view)
+	template <typename Ser>
+	void serialize(Ser &ser) const {
+		std::vector<std::pair<int, V>> nodes(map_->begin(), map_->end());
+		put_vector(ser, *holder_);
+		put_vector(ser, nodes);
+		put_vector(ser, multi_);
+	}
+	// Restores map, serialized by serialize(). Deser has to provide GetSlice()
+	template <typename Deser>
+	void deserialize(Deser &ser) {
+		std::vector<std::pair<int, V>> nodes;
+		clear();
+		get_vector(ser, *holder_);
+		get_vector(ser, nodes);
+		get_vector(ser, multi_);
+		map_->reserve(nodes.size());
+		for (auto &node : nodes) {
+			if (node.first < 0 || size_t(node.first) >= holder_->size()) {
+				clear();
+				throw std::logic_error("Inconsistent serialized flat_str_map");
+			}
+			map_->emplace(node.first, node.second);
+		}
+	}
+
 protected:
+	template <typename Ser, typename T>
+	static void put_vector(Ser &ser, const std::vector<T> &v) {
+		ser.PutSlice(string_view(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T)));
+	}
+	template <typename Deser, typename T>
+	static void get_vector(Deser &ser, std::vector<T> &v) {
+		string_view data = ser.GetSlice();
+		if (data.size() % sizeof(T)) throw std::logic_error("Inconsistent serialized flat_str_map");
+		v.resize(data.size() / sizeof(T));
+		if (!data.empty()) memcpy(static_cast<void *>(&v[0]), data.data(), data.size());
+	}
+
 	// Single buffer for storing all strings in null terminated format
 	std::unique_ptr<holder_t> holder_;
 	// Underlying map container
@@ -1,5 +1,7 @@
 #pragma once
+#include <cstring>
 #include "h_vector.h"
+#include "string_view.h"
 
 namespace reindexer {
 template <typename T>
@@ -89,6 +91,21 @@ public:
 	}
 	bool empty() { return size_ == 0; }
 
+	// Serializes packed data. Ser has to provide PutVarUint and PutSlice
+	template <typename Ser>
+	void serialize(Ser& ser) const {
+		ser.PutVarUint(size_);
+		ser.PutSlice(string_view(reinterpret_cast<const char*>(data_.data()), data_.size()));
+	}
+	// Restores data, serialized by serialize(). Deser has to provide GetVarUint and GetSlice
+	template <typename Deser>
+	void deserialize(Deser& ser) {
+		size_ = ser.GetVarUint();
+		string_view data = ser.GetSlice();
+		data_.resize(data.size());
+		if (!data.empty()) memcpy(data_.data(), data.data(), data.size());
+	}
+
 protected:
 	store_container data_;
 	size_type size_;
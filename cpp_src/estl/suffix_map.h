@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstring>
+#include <stdexcept>
 #include <vector>
 #include "estl/string_view.h"
 #include "libdivsufsort/divsufsort.h"
@@ -173,6 +175,37 @@ public:
 	size_type word_size() const { return words_.size(); }
 
 	const vector<CharT> &text() const { return text_; }
+
+	// Serializes built map. Ser has to provide PutSlice(string_view)
+	template <typename Ser>
+	void serialize(Ser &ser) const {
+		if (!built_) {
+			throw std::logic_error("Should call suffix_map::build before serialize");
+		}
+		put_vector(ser, sa_);
+		put_vector(ser, words_);
+		put_vector(ser, lcp_);
+		put_vector(ser, words_len_);
+		put_vector(ser, mapped_);
+		put_vector(ser, text_);
+	}
+	// Restores map, serialized by serialize(). Deser has to provide GetSlice()
+	template <typename Deser>
+	void deserialize(Deser &ser) {
+		clear();
+		get_vector(ser, sa_);
+		get_vector(ser, words_);
+		get_vector(ser, lcp_);
+		get_vector(ser, words_len_);
+		get_vector(ser, mapped_);
+		get_vector(ser, text_);
+		if (sa_.size() != text_.size() || lcp_.size() != text_.size() || mapped_.size() != text_.size() ||
+			words_.size() != words_len_.size()) {
+			clear();
+			throw std::logic_error("Inconsistent serialized suffix_map");
+		}
+		built_ = true;
+	}
 	size_t heap_size() {
 		return (sa_.capacity() + words_.capacity()) * sizeof(int) +			  //
 			   (lcp_.capacity() + words_len_.capacity()) * sizeof(int16_t) +  //
@@ -180,6 +213,18 @@ public:
 	}
 
 protected:
+	template <typename Ser, typename T>
+	static void put_vector(Ser &ser, const vector<T> &v) {
+		ser.PutSlice(string_view(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T)));
+	}
+	template <typename Deser, typename T>
+	static void get_vector(Deser &ser, vector<T> &v) {
+		string_view data = ser.GetSlice();
+		if (data.size() % sizeof(T)) throw std::logic_error("Inconsistent serialized suffix_map");
+		v.resize(data.size() / sizeof(T));
+		if (!data.empty()) memcpy(static_cast<void *>(&v[0]), data.data(), data.size());
+	}
+
 	void build_lcp() {
 		vector<int> rank_;
 		rank_.resize(sa_.size());
@@ -52,6 +52,8 @@ void ApiTvSimple::RegisterAllCases() {
 	Register("Query4CondRange", &ApiTvSimple::Query4CondRange, this);
 	Register("Query4CondRangeTotal", &ApiTvSimple::Query4CondRangeTotal, this);
 	Register("Query4CondRangeCachedTotal", &ApiTvSimple::Query4CondRangeCachedTotal, this);
+
+	Register("LoadFromStorage", &ApiTvSimple::LoadFromStorage, this)->Iterations(5)->Unit(benchmark::kMillisecond);
 }
 
 Error ApiTvSimple::Initialize() {
@@ -714,3 +716,17 @@ void ApiTvSimple::Query4CondRangeCachedTotal(benchmark::State& state) {
 		if (!err.ok()) state.SkipWithError(err.what().c_str());
 	}
 }
+
+void ApiTvSimple::LoadFromStorage(benchmark::State& state) {
+	AllocsTracker allocsTracker(state);
+	for (auto _ : state) {
+		state.PauseTiming();
+		auto err = db_->CloseNamespace(nsdef_.name);
+		if (!err.ok()) state.SkipWithError(err.what().c_str());
+		state.ResumeTiming();
+
+		// Namespace's items are loaded from storage on open
+		err = db_->OpenNamespace(nsdef_.name);
+		if (!err.ok()) state.SkipWithError(err.what().c_str());
+	}
+}
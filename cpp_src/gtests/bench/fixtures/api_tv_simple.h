@@ -69,6 +69,8 @@ protected:
 	void Query4CondRangeTotal(State& state);
 	void Query4CondRangeCachedTotal(State& state);
 
+	void LoadFromStorage(State& state);
+
 private:
 	vector<string> countries_;
 	vector<string> countryLikePatterns_;
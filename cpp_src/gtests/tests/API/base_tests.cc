@@ -1,15 +1,19 @@
 #include <fstream>
+#include <thread>
 #include <vector>
 #include "reindexer_api.h"
 #include "tools/errors.h"
 
+#include "core/cjson/jsonbuilder.h"
 #include "core/item.h"
+#include "core/itemsloader.h"
 #include "core/keyvalue/key_string.h"
 #include "core/keyvalue/variant.h"
 #include "core/reindexer.h"
 #include "tools/fsops.h"
 #include "tools/logger.h"
 #include "tools/stringstools.h"
+#include "vendor/gason/gason.h"
 
 #include <deque>
 
@@ -125,6 +129,216 @@ TEST_F(ReindexerApi, DropStorage) {
 	ASSERT_TRUE(reindexer::fs::Stat(storagePath) == reindexer::fs::StatError);
 }
 
+TEST_F(ReindexerApi, WaitDurable) {
+	rt.reindexer->Connect("builtin://" + kBaseTestsStoragePath);
+	Error err = rt.reindexer->OpenNamespace(default_namespace);
+	ASSERT_TRUE(err.ok()) << err.what();
+	err = rt.reindexer->AddIndex(default_namespace, {"id", "hash", "int", IndexOpts().PK()});
+	ASSERT_TRUE(err.ok()) << err.what();
+
+	// Concurrent writers wait for their own items, and share synced writes
+	constexpr int kThreads = 8, kItemsPerThread = 100;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < kThreads; ++t) {
+		threads.emplace_back([this, t]() {
+			for (int i = 0; i < kItemsPerThread; ++i) {
+				Item item(rt.reindexer->NewItem(default_namespace));
+				ASSERT_TRUE(item.Status().ok()) << item.Status().what();
+				item["id"] = t * kItemsPerThread + i;
+				Error err = rt.reindexer->Upsert(default_namespace, item);
+				ASSERT_TRUE(err.ok()) << err.what();
+				err = rt.reindexer->WaitDurable(default_namespace, item.GetLSN());
+				ASSERT_TRUE(err.ok()) << err.what();
+			}
+		});
+	}
+	for (auto &th : threads) th.join();
+	err = rt.reindexer->WaitDurable(default_namespace);
+	ASSERT_TRUE(err.ok()) << err.what();
+
+	err = rt.reindexer->CloseNamespace(default_namespace);
+	ASSERT_TRUE(err.ok()) << err.what();
+	err = rt.reindexer->OpenNamespace(default_namespace);
+	ASSERT_TRUE(err.ok()) << err.what();
+	QueryResults qr;
+	err = rt.reindexer->Select(Query(default_namespace), qr);
+	ASSERT_TRUE(err.ok()) << err.what();
+	ASSERT_EQ(qr.Count(), kThreads * kItemsPerThread);
+
+	err = rt.reindexer->DropNamespace(default_namespace);
+	ASSERT_TRUE(err.ok()) << err.what();
+}
+
+TEST_F(ReindexerApi, ParallelLoadFromStorage) {
+	const std::string storagePath = kBaseTestsStoragePath + "/parallel_load";
+	reindexer::fs::RmDirAll(storagePath);
+	Error err = rt.reindexer->Connect("builtin://" + storagePath);
+	ASSERT_TRUE(err.ok()) << err.what();
+	err = rt.reindexer->OpenNamespace(default_namespace);
+	ASSERT_TRUE(err.ok()) << err.what();
+	DefineNamespaceDataset(default_namespace, {IndexDeclaration{"id", "hash", "int", IndexOpts().PK(), 0},
+											   IndexDeclaration{"value", "tree", "int", IndexOpts(), 0},
+											   IndexDeclaration{"name", "hash", "string", IndexOpts(), 0},
+											   IndexDeclaration{"tags", "hash", "int", IndexOpts().Array(), 0},
+											   IndexDeclaration{"sparse", "hash", "int", IndexOpts().Sparse(), 0},
+											   IndexDeclaration{"value+name", "tree", "composite", IndexOpts(), 0}});
+
+	// Several batches of loader with updated items, so LSNs of items are not in the order of ids
+	constexpr int kItemsCount = 5000;
+	auto upsert = [&](int id) {
+		Item item(rt.reindexer->NewItem(default_namespace));
+		ASSERT_TRUE(item.Status().ok()) << item.Status().what();
+		item["id"] = id;
+		item["value"] = rand() % 100;
+		item["name"] = "name_" + std::to_string(rand() % 1000);
+		item["tags"] = RandIntVector(rand() % 5, 0, 50);
+		if (id % 3) item["sparse"] = id;
+		Upsert(default_namespace, item);
+	};
+	for (int i = 0; i < kItemsCount; ++i) upsert(i);
+	for (int i = 0; i < kItemsCount; i += 7) upsert(i);
+	err = rt.reindexer->CloseNamespace(default_namespace);
+	ASSERT_TRUE(err.ok()) << err.what();
+
+	struct State {
+		std::vector<std::pair<std::string, int64_t>> items;
+		uint64_t dataHash = 0;
+	};
+	auto load = [&](unsigned threadsLimit) {
+		reindexer::ItemsLoader::SetThreadsLimit(threadsLimit);
+		State state;
+		Error err = rt.reindexer->OpenNamespace(default_namespace);
+		EXPECT_TRUE(err.ok()) << err.what();
+		QueryResults qr;
+		err = rt.reindexer->Select(Query(default_namespace).Sort("id", false), qr);
+		EXPECT_TRUE(err.ok()) << err.what();
+		for (auto it : qr) {
+			reindexer::WrSerializer ser;
+			err = it.GetJSON(ser, false);
+			EXPECT_TRUE(err.ok()) << err.what();
+			state.items.emplace_back(std::string(ser.Slice().data(), ser.Slice().size()), it.GetLSN());
+		}
+		QueryResults memQr;
+		err = rt.reindexer->Select(Query("#memstats").Where("name", CondEq, default_namespace), memQr);
+		EXPECT_TRUE(err.ok()) << err.what();
+		EXPECT_EQ(memQr.Count(), 1);
+		reindexer::WrSerializer ser;
+		err = memQr.begin().GetJSON(ser, false);
+		EXPECT_TRUE(err.ok()) << err.what();
+		gason::JsonParser parser;
+		state.dataHash = parser.Parse(ser.Slice())["replication"]["data_hash"].As<uint64_t>();
+		err = rt.reindexer->CloseNamespace(default_namespace);
+		EXPECT_TRUE(err.ok()) << err.what();
+		return state;
+	};
+	const State serial = load(0);
+	const State parallel = load(16);
+	reindexer::ItemsLoader::SetThreadsLimit(std::thread::hardware_concurrency());
+
+	ASSERT_EQ(serial.items.size(), size_t(kItemsCount));
+	ASSERT_EQ(parallel.items.size(), size_t(kItemsCount));
+	for (size_t i = 0; i < serial.items.size(); ++i) {
+		ASSERT_GE(serial.items[i].second, 0) << serial.items[i].first;
+		ASSERT_EQ(serial.items[i], parallel.items[i]);
+	}
+	ASSERT_NE(serial.dataHash, 0u);
+	ASSERT_EQ(serial.dataHash, parallel.dataHash);
+}
+
+TEST_F(ReindexerApi, TransactionOnCopyFailedStep) {
+	const std::string storagePath = kBaseTestsStoragePath + "/tx_on_copy";
+	reindexer::fs::RmDirAll(storagePath);
+	Error err = rt.reindexer->Connect("builtin://" + storagePath);
+	ASSERT_TRUE(err.ok()) << err.what();
+	err = rt.reindexer->OpenNamespace(default_namespace);
+	ASSERT_TRUE(err.ok()) << err.what();
+	DefineNamespaceDataset(default_namespace, {IndexDeclaration{"id", "hash", "int", IndexOpts().PK(), 0},
+											   IndexDeclaration{"value", "tree", "int", IndexOpts(), 0}});
+	auto newItem = [&](int id, int value) {
+		Item item(rt.reindexer->NewItem(default_namespace));
+		EXPECT_TRUE(item.Status().ok()) << item.Status().what();
+		item["id"] = id;
+		item["value"] = value;
+		return item;
+	};
+	for (int i = 0; i < 200; ++i) {
+		Item item = newItem(i, i);
+		Upsert(default_namespace, item);
+	}
+
+	// Transactions with more than 10 steps are applied on the namespace copy
+	reindexer::WrSerializer ser;
+	reindexer::JsonBuilder jb(ser);
+	jb.Put("type", "namespaces");
+	auto nsArray = jb.Array("namespaces");
+	auto nsConf = nsArray.Object();
+	nsConf.Put("namespace", default_namespace);
+	nsConf.Put("start_copy_politics_count", 10);
+	nsConf.End();
+	nsArray.End();
+	jb.End();
+	Item cfgItem = rt.reindexer->NewItem("#config");
+	ASSERT_TRUE(cfgItem.Status().ok()) << cfgItem.Status().what();
+	err = cfgItem.FromJSON(ser.Slice());
+	ASSERT_TRUE(err.ok()) << err.what();
+	Upsert("#config", cfgItem);
+
+	struct State {
+		std::vector<std::pair<std::string, int64_t>> items;
+		uint64_t dataHash = 0;
+		int64_t lastLsn = 0;
+	};
+	auto state = [&]() {
+		State state;
+		QueryResults qr;
+		Error err = rt.reindexer->Select(Query(default_namespace).Sort("id", false), qr);
+		EXPECT_TRUE(err.ok()) << err.what();
+		for (auto it : qr) {
+			reindexer::WrSerializer ser;
+			err = it.GetJSON(ser, false);
+			EXPECT_TRUE(err.ok()) << err.what();
+			state.items.emplace_back(std::string(ser.Slice().data(), ser.Slice().size()), it.GetLSN());
+		}
+		QueryResults memQr;
+		err = rt.reindexer->Select(Query("#memstats").Where("name", CondEq, default_namespace), memQr);
+		EXPECT_TRUE(err.ok()) << err.what();
+		EXPECT_EQ(memQr.Count(), 1);
+		reindexer::WrSerializer ser;
+		err = memQr.begin().GetJSON(ser, false);
+		EXPECT_TRUE(err.ok()) << err.what();
+		gason::JsonParser parser;
+		auto replication = parser.Parse(ser.Slice())["replication"];
+		state.dataHash = replication["data_hash"].As<uint64_t>();
+		state.lastLsn = replication["last_lsn"].As<int64_t>();
+		return state;
+	};
+	const State before = state();
+
+	// Update step fails in the middle of transaction, after some items are already written to the copy
+	auto tr = rt.reindexer->NewTransaction(default_namespace);
+	ASSERT_TRUE(tr.Status().ok()) << tr.Status().what();
+	for (int i = 0; i < 50; ++i) tr.Upsert(newItem(i * 2, -i));
+	Query failedUpdate;
+	failedUpdate.FromSQL("UPDATE " + default_namespace + " SET value = value / 0 WHERE id < 10");
+	tr.Modify(std::move(failedUpdate));
+	for (int i = 1000; i < 1050; ++i) tr.Upsert(newItem(i, i));
+	err = rt.reindexer->CommitTransaction(tr);
+	ASSERT_FALSE(err.ok());
+
+	// Namespace keeps its contents, and nothing of transaction gets to storage
+	const State inMemory = state();
+	ASSERT_EQ(inMemory.items, before.items);
+	ASSERT_EQ(inMemory.dataHash, before.dataHash);
+	err = rt.reindexer->CloseNamespace(default_namespace);
+	ASSERT_TRUE(err.ok()) << err.what();
+	err = rt.reindexer->OpenNamespace(default_namespace);
+	ASSERT_TRUE(err.ok()) << err.what();
+	const State reopened = state();
+	ASSERT_EQ(reopened.items, inMemory.items);
+	ASSERT_EQ(reopened.dataHash, inMemory.dataHash);
+	ASSERT_EQ(reopened.lastLsn, inMemory.lastLsn);
+}
+
 TEST_F(ReindexerApi, DeleteNonExistingNamespace) {
 	auto err = rt.reindexer->CloseNamespace(default_namespace);
 	ASSERT_FALSE(err.ok()) << "Error: unexpected result of delete non-existing namespace.";
@@ -199,6 +413,51 @@ TEST_F(ReindexerApi, Insert) {
 	ASSERT_NO_THROW(ASSERT_EQ(selItem["value"].As<string>(), "value"));
 }
 
+TEST_F(ReindexerApi, ModifyItems) {
+	Error err = rt.reindexer->OpenNamespace(default_namespace, StorageOpts().Enabled(false));
+	ASSERT_TRUE(err.ok()) << err.what();
+
+	err = rt.reindexer->AddIndex(default_namespace, {"id", "hash", "int", IndexOpts().PK()});
+	ASSERT_TRUE(err.ok()) << err.what();
+
+	err = rt.reindexer->AddIndex(default_namespace, {"value", "text", "string", IndexOpts()});
+	ASSERT_TRUE(err.ok()) << err.what();
+
+	const std::vector<std::string> jsons = {R"_({"id":1, "value" : "first"})_", R"_({"id":2, "value" : "second"})_",
+											R"_({"id":1, "value" : "duplicate"})_", R"_({"id":3, "value" : "missing"})_",
+											R"_({"id":2})_"};
+	const std::vector<ItemModifyMode> modes = {ModeInsert, ModeUpsert, ModeInsert, ModeUpdate, ModeDelete};
+	std::vector<Item> items;
+	for (auto &json : jsons) {
+		items.emplace_back(rt.reindexer->NewItem(default_namespace));
+		ASSERT_TRUE(items.back().Status().ok()) << items.back().Status().what();
+		err = items.back().FromJSON(json);
+		ASSERT_TRUE(err.ok()) << err.what();
+	}
+
+	std::vector<Error> statuses;
+	err = rt.reindexer->ModifyItems(default_namespace, items, {ModeInsert}, statuses);
+	ASSERT_EQ(err.code(), errParams) << err.what();
+
+	err = rt.reindexer->ModifyItems(default_namespace, items, modes, statuses);
+	ASSERT_TRUE(err.ok()) << err.what();
+	ASSERT_EQ(statuses.size(), items.size());
+	for (auto &status : statuses) ASSERT_TRUE(status.ok()) << status.what();
+	EXPECT_NE(items[0].GetID(), -1);
+	EXPECT_NE(items[1].GetID(), -1);
+	// Insert of existing item and update of missing one are skipped
+	EXPECT_EQ(items[2].GetID(), -1);
+	EXPECT_EQ(items[3].GetID(), -1);
+
+	QueryResults qr;
+	err = rt.reindexer->Select(Query(default_namespace), qr);
+	ASSERT_TRUE(err.ok()) << err.what();
+	ASSERT_EQ(qr.Count(), 1);
+	Item selItem = qr.begin().GetItem();
+	ASSERT_NO_THROW(ASSERT_EQ(selItem["id"].As<int>(), 1));
+	ASSERT_NO_THROW(ASSERT_EQ(selItem["value"].As<string>(), "first"));
+}
+
 TEST_F(ReindexerApi, WithTimeoutInterface) {
 	using std::chrono::milliseconds;
 
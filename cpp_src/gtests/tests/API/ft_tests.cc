@@ -3,6 +3,7 @@
 #include <unordered_set>
 #include "debug/allocdebug.h"
 #include "ft_api.h"
+#include "tools/fsops.h"
 #include "tools/logger.h"
 #include "tools/stringstools.h"
 
@@ -170,3 +171,85 @@ TEST_F(FTApi, Unique) {
 		}
 	}
 }
+
+TEST_F(FTApi, StateRestoredFromStorage) {
+	const std::string kStoragePath = "/tmp/reindex/ft_state_test";
+	const std::string ns = "ft_state";
+	reindexer::fs::RmDirAll(kStoragePath);
+	rt.reindexer.reset(new Reindexer);
+	Error err = rt.reindexer->Connect("builtin://" + kStoragePath);
+	ASSERT_TRUE(err.ok()) << err.what();
+	err = rt.reindexer->OpenNamespace(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+	DefineNamespaceDataset(ns, {IndexDeclaration{"id", "hash", "int", IndexOpts().PK(), 0},
+								IndexDeclaration{"ft1", "text", "string", IndexOpts(), 0},
+								IndexDeclaration{"ft2", "text", "string", IndexOpts(), 0},
+								IndexDeclaration{"ft1+ft2=ft3", "text", "composite", IndexOpts(), 0}});
+	for (int i = 0; i < 1000; ++i) Add(ns, RandString(), RandString());
+	Add(ns, "restored fulltext state", "one");
+	Add(ns, "restored state", "two");
+
+	auto select = [&](const std::string &index, const std::string &text) {
+		QueryResults qr;
+		Error err = rt.reindexer->Select(Query(ns).Where(index, CondEq, text), qr);
+		EXPECT_TRUE(err.ok()) << err.what();
+		std::vector<std::pair<int, int>> res;
+		for (auto it : qr) res.emplace_back(it.GetItem()["id"].As<int>(), it.GetItemRef().proc);
+		return res;
+	};
+
+	const std::vector<std::pair<std::string, std::string>> queries = {
+		{"ft1", "restored"}, {"ft1", "fulltext state"}, {"ft3", "restored +two"}, {"ft3", "state*"}};
+	std::vector<std::vector<std::pair<int, int>>> expected;
+	for (auto &q : queries) {
+		expected.emplace_back(select(q.first, q.second));
+		EXPECT_FALSE(expected.back().empty()) << q.second;
+	}
+
+	// Closing of namespace saves built fulltext indexes to storage
+	err = rt.reindexer->CloseNamespace(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+	err = rt.reindexer->OpenNamespace(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+
+	// Indexes are loaded without rebuild
+	EXPECT_GT(IndexMemStat(ns, "ft1", "fulltext_size"), 0);
+	EXPECT_GT(IndexMemStat(ns, "ft3", "fulltext_size"), 0);
+	for (size_t i = 0; i < queries.size(); ++i) EXPECT_EQ(select(queries[i].first, queries[i].second), expected[i]) << queries[i].second;
+
+	// Loaded index is updated incrementally
+	Add(ns, "restored again", "three");
+	EXPECT_EQ(select("ft1", "restored").size(), expected[0].size() + 1);
+	EXPECT_EQ(select("ft3", "three").size(), 1);
+}
+
+TEST_F(FTApi, OutdatedDataSelectedDuringRebuild) {
+	const std::string ns = "ft_outdated";
+	Error err = rt.reindexer->InitSystemNamespaces();
+	ASSERT_TRUE(err.ok()) << err.what();
+	err = rt.reindexer->OpenNamespace(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+	DefineNamespaceDataset(ns, {IndexDeclaration{"id", "hash", "int", IndexOpts().PK(), 0},
+								IndexDeclaration{"ft1", "text", "string", IndexOpts().SetConfig(R"({"max_rebuild_staleness_ms":2000})"), 0},
+								IndexDeclaration{"ft2", "text", "string", IndexOpts(), 0}});
+	for (int i = 0; i < 100; ++i) Add(ns, RandString(), RandString());
+	Add(ns, "first document", "first document");
+
+	auto count = [&](const std::string &index, const std::string &text) {
+		QueryResults qr;
+		Error err = rt.reindexer->Select(Query(ns).Where(index, CondEq, text), qr);
+		EXPECT_TRUE(err.ok()) << err.what();
+		return qr.Count();
+	};
+	EXPECT_EQ(count("ft1", "first"), 1);
+	EXPECT_EQ(count("ft2", "first"), 1);
+	EXPECT_EQ(IndexMemStat(ns, "ft1", "fulltext_generation"), 1);
+
+	// Select doesn't wait for rebuild and uses the previous generation of data
+	Add(ns, "second document", "second document");
+	EXPECT_EQ(count("ft1", "second"), 0);
+	EXPECT_EQ(count("ft1", "first"), 1);
+	EXPECT_EQ(IndexMemStat(ns, "ft1", "fulltext_generation"), 1);
+	// Index without allowed staleness is rebuilt by select
+	EXPECT_EQ(count("ft2", "second"), 1);
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <limits>
 #include "reindexer_api.h"
+#include "vendor/gason/gason.h"
 
 class FTApi : public ReindexerApi {
 public:
@@ -105,6 +106,21 @@ public:
 
 		return res;
 	}
+	// Returns value of index memstats field, or 0 if the field is not set
+	int64_t IndexMemStat(const std::string& ns, const std::string& index, const std::string& field) {
+		QueryResults qr;
+		Error err = rt.reindexer->Select(Query("#memstats").Where("name", CondEq, ns), qr);
+		EXPECT_TRUE(err.ok()) << err.what();
+		EXPECT_EQ(qr.Count(), 1);
+		reindexer::WrSerializer ser;
+		err = qr.begin().GetJSON(ser, false);
+		EXPECT_TRUE(err.ok()) << err.what();
+		gason::JsonParser parser;
+		for (auto& idx : parser.Parse(ser.Slice())["indexes"]) {
+			if (idx["name"].As<std::string>() == index) return idx[field].As<int64_t>();
+		}
+		return 0;
+	}
 	FTApi() {}
 
 private:
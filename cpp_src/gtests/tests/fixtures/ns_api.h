@@ -1,7 +1,9 @@
 #pragma once
 
 #include <gtest/gtest.h>
+#include "core/cjson/jsonbuilder.h"
 #include "reindexer_api.h"
+#include "tools/serializer.h"
 #include "tools/timetools.h"
 
 class NsApi : public ReindexerApi {
@@ -118,6 +120,33 @@ protected:
 		ASSERT_EQ(1, qr3.Count());
 	}
 
+	// Sort orders of namespace are built by optimization after this timeout since the last modification
+	void SetOptimizationTimeout(const string& ns, int timeoutMs) {
+		reindexer::WrSerializer ser;
+		reindexer::JsonBuilder jb(ser);
+		jb.Put("type", "namespaces");
+		auto nsArray = jb.Array("namespaces");
+		auto nsConf = nsArray.Object();
+		nsConf.Put("namespace", ns);
+		nsConf.Put("optimization_timeout_ms", timeoutMs);
+		nsConf.End();
+		nsArray.End();
+		jb.End();
+		Item cfgItem = NewItem("#config");
+		ASSERT_TRUE(cfgItem.Status().ok()) << cfgItem.Status().what();
+		Error err = cfgItem.FromJSON(ser.Slice());
+		ASSERT_TRUE(err.ok()) << err.what();
+		Upsert("#config", cfgItem);
+	}
+
+	// Sorted selects iterate over built sort orders, otherwise they have to iterate over btree
+	bool SortOrdersBuilt(const string& ns, const string& sortField) {
+		QueryResults qr;
+		Error err = rt.reindexer->Select(Query(ns).Sort(sortField, false).Explain(), qr);
+		EXPECT_TRUE(err.ok()) << err.what();
+		return qr.GetExplainResults().find("UnbuiltSortOrdersIndex") == std::string::npos;
+	}
+
 	static void CheckItemsEqual(Item& lhs, Item& rhs) {
 		for (auto idx = 1; idx < lhs.NumFields(); idx++) {
 			auto field = lhs[idx].Name();
@@ -85,8 +85,11 @@ ReplicationConfig ServerControl::Interface::GetServerConfig(ConfigType type) {
 	for (auto& ns : config.namespaces) {
 		namespaces.insert(ns);
 	}
-	return ReplicationConfig(config.role == ReplicationMaster ? "master" : "slave", config.forceSyncOnLogicError,
-							 config.forceSyncOnWrongDataHash, std::move(config.masterDSN), std::move(namespaces));
+	ReplicationConfig ret(config.role == ReplicationMaster ? "master" : "slave", config.forceSyncOnLogicError,
+						  config.forceSyncOnWrongDataHash, std::move(config.masterDSN), std::move(namespaces));
+	ret.snapshotChunkSize_ = config.snapshotChunkSize;
+	ret.connPoolSize_ = config.connPoolSize;
+	return ret;
 }
 
 void ServerControl::Interface::WriteServerConfig(const std::string& configYaml) {
@@ -155,6 +158,8 @@ void ServerControl::Interface::setReplicationConfig(size_t masterId, const Repli
 	replConf.Put("cluster_id", 2);
 	replConf.Put("force_sync_on_logic_error", config.forceSyncOnLogicError_);
 	replConf.Put("force_sync_on_wrong_data_hash", config.forceSyncOnWrongDataHash_);
+	replConf.Put("snapshot_chunk_size", config.snapshotChunkSize_);
+	replConf.Put("conn_pool_size", config.connPoolSize_);
 
 	auto nsArray = replConf.Array("namespaces");
 	for (auto& ns : config.namespaces_) nsArray.Put(nullptr, ns);
@@ -37,7 +37,8 @@ struct ReplicationConfig {
 
 	bool operator==(const ReplicationConfig& config) const {
 		return role_ == config.role_ && forceSyncOnLogicError_ == config.forceSyncOnLogicError_ &&
-			   forceSyncOnWrongDataHash_ == config.forceSyncOnWrongDataHash_ && dsn_ == config.dsn_ && namespaces_ == config.namespaces_;
+			   forceSyncOnWrongDataHash_ == config.forceSyncOnWrongDataHash_ && dsn_ == config.dsn_ && namespaces_ == config.namespaces_ &&
+			   snapshotChunkSize_ == config.snapshotChunkSize_ && connPoolSize_ == config.connPoolSize_;
 	}
 
 	std::string role_;
@@ -45,6 +46,8 @@ struct ReplicationConfig {
 	bool forceSyncOnWrongDataHash_;
 	std::string dsn_;
 	NsSet namespaces_;
+	int snapshotChunkSize_ = 0;
+	int connPoolSize_ = 1;
 };
 
 struct ReplicationState {
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "core/columnscan.h"
+#include "estl/h_vector.h"
+
+using reindexer::ColumnFilter;
+using reindexer::IdSet;
+
+// std::vector<bool> has no data(), so column is stored in h_vector
+template <typename T>
+using Column = reindexer::h_vector<T, 1>;
+
+template <typename T>
+static std::vector<IdType> scanReference(const Column<T> &column, const ColumnFilter<T> &filter) {
+	std::vector<IdType> res;
+	if (filter.empty) return res;
+	for (size_t i = 0; i < column.size(); ++i) {
+		bool match = false;
+		if (filter.IsSet()) {
+			for (const T &v : filter.values) match = match || (column[i] == v);
+		} else {
+			match = column[i] >= filter.min && column[i] <= filter.max;
+		}
+		if (match) res.push_back(IdType(i));
+	}
+	return res;
+}
+
+template <typename T>
+static void checkScan(const Column<T> &column, const ColumnFilter<T> &filter) {
+	const auto expected = scanReference(column, filter);
+	// Check different lengths of the last incomplete block
+	const size_t size = column.size();
+	for (size_t rowsCount : {size, size - 1, size - 63, size_t(1), size_t(0)}) {
+		IdSet ids;
+		reindexer::ScanColumn(column.data(), rowsCount, filter, ids);
+		std::vector<IdType> exp;
+		for (IdType id : expected) {
+			if (size_t(id) < rowsCount) exp.push_back(id);
+		}
+		std::vector<IdType> actual;
+		ids.ForEach([&actual](IdType id) { actual.push_back(id); });
+		ASSERT_EQ(actual, exp)
+			<< "rowsCount = " << rowsCount << "; instructions set: " << reindexer::ColumnScanInstructionsSet();
+	}
+}
+
+template <typename T, typename Gen>
+static void checkFilters(Gen gen) {
+	Column<T> column;
+	for (size_t i = 0; i < 1000; ++i) column.push_back(gen());
+
+	for (int i = 0; i < 20; ++i) {
+		ColumnFilter<T> range;
+		range.min = gen();
+		range.max = gen();
+		checkScan(column, range);
+
+		ColumnFilter<T> minOnly;
+		minOnly.min = gen();
+		checkScan(column, minOnly);
+
+		ColumnFilter<T> maxOnly;
+		maxOnly.max = gen();
+		checkScan(column, maxOnly);
+
+		ColumnFilter<T> set;
+		for (size_t j = 0; j <= size_t(i) % reindexer::kMaxColumnScanSetSize; ++j) set.values.push_back(gen());
+		checkScan(column, set);
+	}
+
+	ColumnFilter<T> empty;
+	empty.empty = true;
+	checkScan(column, empty);
+}
+
+TEST(ColumnScan, Int) {
+	std::mt19937 rnd(1);
+	checkFilters<int>([&rnd]() { return int(rnd() % 200) - 100; });
+	checkFilters<int>([&rnd]() {
+		return (rnd() % 4 == 0) ? ((rnd() % 2) ? std::numeric_limits<int>::max() : std::numeric_limits<int>::lowest()) : int(rnd());
+	});
+}
+
+TEST(ColumnScan, Int64) {
+	std::mt19937_64 rnd(2);
+	checkFilters<int64_t>([&rnd]() { return int64_t(rnd() % 200) - 100; });
+	checkFilters<int64_t>([&rnd]() { return int64_t(rnd()); });
+}
+
+TEST(ColumnScan, Double) {
+	std::mt19937 rnd(3);
+	checkFilters<double>([&rnd]() { return double(int(rnd() % 200) - 100) / 4; });
+	checkFilters<double>([&rnd]() {
+		switch (rnd() % 8) {
+			case 0:
+				return std::numeric_limits<double>::infinity();
+			case 1:
+				return -std::numeric_limits<double>::infinity();
+			case 2:
+				return std::nan("");
+			default:
+				return double(rnd()) / 1000.0 - 2000000.0;
+		}
+	});
+}
+
+TEST(ColumnScan, Bool) {
+	std::mt19937 rnd(4);
+	checkFilters<bool>([&rnd]() { return bool(rnd() % 2); });
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include "net/cproto/cproto.h"
+#include "tools/errors.h"
+#include "tools/serializer.h"
+
+using namespace reindexer::net::cproto;
+using reindexer::WrSerializer;
+using reindexer::string_view;
+
+static void packFrame(WrSerializer &ser, string_view payload) {
+	CProtoHeader hdr;
+	hdr.magic = kCprotoMagic;
+	hdr.version = kCprotoVersion;
+	hdr.compressed = 0;
+	hdr.acceptCompressed = 1;
+	hdr._reserved = 0;
+	hdr.cmd = kCmdFetchResults;
+	hdr.seq = 42;
+	hdr.len = payload.size();
+	ser.Write(string_view(reinterpret_cast<char *>(&hdr), sizeof(hdr)));
+	ser.Write(payload);
+}
+
+static CProtoHeader frameHeader(const WrSerializer &ser) {
+	CProtoHeader hdr;
+	memcpy(&hdr, ser.Buf(), sizeof(hdr));
+	return hdr;
+}
+
+TEST(CprotoCompressionTest, LargeFrameIsCompressed) {
+	std::string payload;
+	for (int i = 0; i < 1000; ++i) payload += "{\"id\":" + std::to_string(i) + ",\"name\":\"item name\"}";
+
+	WrSerializer ser;
+	packFrame(ser, payload);
+	CompressFrame(ser);
+
+	const CProtoHeader hdr = frameHeader(ser);
+	EXPECT_EQ(hdr.compressed, 1);
+	EXPECT_EQ(hdr.acceptCompressed, 1);
+	EXPECT_EQ(hdr.version, kCprotoVersion);
+	EXPECT_EQ(hdr.cmd, kCmdFetchResults);
+	EXPECT_EQ(hdr.seq, 42);
+	ASSERT_EQ(hdr.len + sizeof(hdr), ser.Len());
+	EXPECT_LT(hdr.len, payload.size());
+
+	std::string uncompressed;
+	UncompressPayload(string_view(reinterpret_cast<char *>(ser.Buf()) + sizeof(hdr), hdr.len), uncompressed);
+	EXPECT_EQ(uncompressed, payload);
+}
+
+TEST(CprotoCompressionTest, SmallFrameIsNotCompressed) {
+	const std::string payload(kCprotoCompressionThreshold - 1, 'a');
+	WrSerializer ser;
+	packFrame(ser, payload);
+	CompressFrame(ser);
+
+	const CProtoHeader hdr = frameHeader(ser);
+	EXPECT_EQ(hdr.compressed, 0);
+	EXPECT_EQ(hdr.len, payload.size());
+	EXPECT_EQ(string_view(reinterpret_cast<char *>(ser.Buf()) + sizeof(hdr), hdr.len), string_view(payload));
+}
+
+TEST(CprotoCompressionTest, CorruptedPayload) {
+	std::string uncompressed;
+	EXPECT_THROW(UncompressPayload("\xff\xff\xff\xff\xff not a snappy data", uncompressed), reindexer::Error);
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+#include "core/index/index.h"
+#include "core/rdxcontext.h"
+#include "core/selectfunc/ctx/ftctx.h"
+
+using reindexer::Index;
+using reindexer::IndexDef;
+using reindexer::Variant;
+using reindexer::VariantArray;
+
+static std::string config(int stalenessMs) { return R"({"max_rebuild_staleness_ms":)" + std::to_string(stalenessMs) + "}"; }
+
+static std::unique_ptr<Index> newFtIndex(int stalenessMs) {
+	return std::unique_ptr<Index>(Index::New(IndexDef("ft", {"ft"}, "text", "string", IndexOpts().SetConfig(config(stalenessMs))),
+											 reindexer::PayloadType(), reindexer::FieldsSet{0}));
+}
+
+static size_t count(Index &index, const std::string &text) {
+	auto ctx = std::make_shared<reindexer::FtCtx>();
+	index.SelectKey(VariantArray{Variant(text)}, CondEq, 0, Index::SelectOpts(), ctx, reindexer::RdxContext());
+	return ctx->GetSize();
+}
+
+static void setStaleness(Index &index, int stalenessMs) { index.SetOpts(IndexOpts().SetConfig(config(stalenessMs))); }
+
+// Index is updated, while the new generation of fulltext data is built, as it happens with background rebuild without namespace lock
+TEST(FtRebuild, UpdatesDuringRebuild) {
+	auto index = newFtIndex(1);
+	const std::string docs[] = {"first document", "second document", "third document", "fourth document"};
+	index->Upsert(Variant(docs[0]), 0);
+	index->Upsert(Variant(docs[1]), 1);
+	EXPECT_EQ(count(*index, "document"), 2);
+	EXPECT_EQ(index->GetMemStat().fulltextGeneration, 1);
+
+	index->Upsert(Variant(docs[2]), 2);
+	auto rebuild = index->PrepareRebuild();
+	ASSERT_TRUE(rebuild);
+
+	// Selects use the current generation, until the new one is swapped
+	setStaleness(*index, 1000000);
+	index->Delete(Variant(docs[0]), 0);
+	index->Upsert(Variant(docs[3]), 3);
+	EXPECT_EQ(count(*index, "document"), 1);
+	EXPECT_EQ(count(*index, "third"), 0);
+
+	rebuild->Build();
+	index->ApplyRebuild(*rebuild);
+	EXPECT_EQ(index->GetMemStat().fulltextGeneration, 2);
+	// Document, deleted during build, is not found, and document, inserted during build, is not indexed yet
+	EXPECT_EQ(count(*index, "document"), 2);
+	EXPECT_EQ(count(*index, "first"), 0);
+	EXPECT_EQ(count(*index, "third"), 1);
+	EXPECT_EQ(count(*index, "fourth"), 0);
+
+	// Keys are bound to vdocs of the new generation
+	index->Delete(Variant(docs[1]), 1);
+	EXPECT_EQ(count(*index, "document"), 1);
+	EXPECT_EQ(count(*index, "second"), 0);
+
+	// Index is still outdated, so it's rebuilt by select, when staleness is not allowed
+	setStaleness(*index, 0);
+	EXPECT_EQ(count(*index, "document"), 2);
+	EXPECT_EQ(count(*index, "fourth"), 1);
+	EXPECT_EQ(index->GetMemStat().fulltextGeneration, 3);
+}
+
+// Generation, built by select during background rebuild, is not replaced by the background one
+TEST(FtRebuild, RebuiltBySelect) {
+	auto index = newFtIndex(1);
+	index->Upsert(Variant(std::string("first document")), 0);
+	EXPECT_EQ(count(*index, "document"), 1);
+
+	index->Upsert(Variant(std::string("second document")), 1);
+	auto rebuild = index->PrepareRebuild();
+	ASSERT_TRUE(rebuild);
+	index->Upsert(Variant(std::string("third document")), 2);
+
+	setStaleness(*index, 0);
+	EXPECT_EQ(count(*index, "document"), 3);
+	EXPECT_EQ(index->GetMemStat().fulltextGeneration, 2);
+
+	rebuild->Build();
+	index->ApplyRebuild(*rebuild);
+	EXPECT_EQ(index->GetMemStat().fulltextGeneration, 2);
+	EXPECT_EQ(count(*index, "document"), 3);
+	EXPECT_FALSE(index->PrepareRebuild());
+}
@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+#include <climits>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "core/idset.h"
+#include "core/idsetbitmap.h"
+
+using reindexer::IdSetBitmap;
+
+// Generates sorted unique ids with sparse and dense chunks
+static std::set<IdType> randomIds(std::mt19937 &rnd) {
+	std::set<IdType> ids;
+	const int chunksCount = 1 + rnd() % 6;
+	for (int c = 0; c < chunksCount; ++c) {
+		const IdType base = IdType(rnd() % 8) << 16;
+		const int count = (rnd() % 2) ? (rnd() % 100) : (5000 + rnd() % 50000);
+		for (int i = 0; i < count; ++i) ids.insert(base + IdType(rnd() % 65536));
+	}
+	return ids;
+}
+
+static IdSetBitmap makeBitmap(const std::set<IdType> &ids) {
+	std::vector<IdType> v(ids.begin(), ids.end());
+	return IdSetBitmap(v.data(), v.data() + v.size());
+}
+
+static std::vector<IdType> toVector(const IdSetBitmap &bitmap) {
+	std::vector<IdType> res;
+	bitmap.ForEach([&res](IdType id) { res.push_back(id); });
+	return res;
+}
+
+TEST(IdSetBitmap, BuildAndIterate) {
+	std::mt19937 rnd(1);
+	for (int i = 0; i < 20; ++i) {
+		const auto ids = randomIds(rnd);
+		const IdSetBitmap bitmap = makeBitmap(ids);
+		ASSERT_EQ(bitmap.Cardinality(), ids.size());
+		ASSERT_EQ(toVector(bitmap), std::vector<IdType>(ids.begin(), ids.end()));
+
+		for (int j = 0; j < 1000; ++j) {
+			const IdType id = rnd() % (9 << 16);
+			ASSERT_EQ(bitmap.Contains(id), ids.count(id) != 0) << id;
+		}
+
+		// Forward iteration with growing hint
+		size_t hint = 0;
+		std::vector<IdType> fwd;
+		for (IdType id = bitmap.Next(-1, hint); id != INT_MAX; id = bitmap.Next(id, hint)) fwd.push_back(id);
+		ASSERT_EQ(fwd, std::vector<IdType>(ids.begin(), ids.end()));
+
+		// Reverse iteration with growing hint
+		hint = 0;
+		std::vector<IdType> rev;
+		for (IdType id = bitmap.Prev(INT_MAX, hint); id != INT_MIN; id = bitmap.Prev(id, hint)) rev.push_back(id);
+		ASSERT_EQ(rev, std::vector<IdType>(ids.rbegin(), ids.rend()));
+
+		// Jumps with skipped ids
+		hint = 0;
+		for (IdType from = -1; from < (9 << 16); from += rnd() % 3000) {
+			auto it = ids.upper_bound(from);
+			ASSERT_EQ(bitmap.Next(from, hint), it == ids.end() ? INT_MAX : *it) << from;
+		}
+	}
+}
+
+TEST(IdSetBitmap, SetOperations) {
+	std::mt19937 rnd(2);
+	for (int i = 0; i < 20; ++i) {
+		const auto lhs = randomIds(rnd), rhs = randomIds(rnd);
+		std::vector<IdType> andRes, orRes, andNotRes;
+		std::set_intersection(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(andRes));
+		std::set_union(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(orRes));
+		std::set_difference(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(andNotRes));
+
+		const IdSetBitmap l = makeBitmap(lhs), r = makeBitmap(rhs);
+		const IdSetBitmap a = IdSetBitmap::And(l, r), o = IdSetBitmap::Or(l, r), n = IdSetBitmap::AndNot(l, r);
+		ASSERT_EQ(toVector(a), andRes);
+		ASSERT_EQ(a.Cardinality(), andRes.size());
+		ASSERT_EQ(toVector(o), orRes);
+		ASSERT_EQ(o.Cardinality(), orRes.size());
+		ASSERT_EQ(toVector(n), andNotRes);
+		ASSERT_EQ(n.Cardinality(), andNotRes.size());
+	}
+}
+
+TEST(IdSetBitmap, AddRemove) {
+	std::mt19937 rnd(3);
+	for (int i = 0; i < 10; ++i) {
+		auto ids = randomIds(rnd);
+		IdSetBitmap bitmap = makeBitmap(ids);
+		const auto origIds = ids;
+		// Copy shares chunks with bitmap, so it has to be kept unchanged
+		const IdSetBitmap copy = bitmap;
+		for (int j = 0; j < 20000; ++j) {
+			// Ids are added and removed around the limit of sparse chunk, to convert chunks both ways
+			const IdType id = IdType(rnd() % 9) << 16 | IdType(rnd() % 8192);
+			if (rnd() % 2) {
+				ASSERT_EQ(bitmap.Add(id), ids.insert(id).second) << id;
+			} else {
+				ASSERT_EQ(bitmap.Remove(id), ids.erase(id) != 0) << id;
+			}
+		}
+		ASSERT_EQ(bitmap.Cardinality(), ids.size());
+		ASSERT_EQ(toVector(bitmap), std::vector<IdType>(ids.begin(), ids.end()));
+		for (IdType id : ids) ASSERT_TRUE(bitmap.Contains(id)) << id;
+		ASSERT_EQ(copy.Cardinality(), origIds.size());
+		ASSERT_EQ(toVector(copy), std::vector<IdType>(origIds.begin(), origIds.end()));
+	}
+}
+
+TEST(IdSetBitmap, IdSetCommit) {
+	reindexer::IdSet ids;
+	for (IdType id = 0; id < 100000; id += 2) ids.Add(id, reindexer::IdSet::Unordered, 0);
+	ids.Commit(true);
+	ASSERT_TRUE(ids.Bitmap() != nullptr);
+	ASSERT_EQ(ids.size(), 50000);
+	ASSERT_LT(ids.BitmapSize(), 50000 * sizeof(IdType));
+
+	// Modification unpacks bitmap back to plain ids
+	ids.Add(1, reindexer::IdSet::Ordered, 0);
+	ASSERT_TRUE(ids.Bitmap() == nullptr);
+	ASSERT_EQ(ids.size(), 50001);
+	ASSERT_EQ(std::vector<IdType>(ids.Sorted(0).begin(), ids.Sorted(0).begin() + 3), std::vector<IdType>({0, 1, 2}));
+
+	// Small idsets are never packed
+	reindexer::IdSet small;
+	for (IdType id = 0; id < 100; ++id) small.Add(id, reindexer::IdSet::Auto, 0);
+	small.Commit(true);
+	ASSERT_TRUE(small.Bitmap() == nullptr);
+}
+
+TEST(IdSetBitmap, IdSetSortOrders) {
+	const int sortedIdxCount = 2;
+	const IdType count = 50000;
+	reindexer::IdSet ids;
+	for (IdType id = 0; id < count; ++id) ids.Add(id * 2, reindexer::IdSet::Unordered, sortedIdxCount);
+	// Sort orders are positions of ids: in the same and in the reversed order
+	auto fillSortOrders = [&]() {
+		reindexer::IdSetRef asc = ids.Sorted(1), desc = ids.Sorted(2);
+		IdType i = 0;
+		ids.ForEach([&](IdType id) {
+			asc[i] = id / 2;
+			desc[i] = count - 1 - id / 2;
+			++i;
+		});
+		ASSERT_EQ(i, count);
+	};
+	auto checkSortOrders = [&]() {
+		reindexer::IdSetRef asc = ids.Sorted(1), desc = ids.Sorted(2);
+		ASSERT_EQ(asc.size(), size_t(count));
+		ASSERT_EQ(desc.size(), size_t(count));
+		for (IdType i = 0; i < count; ++i) {
+			ASSERT_EQ(asc[i], i);
+			ASSERT_EQ(desc[i], count - 1 - i);
+		}
+	};
+	ids.ReserveForSorted(sortedIdxCount);
+	fillSortOrders();
+
+	// Sort orders are kept, when idset is packed to bitmap
+	ids.Commit(true, sortedIdxCount);
+	ASSERT_TRUE(ids.Bitmap() != nullptr);
+	ASSERT_EQ(ids.size(), size_t(count));
+	ASSERT_FALSE(ids.empty());
+	checkSortOrders();
+
+	// Sort orders of bitmap idset are rebuilt without unpacking
+	ids.ReserveForSorted(sortedIdxCount);
+	fillSortOrders();
+	ASSERT_TRUE(ids.Bitmap() != nullptr);
+	checkSortOrders();
+
+	// Copy (without sort orders) shares bitmap with idset, which is not changed by modification of copy
+	reindexer::IdSet copy(ids);
+	const IdType newId = count * 2 + 1;
+	copy.AddSorted(newId, nullptr, 0);
+	ASSERT_TRUE(copy.Bitmap() != nullptr);
+	ASSERT_EQ(copy.size(), size_t(count + 1));
+	ASSERT_TRUE(copy.Bitmap()->Contains(newId));
+	ASSERT_FALSE(ids.Bitmap()->Contains(newId));
+	checkSortOrders();
+}
@@ -4,6 +4,7 @@
 #include <unordered_set>
 #include "core/itemimpl.h"
 #include "join_selects_api.h"
+#include "vendor/gason/gason.h"
 
 TEST_F(JoinSelectsApi, JoinsAsWhereConditionsTest) {
 	Query queryGenres = Query(genres_namespace).Not().Where(genreid, CondEq, 1);
@@ -204,6 +205,98 @@ TEST_F(JoinSelectsApi, LeftJoinTest) {
 	}
 }
 
+TEST_F(JoinSelectsApi, HashJoinTest) {
+	auto joinStrategy = [](const reindexer::QueryResults& qr) {
+		gason::JsonParser parser;
+		auto root = parser.Parse(reindexer::string_view(qr.GetExplainResults()));
+		for (auto& selector : root["selectors"]) {
+			if (selector["join_strategy"].empty()) continue;
+			return selector["join_strategy"].As<std::string>();
+		}
+		return std::string();
+	};
+
+	Query booksQuery = Query(books_namespace).Where(price, CondGe, 500);
+	Query joinQuery = Query(authors_namespace).LeftJoin(authorid, authorid_fk, CondEq, booksQuery).Explain();
+
+	reindexer::QueryResults joinQueryRes;
+	Error err = rt.reindexer->Select(joinQuery, joinQueryRes);
+	ASSERT_TRUE(err.ok()) << err.what();
+	EXPECT_EQ(joinStrategy(joinQueryRes), "hash");
+
+	// Hash join returns the same items, as select from the right namespace for each left item
+	for (auto rowIt : joinQueryRes) {
+		Item authorsItem(rowIt.GetItem());
+		Variant authorIdKeyRef = authorsItem[authorid];
+		reindexer::QueryResults booksRes;
+		err = rt.reindexer->Select(Query(booksQuery).Where(authorid_fk, CondEq, authorIdKeyRef), booksRes);
+		ASSERT_TRUE(err.ok()) << err.what();
+
+		auto itemIt = rowIt.GetJoinedItemsIterator();
+		const int joinedCount = itemIt.getJoinedItemsCount() ? itemIt.begin().ItemsCount() : 0;
+		std::unordered_set<int> joinedBookIds, bookIds;
+		for (int i = 0; i < joinedCount; ++i) {
+			reindexer::ItemImpl joinedItem(itemIt.begin().GetItem(i, joinQueryRes.getPayloadType(1), joinQueryRes.getTagsMatcher(1)));
+			joinedBookIds.insert(static_cast<int>(joinedItem.GetField(joinQueryRes.getPayloadType(1).FieldByName(bookid))));
+		}
+		for (auto bookIt : booksRes) bookIds.insert(bookIt.GetItem()[bookid].Get<int>());
+		EXPECT_EQ(joinedBookIds, bookIds);
+	}
+
+	// Sorted inner join is executed by nested loop
+	reindexer::QueryResults sortedJoinQueryRes;
+	err = rt.reindexer->Select(
+		Query(authors_namespace).InnerJoin(authorid, authorid_fk, CondEq, Query(booksQuery).Sort(price, true)).Explain(), sortedJoinQueryRes);
+	ASSERT_TRUE(err.ok()) << err.what();
+	EXPECT_EQ(joinStrategy(sortedJoinQueryRes), "nested_loop");
+
+	// Hash table is not built for the few left items, selected by filter of left query
+	Item firstAuthor = joinQueryRes.begin().GetItem();
+	const Variant firstAuthorId = firstAuthor[authorid];
+	reindexer::QueryResults filteredJoinQueryRes;
+	err = rt.reindexer->Select(
+		Query(authors_namespace).Where(authorid, CondEq, firstAuthorId).InnerJoin(authorid, authorid_fk, CondEq, booksQuery).Explain(),
+		filteredJoinQueryRes);
+	ASSERT_TRUE(err.ok()) << err.what();
+	EXPECT_EQ(joinStrategy(filteredJoinQueryRes), "nested_loop");
+	reindexer::QueryResults booksRes;
+	err = rt.reindexer->Select(Query(booksQuery).Where(authorid_fk, CondEq, firstAuthorId), booksRes);
+	ASSERT_TRUE(err.ok()) << err.what();
+	if (booksRes.Count()) {
+		ASSERT_EQ(filteredJoinQueryRes.Count(), 1);
+		auto itemIt = filteredJoinQueryRes.begin().GetJoinedItemsIterator();
+		EXPECT_EQ(itemIt.begin().ItemsCount(), int(booksRes.Count()));
+	} else {
+		EXPECT_EQ(filteredJoinQueryRes.Count(), 0);
+	}
+}
+
+TEST_F(JoinSelectsApi, BatchedLeftJoinTest) {
+	Query booksQuery = Query(books_namespace).Where(price, CondGe, 500).Sort(price, true);
+	reindexer::QueryResults joinQueryRes;
+	Error err =
+		rt.reindexer->Select(Query(authors_namespace).LeftJoin(authorid, authorid_fk, CondEq, Query(booksQuery).Limit(3)).Explain(), joinQueryRes);
+	ASSERT_TRUE(err.ok()) << err.what();
+	EXPECT_NE(joinQueryRes.GetExplainResults().find("\"join_strategy\":\"batched\""), std::string::npos) << joinQueryRes.GetExplainResults();
+
+	// Batched join returns the same items in the same order, as sorted select from the right namespace for each left item
+	for (auto rowIt : joinQueryRes) {
+		Variant authorIdKeyRef = rowIt.GetItem()[authorid];
+		reindexer::QueryResults booksRes;
+		err = rt.reindexer->Select(Query(booksQuery).Where(authorid_fk, CondEq, authorIdKeyRef).Limit(3), booksRes);
+		ASSERT_TRUE(err.ok()) << err.what();
+
+		auto itemIt = rowIt.GetJoinedItemsIterator();
+		const int joinedCount = itemIt.getJoinedItemsCount() ? itemIt.begin().ItemsCount() : 0;
+		ASSERT_EQ(joinedCount, int(booksRes.Count()));
+		for (int i = 0; i < joinedCount; ++i) {
+			reindexer::ItemImpl joinedItem(itemIt.begin().GetItem(i, joinQueryRes.getPayloadType(1), joinQueryRes.getTagsMatcher(1)));
+			EXPECT_EQ(static_cast<int>(joinedItem.GetField(joinQueryRes.getPayloadType(1).FieldByName(price))),
+					  booksRes[i].GetItem()[price].Get<int>());
+		}
+	}
+}
+
 TEST_F(JoinSelectsApi, OrInnerJoinTest) {
 	Query queryGenres(genres_namespace);
 	Query queryAuthors(authors_namespace);
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+#include "core/maintenancescheduler.h"
+
+using reindexer::MaintenanceScheduler;
+
+static bool waitFor(const std::function<bool()> &cond, std::chrono::milliseconds timeout = std::chrono::seconds(5)) {
+	const auto deadline = std::chrono::steady_clock::now() + timeout;
+	while (!cond()) {
+		if (std::chrono::steady_clock::now() > deadline) return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+TEST(MaintenanceSchedulerTest, TasksAreRescheduled) {
+	MaintenanceScheduler scheduler(2);
+	int owner;
+	std::atomic<int> flushes{0}, optimizations{0};
+	scheduler.Add(&owner, reindexer::MaintenanceFlush, [&]() {
+		flushes++;
+		return std::chrono::milliseconds(1);
+	});
+	scheduler.Add(&owner, reindexer::MaintenanceOptimize, [&]() {
+		optimizations++;
+		return std::chrono::milliseconds(1);
+	});
+	// Repeated add of task of the same type is ignored
+	scheduler.Add(&owner, reindexer::MaintenanceFlush, []() -> std::chrono::milliseconds { throw std::runtime_error("unexpected"); });
+	ASSERT_TRUE(waitFor([&]() { return flushes > 3 && optimizations > 3; }));
+
+	auto stat = scheduler.GetStat(&owner);
+	ASSERT_EQ(stat.tasks.size(), 2);
+	EXPECT_EQ(stat.tasks[0].type, "flush");
+	EXPECT_GT(stat.tasks[0].totalCount, 0);
+	EXPECT_EQ(stat.tasks[1].type, "optimize");
+
+	scheduler.Remove(&owner);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	const int flushesAfterRemove = flushes;
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	EXPECT_EQ(flushes, flushesAfterRemove);
+	EXPECT_TRUE(scheduler.GetStat(&owner).tasks.empty());
+}
+
+TEST(MaintenanceSchedulerTest, LongTaskDoesNotDelayOthers) {
+	MaintenanceScheduler scheduler(2);
+	int slowOwner, fastOwner;
+	std::atomic<bool> stopSlow{false};
+	std::atomic<int> fastRuns{0};
+	scheduler.Add(&slowOwner, reindexer::MaintenanceOptimize, [&]() {
+		while (!stopSlow) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		return std::chrono::milliseconds(1000);
+	});
+	scheduler.Add(&fastOwner, reindexer::MaintenanceFlush, [&]() {
+		fastRuns++;
+		return std::chrono::milliseconds(1);
+	});
+	EXPECT_TRUE(waitFor([&]() { return fastRuns > 10; }));
+	stopSlow = true;
+}
+
+TEST(MaintenanceSchedulerTest, Parallel) {
+	MaintenanceScheduler scheduler(4);
+	constexpr unsigned kParts = 16;
+	std::atomic<unsigned> calls[kParts];
+	for (auto &c : calls) c = 0;
+	scheduler.Parallel(kParts, [&](unsigned i) { calls[i]++; });
+	for (auto &c : calls) EXPECT_EQ(c, 1);
+
+	EXPECT_THROW(scheduler.Parallel(kParts,
+									[](unsigned i) {
+										if (i == 5) throw std::runtime_error("part failed");
+									}),
+				 std::runtime_error);
+
+	// Parallel is usable after scheduler is stopped: all the parts are called by the caller
+	scheduler.Stop();
+	unsigned count = 0;
+	scheduler.Parallel(kParts, [&](unsigned) { count++; });
+	EXPECT_EQ(count, kParts);
+}
@@ -1,6 +1,9 @@
 #include <chrono>
+#include <thread>
+#include "core/cjson/jsonbuilder.h"
 #include "ns_api.h"
 #include "tools/serializer.h"
+#include "vendor/gason/gason.h"
 
 TEST_F(NsApi, IndexDrop) {
 	Error err = rt.reindexer->OpenNamespace(default_namespace);
@@ -654,3 +657,786 @@ TEST_F(NsApi, TestUpdateFieldWithExpressions) {
 		++i;
 	}
 }
+
+TEST_F(NsApi, TransactionOnNamespaceCopy) {
+	Error err = rt.reindexer->InitSystemNamespaces();
+	ASSERT_TRUE(err.ok()) << err.what();
+	DefineDefaultNamespace();
+	FillDefaultNamespace();
+
+	// Make transactions with more than 100 steps to be applied on the namespace copy
+	reindexer::WrSerializer ser;
+	reindexer::JsonBuilder jb(ser);
+	jb.Put("type", "namespaces");
+	auto nsArray = jb.Array("namespaces");
+	auto nsConf = nsArray.Object();
+	nsConf.Put("namespace", default_namespace);
+	nsConf.Put("start_copy_politics_count", 100);
+	nsConf.End();
+	nsArray.End();
+	jb.End();
+	Item cfgItem = NewItem("#config");
+	ASSERT_TRUE(cfgItem.Status().ok()) << cfgItem.Status().what();
+	err = cfgItem.FromJSON(ser.Slice());
+	ASSERT_TRUE(err.ok()) << err.what();
+	Upsert("#config", cfgItem);
+
+	auto tr = rt.reindexer->NewTransaction(default_namespace);
+	ASSERT_TRUE(tr.Status().ok()) << tr.Status().what();
+	for (int i = 500; i < 1500; ++i) {
+		Item item = tr.NewItem();
+		item[idIdxName] = i;
+		item[intField] = i * 2;
+		item[boolField] = false;
+		item[doubleField] = 1.5;
+		item[stringField] = std::to_string(i);
+		tr.Upsert(std::move(item));
+	}
+	Query delQuery(default_namespace);
+	delQuery.Where(idIdxName, CondLt, 100);
+	delQuery.type_ = QueryDelete;
+	tr.Modify(std::move(delQuery));
+	err = rt.reindexer->CommitTransaction(tr);
+	ASSERT_TRUE(err.ok()) << err.what();
+
+	QueryResults qr;
+	err = rt.reindexer->Select(Query(default_namespace).Sort(idIdxName, false), qr);
+	ASSERT_TRUE(err.ok()) << err.what();
+	ASSERT_EQ(qr.Count(), 1400);
+	int expectedId = 100;
+	for (auto &it : qr) {
+		Item item = it.GetItem();
+		int id = item[idIdxName].As<int>();
+		ASSERT_EQ(id, expectedId++);
+		ASSERT_EQ(item[intField].As<int>(), id < 500 ? id : id * 2);
+	}
+
+	// Namespace must be still writable after the swap
+	Item item = NewItem(default_namespace);
+	item[idIdxName] = 5000;
+	item[intField] = 5000;
+	Upsert(default_namespace, item);
+	qr.Clear();
+	err = rt.reindexer->Select(Query(default_namespace).Where(intField, CondEq, 5000), qr);
+	ASSERT_TRUE(err.ok()) << err.what();
+	ASSERT_EQ(qr.Count(), 1);
+}
+
+TEST_F(NsApi, ParallelSelectLoop) {
+	const std::string ns = "parallel_select_ns";
+	Error err = rt.reindexer->OpenNamespace(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+	DefineNamespaceDataset(ns, {IndexDeclaration{idIdxName.c_str(), "hash", "int", IndexOpts().PK(), 0},
+								IndexDeclaration{"year", "tree", "int", IndexOpts(), 0},
+								IndexDeclaration{"genre", "-", "int64", IndexOpts(), 0}});
+
+	// Namespace must be big enough to make select loop parallel
+	const int itemsCount = 250000;
+	for (int i = 0; i < itemsCount; ++i) {
+		Item item = NewItem(ns);
+		ASSERT_TRUE(item.Status().ok()) << item.Status().what();
+		item[idIdxName] = i;
+		item["year"] = 1900 + rand() % 120;
+		item["genre"] = int64_t(rand() % 10);
+		Upsert(ns, item);
+	}
+	err = Commit(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+
+	const std::vector<Query> queries = {
+		Query(ns, 50, 100, ModeAccurateTotal).Where("genre", CondEq, 3),
+		Query(ns, 10, 20, ModeAccurateTotal).Where("genre", CondLt, 5).Sort("year", true),
+		Query(ns, 0, 30).Where("genre", CondGt, 2).Sort("genre", false),
+		Query(ns).Where("genre", CondSet, {1, 4, 7}).Where("year", CondGe, 1950),
+		Query(ns, 0, UINT_MAX).Where("genre", CondGt, 2).Aggregate(AggSum, {"year"}).Aggregate(AggFacet, {"genre"}),
+	};
+	for (const Query &q : queries) {
+		QueryResults serialQr, parallelQr;
+		err = rt.reindexer->Select(q, serialQr);
+		ASSERT_TRUE(err.ok()) << err.what();
+		err = rt.reindexer->Select(Query(q).Parallel(), parallelQr);
+		ASSERT_TRUE(err.ok()) << err.what();
+
+		ASSERT_EQ(serialQr.Count(), parallelQr.Count()) << q.GetSQL();
+		EXPECT_EQ(serialQr.totalCount, parallelQr.totalCount) << q.GetSQL();
+		for (size_t i = 0; i < serialQr.Count(); ++i) {
+			ASSERT_EQ(serialQr.Items()[i].id, parallelQr.Items()[i].id) << q.GetSQL();
+		}
+		ASSERT_EQ(serialQr.aggregationResults.size(), parallelQr.aggregationResults.size()) << q.GetSQL();
+		for (size_t i = 0; i < serialQr.aggregationResults.size(); ++i) {
+			const auto &serialAgg = serialQr.aggregationResults[i];
+			const auto &parallelAgg = parallelQr.aggregationResults[i];
+			EXPECT_DOUBLE_EQ(serialAgg.value, parallelAgg.value) << q.GetSQL();
+			ASSERT_EQ(serialAgg.facets.size(), parallelAgg.facets.size()) << q.GetSQL();
+			for (size_t j = 0; j < serialAgg.facets.size(); ++j) {
+				EXPECT_EQ(serialAgg.facets[j].values, parallelAgg.facets[j].values) << q.GetSQL();
+				EXPECT_EQ(serialAgg.facets[j].count, parallelAgg.facets[j].count) << q.GetSQL();
+			}
+		}
+	}
+
+	// Concurrent parallel queries share the bounded pool of select workers
+	QueryResults expectedQr;
+	err = rt.reindexer->Select(queries[3], expectedQr);
+	ASSERT_TRUE(err.ok()) << err.what();
+	std::atomic<int> failedCount{0};
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 4; ++i) {
+		threads.emplace_back([&]() {
+			QueryResults qr;
+			Error err = rt.reindexer->Select(Query(queries[3]).Parallel(), qr);
+			if (!err.ok() || qr.Count() != expectedQr.Count()) ++failedCount;
+		});
+	}
+	for (auto &thread : threads) thread.join();
+	EXPECT_EQ(failedCount, 0);
+
+	// Parts of parallel loop check cancellation of query
+	class CancelAfterChecksContext : public reindexer::IRdxCancelContext {
+	public:
+		reindexer::CancelType GetCancelType() const noexcept override {
+			return ++checksCount_ > 3 ? reindexer::CancelType::Explicit : reindexer::CancelType::None;
+		}
+		bool IsCancelable() const noexcept override { return true; }
+
+	private:
+		mutable std::atomic<int> checksCount_{0};
+	} cancelCtx;
+	QueryResults canceledQr;
+	err = rt.reindexer->WithContext(&cancelCtx).Select(Query(ns).Where("genre", CondGe, 0).Parallel(), canceledQr);
+	EXPECT_EQ(err.code(), errCanceled) << err.what();
+}
+
+TEST_F(NsApi, ColumnScanSelect) {
+	const std::string ns = "column_scan_ns";
+	Error err = rt.reindexer->OpenNamespace(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+	DefineNamespaceDataset(ns, {IndexDeclaration{idIdxName.c_str(), "hash", "int", IndexOpts().PK(), 0},
+								IndexDeclaration{"int_col", "-", "int", IndexOpts(), 0},
+								IndexDeclaration{"int64_col", "-", "int64", IndexOpts(), 0},
+								IndexDeclaration{"double_col", "-", "double", IndexOpts(), 0},
+								IndexDeclaration{"bool_col", "-", "bool", IndexOpts(), 0}});
+
+	struct Row {
+		int intVal;
+		int64_t int64Val;
+		double doubleVal;
+		bool boolVal;
+	};
+	const int itemsCount = 5000;
+	std::map<int, Row> rows;
+	for (int i = 0; i < itemsCount; ++i) {
+		const Row row{rand() % 100 - 50, int64_t(rand() % 1000) * 1000000000LL, double(rand() % 400) / 4, rand() % 2 == 0};
+		Item item = NewItem(ns);
+		ASSERT_TRUE(item.Status().ok()) << item.Status().what();
+		item[idIdxName] = i;
+		item["int_col"] = row.intVal;
+		item["int64_col"] = row.int64Val;
+		item["double_col"] = row.doubleVal;
+		item["bool_col"] = row.boolVal;
+		Upsert(ns, item);
+		rows.emplace(i, row);
+	}
+	// Deleted items have to be skipped by column scan
+	for (int i = 0; i < itemsCount; i += 7) {
+		QueryResults qr;
+		err = rt.reindexer->Delete(Query(ns).Where(idIdxName, CondEq, i), qr);
+		ASSERT_TRUE(err.ok()) << err.what();
+		rows.erase(i);
+	}
+	err = Commit(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+
+	const std::vector<std::pair<Query, std::function<bool(const Row &)>>> queries = {
+		{Query(ns).Where("int_col", CondEq, 10), [](const Row &r) { return r.intVal == 10; }},
+		{Query(ns).Where("int_col", CondLt, -20), [](const Row &r) { return r.intVal < -20; }},
+		{Query(ns).Where("int_col", CondGe, 0).Where("bool_col", CondEq, true),
+		 [](const Row &r) { return r.intVal >= 0 && r.boolVal; }},
+		{Query(ns).Where("int_col", CondSet, {-3, 5, 17, 200}), [](const Row &r) { return r.intVal == -3 || r.intVal == 5 || r.intVal == 17; }},
+		{Query(ns).Where("int64_col", CondRange, {int64_t(100000000000LL), int64_t(300000000000LL)}),
+		 [](const Row &r) { return r.int64Val >= 100000000000LL && r.int64Val <= 300000000000LL; }},
+		{Query(ns).Where("int64_col", CondGt, int64_t(900000000000LL)), [](const Row &r) { return r.int64Val > 900000000000LL; }},
+		{Query(ns).Where("double_col", CondGt, 50.25), [](const Row &r) { return r.doubleVal > 50.25; }},
+		{Query(ns).Where("double_col", CondLe, 10.5).Sort(idIdxName, true), [](const Row &r) { return r.doubleVal <= 10.5; }},
+		{Query(ns).Where("bool_col", CondEq, false).Where("int_col", CondGt, 40).Or().Where("double_col", CondLt, 1),
+		 [](const Row &r) { return !r.boolVal && (r.intVal > 40 || r.doubleVal < 1); }},
+		{Query(ns).Not().Where("int_col", CondLe, 0), [](const Row &r) { return !(r.intVal <= 0); }},
+	};
+	for (const auto &q : queries) {
+		QueryResults qr;
+		err = rt.reindexer->Select(q.first, qr);
+		ASSERT_TRUE(err.ok()) << err.what();
+
+		std::set<int> expected, actual;
+		for (const auto &row : rows) {
+			if (q.second(row.second)) expected.insert(row.first);
+		}
+		for (auto it : qr) {
+			Item item = it.GetItem();
+			ASSERT_TRUE(actual.insert(item[idIdxName].As<int>()).second) << q.first.GetSQL();
+		}
+		EXPECT_EQ(actual, expected) << q.first.GetSQL();
+	}
+}
+
+TEST_F(NsApi, BitmapIdsetSelect) {
+	const std::string ns = "bitmap_idset_ns";
+	Error err = rt.reindexer->InitSystemNamespaces();
+	ASSERT_TRUE(err.ok()) << err.what();
+	err = rt.reindexer->OpenNamespace(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+	// Large idsets of hash indexes are stored as bitmaps, and keep sort orders of tree index
+	DefineNamespaceDataset(ns, {IndexDeclaration{idIdxName.c_str(), "hash", "int", IndexOpts().PK(), 0},
+								IndexDeclaration{"a", "hash", "int", IndexOpts(), 0}, IndexDeclaration{"b", "hash", "int", IndexOpts(), 0},
+								IndexDeclaration{"c", "hash", "int", IndexOpts(), 0}, IndexDeclaration{"d", "tree", "int", IndexOpts(), 0}});
+	SetOptimizationTimeout(ns, 10);
+
+	struct Row {
+		int a, b, c, d;
+	};
+	const int itemsCount = 20000;
+	std::map<int, Row> rows;
+	for (int i = 0; i < itemsCount; ++i) {
+		const Row row{rand() % 2, rand() % 3, rand() % 50, rand() % 1000};
+		Item item = NewItem(ns);
+		ASSERT_TRUE(item.Status().ok()) << item.Status().what();
+		item[idIdxName] = i;
+		item["a"] = row.a;
+		item["b"] = row.b;
+		item["c"] = row.c;
+		item["d"] = row.d;
+		Upsert(ns, item);
+		rows.emplace(i, row);
+	}
+	err = Commit(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+	for (int i = 0; i < 500 && !SortOrdersBuilt(ns, "d"); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	ASSERT_TRUE(SortOrdersBuilt(ns, "d"));
+
+	const std::vector<std::pair<Query, std::function<bool(const Row &)>>> queries = {
+		{Query(ns).Where("a", CondEq, 1), [](const Row &r) { return r.a == 1; }},
+		{Query(ns).Where("a", CondEq, 1).Where("b", CondEq, 2), [](const Row &r) { return r.a == 1 && r.b == 2; }},
+		{Query(ns).Where("a", CondEq, 0).Not().Where("b", CondEq, 0), [](const Row &r) { return r.a == 0 && r.b != 0; }},
+		{Query(ns).Where("a", CondEq, 0).Where("b", CondSet, {0, 2}).Where("c", CondLt, 10),
+		 [](const Row &r) { return r.a == 0 && (r.b == 0 || r.b == 2) && r.c < 10; }},
+		{Query(ns).Where("b", CondEq, 1).Where("a", CondEq, 1).Or().Where("c", CondEq, 7),
+		 [](const Row &r) { return r.b == 1 && (r.a == 1 || r.c == 7); }},
+		{Query(ns).Where("a", CondEq, 1).Not().Where("b", CondEq, 1).Sort(idIdxName, true),
+		 [](const Row &r) { return r.a == 1 && r.b != 1; }},
+		{Query(ns).Not().Where("a", CondEq, 1).Not().Where("b", CondEq, 1), [](const Row &r) { return r.a != 1 && r.b != 1; }},
+		{Query(ns).Where("a", CondEq, 1).Where("b", CondEq, 2).Sort("d", false), [](const Row &r) { return r.a == 1 && r.b == 2; }},
+		{Query(ns).Where("b", CondSet, {0, 1}).Sort("d", true), [](const Row &r) { return r.b == 0 || r.b == 1; }},
+	};
+	auto check = [&]() {
+		for (const auto &q : queries) {
+			QueryResults qr;
+			err = rt.reindexer->Select(q.first, qr);
+			ASSERT_TRUE(err.ok()) << err.what();
+
+			std::set<int> expected, actual;
+			for (const auto &row : rows) {
+				if (q.second(row.second)) expected.insert(row.first);
+			}
+			const std::string sortField = q.first.sortingEntries_.empty() ? idIdxName : q.first.sortingEntries_[0].column;
+			std::vector<int> sortValues;
+			for (auto it : qr) {
+				Item item = it.GetItem();
+				ASSERT_TRUE(actual.insert(item[idIdxName].As<int>()).second) << q.first.GetSQL();
+				sortValues.push_back(item[sortField].As<int>());
+			}
+			EXPECT_EQ(actual, expected) << q.first.GetSQL();
+			if (!q.first.sortingEntries_.empty()) {
+				if (q.first.sortingEntries_[0].desc) std::reverse(sortValues.begin(), sortValues.end());
+				EXPECT_TRUE(std::is_sorted(sortValues.begin(), sortValues.end())) << q.first.GetSQL();
+			}
+		}
+	};
+	check();
+
+	// Modifications have to unpack bitmaps
+	for (int i = 0; i < itemsCount; i += 5) {
+		QueryResults qr;
+		err = rt.reindexer->Delete(Query(ns).Where(idIdxName, CondEq, i), qr);
+		ASSERT_TRUE(err.ok()) << err.what();
+		rows.erase(i);
+	}
+	err = Commit(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+	check();
+}
+
+TEST_F(NsApi, ItemsArenaCompaction) {
+	const std::string ns = "arena_compaction_ns";
+	Error err = rt.reindexer->InitSystemNamespaces();
+	ASSERT_TRUE(err.ok()) << err.what();
+	err = rt.reindexer->OpenNamespace(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+	DefineNamespaceDataset(ns, {IndexDeclaration{idIdxName.c_str(), "hash", "int", IndexOpts().PK(), 0},
+								IndexDeclaration{"value", "tree", "int", IndexOpts(), 0}});
+
+	auto arenaStat = [&](const char *field) {
+		QueryResults qr;
+		Error err = rt.reindexer->Select(Query("#memstats").Where("name", CondEq, ns), qr);
+		EXPECT_TRUE(err.ok()) << err.what();
+		EXPECT_EQ(qr.Count(), 1);
+		reindexer::WrSerializer ser;
+		err = qr.begin().GetJSON(ser, false);
+		EXPECT_TRUE(err.ok()) << err.what();
+		gason::JsonParser parser;
+		return parser.Parse(ser.Slice())["arena"][field].As<int64_t>();
+	};
+
+	const int itemsCount = 50000;
+	for (int i = 0; i < itemsCount; ++i) {
+		Item item = NewItem(ns);
+		ASSERT_TRUE(item.Status().ok()) << item.Status().what();
+		item[idIdxName] = i;
+		item["value"] = i;
+		Upsert(ns, item);
+	}
+	err = Commit(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+	EXPECT_EQ(arenaStat("blocks_count"), itemsCount);
+	const int64_t totalSize = arenaStat("total_size");
+	EXPECT_GT(totalSize, 0);
+
+	// Deleted items leave sparse slabs, which are compacted by the background routine
+	for (int i = 0; i < itemsCount; ++i) {
+		if (i % 8 == 0) continue;
+		QueryResults qr;
+		err = rt.reindexer->Delete(Query(ns).Where(idIdxName, CondEq, i), qr);
+		ASSERT_TRUE(err.ok()) << err.what();
+	}
+	EXPECT_EQ(arenaStat("blocks_count"), itemsCount / 8);
+	for (int i = 0; i < 50 && arenaStat("total_size") * 2 > totalSize; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	EXPECT_LT(arenaStat("total_size") * 2, totalSize);
+
+	QueryResults qr;
+	err = rt.reindexer->Select(Query(ns).Where("value", CondGe, 0), qr);
+	ASSERT_TRUE(err.ok()) << err.what();
+	ASSERT_EQ(qr.Count(), itemsCount / 8);
+	for (auto it : qr) {
+		Item item = it.GetItem();
+		EXPECT_EQ(item[idIdxName].As<int>() % 8, 0);
+		EXPECT_EQ(item["value"].As<int>(), item[idIdxName].As<int>());
+	}
+}
+
+TEST_F(NsApi, QueryResultsCache) {
+	Error err = rt.reindexer->InitSystemNamespaces();
+	ASSERT_TRUE(err.ok()) << err.what();
+	DefineDefaultNamespace();
+	FillDefaultNamespace();
+
+	reindexer::WrSerializer ser;
+	reindexer::JsonBuilder jb(ser);
+	jb.Put("type", "namespaces");
+	auto nsArray = jb.Array("namespaces");
+	auto nsConf = nsArray.Object();
+	nsConf.Put("namespace", default_namespace);
+	nsConf.Put("results_cache_size", 1 << 20);
+	nsConf.End();
+	nsArray.End();
+	jb.End();
+	Item cfgItem = NewItem("#config");
+	ASSERT_TRUE(cfgItem.Status().ok()) << cfgItem.Status().what();
+	err = cfgItem.FromJSON(ser.Slice());
+	ASSERT_TRUE(err.ok()) << err.what();
+	Upsert("#config", cfgItem);
+
+	auto cacheStat = [&](const char *field) {
+		QueryResults qr;
+		Error err = rt.reindexer->Select(Query("#memstats").Where("name", CondEq, default_namespace), qr);
+		EXPECT_TRUE(err.ok()) << err.what();
+		EXPECT_EQ(qr.Count(), 1);
+		reindexer::WrSerializer ser;
+		err = qr.begin().GetJSON(ser, false);
+		EXPECT_TRUE(err.ok()) << err.what();
+		gason::JsonParser parser;
+		return parser.Parse(ser.Slice())["results_cache"][field].As<int64_t>();
+	};
+	// Selects query several times, and checks that results are the same, as the results of uncached query
+	const Query query = Query(default_namespace).Where(intField, CondLt, 100).Sort(doubleField, true).Limit(20).ReqTotal();
+	auto check = [&](int expectedTotal) {
+		QueryResults expected;
+		// Explain queries are not cached
+		err = rt.reindexer->Select(Query(query).Explain(), expected);
+		ASSERT_TRUE(err.ok()) << err.what();
+		ASSERT_EQ(expected.totalCount, expectedTotal);
+		for (int i = 0; i < 3; ++i) {
+			QueryResults qr;
+			err = rt.reindexer->Select(query, qr);
+			ASSERT_TRUE(err.ok()) << err.what();
+			ASSERT_EQ(qr.Count(), expected.Count());
+			EXPECT_EQ(qr.totalCount, expected.totalCount);
+			for (size_t j = 0; j < qr.Count(); ++j) {
+				reindexer::WrSerializer json, expectedJson;
+				err = qr[j].GetJSON(json, false);
+				ASSERT_TRUE(err.ok()) << err.what();
+				err = expected[j].GetJSON(expectedJson, false);
+				ASSERT_TRUE(err.ok()) << err.what();
+				EXPECT_EQ(json.Slice(), expectedJson.Slice());
+			}
+		}
+	};
+
+	check(100);
+	int64_t hits = cacheStat("hits_count");
+	EXPECT_GT(hits, 0);
+
+	// Update of the field, which query doesn't depend on, keeps results in cache
+	QueryResults qrUpdate;
+	Query updateQuery = Query(default_namespace).Where(intField, CondLt, 50);
+	updateQuery.updateFields_.push_back({stringField, {Variant("updated")}});
+	err = rt.reindexer->Update(updateQuery, qrUpdate);
+	ASSERT_TRUE(err.ok()) << err.what();
+	check(100);
+	EXPECT_GE(cacheStat("hits_count"), hits + 3);
+	hits = cacheStat("hits_count");
+
+	// Upsert of the whole item with the same values of query fields keeps results as well
+	QueryResults qrItem;
+	err = rt.reindexer->Select(Query(default_namespace).Where(idIdxName, CondEq, 10), qrItem);
+	ASSERT_TRUE(err.ok()) << err.what();
+	ASSERT_EQ(qrItem.Count(), 1);
+	reindexer::WrSerializer itemJson;
+	err = qrItem.begin().GetJSON(itemJson, false);
+	ASSERT_TRUE(err.ok()) << err.what();
+	Item item = NewItem(default_namespace);
+	ASSERT_TRUE(item.Status().ok()) << item.Status().what();
+	err = item.FromJSON(itemJson.Slice());
+	ASSERT_TRUE(err.ok()) << err.what();
+	item[stringField] = "upserted";
+	Upsert(default_namespace, item);
+	check(100);
+	EXPECT_GE(cacheStat("hits_count"), hits + 3);
+
+	// Update of the field, which query depends on, and insert of the new item invalidate results
+	Query updateSortQuery = Query(default_namespace).Where(idIdxName, CondLt, 10);
+	updateSortQuery.updateFields_.push_back({doubleField, {Variant(1000.0)}});
+	qrUpdate.Clear();
+	err = rt.reindexer->Update(updateSortQuery, qrUpdate);
+	ASSERT_TRUE(err.ok()) << err.what();
+	check(100);
+
+	item = NewItem(default_namespace);
+	ASSERT_TRUE(item.Status().ok()) << item.Status().what();
+	item[idIdxName] = 5000;
+	item[intField] = -1;
+	item[doubleField] = 2000.0;
+	Upsert(default_namespace, item);
+	check(101);
+
+	err = rt.reindexer->TruncateNamespace(default_namespace);
+	ASSERT_TRUE(err.ok()) << err.what();
+	check(0);
+}
+
+TEST_F(NsApi, SortOrdersUpdate) {
+	Error err = rt.reindexer->InitSystemNamespaces();
+	ASSERT_TRUE(err.ok()) << err.what();
+	const std::string ns = "sort_orders_update_ns";
+	err = rt.reindexer->OpenNamespace(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+	DefineNamespaceDataset(ns, {IndexDeclaration{idIdxName.c_str(), "hash", "int", IndexOpts().PK(), 0},
+								IndexDeclaration{"year", "tree", "int", IndexOpts(), 0},
+								IndexDeclaration{"name", "tree", "string", IndexOpts(), 0},
+								IndexDeclaration{"year+name", "tree", "composite", IndexOpts(), 0}});
+
+	std::map<int, std::pair<int, std::string>> rows;
+	auto upsertRow = [&](int id, int year, const std::string &name) {
+		Item item = NewItem(ns);
+		ASSERT_TRUE(item.Status().ok()) << item.Status().what();
+		item[idIdxName] = id;
+		item["year"] = year;
+		item["name"] = name;
+		Upsert(ns, item);
+		rows[id] = {year, name};
+	};
+	auto randName = []() { return "name_" + std::to_string(rand() % 500); };
+
+	SetOptimizationTimeout(ns, 10);
+	for (int i = 0; i < 3000; ++i) upsertRow(i, rand() % 100, randName());
+	err = Commit(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+
+	auto sortOrdersBuilt = [&]() { return SortOrdersBuilt(ns, "year"); };
+	for (int i = 0; i < 500 && !sortOrdersBuilt(); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	ASSERT_TRUE(sortOrdersBuilt());
+	// Sort orders must not be rebuilt by optimization during the rest of the test
+	SetOptimizationTimeout(ns, 1000000);
+
+	using SortKey = std::pair<int, std::string>;
+	struct SortedQuery {
+		Query query;
+		std::function<bool(const SortKey &)> filter;
+		std::function<SortKey(const SortKey &)> key;
+		bool desc;
+	};
+	const std::vector<SortedQuery> queries = {
+		{Query(ns).Sort("year", false), [](const SortKey &) { return true; }, [](const SortKey &r) { return SortKey{r.first, ""}; }, false},
+		{Query(ns).Sort("name", true), [](const SortKey &) { return true; }, [](const SortKey &r) { return SortKey{0, r.second}; }, true},
+		{Query(ns).Sort("year+name", false), [](const SortKey &) { return true; }, [](const SortKey &r) { return r; }, false},
+		{Query(ns, 10, 30).Where("year", CondGt, 50).Sort("year", true), [](const SortKey &r) { return r.first > 50; },
+		 [](const SortKey &r) { return SortKey{r.first, ""}; }, true},
+	};
+	auto check = [&]() {
+		ASSERT_TRUE(sortOrdersBuilt());
+		for (const auto &q : queries) {
+			std::vector<SortKey> expected;
+			for (const auto &row : rows) {
+				if (q.filter(row.second)) expected.push_back(q.key(row.second));
+			}
+			std::sort(expected.begin(), expected.end());
+			if (q.desc) std::reverse(expected.begin(), expected.end());
+			const size_t offset = std::min(size_t(q.query.start), expected.size());
+			const size_t count = std::min(size_t(q.query.count), expected.size() - offset);
+			expected = std::vector<SortKey>(expected.begin() + offset, expected.begin() + offset + count);
+
+			QueryResults qr;
+			err = rt.reindexer->Select(q.query, qr);
+			ASSERT_TRUE(err.ok()) << err.what();
+			ASSERT_EQ(qr.Count(), expected.size()) << q.query.GetSQL();
+			size_t i = 0;
+			for (auto it : qr) {
+				Item item = it.GetItem();
+				const SortKey key = q.key({item["year"].As<int>(), item["name"].As<std::string>()});
+				ASSERT_EQ(key, expected[i]) << q.query.GetSQL() << ", position " << i;
+				++i;
+			}
+		}
+	};
+	check();
+
+	// Updates of sort fields
+	for (int i = 0; i < 300; ++i) upsertRow(rand() % 3000, rand() % 100, randName());
+	check();
+
+	// Inserts. Names are inserted between the same neighbours, so free positions between them are exhausted
+	for (int i = 0; i < 300; ++i) {
+		char name[32];
+		snprintf(name, sizeof(name), "name_250_%04d", 1000 - i);
+		upsertRow(3000 + i, rand() % 100, name);
+	}
+	check();
+
+	// Deletes
+	for (int i = 0; i < 3300; i += 11) {
+		QueryResults qr;
+		err = rt.reindexer->Delete(Query(ns).Where(idIdxName, CondEq, i), qr);
+		ASSERT_TRUE(err.ok()) << err.what();
+		rows.erase(i);
+	}
+	check();
+
+	// Update by query
+	QueryResults qrUpdate;
+	Query updateQuery = Query(ns).Where(idIdxName, CondLt, 500);
+	updateQuery.updateFields_.push_back({"year", {Variant(1000)}});
+	err = rt.reindexer->Update(updateQuery, qrUpdate);
+	ASSERT_TRUE(err.ok()) << err.what();
+	for (auto &row : rows) {
+		if (row.first < 500) row.second.first = 1000;
+	}
+	check();
+}
+
+TEST_F(NsApi, SortOrdersUpdateLowCardinality) {
+	Error err = rt.reindexer->InitSystemNamespaces();
+	ASSERT_TRUE(err.ok()) << err.what();
+	const std::string ns = "sort_orders_low_cardinality_ns";
+	err = rt.reindexer->OpenNamespace(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+	// Idsets of low cardinality index are large, and they are stored as bitmaps
+	DefineNamespaceDataset(ns, {IndexDeclaration{idIdxName.c_str(), "hash", "int", IndexOpts().PK(), 0},
+								IndexDeclaration{"category", "hash", "int", IndexOpts(), 0},
+								IndexDeclaration{"year", "tree", "int", IndexOpts(), 0}});
+
+	struct Row {
+		int category, year;
+	};
+	std::map<int, Row> rows;
+	auto upsertRow = [&](int id, const Row &row) {
+		Item item = NewItem(ns);
+		ASSERT_TRUE(item.Status().ok()) << item.Status().what();
+		item[idIdxName] = id;
+		item["category"] = row.category;
+		item["year"] = row.year;
+		Upsert(ns, item);
+		rows[id] = row;
+	};
+	auto bitmapSize = [&]() {
+		QueryResults qr;
+		Error err = rt.reindexer->Select(Query("#memstats").Where("name", CondEq, ns), qr);
+		EXPECT_TRUE(err.ok()) << err.what();
+		EXPECT_EQ(qr.Count(), 1);
+		reindexer::WrSerializer ser;
+		err = qr.begin().GetJSON(ser, false);
+		EXPECT_TRUE(err.ok()) << err.what();
+		gason::JsonParser parser;
+		for (auto &index : parser.Parse(ser.Slice())["indexes"]) {
+			if (index["name"].As<std::string>() == "category") return index["idset_bitmap_size"].As<int64_t>();
+		}
+		return int64_t(0);
+	};
+
+	const int itemsCount = 20000;
+	SetOptimizationTimeout(ns, 10);
+	for (int i = 0; i < itemsCount; ++i) upsertRow(i, Row{rand() % 2, rand() % 100});
+	err = Commit(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+
+	auto sortOrdersBuilt = [&]() { return SortOrdersBuilt(ns, "year"); };
+	for (int i = 0; i < 500 && !sortOrdersBuilt(); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	ASSERT_TRUE(sortOrdersBuilt());
+	ASSERT_GT(bitmapSize(), 0);
+	// Sort orders must not be rebuilt by optimization during the rest of the test
+	SetOptimizationTimeout(ns, 1000000);
+
+	const std::vector<std::pair<Query, std::function<bool(const Row &)>>> queries = {
+		{Query(ns).Where("category", CondEq, 1).Sort("year", false), [](const Row &r) { return r.category == 1; }},
+		{Query(ns).Where("category", CondEq, 0).Sort("year", true), [](const Row &r) { return r.category == 0; }},
+		{Query(ns).Where("category", CondSet, {0, 1}).Where("year", CondLt, 30).Sort("year", false),
+		 [](const Row &r) { return r.year < 30; }},
+	};
+	auto check = [&]() {
+		// Sort orders of large idsets have to be kept actual instead of rebuild
+		ASSERT_TRUE(sortOrdersBuilt());
+		EXPECT_GT(bitmapSize(), 0);
+		for (const auto &q : queries) {
+			QueryResults qr;
+			err = rt.reindexer->Select(q.first, qr);
+			ASSERT_TRUE(err.ok()) << err.what();
+
+			std::set<int> expected, actual;
+			for (const auto &row : rows) {
+				if (q.second(row.second)) expected.insert(row.first);
+			}
+			std::vector<int> years;
+			for (auto it : qr) {
+				Item item = it.GetItem();
+				ASSERT_TRUE(actual.insert(item[idIdxName].As<int>()).second) << q.first.GetSQL();
+				years.push_back(item["year"].As<int>());
+			}
+			EXPECT_EQ(actual, expected) << q.first.GetSQL();
+			if (q.first.sortingEntries_[0].desc) std::reverse(years.begin(), years.end());
+			EXPECT_TRUE(std::is_sorted(years.begin(), years.end())) << q.first.GetSQL();
+		}
+	};
+	check();
+
+	// Trickle updates: items are moved between large idsets and in sort order
+	for (int i = 0; i < 300; ++i) upsertRow(rand() % itemsCount, Row{rand() % 2, rand() % 100});
+	check();
+
+	// Inserts
+	for (int i = 0; i < 300; ++i) upsertRow(itemsCount + i, Row{rand() % 2, rand() % 100});
+	check();
+
+	// Deletes
+	for (int i = 0; i < 300; ++i) {
+		const int id = rand() % itemsCount;
+		QueryResults qr;
+		err = rt.reindexer->Delete(Query(ns).Where(idIdxName, CondEq, id), qr);
+		ASSERT_TRUE(err.ok()) << err.what();
+		rows.erase(id);
+	}
+	check();
+}
+
+TEST_F(NsApi, SortOrdersUpdateLargeIdsets) {
+	Error err = rt.reindexer->InitSystemNamespaces();
+	ASSERT_TRUE(err.ok()) << err.what();
+	const std::string ns = "sort_orders_large_idsets_ns";
+	err = rt.reindexer->OpenNamespace(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+	// Single-valued "category" (bitmap) and "group" (plain) idsets contain all items, and each of them has 4 sort orders
+	DefineNamespaceDataset(ns, {IndexDeclaration{idIdxName.c_str(), "hash", "int", IndexOpts().PK(), 0},
+								IndexDeclaration{"category", "hash", "int", IndexOpts(), 0},
+								IndexDeclaration{"group", "tree", "int", IndexOpts(), 0},
+								IndexDeclaration{"year", "tree", "int", IndexOpts(), 0},
+								IndexDeclaration{"rating", "tree", "int", IndexOpts(), 0},
+								IndexDeclaration{"name", "tree", "string", IndexOpts(), 0}});
+
+	struct Row {
+		int year, rating;
+		std::string name;
+	};
+	std::map<int, Row> rows;
+	auto randomRow = []() { return Row{rand() % 100, rand() % 100, "name" + std::to_string(rand() % 10000)}; };
+	auto upsertRow = [&](int id, const Row &row) {
+		Item item = NewItem(ns);
+		ASSERT_TRUE(item.Status().ok()) << item.Status().what();
+		item[idIdxName] = id;
+		item["category"] = 0;
+		item["group"] = 0;
+		item["year"] = row.year;
+		item["rating"] = row.rating;
+		item["name"] = row.name;
+		Upsert(ns, item);
+		rows[id] = row;
+	};
+
+	// Sort orders of idsets of this size were rebuilt on every update before
+	const int itemsCount = 270000;
+	SetOptimizationTimeout(ns, 10);
+	for (int i = 0; i < itemsCount; ++i) upsertRow(i, randomRow());
+	err = Commit(ns);
+	ASSERT_TRUE(err.ok()) << err.what();
+
+	auto sortOrdersBuilt = [&]() { return SortOrdersBuilt(ns, "year"); };
+	for (int i = 0; i < 3000 && !sortOrdersBuilt(); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	ASSERT_TRUE(sortOrdersBuilt());
+	// Sort orders must not be rebuilt by optimization during the rest of the test
+	SetOptimizationTimeout(ns, 1000000);
+
+	const std::vector<std::pair<Query, std::function<bool(const Row &)>>> queries = {
+		{Query(ns).Where("category", CondEq, 0).Where("year", CondLt, 3).Sort("name", false), [](const Row &r) { return r.year < 3; }},
+		{Query(ns).Where("group", CondEq, 0).Where("rating", CondLt, 3).Sort("year", true), [](const Row &r) { return r.rating < 3; }},
+		{Query(ns).Where("group", CondEq, 0).Where("year", CondEq, 50).Sort("rating", false), [](const Row &r) { return r.year == 50; }},
+	};
+	auto check = [&]() {
+		ASSERT_TRUE(sortOrdersBuilt());
+		for (const auto &q : queries) {
+			QueryResults qr;
+			err = rt.reindexer->Select(q.first, qr);
+			ASSERT_TRUE(err.ok()) << err.what();
+
+			std::set<int> expected, actual;
+			for (const auto &row : rows) {
+				if (q.second(row.second)) expected.insert(row.first);
+			}
+			const std::string sortField = q.first.sortingEntries_[0].column;
+			std::vector<Variant> values;
+			for (auto it : qr) {
+				Item item = it.GetItem();
+				ASSERT_TRUE(actual.insert(item[idIdxName].As<int>()).second) << q.first.GetSQL();
+				values.push_back(item[sortField].operator Variant());
+			}
+			EXPECT_EQ(actual, expected) << q.first.GetSQL();
+			if (q.first.sortingEntries_[0].desc) std::reverse(values.begin(), values.end());
+			EXPECT_TRUE(std::is_sorted(values.begin(), values.end())) << q.first.GetSQL();
+		}
+	};
+	check();
+
+	// Trickle updates: items are moved in sort orders of large idsets
+	for (int i = 0; i < 300; ++i) upsertRow(rand() % itemsCount, randomRow());
+	check();
+
+	// Inserts
+	for (int i = 0; i < 300; ++i) upsertRow(itemsCount + i, randomRow());
+	check();
+
+	// Deletes
+	for (int i = 0; i < 300; ++i) {
+		const int id = rand() % itemsCount;
+		QueryResults qr;
+		err = rt.reindexer->Delete(Query(ns).Where(idIdxName, CondEq, id), qr);
+		ASSERT_TRUE(err.ok()) << err.what();
+		rows.erase(id);
+	}
+	check();
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "core/payload/payloadarena.h"
+#include "core/payload/payloadvalue.h"
+
+using reindexer::PayloadArena;
+using reindexer::PayloadValue;
+
+static void fill(PayloadValue &pv, size_t size, int seed) {
+	for (size_t i = 0; i < size; ++i) pv.Ptr()[i] = uint8_t(seed + i);
+}
+
+static bool check(const PayloadValue &pv, size_t size, int seed) {
+	for (size_t i = 0; i < size; ++i) {
+		if (pv.Ptr()[i] != uint8_t(seed + i)) return false;
+	}
+	return true;
+}
+
+TEST(PayloadArena, CopyOnWrite) {
+	PayloadArena::Ptr arena(new PayloadArena);
+	PayloadValue pv(100, *arena);
+	EXPECT_GE(pv.GetCapacity(), 100u);
+	fill(pv, 100, 1);
+	pv.SetLSN(5);
+
+	PayloadValue copy(pv);
+	EXPECT_EQ(copy.get(), pv.get());
+	auto stat = arena->GetMemStat();
+	EXPECT_EQ(stat.blocksCount, 1u);
+	EXPECT_EQ(stat.slabsCount, 1u);
+
+	// Shared data is cloned to the same arena
+	copy.Clone();
+	EXPECT_NE(copy.get(), pv.get());
+	EXPECT_TRUE(check(copy, 100, 1));
+	EXPECT_EQ(copy.GetLSN(), 5);
+	EXPECT_EQ(PayloadArena::Of(copy.get()), arena.get());
+	EXPECT_EQ(arena->GetMemStat().blocksCount, 2u);
+
+	// Resize in place within block, and to the bigger block
+	copy.Resize(100, copy.GetCapacity());
+	copy.Resize(copy.GetCapacity(), 1000);
+	EXPECT_TRUE(check(copy, 100, 1));
+	EXPECT_EQ(arena->GetMemStat().blocksCount, 2u);
+
+	// Big payloads are not allocated in slabs
+	PayloadValue big(PayloadArena::kMaxBlockSize * 2, *arena);
+	EXPECT_EQ(arena->GetMemStat().blocksCount, 2u);
+
+	copy.Free();
+	EXPECT_EQ(arena->GetMemStat().blocksCount, 1u);
+	EXPECT_TRUE(check(pv, 100, 1));
+}
+
+TEST(PayloadArena, OutlivesOwner) {
+	PayloadArena::Ptr arena(new PayloadArena);
+	PayloadValue pv(64, *arena);
+	fill(pv, 64, 7);
+	PayloadValue copy(pv);
+	// Allocated blocks keep arena alive
+	arena = PayloadArena::Ptr();
+	copy.Clone();
+	EXPECT_TRUE(check(copy, 64, 7));
+	pv.Free();
+	EXPECT_TRUE(check(copy, 64, 7));
+}
+
+TEST(PayloadArena, Compaction) {
+	PayloadArena::Ptr arena(new PayloadArena);
+	const size_t kSize = 200;
+	const size_t kCount = 50000;
+	std::vector<PayloadValue> values;
+	values.reserve(kCount);
+	for (size_t i = 0; i < kCount; ++i) {
+		values.emplace_back(kSize, *arena);
+		fill(values.back(), kSize, i);
+	}
+	EXPECT_FALSE(arena->NeedsCompaction());
+
+	// Keep every 8th value, and share some of them in the first slabs
+	std::vector<PayloadValue> shared;
+	for (size_t i = 0; i < kCount; ++i) {
+		if (i % 8) {
+			values[i].Free();
+		} else if (i % 64 == 0 && i < 1024) {
+			shared.push_back(values[i]);
+		}
+	}
+	const auto before = arena->GetMemStat();
+	EXPECT_EQ(before.blocksCount, kCount / 8);
+	// Slabs are carved from regions
+	EXPECT_LE(before.regionsCount, before.slabsCount / PayloadArena::kRegionSlabs + 1);
+	EXPECT_TRUE(arena->NeedsCompaction());
+
+	ASSERT_TRUE(arena->BeginCompaction());
+	size_t moved = 0;
+	for (auto &pv : values) {
+		if (pv.Compact(*arena)) ++moved;
+	}
+	arena->EndCompaction();
+
+	const auto after = arena->GetMemStat();
+	EXPECT_GT(moved, 0u);
+	EXPECT_EQ(after.blocksCount, before.blocksCount);
+	EXPECT_EQ(after.usedSize, before.usedSize);
+	EXPECT_LT(after.totalSize * 2, before.totalSize);
+	EXPECT_FALSE(arena->NeedsCompaction());
+
+	for (size_t i = 0; i < kCount; i += 8) EXPECT_TRUE(check(values[i], kSize, i)) << i;
+	// Shared values are left in place
+	for (size_t i = 0; i < shared.size(); ++i) EXPECT_EQ(shared[i].get(), values[i * 64].get());
+}
+
+TEST(PayloadArena, ConcurrentAllocFree) {
+	PayloadArena::Ptr arena(new PayloadArena);
+	const int kThreads = 4;
+	const size_t kCount = 20000;
+	std::vector<std::thread> threads;
+	std::vector<std::vector<PayloadValue>> values(kThreads);
+	for (int t = 0; t < kThreads; ++t) {
+		threads.emplace_back([&, t]() {
+			auto &vals = values[t];
+			vals.reserve(kCount);
+			// Threads use both the same and different size classes
+			for (size_t i = 0; i < kCount; ++i) {
+				const size_t size = 32 + (i % 2 ? t * 100 : 0);
+				vals.emplace_back(size, *arena);
+				fill(vals.back(), size, t + i);
+				if (i % 3 == 0) vals[i / 2].Free();
+			}
+		});
+	}
+	for (auto &th : threads) th.join();
+
+	size_t alive = 0;
+	for (int t = 0; t < kThreads; ++t) {
+		for (size_t i = 0; i < kCount; ++i) {
+			if (!values[t][i].IsFree()) {
+				++alive;
+				EXPECT_TRUE(check(values[t][i], 32 + (i % 2 ? t * 100 : 0), t + i)) << t << ", " << i;
+			}
+		}
+	}
+	EXPECT_EQ(arena->GetMemStat().blocksCount, alive);
+
+	values.clear();
+	const auto stat = arena->GetMemStat();
+	EXPECT_EQ(stat.blocksCount, 0u);
+	EXPECT_EQ(stat.usedSize, 0u);
+	// Only the last empty slab of each size class is kept, and it holds its region
+	EXPECT_LE(stat.slabsCount, size_t(kThreads));
+	EXPECT_LE(stat.regionsCount, stat.slabsCount);
+}
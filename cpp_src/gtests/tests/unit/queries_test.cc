@@ -119,3 +119,179 @@ TEST_F(QueriesApi, QueriesSqlGenerate) {
 		"SELECT ID FROM test_namespace WHERE name LIKE 'something' AND (genre IN ('1','2','3') AND year > '2016') OR age IN "
 		"('1','2','3','4') LIMIT 10000000");
 }
+
+TEST_F(QueriesApi, SortWithLimit) {
+	FillDefaultNamespace(0, 3000, 20);
+
+	// Items of query with limit and offset must be equal to the slice of the items of the same query without limit
+	const auto check = [this](const Query& query, unsigned start, unsigned count) {
+		QueryResults fullQr;
+		Error err = rt.reindexer->Select(query, fullQr);
+		ASSERT_TRUE(err.ok()) << err.what();
+		for (bool parallel : {false, true}) {
+			Query limitedQuery(query);
+			limitedQuery.Offset(start).Limit(count).ReqTotal().Parallel(parallel);
+			QueryResults qr;
+			err = rt.reindexer->Select(limitedQuery, qr);
+			ASSERT_TRUE(err.ok()) << err.what();
+			EXPECT_EQ(qr.totalCount, fullQr.Count()) << limitedQuery.GetSQL();
+			ASSERT_EQ(qr.Count(), std::min<size_t>(count, fullQr.Count() > start ? fullQr.Count() - start : 0)) << limitedQuery.GetSQL();
+			for (size_t i = 0; i < qr.Count(); ++i) {
+				Item item = qr[i].GetItem();
+				Item expected = fullQr[start + i].GetItem();
+				EXPECT_EQ(item[kFieldNameId].As<int>(), expected[kFieldNameId].As<int>()) << limitedQuery.GetSQL() << " #" << i;
+			}
+		}
+	};
+
+	check(Query(default_namespace).Sort(kFieldNameAge, false), 0, 10);
+	check(Query(default_namespace).Sort(kFieldNameAge, true), 15, 20);
+	check(Query(default_namespace).Where(kFieldNameGenre, CondGe, 3).Sort(kFieldNameAge, false), 100, 50);
+	check(Query(default_namespace).Sort(kFieldNameGenre, true).Sort(kFieldNameName, false), 7, 30);
+	check(Query(default_namespace).Sort(kFieldNameAge, false).Sort(kFieldNameYear, true), 2990, 100);
+}
+
+TEST_F(QueriesApi, PreparedQueries) {
+	FillDefaultNamespace(0, 3000, 20);
+
+	const string sqlTemplate = "SELECT * FROM " + default_namespace +
+							   " WHERE age = ? AND genre = ? OR year > ? AND name IN (?, ?, 'unknown') ORDER BY year DESC LIMIT 100";
+	reindexer::PreparedQuery::Ptr prepared;
+	Error err = rt.reindexer->Prepare(sqlTemplate, prepared);
+	ASSERT_TRUE(err.ok()) << err.what();
+	ASSERT_TRUE(prepared);
+	EXPECT_EQ(prepared->PlaceholdersCount(), 5);
+
+	// Prepared query is cached by template
+	reindexer::PreparedQuery::Ptr preparedAgain;
+	err = rt.reindexer->Prepare(sqlTemplate, preparedAgain);
+	ASSERT_TRUE(err.ok()) << err.what();
+	EXPECT_EQ(prepared.get(), preparedAgain.get());
+
+	// Cache overflow evicts least recently used templates, and keeps the one, which is used often
+	for (int i = 0; i < 20000; ++i) {
+		reindexer::PreparedQuery::Ptr other;
+		err = rt.reindexer->Prepare("SELECT * FROM " + default_namespace + " WHERE id = ? AND year > " + std::to_string(i), other);
+		ASSERT_TRUE(err.ok()) << err.what();
+		if (i % 100 == 0) {
+			err = rt.reindexer->Prepare(sqlTemplate, preparedAgain);
+			ASSERT_TRUE(err.ok()) << err.what();
+			ASSERT_EQ(prepared.get(), preparedAgain.get()) << i;
+		}
+	}
+
+	// Results of prepared query must be the same, as the results of sql query with the same values
+	const auto check = [&](int age, int genre, int year, const string& name1, const string& name2) {
+		const string sql = "SELECT * FROM " + default_namespace + " WHERE age = " + std::to_string(age) +
+						   " AND genre = " + std::to_string(genre) + " OR year > " + std::to_string(year) + " AND name IN ('" + name1 +
+						   "', '" + name2 + "', 'unknown') ORDER BY year DESC LIMIT 100";
+		QueryResults expected;
+		Error err = rt.reindexer->Select(sql, expected);
+		ASSERT_TRUE(err.ok()) << err.what();
+		QueryResults qr;
+		err = rt.reindexer->Select(*prepared, {Variant(age), Variant(genre), Variant(year), Variant(name1), Variant(name2)}, qr);
+		ASSERT_TRUE(err.ok()) << err.what();
+		ASSERT_EQ(qr.Count(), expected.Count()) << sql;
+		for (size_t i = 0; i < qr.Count(); ++i) {
+			Item item = qr[i].GetItem();
+			Item expectedItem = expected[i].GetItem();
+			EXPECT_EQ(item[kFieldNameId].As<int>(), expectedItem[kFieldNameId].As<int>()) << sql << " #" << i;
+		}
+	};
+
+	QueryResults someItems;
+	err = rt.reindexer->Select(Query(default_namespace).Limit(10), someItems);
+	ASSERT_TRUE(err.ok()) << err.what();
+	for (auto it : someItems) {
+		Item item = it.GetItem();
+		check(item[kFieldNameAge].As<int>(), item[kFieldNameGenre].As<int>(), 2000, item[kFieldNameName].As<string>(), "name");
+	}
+	check(1, 1, 1000, "", "");
+
+	// Plan of query is rebuilt after change of indexes
+	err = rt.reindexer->DropIndex(default_namespace, reindexer::IndexDef(kFieldNameYear));
+	ASSERT_TRUE(err.ok()) << err.what();
+	for (auto it : someItems) {
+		Item item = it.GetItem();
+		check(item[kFieldNameAge].As<int>(), item[kFieldNameGenre].As<int>(), 2000, item[kFieldNameName].As<string>(), "name");
+	}
+
+	QueryResults qr;
+	err = rt.reindexer->Select(*prepared, {Variant(1), Variant(2)}, qr);
+	EXPECT_EQ(err.code(), errParams);
+	err = rt.reindexer->Prepare("DELETE FROM " + default_namespace + " WHERE id = ?", prepared);
+	EXPECT_EQ(err.code(), errParams);
+	err = rt.reindexer->Prepare("SELECT * FROM " + default_namespace + " WHERE id = ? MERGE (SELECT * FROM " + default_namespace +
+									" WHERE id = ?)",
+								prepared);
+	EXPECT_FALSE(err.ok());
+}
+
+TEST_F(QueriesApi, PreparedQueryPlan) {
+	FillDefaultNamespace(0, 3000, 20);
+
+	const string compositeIndexName(kFieldNameAge + compositePlus + kFieldNameGenre);
+	reindexer::PreparedQuery::Ptr prepared;
+	Error err = rt.reindexer->Prepare(
+		"SELECT * FROM " + default_namespace + " WHERE genre IN (?, ?, ?) AND age = ? AND genre = ? AND year > ? AND year < ?", prepared);
+	ASSERT_TRUE(err.ok()) << err.what();
+
+	// Results of prepared query must be the same and in the same order, as the results of sql query with the same values
+	const auto check = [&](int genre1, int genre2, int genre3, int age, int genre, int yearFrom, int yearTo) {
+		const string sql = "SELECT * FROM " + default_namespace + " WHERE genre IN (" + std::to_string(genre1) + ", " +
+						   std::to_string(genre2) + ", " + std::to_string(genre3) + ") AND age = " + std::to_string(age) +
+						   " AND genre = " + std::to_string(genre) + " AND year > " + std::to_string(yearFrom) +
+						   " AND year < " + std::to_string(yearTo);
+		QueryResults expected;
+		Error err = rt.reindexer->Select(sql, expected);
+		ASSERT_TRUE(err.ok()) << err.what();
+		QueryResults qr;
+		err = rt.reindexer->Select(
+			*prepared, {Variant(genre1), Variant(genre2), Variant(genre3), Variant(age), Variant(genre), Variant(yearFrom), Variant(yearTo)},
+			qr);
+		ASSERT_TRUE(err.ok()) << err.what();
+		ASSERT_EQ(qr.Count(), expected.Count()) << sql;
+		for (size_t i = 0; i < qr.Count(); ++i) {
+			Item item = qr[i].GetItem();
+			Item expectedItem = expected[i].GetItem();
+			EXPECT_EQ(item[kFieldNameId].As<int>(), expectedItem[kFieldNameId].As<int>()) << sql << " #" << i;
+		}
+	};
+	const auto hasCompositeEntry = [&compositeIndexName](const reindexer::PreparedQuery::Plan& plan) {
+		for (size_t i = 0; i < plan.entries.Size(); ++i) {
+			if (plan.entries.IsEntry(i) && plan.entries[i].index == compositeIndexName) return true;
+		}
+		return false;
+	};
+
+	QueryResults someItems;
+	err = rt.reindexer->Select(Query(default_namespace).Limit(10), someItems);
+	ASSERT_TRUE(err.ok()) << err.what();
+	for (auto it : someItems) {
+		Item item = it.GetItem();
+		const int genre = item[kFieldNameGenre].As<int>();
+		check(genre, genre + 1, genre + 2, item[kFieldNameAge].As<int>(), genre, 2000, 2040);
+	}
+	check(1, 2, 3, 4, 5, 2000, 2049);
+	check(1, 2, 3, 4, 2, 2049, 2000);
+
+	// Merged conditions are substituted by composite index, and sort order is detected by range conditions once
+	const auto plan = prepared->GetPlan();
+	ASSERT_TRUE(plan);
+	EXPECT_TRUE(hasCompositeEntry(*plan));
+	ASSERT_EQ(plan->sortBy.size(), 1);
+	EXPECT_EQ(plan->sortBy[0].column, kFieldNameYear);
+
+	// Plan is rebuilt after change of indexes
+	err = rt.reindexer->DropIndex(default_namespace, reindexer::IndexDef(compositeIndexName));
+	ASSERT_TRUE(err.ok()) << err.what();
+	for (auto it : someItems) {
+		Item item = it.GetItem();
+		const int genre = item[kFieldNameGenre].As<int>();
+		check(genre, genre + 1, genre + 2, item[kFieldNameAge].As<int>(), genre, 2000, 2040);
+	}
+	const auto newPlan = prepared->GetPlan();
+	ASSERT_TRUE(newPlan);
+	EXPECT_NE(plan.get(), newPlan.get());
+	EXPECT_FALSE(hasCompositeEntry(*newPlan));
+}
@@ -133,3 +133,52 @@ TEST_F(ReplicationLoadApi, DynamicRoleSwitch) {
 		SwitchMaster(i % 4);
 	}
 }
+
+TEST_F(ReplicationLoadApi, SnapshotSync) {
+	// Namespace "some" is not replicated until slaves are reconfigured
+	ReplicationConfig config("slave", false, true, std::string(), {"some1"});
+	for (size_t i = 1; i < kDefaultServerCount; ++i) SetServerConfig(i, config);
+
+	InitNs();
+	FillData(2000);
+	{
+		// Free item ids in the middle of the namespace: snapshot chunks must not shift over them
+		reindexer::client::QueryResults qr;
+		auto err = GetSrv(masterId_)->api.reindexer->Delete(Query("some").Where("id", CondRange, {500, 1500}), qr);
+		ASSERT_TRUE(err.ok()) << err.what();
+	}
+	WaitSync("some1");
+
+	// Slaves have not got "some" namespace, so it will be synced by the bulk snapshot
+	config = ReplicationConfig("slave", false, true);
+	config.snapshotChunkSize_ = 100;
+	config.connPoolSize_ = 4;
+	for (size_t i = 1; i < kDefaultServerCount; ++i) SetServerConfig(i, config);
+	WaitSync("some");
+	WaitSync("some1");
+
+	for (size_t i = 1; i < kDefaultServerCount; ++i) {
+		// Stats of sync are finished right after namespace is synced
+		size_t count = 0;
+		for (int retry = 0; count != 1 && retry < 100; ++retry) {
+			if (retry) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			reindexer::client::QueryResults qr;
+			auto err = GetSrv(i)->api.reindexer->Select(Query("#replicationstats")
+															.Where("name", CondEq, "some")
+															.Where("sync_type", CondEq, "snapshot")
+															.Where("in_progress", CondEq, false)
+															// Chunks cover all the 2000 ids of master, not only its remaining items
+															.Where("chunks_total", CondGe, 20),
+														qr);
+			ASSERT_TRUE(err.ok()) << err.what();
+			count = qr.Count();
+		}
+		EXPECT_EQ(count, 1);
+		EXPECT_EQ(SimpleSelect(i).Count(), SimpleSelect(masterId_).Count());
+	}
+
+	// Updates after snapshot are replicated by WAL
+	FillData(100);
+	WaitSync("some");
+	for (size_t i = 1; i < kDefaultServerCount; ++i) EXPECT_EQ(SimpleSelect(i).Count(), SimpleSelect(masterId_).Count());
+}
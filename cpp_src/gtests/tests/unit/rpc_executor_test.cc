@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "core/query/query.h"
+#include "net/cproto/executor.h"
+
+using namespace reindexer::net::cproto;
+
+static RPCCall makeCall(CmdCode cmd, bool pointSelect = false) {
+	return RPCCall{cmd, 0, Args(), std::chrono::milliseconds(0), pointSelect};
+}
+
+TEST(RPCExecutorTest, CommandClasses) {
+	EXPECT_EQ(GetCmdClass(makeCall(kCmdPing)), kCmdClassLight);
+	EXPECT_EQ(GetCmdClass(makeCall(kCmdFetchResults)), kCmdClassLight);
+	EXPECT_EQ(GetCmdClass(makeCall(kCmdSelect)), kCmdClassSelect);
+	EXPECT_EQ(GetCmdClass(makeCall(kCmdSelectSQL)), kCmdClassSelect);
+	EXPECT_EQ(GetCmdClass(makeCall(kCmdModifyItem)), kCmdClassWrite);
+	EXPECT_EQ(GetCmdClass(makeCall(kCmdCommitTx)), kCmdClassWrite);
+
+	// Point selects are marked by client in header
+	EXPECT_EQ(GetCmdClass(makeCall(kCmdSelect, true)), kCmdClassPointSelect);
+	EXPECT_EQ(GetCmdClass(makeCall(kCmdSelectSQL, true)), kCmdClassPointSelect);
+	EXPECT_EQ(GetCmdClass(makeCall(kCmdModifyItem, true)), kCmdClassWrite);
+}
+
+TEST(RPCExecutorTest, PointSelects) {
+	// Queries with small limit and without heavy parts are point selects
+	EXPECT_TRUE(IsPointSelect(reindexer::Query("ns").Where("id", CondEq, 5).Limit(1)));
+	EXPECT_FALSE(IsPointSelect(reindexer::Query("ns").Where("id", CondEq, 5)));
+	EXPECT_FALSE(IsPointSelect(reindexer::Query("ns").Limit(1).Sort("name", false)));
+	EXPECT_FALSE(IsPointSelect(reindexer::Query("ns").Limit(1).ReqTotal()));
+	EXPECT_FALSE(IsPointSelect(reindexer::Query("ns").Limit(1).Aggregate(AggMax, {"id"})));
+}
+
+TEST(RPCExecutorTest, HeavyCallsDoNotDelayOtherClasses) {
+	ExecutorConfig config;
+	config.workersPerClass = 1;
+	Executor executor(config);
+	ASSERT_TRUE(executor.Enabled());
+
+	std::atomic<bool> stopHeavy{false};
+	std::atomic<int> lightCalls{0};
+	ASSERT_TRUE(executor.Push(kCmdClassSelect, [&](std::chrono::microseconds) {
+		while (!stopHeavy) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}));
+	for (int i = 0; i < 10; ++i) {
+		ASSERT_TRUE(executor.Push(kCmdClassLight, [&](std::chrono::microseconds) { lightCalls++; }));
+	}
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (lightCalls < 10 && std::chrono::steady_clock::now() < deadline) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	EXPECT_EQ(lightCalls, 10);
+	stopHeavy = true;
+}
+
+TEST(RPCExecutorTest, AdmissionControl) {
+	ExecutorConfig config;
+	config.workersPerClass = 1;
+	config.maxQueueSize = 2;
+	Executor executor(config);
+
+	std::atomic<bool> started{false}, stop{false};
+	std::atomic<int> calls{0};
+	std::atomic<int64_t> maxWaitUs{0};
+	ASSERT_TRUE(executor.Push(kCmdClassWrite, [&](std::chrono::microseconds) {
+		started = true;
+		while (!stop) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}));
+	while (!started) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	auto task = [&](std::chrono::microseconds wait) {
+		calls++;
+		if (wait.count() > maxWaitUs) maxWaitUs = wait.count();
+	};
+	EXPECT_TRUE(executor.Push(kCmdClassWrite, task));
+	EXPECT_TRUE(executor.Push(kCmdClassWrite, task));
+	// Queue of class is full
+	EXPECT_FALSE(executor.Push(kCmdClassWrite, task));
+	// Queues of the other classes are not affected
+	EXPECT_TRUE(executor.Push(kCmdClassLight, task));
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	stop = true;
+	// Queued tasks are finished on stop
+	executor.Stop();
+	EXPECT_EQ(calls, 3);
+	EXPECT_GE(maxWaitUs, 20000);
+	EXPECT_FALSE(executor.Push(kCmdClassLight, task));
+}
+
+TEST(RPCExecutorTest, Disabled) {
+	ExecutorConfig config;
+	config.workersPerClass = 0;
+	Executor executor(config);
+	EXPECT_FALSE(executor.Enabled());
+	EXPECT_FALSE(executor.Push(kCmdClassLight, [](std::chrono::microseconds) {}));
+}
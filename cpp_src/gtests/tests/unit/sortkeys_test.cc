@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/keyvalue/variant.h"
+#include "core/nsselecter/sortkeys.h"
+
+using reindexer::SortKeys;
+using reindexer::Variant;
+
+static int sign(int v) { return (v > 0) - (v < 0); }
+
+// Order of encoded keys must be the same, as the order of values by Variant::Compare
+static void checkOrder(const std::vector<Variant> &values, const CollateOpts &opts) {
+	for (bool desc : {false, true}) {
+		std::vector<std::string> keys(values.size());
+		std::vector<bool> encoded(values.size());
+		for (size_t i = 0; i < values.size(); ++i) encoded[i] = SortKeys::Encode(values[i], opts, desc, keys[i]);
+
+		for (size_t i = 0; i < values.size(); ++i) {
+			if (!encoded[i]) continue;
+			for (size_t j = 0; j < values.size(); ++j) {
+				if (!encoded[j]) continue;
+				int res = memcmp(keys[i].data(), keys[j].data(), std::min(keys[i].size(), keys[j].size()));
+				if (!res) res = int(keys[i].size()) - int(keys[j].size());
+				const int expected = values[i].Compare(values[j], opts) * (desc ? -1 : 1);
+				ASSERT_EQ(sign(res), sign(expected)) << i << " " << j << " desc=" << desc;
+			}
+		}
+	}
+}
+
+TEST(SortKeysTest, Numbers) {
+	std::mt19937 rnd(1);
+	std::vector<Variant> ints, ints64, doubles, bools{Variant(false), Variant(true)};
+	for (int v : {INT_MIN, INT_MIN + 1, -1, 0, 1, INT_MAX - 1, INT_MAX}) ints.emplace_back(v);
+	for (int64_t v : {int64_t(LLONG_MIN), int64_t(INT_MIN) - 1, int64_t(-1), int64_t(0), int64_t(1), int64_t(LLONG_MAX)}) ints64.emplace_back(v);
+	for (double v : {-HUGE_VAL, -1e300, -1.5, -0.0, 0.0, 1e-300, 1.5, 1e300, HUGE_VAL}) doubles.emplace_back(v);
+	for (int i = 0; i < 100; ++i) {
+		ints.emplace_back(int(rnd()));
+		ints64.emplace_back(int64_t(uint64_t(rnd()) << 32 | rnd()));
+		doubles.emplace_back(double(int(rnd())) / (1 + rnd() % 1000));
+	}
+	checkOrder(ints, CollateOpts());
+	checkOrder(ints64, CollateOpts());
+	checkOrder(doubles, CollateOpts());
+	checkOrder(bools, CollateOpts());
+
+	std::string key;
+	EXPECT_FALSE(SortKeys::Encode(Variant(std::nan("")), CollateOpts(), false, key));
+}
+
+TEST(SortKeysTest, Strings) {
+	// Chars with the different case, zero byte, non ASCII chars and chars, which are the prefixes of each other
+	const std::vector<std::string> chars = {"a", "A", "b", "Z", "0", std::string(1, '\0'), "\x7f", "\xc3\xa9", "\xc3\x89", "\xd1\x8f", "\xd0\xaf"};
+	std::mt19937 rnd(1);
+	std::vector<Variant> values{Variant(std::string())};
+	for (int i = 0; i < 300; ++i) {
+		std::string str;
+		const int len = rnd() % 6;
+		for (int j = 0; j < len; ++j) str += chars[rnd() % chars.size()];
+		values.emplace_back(str);
+	}
+
+	for (auto mode : {CollateNone, CollateASCII, CollateUTF8}) {
+		checkOrder(values, CollateOpts(mode));
+	}
+	EXPECT_TRUE(SortKeys::IsSupported(reindexer::PayloadFieldType(KeyValueString, "f", {}, false), CollateOpts(CollateUTF8)));
+	EXPECT_FALSE(SortKeys::IsSupported(reindexer::PayloadFieldType(KeyValueString, "f", {}, false), CollateOpts(CollateNumeric)));
+	EXPECT_FALSE(SortKeys::IsSupported(reindexer::PayloadFieldType(KeyValueInt, "f", {}, true), CollateOpts()));
+}
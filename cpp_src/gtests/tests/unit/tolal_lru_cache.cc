@@ -2,6 +2,7 @@
 #include <thread>
 #include <vector>
 
+#include "core/idsetcache.h"
 #include "core/query/query.h"
 #include "core/querycache.h"
 #include "debug/allocdebug.h"
@@ -110,3 +111,97 @@ TEST(LruCache, StressTest) {
 		EXPECT_TRUE(memoryConsumed <= cacheSize);
 	}
 }
+
+TEST(LruCache, ShardsStat) {
+	const int queriesCount = 100;
+
+	QueryCache cache(reindexer::kDefaultCacheSizeLimit, 1);
+
+	for (int i = 0; i < queriesCount; ++i) {
+		QueryCacheKey ckey{Query("namespace" + std::to_string(i))};
+		auto cached = cache.Get(ckey);
+		ASSERT_TRUE(cached.valid);
+		cache.Put(ckey, QueryCacheVal{size_t(i)});
+	}
+	for (int i = 0; i < queriesCount; ++i) {
+		QueryCacheKey ckey{Query("namespace" + std::to_string(i))};
+		auto cached = cache.Get(ckey);
+		ASSERT_TRUE(cached.valid);
+		EXPECT_EQ(cached.val.total_count, i);
+	}
+
+	auto stat = cache.GetMemStat();
+	ASSERT_EQ(stat.shards.size(), reindexer::kDefaultCacheShardsCount);
+	EXPECT_EQ(stat.itemsCount, size_t(queriesCount));
+	EXPECT_EQ(stat.hitsCount, uint64_t(queriesCount));
+	EXPECT_EQ(stat.missesCount, uint64_t(queriesCount));
+
+	size_t totalSize = 0, itemsCount = 0, usedShards = 0;
+	uint64_t hitsCount = 0, missesCount = 0;
+	for (auto& shard : stat.shards) {
+		totalSize += shard.totalSize;
+		itemsCount += shard.itemsCount;
+		hitsCount += shard.hitsCount;
+		missesCount += shard.missesCount;
+		EXPECT_EQ(shard.hitsCount, shard.missesCount);
+		if (shard.itemsCount) ++usedShards;
+	}
+	EXPECT_GT(usedShards, 1u);
+	EXPECT_EQ(totalSize, stat.totalSize);
+	EXPECT_EQ(itemsCount, stat.itemsCount);
+	EXPECT_EQ(hitsCount, stat.hitsCount);
+	EXPECT_EQ(missesCount, stat.missesCount);
+}
+
+TEST(LruCache, Eviction) {
+	const int queriesCount = 2000;
+	const size_t cacheSize = 64 * 1024;
+
+	QueryCache cache(cacheSize, 1);
+
+	for (int i = 0; i < queriesCount; ++i) {
+		QueryCacheKey ckey{Query("namespace" + std::to_string(i))};
+		auto cached = cache.Get(ckey);
+		if (cached.valid) cache.Put(ckey, QueryCacheVal{size_t(i)});
+	}
+
+	auto stat = cache.GetMemStat();
+	EXPECT_LE(stat.totalSize, cacheSize);
+	EXPECT_GT(stat.itemsCount, 0u);
+	EXPECT_LT(stat.itemsCount, size_t(queriesCount));
+	EXPECT_EQ(stat.missesCount, uint64_t(queriesCount));
+	EXPECT_EQ(stat.hitsCount, 0u);
+}
+
+TEST(LruCache, BigEntry) {
+	const size_t cacheSize = 1024 * 1024;
+	using IdSetLRUCache =
+		reindexer::LRUCache<reindexer::IdSetCacheKey, reindexer::IdSetCacheVal, reindexer::hash_idset_cache_key, reindexer::equal_idset_cache_key>;
+	IdSetLRUCache cache(cacheSize, 1);
+
+	// Entry is much bigger than the part of limit of a single shard
+	auto ids = reindexer::make_intrusive<reindexer::intrusive_atomic_rc_wrapper<reindexer::IdSet>>();
+	for (int id = 0; reindexer::IdSetCacheVal(ids).Size() < cacheSize / 4; ++id) ids->Add(id, reindexer::IdSet::Unordered, 0);
+
+	reindexer::VariantArray keys{reindexer::Variant(1)};
+	reindexer::IdSetCacheKey ckey(keys, CondEq, 0);
+	ASSERT_TRUE(cache.Get(ckey).valid);
+	cache.Put(ckey, reindexer::IdSetCacheVal(ids));
+
+	auto cached = cache.Get(ckey);
+	ASSERT_TRUE(cached.valid);
+	ASSERT_TRUE(cached.val.ids);
+	EXPECT_EQ(cached.val.ids->size(), ids->size());
+	EXPECT_LE(cache.GetMemStat().totalSize, cacheSize);
+
+	// Entry, which is bigger than the whole cache, is not cached
+	reindexer::VariantArray hugeKeys{reindexer::Variant(2)};
+	reindexer::IdSetCacheKey hugeKey(hugeKeys, CondEq, 0);
+	auto huge = reindexer::make_intrusive<reindexer::intrusive_atomic_rc_wrapper<reindexer::IdSet>>();
+	for (int id = 0; reindexer::IdSetCacheVal(huge).Size() < 2 * cacheSize; ++id) huge->Add(id, reindexer::IdSet::Unordered, 0);
+	ASSERT_TRUE(cache.Get(hugeKey).valid);
+	cache.Put(hugeKey, reindexer::IdSetCacheVal(huge));
+	auto hugeCached = cache.Get(hugeKey);
+	EXPECT_FALSE(hugeCached.valid && hugeCached.val.ids);
+	EXPECT_LE(cache.GetMemStat().totalSize, cacheSize);
+}
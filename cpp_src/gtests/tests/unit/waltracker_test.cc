@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <string>
+
+#include "replicator/waltracker.h"
+
+using reindexer::WALRecord;
+using reindexer::WALTracker;
+
+class WALTrackerTest : public ::testing::Test {
+protected:
+	// Adds record: item update, or item modify with data of random size
+	int64_t add(size_t maxDataSize = 500) {
+		int64_t lsn;
+		if (rnd_() % 3 == 0) {
+			const int id = rnd_() % 1000;
+			lsn = wal_.Add(WALRecord(reindexer::WalItemUpdate, id));
+			expected_[lsn] = "update " + std::to_string(id);
+		} else {
+			std::string data(1 + rnd_() % maxDataSize, 'a' + rnd_() % 26);
+			lsn = wal_.Add(WALRecord(reindexer::WalItemModify, data, 1, ModeUpsert));
+			expected_[lsn] = "modify " + data;
+		}
+		return lsn;
+	}
+
+	static std::string describe(const WALRecord &rec) {
+		switch (rec.type) {
+			case reindexer::WalEmpty:
+				return "empty";
+			case reindexer::WalItemUpdate:
+				return "update " + std::to_string(rec.id);
+			case reindexer::WalItemModify:
+				return "modify " + std::string(rec.itemModify.itemCJson);
+			default:
+				return "unexpected";
+		}
+	}
+
+	// Checks, that WAL contains the consecutive tail of the added records
+	void check(int64_t fromLSN) {
+		ASSERT_FALSE(wal_.is_outdated(fromLSN));
+		int64_t lsn = fromLSN;
+		for (auto it = wal_.upper_bound(fromLSN - 1); it != wal_.end(); ++it, ++lsn) {
+			ASSERT_EQ(it.GetLSN(), lsn);
+			auto expected = expected_.find(lsn);
+			EXPECT_EQ(describe(*it), expected == expected_.end() ? "empty" : expected->second) << lsn;
+		}
+		EXPECT_EQ(lsn, wal_.LSNCounter());
+	}
+
+	std::mt19937 rnd_{1};
+	WALTracker wal_;
+	std::map<int64_t, std::string> expected_;
+};
+
+TEST_F(WALTrackerTest, AddAndSet) {
+	for (int i = 0; i < 1000; ++i) add();
+	check(0);
+	EXPECT_EQ(wal_.size(), 1000u);
+
+	// Records are replaced by smaller and bigger ones
+	for (int64_t lsn = 0; lsn < 1000; lsn += 7) {
+		if (lsn % 2) {
+			ASSERT_TRUE(wal_.Set(WALRecord(), lsn));
+			expected_.erase(lsn);
+		} else {
+			std::string data(lsn % 3 ? 1 : 1000, 'z');
+			ASSERT_TRUE(wal_.Set(WALRecord(reindexer::WalItemModify, data, 1, ModeUpsert), lsn));
+			expected_[lsn] = "modify " + data;
+		}
+	}
+	// Previous record of the updated item is emptied
+	int64_t lsn = wal_.Add(WALRecord(reindexer::WalItemUpdate, 5), 10);
+	expected_[lsn] = "update 5";
+	expected_.erase(10);
+	check(0);
+}
+
+TEST_F(WALTrackerTest, BytesLimit) {
+	const int64_t kMaxBytes = 16 * 1024;
+	wal_.SetLimits(100000, kMaxBytes);
+	for (int i = 0; i < 5000; ++i) add();
+
+	EXPECT_TRUE(wal_.is_outdated(0));
+	// Ring of records takes 8 bytes per record
+	EXPECT_LE(wal_.heap_size(), 2 * 5000 * sizeof(int64_t) + kMaxBytes);
+	const int64_t firstLSN = wal_.LSNCounter() - wal_.size();
+	EXPECT_GT(firstLSN, 0);
+	EXPECT_TRUE(wal_.is_outdated(firstLSN - 2));
+	check(firstLSN);
+
+	// Record, which is bigger than limit, evicts all the records
+	std::string data(kMaxBytes, 'x');
+	int64_t lsn = wal_.Add(WALRecord(reindexer::WalItemModify, data, 1, ModeUpsert));
+	EXPECT_TRUE(wal_.is_outdated(lsn - 1));
+	EXPECT_EQ(wal_.size(), 0u);
+	for (int i = 0; i < 10; ++i) add(100);
+	check(lsn + 1);
+}
+
+TEST_F(WALTrackerTest, RecordsLimit) {
+	for (int i = 0; i < 1000; ++i) add();
+	wal_.SetLimits(100, 1 << 20);
+	EXPECT_TRUE(wal_.is_outdated(500));
+	check(wal_.LSNCounter() - wal_.size());
+	EXPECT_EQ(wal_.size(), 99u);
+
+	for (int i = 0; i < 1000; ++i) add();
+	check(wal_.LSNCounter() - wal_.size());
+
+	// Shrink of bytes limit keeps the newest records
+	wal_.SetLimits(100, 4096);
+	EXPECT_LT(wal_.size(), 99u);
+	EXPECT_GT(wal_.size(), 0u);
+	check(wal_.LSNCounter() - wal_.size());
+}
+
+TEST_F(WALTrackerTest, ForkAndMerge) {
+	for (int i = 0; i < 500; ++i) add();
+
+	// Fork gets only new records, and empties records of the parent via LSNs of updated items
+	WALTracker parent = wal_.Fork();
+	std::swap(parent, wal_);
+	EXPECT_EQ(wal_.size(), 0u);
+	EXPECT_EQ(wal_.LSNCounter(), 500);
+	for (int i = 0; i < 300; ++i) add();
+	int64_t lsn = wal_.Add(WALRecord(reindexer::WalItemUpdate, 7), 20);
+	expected_[lsn] = "update 7";
+	expected_.erase(20);
+	EXPECT_FALSE(wal_.Set(WALRecord(), 30));
+	expected_.erase(30);
+
+	parent.Merge(std::move(wal_));
+	wal_ = std::move(parent);
+	EXPECT_EQ(wal_.size(), 801u);
+	check(0);
+}
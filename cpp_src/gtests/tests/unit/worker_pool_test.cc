@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "core/workerpool.h"
+
+using reindexer::WorkerPool;
+
+TEST(WorkerPoolTest, Parallel) {
+	WorkerPool pool(4);
+	constexpr unsigned kParts = 16;
+	std::atomic<unsigned> calls[kParts];
+	for (auto &c : calls) c = 0;
+	pool.Parallel(kParts, [&](unsigned i) { calls[i]++; });
+	for (auto &c : calls) EXPECT_EQ(c, 1);
+
+	EXPECT_THROW(pool.Parallel(kParts,
+							   [](unsigned i) {
+								   if (i == 5) throw std::runtime_error("part failed");
+							   }),
+				 std::runtime_error);
+
+	// Pool without workers runs all the parts by the caller
+	WorkerPool empty(0);
+	unsigned count = 0;
+	empty.Parallel(kParts, [&](unsigned) { count++; });
+	EXPECT_EQ(count, kParts);
+	EXPECT_FALSE(empty.Run([]() {}));
+}
+
+TEST(WorkerPoolTest, RunTasks) {
+	WorkerPool pool(2);
+	constexpr int kTasks = 100;
+	std::mutex mtx;
+	std::condition_variable cv;
+	int done = 0;
+	for (int i = 0; i < kTasks; ++i) {
+		ASSERT_TRUE(pool.Run([&]() {
+			std::lock_guard<std::mutex> lck(mtx);
+			if (++done == kTasks) cv.notify_all();
+		}));
+	}
+	// Failed task doesn't stop its worker
+	ASSERT_TRUE(pool.Run([]() { throw std::runtime_error("task failed"); }));
+	std::unique_lock<std::mutex> lck(mtx);
+	EXPECT_TRUE(cv.wait_for(lck, std::chrono::seconds(5), [&]() { return done == kTasks; }));
+	lck.unlock();
+
+	// Parallel parts are run, while workers are busy with tasks: the caller runs them by itself
+	std::atomic<bool> release{false};
+	for (unsigned i = 0; i < pool.WorkersCount(); ++i) {
+		pool.Run([&]() {
+			while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		});
+	}
+	std::atomic<unsigned> parts{0};
+	pool.Parallel(8, [&](unsigned) { parts++; });
+	EXPECT_EQ(parts, 8);
+	release = true;
+
+	pool.Stop();
+	EXPECT_FALSE(pool.Run([]() {}));
+}
@@ -28,6 +28,7 @@ void Connection<Mutex>::restart(int fd) {
 	rdBuf_.clear();
 	curEvents_ = 0;
 	closeConn_ = false;
+	readPaused_ = false;
 }
 
 template <typename Mutex>
@@ -83,12 +84,19 @@ void Connection<Mutex>::callback(ev::io & /*watcher*/, int revents) {
 	if (revents & ev::WRITE) {
 		canWrite_ = true;
 		write_cb();
+		if (sock_.valid() && !closeConn_) onWrite();
 	}
 
 	int nevents = ev::READ | (wrBuf_.size() ? ev::WRITE : 0);
+	// Pending input doesn't wake the loop, while reading is paused. So socket is not polled at all, if there is nothing to write
+	if (readPaused_) nevents = wrBuf_.size() ? ev::WRITE : 0;
 
 	if (curEvents_ != nevents && sock_.valid()) {
-		(curEvents_) ? io_.set(nevents) : io_.start(sock_.fd(), nevents);
+		if (!nevents) {
+			io_.stop();
+		} else {
+			(curEvents_) ? io_.set(nevents) : io_.start(sock_.fd(), nevents);
+		}
 		curEvents_ = nevents;
 	}
 }
@@ -125,7 +133,7 @@ void Connection<Mutex>::write_cb() {
 // Receive message from client socket
 template <typename Mutex>
 void Connection<Mutex>::read_cb() {
-	while (!closeConn_) {
+	while (!closeConn_ && !readPaused_) {
 		auto it = rdBuf_.head();
 		ssize_t nread = sock_.recv(it);
 		int err = sock_.last_error();
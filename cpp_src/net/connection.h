@@ -26,6 +26,8 @@ public:
 protected:
 	virtual void onRead() = 0;
 	virtual void onClose() = 0;
+	// Socket is writable and pending data is sent
+	virtual void onWrite() {}
 
 	// Generic callback
 	void callback(ev::io &watcher, int revents);
@@ -48,6 +50,8 @@ protected:
 	bool closeConn_ = false;
 	bool attached_ = false;
 	bool canWrite_ = true;
+	// Don't read from socket, until current request is finished
+	bool readPaused_ = false;
 
 	chain_buf<Mutex> wrBuf_;
 	cbuf<char> rdBuf_;
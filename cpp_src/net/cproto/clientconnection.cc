@@ -13,7 +13,8 @@ const int kMaxCompletions = 512;
 const int kKeepAliveInterval = 30;
 const int kDeadlineCheckInterval = 1;
 
-ClientConnection::ClientConnection(ev::dynamic_loop &loop, const httpparser::UrlParser *uri, seconds loginTimeout, seconds requestTimeout)
+ClientConnection::ClientConnection(ev::dynamic_loop &loop, const httpparser::UrlParser *uri, seconds loginTimeout, seconds requestTimeout,
+								   bool enableCompression)
 	: ConnectionMT(-1, loop),
 	  state_(ConnInit),
 	  completions_(kMaxCompletions),
@@ -23,7 +24,9 @@ ClientConnection::ClientConnection(ev::dynamic_loop &loop, const httpparser::Url
 	  now_(0),
 	  loginTimeout_(loginTimeout),
 	  keepAliveTimeout_(requestTimeout),
-	  terminate_(false) {
+	  terminate_(false),
+	  enableCompression_(enableCompression),
+	  peerAcceptsCompressed_(false) {
 	connect_async_.set<ClientConnection, &ClientConnection::connect_async_cb>(this);
 	connect_async_.set(loop);
 	connect_async_.start();
@@ -59,6 +62,10 @@ void ClientConnection::connectInternal() {
 		std::unique_lock<std::mutex> lck(mtx_);
 		lastError_ = ans.Status();
 		state_ = ans.Status().ok() ? ConnConnected : ConnFailed;
+		if (state_ == ConnConnected) {
+			auto args = ans.GetArgs();
+			if (args.size()) serverVersion_ = args[0].As<std::string>();
+		}
 		wrBuf_.clear();
 		connectCond_.notify_all();
 		if (!lastError_.ok()) {
@@ -132,6 +139,7 @@ void ClientConnection::onClose() {
 	if (lastError_.ok()) lastError_ = Error(errNetwork, "Socket connection closed");
 	closeConn_ = false;
 	state_ = ConnFailed;
+	peerAcceptsCompressed_.store(false, std::memory_order_relaxed);
 	completions_.swap(tmpCompletions);
 	mtx_.unlock();
 	keep_alive_.stop();
@@ -182,17 +190,26 @@ void ClientConnection::onRead() {
 		}
 		assert(it.size() >= hdr.len);
 
+		if (enableCompression_ && hdr.acceptCompressed && hdr.version >= kCprotoMinSnappyVersion) {
+			peerAcceptsCompressed_.store(true, std::memory_order_relaxed);
+		}
+
 		RPCAnswer ans;
 
 		int errCode = 0;
 		try {
-			Serializer ser(it.data(), hdr.len);
+			string_view payload(it.data(), hdr.len);
+			if (hdr.compressed) {
+				UncompressPayload(payload, uncompressed_);
+				payload = uncompressed_;
+			}
+			Serializer ser(payload);
 			errCode = ser.GetVarUint();
 			string_view errMsg = ser.GetVString();
 			if (errCode != errOK) {
 				ans.status_ = Error(errCode, errMsg);
 			}
-			ans.data_ = {reinterpret_cast<uint8_t *>(it.data()) + ser.Pos(), hdr.len - ser.Pos()};
+			ans.data_ = {reinterpret_cast<uint8_t *>(const_cast<char *>(payload.data())) + ser.Pos(), payload.size() - ser.Pos()};
 		} catch (const Error &err) {
 			failInternal(err);
 			return;
@@ -251,12 +268,16 @@ Args RPCAnswer::GetArgs(int minArgs) const {
 
 Error RPCAnswer::Status() const { return status_; }
 
-chunk ClientConnection::packRPC(CmdCode cmd, uint32_t seq, const Args &args, const Args &ctxArgs) {
+chunk ClientConnection::packRPC(const CommandParams &opts, uint32_t seq, const Args &args, const Args &ctxArgs) {
 	CProtoHeader hdr;
 	hdr.len = 0;
 	hdr.magic = kCprotoMagic;
 	hdr.version = kCprotoVersion;
-	hdr.cmd = cmd;
+	hdr.compressed = 0;
+	hdr.acceptCompressed = enableCompression_;
+	hdr.pointSelect = opts.pointSelect;
+	hdr._reserved = 0;
+	hdr.cmd = opts.cmd;
 	hdr.seq = seq;
 
 	WrSerializer ser(wrBuf_.get_chunk());
@@ -267,13 +288,14 @@ chunk ClientConnection::packRPC(CmdCode cmd, uint32_t seq, const Args &args, con
 	ctxArgs.Pack(ser);
 
 	reinterpret_cast<CProtoHeader *>(ser.Buf())->len = ser.Len() - sizeof(hdr);
+	if (peerAcceptsCompressed_.load(std::memory_order_relaxed)) CompressFrame(ser);
 
 	return ser.DetachChunk();
 }
 
 void ClientConnection::call(Completion cmpl, const CommandParams &opts, const Args &args) {
 	uint32_t seq = seq_++;
-	chunk data = packRPC(opts.cmd, seq, args, Args{Arg{int64_t(opts.execTimeout.count())}});
+	chunk data = packRPC(opts, seq, args, Args{Arg{int64_t(opts.execTimeout.count())}});
 	bool inLoopThread = loopThreadID_ == std::this_thread::get_id();
 
 	std::unique_lock<std::mutex> lck(mtx_);
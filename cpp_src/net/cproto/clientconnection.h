@@ -66,8 +66,9 @@ protected:
 
 class ClientConnection : public ConnectionMT {
 public:
+	/// @param enableCompression - request compression of frames. Compression is used, if server supports it
 	ClientConnection(ev::dynamic_loop &loop, const httpparser::UrlParser *uri, seconds loginTimeout = seconds(0),
-					 seconds requestTimeout = seconds(0));
+					 seconds requestTimeout = seconds(0), bool enableCompression = false);
 	~ClientConnection();
 	typedef std::function<void(RPCAnswer &&ans, ClientConnection *conn)> Completion;
 
@@ -78,6 +79,8 @@ public:
 		seconds netTimeout;
 		milliseconds execTimeout;
 		const IRdxCancelContext *cancelCtx;
+		// Query of call is point query. Server executes point queries apart from the others
+		bool pointSelect = false;
 	};
 
 	template <typename... Argss>
@@ -121,6 +124,11 @@ public:
 		delete cur;
 	}
 	seconds Now() const { return seconds(now_); }
+	// Version of server, which is returned on login. It's empty, until connection is logged in
+	std::string ServerVersion() {
+		std::lock_guard<std::mutex> lck(mtx_);
+		return serverVersion_;
+	}
 
 protected:
 	void connect_async_cb(ev::async &) { connectInternal(); }
@@ -153,7 +161,7 @@ protected:
 
 	void call(Completion cmpl, const CommandParams &opts, const Args &args);
 
-	chunk packRPC(CmdCode cmd, uint32_t seq, const Args &args, const Args &ctxArgs);
+	chunk packRPC(const CommandParams &opts, uint32_t seq, const Args &args, const Args &ctxArgs);
 
 	void onRead() override;
 	void onClose() override;
@@ -189,6 +197,11 @@ protected:
 	const seconds loginTimeout_;
 	const seconds keepAliveTimeout_;
 	std::atomic<bool> terminate_;
+	const bool enableCompression_;
+	// Server accepts compressed requests
+	std::atomic<bool> peerAcceptsCompressed_;
+	std::string uncompressed_;
+	std::string serverVersion_;
 };
 }  // namespace cproto
 }  // namespace net
@@ -1,6 +1,11 @@
+#include <snappy.h>
+#include <string.h>
 #include <unordered_map>
 
 #include "cproto.h"
+#include "core/query/query.h"
+#include "tools/errors.h"
+#include "tools/serializer.h"
 
 namespace reindexer {
 namespace net {
@@ -56,6 +61,8 @@ string_view CmdName(uint16_t cmd) {
 			return "DeleteQuery"_sv;
 		case kCmdUpdateQuery:
 			return "UpdateQuery"_sv;
+		case kCmdModifyItems:
+			return "ModifyItems"_sv;
 		case kCmdSelect:
 			return "Select"_sv;
 		case kCmdSelectSQL:
@@ -64,6 +71,12 @@ string_view CmdName(uint16_t cmd) {
 			return "FetchResults"_sv;
 		case kCmdCloseResults:
 			return "CloseResults"_sv;
+		case kCmdPrepareSQL:
+			return "PrepareSQL"_sv;
+		case kCmdSelectPrepared:
+			return "SelectPrepared"_sv;
+		case kCmdClosePrepared:
+			return "ClosePrepared"_sv;
 		case kCmdGetMeta:
 			return "GetMeta"_sv;
 		case kCmdPutMeta:
@@ -81,6 +94,42 @@ string_view CmdName(uint16_t cmd) {
 	}
 }
 
+void CompressFrame(WrSerializer &ser) {
+	const size_t payloadLen = ser.Len() - sizeof(CProtoHeader);
+	if (payloadLen < kCprotoCompressionThreshold) return;
+
+	std::string compressed;
+	snappy::Compress(reinterpret_cast<const char *>(ser.Buf()) + sizeof(CProtoHeader), payloadLen, &compressed);
+	if (compressed.size() >= payloadLen) return;
+
+	CProtoHeader hdr;
+	memcpy(&hdr, ser.Buf(), sizeof(hdr));
+	hdr.compressed = 1;
+	hdr.len = compressed.size();
+	ser.Reset();
+	ser.Write(string_view(reinterpret_cast<char *>(&hdr), sizeof(hdr)));
+	ser.Write(compressed);
+}
+
+void UncompressPayload(string_view payload, std::string &out) {
+	size_t uncompressedLen = 0;
+	if (!snappy::GetUncompressedLength(payload.data(), payload.size(), &uncompressedLen)) {
+		throw Error(errParseBin, "Invalid header of compressed cproto frame of %d bytes", int(payload.size()));
+	}
+	if (uncompressedLen > kCprotoMaxUncompressedSize) {
+		throw Error(errParseBin, "Uncompressed size %d of cproto frame exceeds limit %d", int64_t(uncompressedLen),
+					int(kCprotoMaxUncompressedSize));
+	}
+	if (!snappy::Uncompress(payload.data(), payload.size(), &out)) {
+		throw Error(errParseBin, "Can't uncompress cproto frame of %d bytes", int(payload.size()));
+	}
+}
+
+bool IsPointSelect(const Query &q) {
+	return q.count <= kCprotoMaxPointSelectLimit && q.sortingEntries_.empty() && q.joinQueries_.empty() && q.mergeQueries_.empty() &&
+		   q.aggregations_.empty() && q.calcTotal == ModeNoTotal;
+}
+
 }  // namespace cproto
 }  // namespace net
 }  // namespace reindexer
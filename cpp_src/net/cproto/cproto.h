@@ -1,10 +1,15 @@
 #pragma once
 
 #include <stdint.h>
+#include <string>
 
 #include "estl/string_view.h"
 
 namespace reindexer {
+
+class WrSerializer;
+class Query;
+
 namespace net {
 namespace cproto {
 enum CmdCode : uint16_t {
@@ -34,11 +39,15 @@ enum CmdCode : uint16_t {
 	kCmdModifyItem = 33,
 	kCmdDeleteQuery = 34,
 	kCmdUpdateQuery = 35,
+	kCmdModifyItems = 36,
 
 	kCmdSelect = 48,
 	kCmdSelectSQL = 49,
 	kCmdFetchResults = 50,
 	kCmdCloseResults = 51,
+	kCmdPrepareSQL = 52,
+	kCmdSelectPrepared = 53,
+	kCmdClosePrepared = 54,
 
 	kCmdGetMeta = 64,
 	kCmdPutMeta = 65,
@@ -56,15 +65,30 @@ string_view CmdName(uint16_t code);
 
 // Maximum number of active queries per cleint
 const uint32_t kMaxConcurentQueries = 256;
+const uint32_t kMaxPreparedQueries = 1024;
 
 const uint32_t kCprotoMagic = 0xEEDD1132;
-const uint32_t kCprotoVersion = 0x102;
+const uint32_t kCprotoVersion = 0x103;
 const uint32_t kCprotoMinCompatVersion = 0x101;
+const uint32_t kCprotoMinSnappyVersion = 0x103;
+// Payloads of frames smaller than threshold are not compressed
+const uint32_t kCprotoCompressionThreshold = 1024;
+// Max size of uncompressed payload of frame. Frames with larger payloads are rejected before uncompression
+const uint32_t kCprotoMaxUncompressedSize = 256 * 1024 * 1024;
+// Maximum limit of point query
+const unsigned kCprotoMaxPointSelectLimit = 16;
 
 #pragma pack(push, 1)
 struct CProtoHeader {
 	uint32_t magic;
-	uint16_t version;
+	uint16_t version : 10;
+	// Payload of frame is compressed with snappy
+	uint16_t compressed : 1;
+	// Sender of frame is able to receive compressed frames
+	uint16_t acceptCompressed : 1;
+	// Call is point query: with small limit, and without sorting, joins, merges, aggregations and total count
+	uint16_t pointSelect : 1;
+	uint16_t _reserved : 3;
 	uint16_t cmd;
 	uint32_t len;
 	uint32_t seq;
@@ -72,6 +96,13 @@ struct CProtoHeader {
 
 #pragma pack(pop)
 
+// Compress payload of frame, packed to ser, if payload is larger than kCprotoCompressionThreshold and compression is effective
+void CompressFrame(WrSerializer &ser);
+// Uncompress payload of frame to out. Throws Error on corrupted payload or on payload larger than kCprotoMaxUncompressedSize
+void UncompressPayload(string_view payload, std::string &out);
+// Query is point query, so it's call is marked with pointSelect flag of header
+bool IsPointSelect(const Query &q);
+
 }  // namespace cproto
 }  // namespace net
 }  // namespace reindexer
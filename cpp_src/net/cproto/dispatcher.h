@@ -24,6 +24,8 @@ struct RPCCall {
 	uint32_t seq;
 	Args args;
 	milliseconds execTimeout_;
+	// Call is point query, as it's marked by client in header
+	bool pointSelect;
 };
 
 class ClientData {
@@ -0,0 +1,97 @@
+#include "executor.h"
+
+namespace reindexer {
+namespace net {
+namespace cproto {
+
+CmdClass GetCmdClass(const RPCCall &call) {
+	switch (call.cmd) {
+		case kCmdPing:
+		case kCmdLogin:
+		case kCmdOpenDatabase:
+		case kCmdCloseDatabase:
+		case kCmdEnumDatabases:
+		case kCmdEnumNamespaces:
+		case kCmdFetchResults:
+		case kCmdCloseResults:
+		case kCmdClosePrepared:
+		case kCmdGetMeta:
+		case kCmdEnumMeta:
+		case kCmdSubscribeUpdates:
+		case kCmdGetSQLSuggestions:
+			return kCmdClassLight;
+		case kCmdSelect:
+		case kCmdSelectSQL:
+			// Query is not parsed on I/O thread: client marks point queries in header
+			return call.pointSelect ? kCmdClassPointSelect : kCmdClassSelect;
+		case kCmdPrepareSQL:
+		case kCmdSelectPrepared:
+			return kCmdClassSelect;
+		default:
+			return kCmdClassWrite;
+	}
+}
+
+string_view CmdClassName(CmdClass cls) {
+	switch (cls) {
+		case kCmdClassLight:
+			return "light"_sv;
+		case kCmdClassPointSelect:
+			return "point_select"_sv;
+		case kCmdClassSelect:
+			return "select"_sv;
+		case kCmdClassWrite:
+			return "write"_sv;
+		default:
+			return "unknown"_sv;
+	}
+}
+
+Executor::Executor(const ExecutorConfig &config) : config_(config) {
+	for (auto &queue : queues_) {
+		for (int i = 0; i < config_.workersPerClass; ++i) {
+			workers_.emplace_back(&Executor::run, this, std::ref(queue));
+		}
+	}
+}
+
+Executor::~Executor() { Stop(); }
+
+bool Executor::Push(CmdClass cls, Task task) {
+	auto &queue = queues_[cls];
+	{
+		std::lock_guard<std::mutex> lck(mtx_);
+		if (terminate_ || !Enabled() || queue.tasks.size() >= size_t(config_.maxQueueSize)) return false;
+		queue.tasks.emplace_back(Clock::now(), std::move(task));
+	}
+	queue.cond.notify_one();
+	return true;
+}
+
+void Executor::Stop() {
+	{
+		std::lock_guard<std::mutex> lck(mtx_);
+		terminate_ = true;
+	}
+	for (auto &queue : queues_) queue.cond.notify_all();
+	for (auto &worker : workers_) worker.join();
+	workers_.clear();
+}
+
+void Executor::run(Queue &queue) {
+	std::unique_lock<std::mutex> lck(mtx_);
+	for (;;) {
+		queue.cond.wait(lck, [&]() { return terminate_ || !queue.tasks.empty(); });
+		if (queue.tasks.empty()) return;
+
+		auto task = std::move(queue.tasks.front());
+		queue.tasks.pop_front();
+		lck.unlock();
+		task.second(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - task.first));
+		lck.lock();
+	}
+}
+
+}  // namespace cproto
+}  // namespace net
+}  // namespace reindexer
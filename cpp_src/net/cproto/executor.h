@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "cproto.h"
+#include "dispatcher.h"
+#include "estl/string_view.h"
+
+namespace reindexer {
+namespace net {
+namespace cproto {
+
+/// Classes of RPC commands. Each class has its own queue and workers, so heavy calls of one class don't delay calls of the others
+enum CmdClass {
+	/// Cheap calls: ping, login, fetch of results, meta and namespaces enumeration, etc
+	kCmdClassLight = 0,
+	/// Point queries: with small limit, and without sorting, joins, merges, aggregations and total count
+	kCmdClassPointSelect,
+	/// Other queries
+	kCmdClassSelect,
+	/// Data and schema modifications, transactions
+	kCmdClassWrite,
+	kCmdClassCount
+};
+
+CmdClass GetCmdClass(const RPCCall &call);
+string_view CmdClassName(CmdClass cls);
+
+struct ExecutorConfig {
+	/// Count of worker threads per class of commands. 0 means, that calls are executed by I/O threads
+	int workersPerClass = 4;
+	/// Maximum count of calls, waiting in queue of each class. Calls above limit are rejected
+	int maxQueueSize = 1024;
+};
+
+/// Pool of workers, which execute RPC calls outside of connections I/O threads
+class Executor {
+public:
+	using Clock = std::chrono::steady_clock;
+	/// Task routine. Gets time, which task has spent in queue
+	using Task = std::function<void(std::chrono::microseconds queueWait)>;
+
+	explicit Executor(const ExecutorConfig &config);
+	~Executor();
+	Executor(const Executor &) = delete;
+	Executor &operator=(const Executor &) = delete;
+
+	/// Executor has workers
+	bool Enabled() const { return config_.workersPerClass > 0; }
+	/// Enqueue task to queue of command class
+	/// @return false, if queue is full, or executor is stopped. Task is not run in this case
+	bool Push(CmdClass cls, Task task);
+	/// Stop workers. Already queued tasks are finished before return
+	void Stop();
+
+private:
+	struct Queue {
+		std::deque<std::pair<Clock::time_point, Task>> tasks;
+		std::condition_variable cond;
+	};
+
+	void run(Queue &queue);
+
+	ExecutorConfig config_;
+	std::mutex mtx_;
+	Queue queues_[kCmdClassCount];
+	std::vector<std::thread> workers_;
+	bool terminate_ = false;
+};
+
+}  // namespace cproto
+}  // namespace net
+}  // namespace reindexer
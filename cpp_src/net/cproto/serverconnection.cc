@@ -10,9 +10,11 @@ namespace cproto {
 
 const auto kCProtoTimeoutSec = 300.;
 const auto kUpdatesResendTimeout = 0.1;
+// Maximum count of calls of connection, which wait for executor. Calls above limit are rejected without copy of their data
+const size_t kMaxPendingCalls = 1024;
 
-ServerConnection::ServerConnection(int fd, ev::dynamic_loop &loop, Dispatcher &dispatcher)
-	: net::ConnectionST(fd, loop), dispatcher_(dispatcher) {
+ServerConnection::ServerConnection(int fd, ev::dynamic_loop &loop, Dispatcher &dispatcher, Executor *executor)
+	: net::ConnectionST(fd, loop), dispatcher_(dispatcher), executor_(executor) {
 	timeout_.start(kCProtoTimeoutSec);
 	updates_async_.set<ServerConnection, &ServerConnection::async_cb>(this);
 	updates_timeout_.set<ServerConnection, &ServerConnection::timeout_cb>(this);
@@ -27,6 +29,8 @@ ServerConnection::ServerConnection(int fd, ev::dynamic_loop &loop, Dispatcher &d
 
 bool ServerConnection::Restart(int fd) {
 	restart(fd);
+	closePending_ = false;
+	peerAcceptsCompressed_.store(false, std::memory_order_relaxed);
 	timeout_.start(kCProtoTimeoutSec);
 	updates_async_.start();
 	callback(io_, ev::READ);
@@ -39,8 +43,10 @@ void ServerConnection::Attach(ev::dynamic_loop &loop) {
 		attach(loop);
 
 		timeout_.start(kCProtoTimeoutSec);
+		std::unique_lock<std::mutex> lck(updates_mtx_);
 		updates_async_.set(loop);
 		updates_async_.start();
+		lck.unlock();
 		updates_timeout_.set(loop);
 		updates_timeout_.start(kUpdatesResendTimeout, kUpdatesResendTimeout);
 	}
@@ -49,21 +55,34 @@ void ServerConnection::Attach(ev::dynamic_loop &loop) {
 void ServerConnection::Detach() {
 	if (attached_) {
 		detach();
+		// Executor's workers are sending updates_async_ under updates_mtx_
+		std::unique_lock<std::mutex> lck(updates_mtx_);
 		updates_async_.stop();
 		updates_async_.reset();
+		lck.unlock();
 		updates_timeout_.stop();
 		updates_timeout_.reset();
 	}
 }
 
 void ServerConnection::onClose() {
+	pendingCalls_.clear();
+	if (callInProgress_.load(std::memory_order_acquire)) {
+		closePending_ = true;
+		return;
+	}
+	closeClient();
+}
+
+void ServerConnection::closeClient() {
 	if (dispatcher_.onClose_) {
-		Context ctx{"", nullptr, this, {{}, {}}, false};
+		Context ctx{"", nullptr, this, {{}, {}, {}}, false};
 		dispatcher_.onClose_(ctx, errOK);
 	}
 	clientData_.reset();
 	updates_mtx_.lock();
 	updates_.clear();
+	responses_.clear();
 	updates_mtx_.unlock();
 }
 
@@ -76,10 +95,36 @@ void ServerConnection::handleRPC(Context &ctx) {
 }
 
 void ServerConnection::onRead() {
+	parseCalls();
+	if (executor_) {
+		dispatchCall();
+		takeResponses();
+	}
+}
+
+void ServerConnection::parseCall(const CProtoHeader &hdr, string_view payload, RPCCall &call) {
+	call.cmd = CmdCode(hdr.cmd);
+	call.seq = hdr.seq;
+	call.pointSelect = hdr.pointSelect;
+	Serializer ser(payload);
+	call.execTimeout_ = milliseconds(0);
+
+	call.args.Unpack(ser);
+
+	if (!ser.Eof()) {
+		Args ctxArgs;
+		ctxArgs.Unpack(ser);
+		if (ctxArgs.size() > 0) {
+			call.execTimeout_ = milliseconds(int64_t(ctxArgs[0]));
+		}
+	}
+}
+
+void ServerConnection::parseCalls() {
 	CProtoHeader hdr;
 
 	while (!closeConn_) {
-		Context ctx{clientAddr_, nullptr, this, {{}, {}}, false};
+		Context ctx{clientAddr_, nullptr, this, {{}, {}, {}}, false};
 
 		auto len = rdBuf_.peek(reinterpret_cast<char *>(&hdr), sizeof(hdr));
 		if (len < sizeof(hdr)) return;
@@ -116,25 +161,42 @@ void ServerConnection::onRead() {
 		}
 		assert(it.size() >= hdr.len);
 
-		ctx.call = &call_;
+		if (hdr.acceptCompressed && hdr.version >= kCprotoMinSnappyVersion) {
+			peerAcceptsCompressed_.store(true, std::memory_order_relaxed);
+		}
+
 		try {
 			ctx.stat.sizeStat.reqSizeBytes = hdr.len + sizeof(hdr);
-			ctx.call->cmd = CmdCode(hdr.cmd);
-			ctx.call->seq = hdr.seq;
-			Serializer ser(it.data(), hdr.len);
-			ctx.call->execTimeout_ = milliseconds(0);
-
-			ctx.call->args.Unpack(ser);
-
-			if (!ser.Eof()) {
-				Args ctxArgs;
-				ctxArgs.Unpack(ser);
-				if (ctxArgs.size() > 0) {
-					ctx.call->execTimeout_ = milliseconds(int64_t(ctxArgs[0]));
+			string_view payload(it.data(), hdr.len);
+			if (executor_ && pendingCalls_.size() >= kMaxPendingCalls) {
+				call_.cmd = CmdCode(hdr.cmd);
+				call_.seq = hdr.seq;
+				call_.args.clear();
+				call_.pointSelect = hdr.pointSelect;
+				ctx.call = &call_;
+				ctx.stat.queueStat.rejected = true;
+				responceRPC(ctx, Error(errOverloaded, "Too many pending calls of connection: %d", pendingCalls_.size()), Args());
+			} else if (executor_) {
+				// Call is executed by executor later, so it's data is copied out of read buffer
+				std::unique_ptr<PendingCall> pc(new PendingCall);
+				if (hdr.compressed) {
+					UncompressPayload(payload, pc->data);
+				} else {
+					pc->data.assign(payload.data(), payload.size());
 				}
+				pc->reqSize = ctx.stat.sizeStat.reqSizeBytes;
+				ctx.call = &pc->call;
+				parseCall(hdr, pc->data, pc->call);
+				pendingCalls_.emplace_back(std::move(pc));
+			} else {
+				if (hdr.compressed) {
+					UncompressPayload(payload, uncompressed_);
+					payload = uncompressed_;
+				}
+				ctx.call = &call_;
+				parseCall(hdr, payload, call_);
+				handleRPC(ctx);
 			}
-
-			handleRPC(ctx);
 		} catch (const Error &err) {
 			// Execption occurs on unrecoverble error. Send responce, and drop connection
 			fprintf(stderr, "drop connect, reason: %s\n", err.what().c_str());
@@ -143,17 +205,22 @@ void ServerConnection::onRead() {
 		}
 
 		rdBuf_.erase(hdr.len);
-		timeout_.start(kCProtoTimeoutSec);
+		// Connection is not timed out, while it's call is executed
+		if (!callInProgress_.load(std::memory_order_acquire)) timeout_.start(kCProtoTimeoutSec);
 	}
 }
 
 chunk ServerConnection::packRPC(chunk chunk, Context &ctx, const Error &status, const Args &args) {
 	WrSerializer ser(std::move(chunk));
 
+	const bool compress = peerAcceptsCompressed_.load(std::memory_order_relaxed);
 	CProtoHeader hdr;
 	hdr.len = 0;
 	hdr.magic = kCprotoMagic;
 	hdr.version = kCprotoVersion;
+	hdr.compressed = 0;
+	hdr.acceptCompressed = compress;
+	hdr._reserved = 0;
 	if (ctx.call != nullptr) {
 		hdr.cmd = ctx.call->cmd;
 		hdr.seq = ctx.call->seq;
@@ -167,6 +234,7 @@ chunk ServerConnection::packRPC(chunk chunk, Context &ctx, const Error &status,
 	ser.PutVString(status.what());
 	args.Pack(ser);
 	reinterpret_cast<CProtoHeader *>(ser.Buf())->len = ser.Len() - sizeof(hdr);
+	if (compress) CompressFrame(ser);
 
 	if (dispatcher_.onResponse_) {
 		ctx.stat.sizeStat.respSizeBytes = ser.Len();
@@ -182,7 +250,14 @@ void ServerConnection::responceRPC(Context &ctx, const Error &status, const Args
 		return;
 	}
 
-	wrBuf_.write(packRPC(wrBuf_.get_chunk(), ctx, status, args));
+	if (executor_) {
+		// Responses of executor's workers are passed to connection's thread
+		auto packed = packRPC(chunk(), ctx, status, args);
+		std::lock_guard<std::mutex> lck(updates_mtx_);
+		responses_.emplace_back(std::move(packed));
+	} else {
+		wrBuf_.write(packRPC(wrBuf_.get_chunk(), ctx, status, args));
+	}
 	ctx.respSent = true;
 	// if (canWrite_) {
 	// 	write_cb();
@@ -195,7 +270,7 @@ void ServerConnection::responceRPC(Context &ctx, const Error &status, const Args
 
 void ServerConnection::CallRPC(CmdCode cmd, const Args &args) {
 	RPCCall call{cmd, 0, {}, milliseconds(0)};
-	cproto::Context ctx{"", &call, this, {{}, {}}, false};
+	cproto::Context ctx{"", &call, this, {{}, {}, {}}, false};
 	auto packed = packRPC(chunk(), ctx, errOK, args);
 	updates_mtx_.lock();
 	updates_.emplace_back(std::move(packed));
@@ -203,6 +278,74 @@ void ServerConnection::CallRPC(CmdCode cmd, const Args &args) {
 	// async_.send();
 }
 
+void ServerConnection::dispatchCall() {
+	while (!callInProgress_.load(std::memory_order_acquire) && !pendingCalls_.empty()) {
+		activeCall_ = std::move(pendingCalls_.front());
+		pendingCalls_.pop_front();
+		PendingCall *pc = activeCall_.get();
+		const CmdClass cls = GetCmdClass(pc->call);
+
+		callInProgress_.store(true, std::memory_order_release);
+		if (executor_->Push(cls, [this, pc](std::chrono::microseconds queueWait) { execCall(*pc, queueWait); })) {
+			timeout_.stop();
+		} else {
+			callInProgress_.store(false, std::memory_order_release);
+			Context ctx{clientAddr_, &pc->call, this, {{}, {}, {}}, false};
+			ctx.stat.sizeStat.reqSizeBytes = pc->reqSize;
+			ctx.stat.queueStat.rejected = true;
+			responceRPC(ctx, Error(errOverloaded, "Server is overloaded with '%s' calls", CmdClassName(cls)), Args());
+			activeCall_.reset();
+		}
+	}
+}
+
+void ServerConnection::execCall(PendingCall &pc, std::chrono::microseconds queueWait) {
+	Context ctx{clientAddr_, &pc.call, this, {{}, {}, {}}, false};
+	ctx.stat.sizeStat.reqSizeBytes = pc.reqSize;
+	ctx.stat.queueStat.waitUs = queueWait.count();
+	try {
+		handleRPC(ctx);
+	} catch (const Error &err) {
+		if (!ctx.respSent) responceRPC(ctx, err, Args());
+	}
+
+	std::lock_guard<std::mutex> lck(updates_mtx_);
+	callDone_ = true;
+	updates_async_.send();
+}
+
+void ServerConnection::takeResponses() {
+	std::vector<chunk> responses;
+	updates_mtx_.lock();
+	responses.swap(responses_);
+	bool callDone = callDone_;
+	callDone_ = false;
+	updates_mtx_.unlock();
+
+	if (sock_.valid()) {
+		for (auto &ch : responses) wrBuf_.write(std::move(ch));
+	}
+
+	if (callDone) {
+		activeCall_.reset();
+		if (closePending_) {
+			closePending_ = false;
+			closeClient();
+		}
+		callInProgress_.store(false, std::memory_order_release);
+		if (sock_.valid()) timeout_.start(kCProtoTimeoutSec);
+		dispatchCall();
+	}
+}
+
+void ServerConnection::onAsync() {
+	if (executor_) {
+		takeResponses();
+		if (sock_.valid() && wrBuf_.size()) callback(io_, ev::WRITE);
+	}
+	sendUpdates();
+}
+
 void ServerConnection::sendUpdates() {
 	if (wrBuf_.size() + 10 > wrBuf_.capacity()) {
 		return;
@@ -212,7 +355,7 @@ void ServerConnection::sendUpdates() {
 	updates_mtx_.lock();
 	updates.swap(updates_);
 	updates_mtx_.unlock();
-	cproto::Context ctx{"", nullptr, this, {{}, {}}, false};
+	cproto::Context ctx{"", nullptr, this, {{}, {}, {}}, false};
 	size_t len = 0;
 	if (updates.size() > 2) {
 		WrSerializer ser(wrBuf_.get_chunk());
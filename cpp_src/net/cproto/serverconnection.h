@@ -1,7 +1,10 @@
 #pragma once
 
 #include <string.h>
+#include <atomic>
+#include <deque>
 #include "dispatcher.h"
+#include "executor.h"
 #include "net/connection.h"
 #include "net/iserverconnection.h"
 #include "replicator/updatesobserver.h"
@@ -14,14 +17,15 @@ using reindexer::h_vector;
 
 class ServerConnection : public ConnectionST, public IServerConnection, public Writer {
 public:
-	ServerConnection(int fd, ev::dynamic_loop &loop, Dispatcher &dispatcher);
+	/// @param executor - executor of calls. If nullptr, calls are executed by connection's I/O thread
+	ServerConnection(int fd, ev::dynamic_loop &loop, Dispatcher &dispatcher, Executor *executor = nullptr);
 
 	// IServerConnection interface implementation
-	static ConnectionFactory NewFactory(Dispatcher &dispatcher) {
-		return [&dispatcher](ev::dynamic_loop &loop, int fd) { return new ServerConnection(fd, loop, dispatcher); };
+	static ConnectionFactory NewFactory(Dispatcher &dispatcher, Executor *executor = nullptr) {
+		return [&dispatcher, executor](ev::dynamic_loop &loop, int fd) { return new ServerConnection(fd, loop, dispatcher, executor); };
 	}
 
-	bool IsFinished() override final { return !sock_.valid(); }
+	bool IsFinished() override final { return !sock_.valid() && !callInProgress_.load(std::memory_order_acquire); }
 	bool Restart(int fd) override final;
 	void Detach() override final;
 	void Attach(ev::dynamic_loop &loop) override final;
@@ -33,23 +37,53 @@ public:
 	ClientData::Ptr GetClientData() override final { return clientData_; }
 
 protected:
+	// Call, waiting for execution by executor
+	struct PendingCall {
+		RPCCall call;
+		// Raw data of call. Args of call are referencing it
+		std::string data;
+		size_t reqSize;
+	};
+
 	void onRead() override;
 	void onClose() override;
+	void parseCalls();
+	void parseCall(const CProtoHeader &hdr, string_view payload, RPCCall &call);
 	void handleRPC(Context &ctx);
+	// Pass the next pending call to executor. Calls of connection are executed one by one in order of receiving
+	void dispatchCall();
+	void execCall(PendingCall &pc, std::chrono::microseconds queueWait);
+	// Move responses, prepared by executor, to write buffer
+	void takeResponses();
+	void closeClient();
 	chunk packRPC(chunk chunk, Context &ctx, const Error &status, const Args &args);
 	void responceRPC(Context &ctx, const Error &error, const Args &args);
-	void async_cb(ev::async &) { sendUpdates(); }
-	void timeout_cb(ev::periodic &, int) { sendUpdates(); }
+	void async_cb(ev::async &) { onAsync(); }
+	void timeout_cb(ev::periodic &, int) { onAsync(); }
+	void onAsync();
 	void sendUpdates();
 
 	Dispatcher &dispatcher_;
 	ClientData::Ptr clientData_;
 	// keep here to prevent allocs
 	RPCCall call_;
+	std::string uncompressed_;
+	// Client accepts compressed responses
+	std::atomic<bool> peerAcceptsCompressed_{false};
 	std::vector<chunk> updates_;
 	std::mutex updates_mtx_;
 	ev::periodic updates_timeout_;
 	ev::async updates_async_;
+
+	Executor *executor_;
+	std::deque<std::unique_ptr<PendingCall>> pendingCalls_;
+	std::unique_ptr<PendingCall> activeCall_;
+	std::atomic<bool> callInProgress_{false};
+	// Connection is closed, while call is in progress. Client is closed on call finish
+	bool closePending_ = false;
+	// Responses and state of active call, guarded by updates_mtx_
+	std::vector<chunk> responses_;
+	bool callDone_ = false;
 };
 }  // namespace cproto
 }  // namespace net
@@ -118,6 +118,12 @@ struct Request {
 
 class Writer {
 public:
+	/// Producer of response body parts. Called each time, when connection is ready to send the next part of body
+	/// @return false, if body is complete
+	using Streamer = std::function<bool(Writer &)>;
+	/// Resumes suspended streaming of response. May be called from any thread, even after connection is closed
+	using Resumer = std::function<void()>;
+
 	virtual ssize_t Write(chunk &&ch) = 0;
 	virtual ssize_t Write(string_view data) = 0;
 	virtual chunk GetChunk() = 0;
@@ -126,6 +132,12 @@ public:
 	virtual bool SetRespCode(int code) = 0;
 	virtual bool SetContentLength(size_t len) = 0;
 	virtual bool SetConnectionClose() = 0;
+	/// Send response body by parts with chunked transfer encoding after return from handler.
+	/// Memory, used by response, is limited to parts, which are not sent to socket yet
+	virtual void Stream(Streamer streamer) = 0;
+	/// Suspend streaming of response: streamer is not called anymore, until the returned resumer is called. Lets streamer produce
+	/// the next part outside of connection's I/O thread. Can be called by streamer only, which has to return true in this case
+	virtual Resumer Suspend() = 0;
 
 	virtual int RespCode() = 0;
 	virtual ssize_t Written() = 0;
@@ -19,24 +19,51 @@ ServerConnection::ServerConnection(int fd, ev::dynamic_loop &loop, Router &route
 	callback(io_, ev::READ);
 }
 
+ServerConnection::~ServerConnection() { dropSuspended(); }
+
 bool ServerConnection::Restart(int fd) {
 	restart(fd);
 	bodyLeft_ = 0;
 	formData_ = false;
 	enableHttp11_ = false;
 	expectContinue_ = false;
+	streamWriter_.reset();
+	streamCtx_ = Context();
 	callback(io_, ev::READ);
 	return true;
 }
 
 void ServerConnection::Attach(ev::dynamic_loop &loop) {
-	if (!attached_) attach(loop);
+	if (attached_) return;
+	if (!suspended_) {
+		attach(loop);
+		return;
+	}
+	// Resumer of suspended streaming sends async_ concurrently. Resume, which is sent while connection is detached, is repeated
+	std::lock_guard<std::mutex> lck(suspended_->mtx);
+	attach(loop);
+	async_.start();
+	if (suspended_->resumed) async_.send();
 }
 void ServerConnection::Detach() {
-	if (attached_) detach();
+	if (!attached_) return;
+	std::unique_lock<std::mutex> lck;
+	if (suspended_) lck = std::unique_lock<std::mutex>(suspended_->mtx);
+	detach();
 }
 
-void ServerConnection::onClose() {}
+void ServerConnection::onClose() {
+	dropSuspended();
+	streamWriter_.reset();
+	streamCtx_ = Context();
+}
+
+void ServerConnection::onWrite() {
+	if (!streamWriter_) return;
+	stream();
+	// Handle pipelined requests, which were received before response was finished
+	if (!streamWriter_ && rdBuf_.size() && !closeConn_) onRead();
+}
 
 void ServerConnection::setJsonStatus(Context &ctx, bool success, int responseCode, const string &status) {
 	WrSerializer ser;
@@ -57,8 +84,10 @@ void ServerConnection::handleRequest(Request &req) {
 	ctx.body = &reader;
 	ctx.stat.sizeStat.reqSizeBytes = req.size;
 
+	bool streamed = false;
 	try {
 		router_.handle(ctx);
+		streamed = writer.IsStreamed();
 	} catch (const HttpStatus &status) {
 		if (!writer.IsRespSent()) {
 			setJsonStatus(ctx, false, status.code, status.what);
@@ -68,6 +97,20 @@ void ServerConnection::handleRequest(Request &req) {
 			setJsonStatus(ctx, false, StatusInternalServerError, status.what());
 		}
 	}
+	if (streamed) {
+		// Request remains in read buffer until response is finished, so reading from socket is paused
+		streamWriter_.reset(new ResponseWriter(std::move(writer)));
+		streamCtx_ = ctx;
+		streamCtx_.writer = streamWriter_.get();
+		streamCtx_.body = nullptr;
+		readPaused_ = true;
+		stream();
+		return;
+	}
+	finishRequest(ctx);
+}
+
+void ServerConnection::finishRequest(Context &ctx) {
 	router_.log(ctx);
 
 	ctx.writer->Write(string_view());
@@ -77,6 +120,62 @@ void ServerConnection::handleRequest(Request &req) {
 	}
 }
 
+void ServerConnection::stream() {
+	bool finished = false, broken = false;
+	try {
+		while (wrBuf_.size() < kHttpStreamWindow && !finished) {
+			// Streamer is producing the next part. Streaming is continued by async_, when it's ready
+			if (suspended_ && !takeResumed()) return;
+			finished = !streamWriter_->StreamNext();
+		}
+	} catch (const HttpStatus &status) {
+		broken = streamWriter_->IsRespSent();
+		if (!broken) setJsonStatus(streamCtx_, false, status.code, status.what);
+		finished = true;
+	} catch (const Error &status) {
+		broken = streamWriter_->IsRespSent();
+		if (!broken) setJsonStatus(streamCtx_, false, StatusInternalServerError, status.what());
+		finished = true;
+	}
+	if (!finished) return;
+
+	if (broken) {
+		// Response is partially sent: close connection without final chunk, so client will not accept truncated body
+		closeConn_ = true;
+		router_.log(streamCtx_);
+		streamCtx_.stat.sizeStat.respSizeBytes = streamWriter_->Written();
+		if (router_.onResponse_) {
+			router_.onResponse_(streamCtx_);
+		}
+	} else {
+		finishRequest(streamCtx_);
+	}
+	dropSuspended();
+	streamWriter_.reset();
+	streamCtx_ = Context();
+	readPaused_ = false;
+	if (broken && !wrBuf_.size()) closeConn();
+}
+
+bool ServerConnection::takeResumed() {
+	{
+		std::lock_guard<std::mutex> lck(suspended_->mtx);
+		if (!suspended_->resumed) return false;
+		suspended_->async = nullptr;
+	}
+	suspended_.reset();
+	return true;
+}
+
+void ServerConnection::dropSuspended() {
+	if (!suspended_) return;
+	{
+		std::lock_guard<std::mutex> lck(suspended_->mtx);
+		suspended_->async = nullptr;
+	}
+	suspended_.reset();
+}
+
 void ServerConnection::badRequest(int code, const char *msg) {
 	ResponseWriter writer(this);
 	HandlerStat stat;
@@ -142,7 +241,7 @@ void ServerConnection::onRead() {
 	int minor_version = 0;
 	struct phr_header headers[kHttpMaxHeaders];
 
-	while (rdBuf_.size()) {
+	while (rdBuf_.size() && !streamWriter_) {
 		if (!bodyLeft_) {
 			auto chunk = rdBuf_.tail();
 
@@ -311,6 +410,19 @@ ssize_t ServerConnection::ResponseWriter::Write(string_view data) {
 }
 chunk ServerConnection::ResponseWriter::GetChunk() { return conn_->wrBuf_.get_chunk(); }
 
+Writer::Resumer ServerConnection::ResponseWriter::Suspend() {
+	assert(!conn_->suspended_);
+	auto suspended = std::make_shared<SuspendedStream>();
+	suspended->async = &conn_->async_;
+	conn_->async_.start();
+	conn_->suspended_ = suspended;
+	return [suspended]() {
+		std::lock_guard<std::mutex> lck(suspended->mtx);
+		suspended->resumed = true;
+		if (suspended->async) suspended->async->send();
+	};
+}
+
 bool ServerConnection::ResponseWriter::SetConnectionClose() {
 	conn_->closeConn_ = true;
 	return true;
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string.h>
+#include <memory>
+#include <mutex>
 #include "net/connection.h"
 #include "net/iserverconnection.h"
 #include "picohttpparser/picohttpparser.h"
@@ -13,9 +15,12 @@ namespace http {
 
 const ssize_t kHttpMaxHeaders = 128;
 const ssize_t kHttpMaxBodySize = 2 * 1024 * 1024LL;
+// Max count of pending write buffer chunks, when next part of streamed response is requested
+const unsigned kHttpStreamWindow = 16;
 class ServerConnection : public IServerConnection, public ConnectionST {
 public:
 	ServerConnection(int fd, ev::dynamic_loop &loop, Router &router);
+	~ServerConnection();
 
 	static ConnectionFactory NewFactory(Router &router) {
 		return [&router](ev::dynamic_loop &loop, int fd) { return new ServerConnection(fd, loop, router); };
@@ -44,11 +49,15 @@ protected:
 		virtual bool SetRespCode(int code) override final;
 		virtual bool SetContentLength(size_t len) override final;
 		virtual bool SetConnectionClose() override final;
+		virtual void Stream(Streamer streamer) override final { streamer_ = std::move(streamer); }
+		virtual Resumer Suspend() override final;
 		ssize_t Write(chunk &&chunk) override final;
 		ssize_t Write(string_view data) override final;
 		virtual chunk GetChunk() override final;
 
 		bool IsRespSent() { return respSend_; }
+		bool IsStreamed() { return bool(streamer_); }
+		bool StreamNext() { return streamer_(*this); }
 		virtual int RespCode() override final { return code_; }
 		virtual ssize_t Written() override final { return written_; }
 
@@ -61,12 +70,28 @@ protected:
 		bool respSend_ = false;
 		ssize_t contentLength_ = -1, written_ = 0;
 		ServerConnection *conn_;
+		Streamer streamer_;
+	};
+
+	// Suspended streaming of response. It's shared with resumer, which may be called after the connection is closed or destroyed
+	struct SuspendedStream {
+		std::mutex mtx;
+		// Async watcher of connection, which is waiting for resume. nullptr, if connection doesn't wait for it anymore
+		ev::async *async = nullptr;
+		bool resumed = false;
 	};
 
 	void handleRequest(Request &req);
+	void finishRequest(Context &ctx);
+	void stream();
+	// Finish suspension of streaming, if it's resumed
+	bool takeResumed();
+	// Stop waiting for resume of streaming. Resumer, called after it, does nothing
+	void dropSuspended();
 	void badRequest(int code, const char *msg);
 	void onRead() override;
 	void onClose() override;
+	void onWrite() override;
 
 	void parseParams(const string_view &str);
 	void writeHttpResponse(int code);
@@ -79,6 +104,11 @@ protected:
 	bool enableHttp11_ = false;
 	bool expectContinue_ = false;
 	phr_chunked_decoder chunked_decoder_{0, 0, 0, 0};
+	// Response, which body is being streamed
+	std::unique_ptr<ResponseWriter> streamWriter_;
+	Context streamCtx_;
+	// Streaming, which is suspended by streamer (see Writer::Suspend). Connection is resumed by async_
+	std::shared_ptr<SuspendedStream> suspended_;
 	// cbuf<char> tmpBuf_;
 };
 }  // namespace http
@@ -33,9 +33,17 @@ struct SizeStat {
 	size_t respSizeBytes{0};
 };
 
+struct QueueStat {
+	// Time, which call has spent in executor's queue
+	uint64_t waitUs{0};
+	// Call has been rejected due to executor's queue overflow
+	bool rejected{false};
+};
+
 struct Stat {
 	HandlerStat allocStat;
 	SizeStat sizeStat;
+	QueueStat queueStat;
 };
 
 class TrafficStat {
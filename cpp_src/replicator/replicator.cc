@@ -8,13 +8,32 @@
 #include "core/reindexerimpl.h"
 #include "tools/logger.h"
 #include "tools/stringstools.h"
+#include "tools/timetools.h"
 #include "walrecord.h"
+#include "walselecter.h"
 
 namespace reindexer {
 
 using namespace net;
 
 static constexpr size_t kTmpNsPostfixLen = 20;
+// The first version of master, which selects items of WAL query by ranges of ids ('#id' condition)
+static constexpr int kSnapshotByIdsVersion[] = {2, 3, 4};
+
+// Version of server is formatted as '2.3.4' or, by git describe, as 'v2.3.4-12-gdeadbee'
+static bool isSnapshotByIdsSupported(string_view version) {
+	if (!version.empty() && version[0] == 'v') version = version.substr(1);
+	const std::string str(version.data(), version.size());
+	const char *p = str.c_str();
+	for (int part : kSnapshotByIdsVersion) {
+		char *end = nullptr;
+		const long num = std::strtol(p, &end, 10);
+		if (end == p) return false;
+		if (num != part) return num > part;
+		p = (*end == '.') ? end + 1 : end;
+	}
+	return true;
+}
 
 Replicator::Replicator(ReindexerImpl *slave) : slave_(slave), terminate_(false), state_(StateInit), enabled_(false) {
 	stop_.set(loop_);
@@ -33,7 +52,7 @@ Error Replicator::Start() {
 
 	master_.reset(
 		new client::Reindexer(client::ReindexerConfig(config_.connPoolSize, config_.workerThreads, 10000,
-													  std::chrono::seconds(config_.timeoutSec), std::chrono::seconds(config_.timeoutSec))));
+													  std::chrono::seconds(config_.timeoutSec), std::chrono::seconds(config_.timeoutSec), true)));
 
 	auto err = master_->Connect(config_.masterDSN);
 	terminate_ = false;
@@ -107,7 +126,19 @@ Error Replicator::syncDatabase() {
 	vector<NamespaceDef> nses;
 	logPrintf(LogInfo, "[repl] Starting sync from '%s'", config_.masterDSN);
 
-	Error err = master_->EnumNamespaces(nses, false);
+	string masterVersion;
+	Error err = master_->GetServerVersion(masterVersion);
+	if (!err.ok()) {
+		logPrintf(LogError, "[repl] GetServerVersion error: %s", err.what());
+		return err;
+	}
+	snapshotByIds_ = isSnapshotByIdsSupported(masterVersion);
+	if (!snapshotByIds_ && config_.snapshotChunkSize > 0) {
+		logPrintf(LogWarning, "[repl] Master's version '%s' doesn't support snapshot sync, namespaces are synced by full select",
+				  masterVersion);
+	}
+
+	err = master_->EnumNamespaces(nses, false);
 	if (!err.ok()) {
 		logPrintf(LogError, "[repl] EnumNamespaces error: %s", err.what());
 		return err;
@@ -118,72 +149,89 @@ Error Replicator::syncDatabase() {
 	state_.store(StateSyncing, std::memory_order_release);
 	syncMtx_.unlock();
 
-	// Loop for all master namespaces
-	for (auto &ns : nses) {
-		// skip system & non enabled namespaces
-		if (!isSyncEnabled(ns.name)) continue;
+	// Namespaces are synced concurrently, one namespace per connection of pool
+	std::atomic<size_t> nextNs{0};
+	std::mutex errMtx;
+	auto syncRoutine = [&]() {
+		for (size_t i = nextNs++; i < nses.size() && !terminate_; i = nextNs++) {
+			// skip system & non enabled namespaces
+			if (!isSyncEnabled(nses[i].name)) continue;
+			Error nsErr = syncNamespace(nses[i]);
+			if (!nsErr.ok()) {
+				std::lock_guard<std::mutex> lck(errMtx);
+				err = nsErr;
+			}
+		}
+	};
+	const size_t threadsCount = std::min(nses.size(), size_t(std::max(config_.connPoolSize, 1)));
+	vector<std::thread> threads;
+	for (size_t i = 1; i < threadsCount; ++i) threads.emplace_back(syncRoutine);
+	syncRoutine();
+	for (auto &th : threads) th.join();
 
-		if (terminate_) break;
+	state_.store(StateIdle, std::memory_order_release);
 
-		auto openErr = slave_->OpenNamespace(ns.name, StorageOpts().Enabled().SlaveMode());
-		if (!openErr.ok()) {
-			logPrintf(LogError, "[repl:%s] Error: %s", ns.name, openErr.what());
-		}
+	return err;
+}
 
-		// Protect for concurent updates stream of same namespace
-		// if state is StateSync is set, then concurent updates will not modify data, but just set maxLsn_
+Error Replicator::syncNamespace(const NamespaceDef &ns) {
+	Error err;
+	auto openErr = slave_->OpenNamespace(ns.name, StorageOpts().Enabled().SlaveMode());
+	if (!openErr.ok()) {
+		logPrintf(LogError, "[repl:%s] Error: %s", ns.name, openErr.what());
+	}
 
-		for (bool done = false; err.ok() && !done && !terminate_;) {
-			if (openErr.ok()) {
-				err = syncNamespaceByWAL(ns);
+	// Protect for concurent updates stream of same namespace
+	// if state is StateSync is set, then concurent updates will not modify data, but just set maxLsn_
+
+	for (bool done = false; err.ok() && !done && !terminate_;) {
+		if (openErr.ok()) {
+			err = syncNamespaceByWAL(ns);
+			if (!err.ok()) {
+				logPrintf(LogError, "[repl:%s] syncNamespace error: %s", ns.name, err.what());
+				if (err.code() == errDataHashMismatch && !terminate_) {
+					if (config_.forceSyncOnWrongDataHash) {
+						err = syncNamespaceForced(ns, "DataHash mismatch");
+					} else {
+						err = errOK;
+					}
+				} else if (err.code() != errNetwork && !terminate_ && config_.forceSyncOnLogicError) {
+					err = syncNamespaceForced(ns, "Logic error occurried");
+				} else
+					break;
 				if (!err.ok()) {
 					logPrintf(LogError, "[repl:%s] syncNamespace error: %s", ns.name, err.what());
-					if (err.code() == errDataHashMismatch && !terminate_) {
-						if (config_.forceSyncOnWrongDataHash) {
-							err = syncNamespaceForced(ns, "DataHash mismatch");
-						} else {
-							err = errOK;
-						}
-					} else if (err.code() != errNetwork && !terminate_ && config_.forceSyncOnLogicError) {
-						err = syncNamespaceForced(ns, "Logic error occurried");
-					} else
-						break;
-					if (!err.ok()) {
-						logPrintf(LogError, "[repl:%s] syncNamespace error: %s", ns.name, err.what());
-						break;
-					}
+					break;
+				}
+			}
+		} else {
+			openErr = err = syncNamespaceForced(ns, "Can't open namespace");
+		}
+		if (err.ok()) {
+			int64_t curLSN = -1;
+			try {
+				curLSN = slave_->getNamespace(ns.name, dummyCtx_)->GetReplState(dummyCtx_).lastLsn;
+				std::lock_guard<std::mutex> lck(syncMtx_);
+				// Check, if concurrent update attempt happened with LSN bigger, than current LSN
+				// In this case retry sync
+				if (maxLsns_[ns.name] <= curLSN) {
+					done = true;
+					maxLsns_.erase(ns.name);
 				}
-			} else {
-				openErr = err = syncNamespaceForced(ns, "Can't open namespace");
+			} catch (const Error &e) {
+				err = e;
 			}
-			if (err.ok()) {
-				int64_t curLSN = -1;
+		} else {
+			if (openErr.ok()) {
 				try {
-					curLSN = slave_->getNamespace(ns.name, dummyCtx_)->GetReplState(dummyCtx_).lastLsn;
-					std::lock_guard<std::mutex> lck(syncMtx_);
-					// Check, if concurrent update attempt happened with LSN bigger, than current LSN
-					// In this case retry sync
-					if (maxLsns_[ns.name] <= curLSN) {
-						done = true;
-						maxLsns_.erase(ns.name);
-					}
+					slave_->getNamespace(ns.name, dummyCtx_)->SetSlaveReplError(err, dummyCtx_);
 				} catch (const Error &e) {
 					err = e;
 				}
-			} else {
-				if (openErr.ok()) {
-					try {
-						slave_->getNamespace(ns.name, dummyCtx_)->SetSlaveReplError(err, dummyCtx_);
-					} catch (const Error &e) {
-						err = e;
-					}
-				}
-				logPrintf(LogError, "Sync error: %s", err.what());
 			}
+			logPrintf(LogError, "Sync error: %s", err.what());
 		}
 	}
-	state_.store(StateIdle, std::memory_order_release);
-
 	return err;
 }
 
@@ -201,6 +249,7 @@ Error Replicator::syncNamespaceByWAL(const NamespaceDef &ns) {
 	int64_t lsn = slaveNs->GetReplState(dummyCtx_).lastLsn;
 
 	logPrintf(LogTrace, "[repl:%s] Start sync items, lsn %ld", ns.name, lsn);
+	beginSyncStat(ns.name, "wal"_sv);
 
 	//  Make query to master's WAL
 	client::QueryResults qr(kResultsWithPayloadTypes | kResultsCJson | kResultsWithItemID | kResultsWithRaw);
@@ -211,13 +260,16 @@ Error Replicator::syncNamespaceByWAL(const NamespaceDef &ns) {
 			// Check if WAL has been outdated, if yes, then force resync
 			return syncNamespaceForced(ns, err.what());
 		case errOK:
-			return applyWAL(ns.name, qr);
+			err = applyWAL(ns.name, qr);
+			break;
 		case errNoWAL:
 			terminate_ = true;
-			return err;
+			break;
 		default:
-			return err;
+			break;
 	}
+	endSyncStat(ns.name, err);
+	return err;
 }
 
 // Foced namespace sync
@@ -225,6 +277,8 @@ Error Replicator::syncNamespaceByWAL(const NamespaceDef &ns) {
 // read all indexes and data from master, then apply to slave
 Error Replicator::syncNamespaceForced(const NamespaceDef &ns, string_view reason) {
 	logPrintf(LogWarning, "[repl:%s] Start FORCED sync: %s", ns.name, reason);
+	const bool snapshot = config_.snapshotChunkSize > 0 && snapshotByIds_;
+	beginSyncStat(ns.name, snapshot ? "snapshot"_sv : "forced"_sv);
 
 	// Create temporary namespace
 	NamespaceDef tmpNsDef;
@@ -234,6 +288,7 @@ Error Replicator::syncNamespaceForced(const NamespaceDef &ns, string_view reason
 	auto err = slave_->AddNamespace(tmpNsDef);
 	if (!err.ok()) {
 		logPrintf(LogWarning, "Unable to create temporary namespace %s for the force sync: %s", tmpNsDef.name, err.what());
+		endSyncStat(ns.name, err);
 		return err;
 	}
 
@@ -241,36 +296,205 @@ Error Replicator::syncNamespaceForced(const NamespaceDef &ns, string_view reason
 		tmpNs = slave_->getNamespace(tmpNsDef.name, dummyCtx_);
 	} catch (const Error &exErr) {
 		logPrintf(LogWarning, "Unable to get temporary namespace %s for the force sync: %s", tmpNsDef.name, err.what());
+		endSyncStat(ns.name, exErr);
 		return exErr;
 	}
-	err = syncIndexesForced(tmpNs, ns);
-	if (err.ok()) err = syncMetaForced(tmpNs);
 
-	//  Make query to complete master's namespace data
-	client::QueryResults qr(kResultsWithPayloadTypes | kResultsCJson | kResultsWithItemID | kResultsWithRaw);
-	if (err.ok()) err = master_->Select(Query(ns.name).Where("#lsn", CondAny, {}), qr);
-	if (err.ok()) {
-		tmpNs->ReplaceTagsMatcher(qr.getTagsMatcher(0), dummyCtx_);
-		err = applyWAL(tmpNs, qr);
+	// Namespaces are enumerated once at the beginning of database sync, so indexes of namespace may be changed on master since then.
+	// Actual definition is taken after the first select of data, so its indexes are not older than data. Indexes, which are added
+	// in between, are added again by WAL records with the same definitions, and it's no-op
+	auto syncIndexes = [&]() -> Error {
+		vector<NamespaceDef> nses;
+		Error status = master_->EnumNamespaces(nses, false);
+		if (!status.ok()) return status;
+		auto it = std::find_if(nses.begin(), nses.end(), [&ns](const NamespaceDef &def) { return def.name == ns.name; });
+		status = syncIndexesForced(tmpNs, it != nses.end() ? *it : ns);
+		if (status.ok()) status = syncMetaForced(tmpNs);
+		return status;
+	};
+
+	if (snapshot) {
+		err = syncSnapshot(tmpNs, ns, syncIndexes);
+	} else {
+		//  Make query to complete master's namespace data
+		client::QueryResults qr(kResultsWithPayloadTypes | kResultsCJson | kResultsWithItemID | kResultsWithRaw);
+		err = master_->Select(Query(ns.name).Where("#lsn", CondAny, {}), qr);
+		if (err.ok()) err = syncIndexes();
+		if (err.ok()) {
+			tmpNs->ReplaceTagsMatcher(qr.getTagsMatcher(0), dummyCtx_);
+			err = applyWAL(tmpNs, qr, ns.name);
+		}
 	}
 	if (err.ok()) err = slave_->RenameNamespace(tmpNsDef.name, ns.name);
 	if (!err.ok()) {
 		auto dropErr = slave_->closeNamespace(tmpNsDef.name, dummyCtx_, true, true);
 		if (!dropErr.ok()) logPrintf(LogWarning, "Unable to drop temporary namespace %s: %s", tmpNsDef.name, dropErr.what());
 	}
+	endSyncStat(ns.name, err);
 
 	return err;
 }
 
+// Snapshot sync
+// Master's namespace data is fetched by chunks over several connections of pool. Chunk is a range of snapshotChunkSize item ids, so
+// items, which are deleted on master during transfer, don't shift the other chunks, and each chunk is selected without scan of the
+// previous ones. Ranges cover ids up to the count of item ids on master (ids are sparse, so it may exceed count of items).
+// Ids of items, which are inserted during transfer, may exceed ranges of chunks: they are fetched by the cursor over ids.
+// Each chunk is applied to slave namespace under single lock; indexes are not optimized until all the chunks are loaded.
+// Updates, which happened on master during snapshot transfer, are applied later from WAL
+Error Replicator::syncSnapshot(Namespace::Ptr slaveNs, const NamespaceDef &ns, const std::function<Error()> &syncIndexes) {
+	const int64_t chunkSize = config_.snapshotChunkSize;
+	const size_t fetchersCount = std::max(config_.connPoolSize, 1);
+	auto chunkQuery = [&](int64_t chunk) {
+		return Query(ns.name).Where("#lsn", CondAny, {}).Where(kWALIdField, CondRange, {chunk * chunkSize, (chunk + 1) * chunkSize - 1});
+	};
+
+	ReplicationState beginState;
+	std::mutex mtx;
+	Error err;
+	// Count of chunks, which are known from the count of item ids on master at the beginning of snapshot
+	int64_t chunksCount = 1;
+	std::atomic<int64_t> nextChunk{0};
+
+	// Fetches items by query and applies them to slave namespace
+	// @param fetched - count of fetched items
+	// @param lastId - max id of fetched items on master
+	auto fetchItems = [&](const Query &q, bool first, size_t &fetched, int &lastId) -> Error {
+		client::QueryResults qr(kResultsWithPayloadTypes | kResultsCJson | kResultsWithItemID | kResultsWithRaw);
+		Error status = master_->Select(q, qr);
+		if (first && status.ok()) status = syncIndexes();
+		if (!status.ok()) return status;
+		if (first) slaveNs->ReplaceTagsMatcher(qr.getTagsMatcher(0), dummyCtx_);
+
+		vector<Item> items;
+		items.reserve(chunkSize);
+		WrSerializer ser;
+		for (auto it : qr) {
+			if (!qr.Status().ok()) return qr.Status();
+			if (it.IsRaw()) {
+				WALRecord rec(it.GetRaw());
+				if (first && rec.type == WalReplState) beginState.FromJSON(giftStr(rec.data));
+				continue;
+			}
+			lastId = std::max(lastId, it.GetID());
+			ser.Reset();
+			status = it.GetCJSON(ser, false);
+			items.emplace_back();
+			if (status.ok()) status = itemFromCJson(it.GetLSN(), *slaveNs, ser.Slice(), qr.getTagsMatcher(0), items.back());
+			if (!status.ok()) return status;
+		}
+		if (first) {
+			if (beginState.clusterID != config_.clusterID) {
+				terminate_ = true;
+				return Error(errLogic, "Wrong cluster ID expect %d, got %d from master. Terminating replicator.", config_.clusterID,
+							 beginState.clusterID);
+			}
+			chunksCount = std::max<int64_t>((beginState.dataIdsCount + chunkSize - 1) / chunkSize, 1);
+			updateSyncStat(ns.name, [&](ReplicationSyncStat &stat) {
+				stat.itemsTotal = beginState.dataCount;
+				stat.chunksTotal = chunksCount;
+			});
+		}
+
+		try {
+			slaveNs->UpsertBulk(items, dummyCtx_);
+		} catch (const Error &e) {
+			return e;
+		}
+		fetched = items.size();
+		updateSyncStat(ns.name, [&](ReplicationSyncStat &stat) {
+			stat.itemsSynced += items.size();
+			stat.chunksDone++;
+		});
+		return errOK;
+	};
+
+	auto fetchRoutine = [&]() {
+		for (;;) {
+			const int64_t chunk = nextChunk++;
+			{
+				std::lock_guard<std::mutex> lck(mtx);
+				if (chunk >= chunksCount || !err.ok()) return;
+			}
+			if (terminate_) {
+				std::lock_guard<std::mutex> lck(mtx);
+				if (err.ok()) err = Error(errCanceled, "Replicator is terminated");
+				return;
+			}
+			size_t fetched = 0;
+			int lastId = -1;
+			Error chunkErr = fetchItems(chunkQuery(chunk), false, fetched, lastId);
+			if (!chunkErr.ok()) {
+				std::lock_guard<std::mutex> lck(mtx);
+				if (err.ok()) err = chunkErr;
+				return;
+			}
+		}
+	};
+
+	slaveNs->BeginBulkLoad();
+	// The first chunk is fetched before the others: it's carrying master's state and tags matcher
+	size_t fetched = 0;
+	int lastId = -1;
+	err = fetchItems(chunkQuery(nextChunk++), true, fetched, lastId);
+	if (err.ok()) {
+		vector<std::thread> fetchers;
+		for (size_t i = 1; i < fetchersCount; ++i) fetchers.emplace_back(fetchRoutine);
+		fetchRoutine();
+		for (auto &th : fetchers) th.join();
+	}
+	// Items with ids after the known chunks are fetched by pages of cursor, until short page
+	for (int64_t fromId = chunksCount * chunkSize; err.ok() && !terminate_;) {
+		fetched = 0;
+		lastId = fromId - 1;
+		err = fetchItems(Query(ns.name).Where("#lsn", CondAny, {}).Where(kWALIdField, CondGe, fromId).Limit(chunkSize), false, fetched,
+						 lastId);
+		if (fetched < size_t(chunkSize)) break;
+		fromId = int64_t(lastId) + 1;
+	}
+	if (err.ok() && terminate_) err = Error(errCanceled, "Replicator is terminated");
+	slaveNs->EndBulkLoad();
+	if (!err.ok()) return err;
+
+	// Get master's state after snapshot transfer
+	client::QueryResults qr(kResultsWithPayloadTypes | kResultsCJson | kResultsWithItemID | kResultsWithRaw);
+	err = master_->Select(Query(ns.name).Where("#lsn", CondAny, {}).Limit(0), qr);
+	if (!err.ok()) return err;
+	ReplicationState endState;
+	for (auto it : qr) {
+		if (!qr.Status().ok()) return qr.Status();
+		if (!it.IsRaw()) continue;
+		WALRecord rec(it.GetRaw());
+		if (rec.type == WalReplState) endState.FromJSON(giftStr(rec.data));
+	}
+
+	slaveNs->SetSlaveLSN(beginState.lastLsn, dummyCtx_);
+	if (endState.lastLsn == beginState.lastLsn) {
+		ReplicationState slaveState = slaveNs->GetReplState(dummyCtx_);
+		if (slaveState.dataHash != beginState.dataHash) {
+			return Error(errDataHashMismatch, "[repl:%s] dataHash mismatch with master %u != %u; itemsCount %d %d; lsn %d", ns.name,
+						 beginState.dataHash, slaveState.dataHash, beginState.dataCount, slaveState.dataCount, beginState.lastLsn);
+		}
+	} else {
+		// Master has been modified during snapshot transfer. Namespace will be synced with it's WAL from beginState.lastLsn
+		std::lock_guard<std::mutex> lck(syncMtx_);
+		auto &maxLsn = maxLsns_[ns.name];
+		maxLsn = std::max(maxLsn, endState.lastLsn);
+	}
+	logPrintf(LogInfo, "[repl:%s] Snapshot sync done: %d items, lsn #%ld", ns.name, slaveNs->GetItemsCount(), beginState.lastLsn);
+
+	return errOK;
+}
+
 Error Replicator::applyWAL(string_view nsName, client::QueryResults &qr) {
 	try {
-		return applyWAL(slave_->getNamespace(nsName, dummyCtx_), qr);
+		return applyWAL(slave_->getNamespace(nsName, dummyCtx_), qr, nsName);
 	} catch (const Error &err) {
 		return err;
 	}
 }
 
-Error Replicator::applyWAL(Namespace::Ptr slaveNs, client::QueryResults &qr) {
+Error Replicator::applyWAL(Namespace::Ptr slaveNs, client::QueryResults &qr, string_view syncName) {
 	Error err;
 	SyncStat stat;
 	WrSerializer ser;
@@ -322,6 +546,8 @@ Error Replicator::applyWAL(Namespace::Ptr slaveNs, client::QueryResults &qr) {
 									 slaveState.dataCount, stat.masterState.lastLsn, slaveLSN);
 	}
 
+	updateSyncStat(syncName, [&stat](ReplicationSyncStat &syncStat) { syncStat.itemsSynced += stat.processed; });
+
 	ser.Reset();
 	stat.Dump(ser) << "lsn #" << slaveState.lastLsn;
 
@@ -412,10 +638,8 @@ Error Replicator::applyWALRecord(int64_t lsn, string_view nsName, std::shared_pt
 	return err;
 }
 
-Error Replicator::applyItemCJson(int64_t lsn, std::shared_ptr<Namespace> slaveNs, string_view cjson, int modifyMode, const TagsMatcher &tm,
-								 SyncStat &stat) {
-	// break;
-	Item item = slaveNs->NewItem(dummyCtx_);
+Error Replicator::itemFromCJson(int64_t lsn, Namespace &slaveNs, string_view cjson, const TagsMatcher &tm, Item &item) {
+	item = slaveNs.NewItem(dummyCtx_);
 
 	if (item.impl_->tagsMatcher().size() < tm.size()) {
 		bool res = item.impl_->tagsMatcher().try_merge(tm);
@@ -425,7 +649,13 @@ Error Replicator::applyItemCJson(int64_t lsn, std::shared_ptr<Namespace> slaveNs
 	}
 
 	item.setLSN(lsn);
-	Error err = item.FromCJSON(cjson);
+	return item.FromCJSON(cjson);
+}
+
+Error Replicator::applyItemCJson(int64_t lsn, std::shared_ptr<Namespace> slaveNs, string_view cjson, int modifyMode, const TagsMatcher &tm,
+								 SyncStat &stat) {
+	Item item;
+	Error err = itemFromCJson(lsn, *slaveNs, cjson, tm, item);
 	if (err.ok()) {
 		switch (modifyMode) {
 			case ModeDelete:
@@ -463,6 +693,39 @@ WrSerializer &Replicator::SyncStat::Dump(WrSerializer &ser) {
 	return ser;
 }
 
+void Replicator::beginSyncStat(string_view nsName, string_view syncType) {
+	updateSyncStat(nsName, [&](ReplicationSyncStat &stat) {
+		stat = ReplicationSyncStat();
+		stat.name = string(nsName);
+		stat.syncType = string(syncType);
+		stat.inProgress = true;
+		stat.startTimeUnixNano = getTimeNow("nsec"_sv);
+	});
+}
+
+void Replicator::endSyncStat(string_view nsName, const Error &err) {
+	updateSyncStat(nsName, [&](ReplicationSyncStat &stat) {
+		stat.inProgress = false;
+		stat.durationMs = (getTimeNow("nsec"_sv) - stat.startTimeUnixNano) / 1000000;
+		stat.lastError = err;
+	});
+}
+
+void Replicator::updateSyncStat(string_view nsName, const std::function<void(ReplicationSyncStat &)> &update) {
+	std::lock_guard<std::mutex> lck(syncStatsMtx_);
+	auto it = syncStats_.find(nsName);
+	if (it == syncStats_.end()) it = syncStats_.emplace(string(nsName), ReplicationSyncStat()).first;
+	update(it->second);
+}
+
+std::vector<ReplicationSyncStat> Replicator::GetSyncStats() {
+	std::vector<ReplicationSyncStat> ret;
+	std::lock_guard<std::mutex> lck(syncStatsMtx_);
+	ret.reserve(syncStats_.size());
+	for (auto &stat : syncStats_) ret.push_back(stat.second);
+	return ret;
+}
+
 Error Replicator::syncIndexesForced(Namespace::Ptr slaveNs, const NamespaceDef &masterNsDef) {
 	const string &nsName = masterNsDef.name;
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <string>
 #include <thread>
 #include "core/dbconfig.h"
@@ -28,6 +29,8 @@ public:
 	Error Start();
 	void Stop();
 	void Enable() { enabled_.store(true, std::memory_order_release); }
+	// Get progress of the last sync of each namespace
+	std::vector<ReplicationSyncStat> GetSyncStats();
 
 protected:
 	struct SyncStat {
@@ -41,22 +44,33 @@ protected:
 	void stop();
 	// Sync database
 	Error syncDatabase();
+	// Sync single namespace until it's up to date with master
+	Error syncNamespace(const NamespaceDef &ns);
 	// Read and apply WAL from master
 	Error syncNamespaceByWAL(const NamespaceDef &ns);
 	// Apply WAL from master to namespace
 	Error applyWAL(string_view nsName, client::QueryResults &qr);
-	// Apply WAL from master to namespace
-	Error applyWAL(Namespace::Ptr slaveNs, client::QueryResults &qr);
+	// Apply WAL from master to namespace. Progress is accounted to syncName in sync stats
+	Error applyWAL(Namespace::Ptr slaveNs, client::QueryResults &qr, string_view syncName);
 	// Sync indexes of namespace
 	Error syncIndexesForced(Namespace::Ptr slaveNs, const NamespaceDef &masterNsDef);
 	// Forced sync of namespace
 	Error syncNamespaceForced(const NamespaceDef &ns, string_view reason);
+	// Fetch namespace snapshot from master by chunks over several connections and bulk load it to slave namespace
+	Error syncSnapshot(Namespace::Ptr slaveNs, const NamespaceDef &ns, const std::function<Error()> &syncIndexes);
 	// Sync meta data
 	Error syncMetaForced(reindexer::Namespace::Ptr slaveNs);
 	// Apply single WAL record
 	Error applyWALRecord(int64_t lsn, string_view nsName, std::shared_ptr<Namespace> ns, const WALRecord &wrec, SyncStat &stat);
 	// Apply single cjson item
 	Error applyItemCJson(int64_t, std::shared_ptr<Namespace> ns, string_view cjson, int modifyMode, const TagsMatcher &tm, SyncStat &stat);
+	// Build item of slave namespace from master's cjson
+	Error itemFromCJson(int64_t lsn, Namespace &ns, string_view cjson, const TagsMatcher &tm, Item &item);
+
+	// Sync progress reporting
+	void beginSyncStat(string_view nsName, string_view syncType);
+	void endSyncStat(string_view nsName, const Error &err);
+	void updateSyncStat(string_view nsName, const std::function<void(ReplicationSyncStat &)> &update);
 
 	void OnWALUpdate(int64_t lsn, string_view nsName, const WALRecord &walRec) override final;
 	void OnConnectionState(const Error &err) override final;
@@ -79,8 +93,12 @@ protected:
 	fast_hash_map<string, int64_t, nocase_hash_str, nocase_equal_str> maxLsns_;
 
 	std::mutex syncMtx_;
+	std::mutex syncStatsMtx_;
+	fast_hash_map<string, ReplicationSyncStat, nocase_hash_str, nocase_equal_str> syncStats_;
 	std::mutex masterMtx_;
 	std::atomic<bool> enabled_;
+	// Master selects items of WAL query by ranges of ids, so namespaces may be synced by snapshot
+	std::atomic<bool> snapshotByIds_{false};
 
 	const RdxContext dummyCtx_;
 };
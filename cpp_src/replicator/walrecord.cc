@@ -7,36 +7,40 @@ namespace reindexer {
 
 void PackedWALRecord::Pack(const WALRecord &rec) {
 	WrSerializer ser;
-	ser.PutVarUint(rec.type);
-	switch (rec.type) {
+	rec.Pack(ser);
+	assign(ser.Buf(), ser.Buf() + ser.Len());
+}
+
+void WALRecord::Pack(WrSerializer &ser) const {
+	ser.PutVarUint(type);
+	switch (type) {
 		case WalItemUpdate:
-			ser.PutUInt32(rec.id);
+			ser.PutUInt32(id);
 			break;
 		case WalUpdateQuery:
 		case WalIndexAdd:
 		case WalIndexDrop:
 		case WalIndexUpdate:
 		case WalReplState:
-			ser.PutVString(rec.data);
+			ser.PutVString(data);
 			break;
 		case WalPutMeta:
-			ser.PutVString(rec.putMeta.key);
-			ser.PutVString(rec.putMeta.value);
+			ser.PutVString(putMeta.key);
+			ser.PutVString(putMeta.value);
 			break;
 		case WalItemModify:
-			ser.PutVString(rec.itemModify.itemCJson);
-			ser.PutVarUint(rec.itemModify.modifyMode);
-			ser.PutVarUint(rec.itemModify.tmVersion);
+			ser.PutVString(itemModify.itemCJson);
+			ser.PutVarUint(itemModify.modifyMode);
+			ser.PutVarUint(itemModify.tmVersion);
 			break;
 		case WalEmpty:
 		case WalNamespaceAdd:
 		case WalNamespaceDrop:
 			break;
 		default:
-			fprintf(stderr, "Unexpected WAL rec type %d\n", int(rec.type));
+			fprintf(stderr, "Unexpected WAL rec type %d\n", int(type));
 			std::abort();
 	}
-	assign(ser.Buf(), ser.Buf() + ser.Len());
 }
 
 WALRecord::WALRecord(span<uint8_t> packed) {
@@ -9,6 +9,11 @@
 
 namespace reindexer {
 
+/// Default limit of WAL records count
+static const int64_t kDefaultWALSize = 1000000;
+/// Default limit of memory size of WAL records
+static const int64_t kDefaultWALBytes = 64 << 20;
+
 enum WALRecType {
 	WalEmpty,
 	WalReplState,
@@ -35,6 +40,7 @@ struct WALRecord {
 	explicit WALRecord(WALRecType _type, string_view cjson, int tmVersion, int modifyMode) : type(_type) {
 		itemModify = {cjson, tmVersion, modifyMode};
 	}
+	void Pack(WrSerializer &ser) const;
 	WrSerializer &Dump(WrSerializer &ser, std::function<std::string(string_view)> cjsonViewer) const;
 	void GetJSON(JsonBuilder &jb, std::function<string(string_view)> cjsonViewer) const;
 	WALRecType type;
@@ -6,6 +6,8 @@
 
 namespace reindexer {
 
+const char *const kWALIdField = "#id";
+
 WALSelecter::WALSelecter(const Namespace *ns) : ns_(ns) {}
 
 void WALSelecter::operator()(QueryResults &result, SelectCtx &params) {
@@ -14,7 +16,10 @@ void WALSelecter::operator()(QueryResults &result, SelectCtx &params) {
 	int start = q.start;
 	result.totalCount = 0;
 
-	if (q.entries.Size() != 1 || !q.entries.IsEntry(0)) {
+	// Query of all items may be limited by range of ids: '#lsn is not null and #id >= number' or '#id range(from,to)'
+	const bool withIdRange = q.entries.Size() == 2 && q.entries.IsEntry(1) && q.entries[1].index == kWALIdField &&
+							 q.entries.GetOperation(1) == OpAnd && q.entries[0].condition == CondAny;
+	if ((q.entries.Size() != 1 && !withIdRange) || !q.entries.IsEntry(0)) {
 		throw Error(errLogic, "Query to WAL should contain only 1 condition '#lsn > number'");
 	}
 	if (ns_->repl_.slaveMode) throw Error(errNoWAL, "Query to WAL, but WAL is disabled. Set replication role to master to continue");
@@ -69,7 +74,19 @@ void WALSelecter::operator()(QueryResults &result, SelectCtx &params) {
 			}
 		}
 	} else if (q.entries[0].condition == CondAny) {
-		for (size_t id = 0; count && id < ns_->items_.size(); ++id) {
+		size_t fromId = 0, toId = ns_->items_.size();
+		if (withIdRange) {
+			const QueryEntry &idEntry = q.entries[1];
+			if (idEntry.condition == CondGe && idEntry.values.size() == 1) {
+				fromId = std::max(idEntry.values[0].As<int64_t>(), int64_t(0));
+			} else if (idEntry.condition == CondRange && idEntry.values.size() == 2) {
+				fromId = std::max(idEntry.values[0].As<int64_t>(), int64_t(0));
+				toId = std::min(size_t(std::max(idEntry.values[1].As<int64_t>() + 1, int64_t(0))), toId);
+			} else {
+				throw Error(errLogic, "Query to WAL should contain condition '#id >= number' or '#id range(from,to)'");
+			}
+		}
+		for (size_t id = fromId; count && id < toId; ++id) {
 			if (ns_->items_[id].IsFree()) continue;
 			if (start) {
 				start--;
@@ -5,6 +5,10 @@ namespace reindexer {
 class Namespace;
 class QueryResults;
 struct SelectCtx;
+
+// Pseudo field of query to WAL, which limits ids of selected items
+extern const char *const kWALIdField;
+
 class WALSelecter {
 public:
 	WALSelecter(const Namespace *ns);
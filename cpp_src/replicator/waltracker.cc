@@ -1,21 +1,48 @@
-
 #include "waltracker.h"
+#include <string.h>
+#include <algorithm>
 #include "tools/serializer.h"
 
 #define kStorageWALPrefix "W"
 
 namespace reindexer {
 
+constexpr uint8_t WALTracker::Record::kInRing;
+constexpr size_t WALTracker::Record::kInlineSize;
+
+// Initial size of ring buffer. Buffer grows twice up to maxBytes_
+static const size_t kMinRingSize = 64 * 1024;
+
+// Chunks in the ring buffer are aligned by 16 bytes, so the header of chunk always fits before the end of buffer
+static size_t alignChunk(size_t size) { return (size + 15) & ~size_t(15); }
+
+uint64_t WALTracker::Record::Offset() const {
+	uint64_t offset = 0;
+	for (size_t i = 0; i < kInlineSize; ++i) offset |= uint64_t(data[i]) << (i * 8);
+	return offset;
+}
+
+void WALTracker::Record::SetOffset(uint64_t offset) {
+	tag = kInRing;
+	for (size_t i = 0; i < kInlineSize; ++i) data[i] = uint8_t(offset >> (i * 8));
+}
+
 int64_t WALTracker::Add(const WALRecord &rec, int64_t oldLsn) {
 	int64_t lsn = lsnCounter_++;
 	put(lsn, rec);
 	if (oldLsn >= 0 && available(oldLsn)) {
 		put(oldLsn, WALRecord());
+	} else if (oldLsn >= 0 && oldLsn < forkLSN_) {
+		outdated_.push_back(oldLsn);
 	}
 
 	if (rec.type != WalItemUpdate) {
-		//
-		writeToStorage(lsn);
+		// Fork may be discarded, so its records get to storage only on merge
+		if (forkLSN_ >= 0) {
+			unstored_.push_back(lsn);
+		} else {
+			writeToStorage(lsn);
+		}
 	}
 
 	return lsn;
@@ -23,6 +50,7 @@ int64_t WALTracker::Add(const WALRecord &rec, int64_t oldLsn) {
 
 bool WALTracker::Set(const WALRecord &rec, int64_t lsn) {
 	if (!available(lsn)) {
+		if (rec.type == WalEmpty && lsn >= 0 && lsn < forkLSN_) outdated_.push_back(lsn);
 		return false;
 	}
 	put(lsn, rec);
@@ -35,29 +63,200 @@ void WALTracker::Init(int64_t maxLSN, shared_ptr<datastorage::IDataStorage> stor
 	maxLSN++;
 
 	records_.clear();
-	records_.resize(std::min(maxLSN, walSize_));
+	records_.resize(std::min(maxLSN, maxRecords_));
+	ring_.clear();
+	ringBegin_ = ringEnd_ = 0;
 	lsnCounter_ = maxLSN;
+	firstLSN_ = 0;
 
-	// Fill records from storage
+	// Fill records from storage in order of LSN, so the oldest records are evicted first
+	std::sort(data.begin(), data.end(),
+			  [](const std::pair<int64_t, std::string> &lhs, const std::pair<int64_t, std::string> &rhs) { return lhs.first < rhs.first; });
 	for (auto &rec : data) {
 		Set(WALRecord(string_view(rec.second)), rec.first);
 	}
 }
 
+WALTracker WALTracker::Fork() const {
+	WALTracker wal;
+	wal.maxRecords_ = maxRecords_;
+	wal.maxBytes_ = maxBytes_;
+	wal.lsnCounter_ = lsnCounter_;
+	wal.firstLSN_ = lsnCounter_;
+	wal.forkLSN_ = lsnCounter_;
+	wal.storage_ = storage_;
+	return wal;
+}
+
+void WALTracker::Merge(WALTracker &&fork) {
+	assert(fork.forkLSN_ == lsnCounter_);
+	for (int64_t lsn : fork.outdated_) {
+		if (available(lsn)) put(lsn, WALRecord());
+	}
+	// Records, evicted from the fork, break continuity of WAL
+	const int64_t from = fork.begin().idx_;
+	if (from > lsnCounter_) firstLSN_ = std::max(firstLSN_, from);
+	lsnCounter_ = fork.lsnCounter_;
+	for (int64_t lsn = from; lsn < lsnCounter_; ++lsn) {
+		if (available(lsn)) put(lsn, fork.raw(lsn));
+	}
+	for (int64_t lsn : fork.unstored_) writeToStorage(lsn);
+}
+
+void WALTracker::SetLimits(int64_t maxRecords, int64_t maxBytes) {
+	if (maxRecords <= 0) maxRecords = kDefaultWALSize;
+	if (maxBytes <= 0) maxBytes = kDefaultWALBytes;
+	if (maxRecords == maxRecords_ && maxBytes == maxBytes_) return;
+
+	maxBytes_ = maxBytes;
+	rebuild(maxRecords, std::min(ring_.size(), maxRingSize()));
+}
+
 void WALTracker::put(int64_t lsn, const WALRecord &rec) {
-	uint64_t pos = lsn % walSize_;
+	if (rec.type == WalEmpty) {
+		put(lsn, span<uint8_t>());
+		return;
+	}
+	WrSerializer ser;
+	rec.Pack(ser);
+	put(lsn, span<uint8_t>(ser.Buf(), ser.Len()));
+}
+
+void WALTracker::put(int64_t lsn, span<uint8_t> packed) {
+	uint64_t pos = lsn % maxRecords_;
 	if (pos >= records_.size()) records_.resize(pos + 1);
-	records_[pos].Pack(rec);
+
+	if (packed.size() <= Record::kInlineSize) {
+		Record &rec = records_[pos];
+		rec.tag = packed.size();
+		if (packed.size()) memcpy(rec.data, packed.data(), packed.size());
+		return;
+	}
+
+	if (inRing(records_[pos])) {
+		// Rewrite record inplace, if it fits to the chunk. Position may also refer to the chunk of the previous record with the same position
+		const uint64_t offset = records_[pos].Offset();
+		ChunkHeader hdr = chunkHeader(offset);
+		if (hdr.lsn == lsn && hdr.size >= sizeof(ChunkHeader) + packed.size()) {
+			hdr.dataSize = packed.size();
+			setChunkHeader(offset, hdr);
+			memcpy(ring_.data() + offset % ring_.size() + sizeof(ChunkHeader), packed.data(), packed.size());
+			return;
+		}
+	}
+
+	// Eviction of the oldest chunks may evict this record, or move records to the new ring buffer
+	records_[pos].tag = 0;
+	const uint64_t offset = allocChunk(lsn, packed.size());
+	if (lsn < firstLSN_) return;
+	memcpy(ring_.data() + offset % ring_.size() + sizeof(ChunkHeader), packed.data(), packed.size());
+	records_[lsn % maxRecords_].SetOffset(offset);
 }
 
+bool WALTracker::inRing(const Record &rec) const {
+	if (rec.tag != Record::kInRing) return false;
+	const uint64_t offset = rec.Offset();
+	return offset >= ringBegin_ && offset < ringEnd_;
+}
+
+span<uint8_t> WALTracker::raw(int64_t lsn) const {
+	const Record &rec = records_[lsn % maxRecords_];
+	if (rec.tag != Record::kInRing) return span<uint8_t>(rec.data, rec.tag);
+
+	const uint64_t offset = rec.Offset();
+	const ChunkHeader hdr = chunkHeader(offset);
+	return span<uint8_t>(ring_.data() + offset % ring_.size() + sizeof(ChunkHeader), hdr.dataSize);
+}
+
+uint64_t WALTracker::allocChunk(int64_t lsn, size_t dataSize) {
+	const size_t chunkSize = alignChunk(sizeof(ChunkHeader) + dataSize);
+	if (chunkSize > maxRingSize()) {
+		// Record doesn't fit to the ring buffer: all the previous records are evicted
+		firstLSN_ = std::max(firstLSN_, lsn + 1);
+		ring_.clear();
+		ringBegin_ = ringEnd_ = 0;
+		return 0;
+	}
+
+	size_t padding;
+	for (;;) {
+		const size_t tail = ring_.size() ? ring_.size() - ringEnd_ % ring_.size() : 0;
+		padding = (tail < chunkSize) ? tail : 0;
+		if (ringEnd_ + padding + chunkSize - ringBegin_ <= ring_.size()) break;
+
+		if (ring_.size() < maxRingSize()) {
+			size_t ringSize = std::max(ring_.size() * 2, kMinRingSize);
+			while (ringSize < ringEnd_ - ringBegin_ + 2 * chunkSize) ringSize *= 2;
+			rebuild(maxRecords_, std::min(ringSize, maxRingSize()));
+		} else {
+			evictChunk();
+		}
+	}
+
+	if (padding) {
+		setChunkHeader(ringEnd_, {-1, uint32_t(padding), 0});
+		ringEnd_ += padding;
+	}
+	const uint64_t offset = ringEnd_;
+	setChunkHeader(offset, {lsn, uint32_t(chunkSize), uint32_t(dataSize)});
+	ringEnd_ += chunkSize;
+	return offset;
+}
+
+void WALTracker::evictChunk() {
+	assert(ringBegin_ < ringEnd_);
+	const ChunkHeader hdr = chunkHeader(ringBegin_);
+	if (hdr.lsn >= 0) {
+		// Chunk may be outdated, if record was moved or rewritten
+		Record &rec = records_[hdr.lsn % maxRecords_];
+		if (rec.tag == Record::kInRing && rec.Offset() == ringBegin_) {
+			rec.tag = 0;
+			firstLSN_ = std::max(firstLSN_, hdr.lsn + 1);
+		}
+	}
+	ringBegin_ += hdr.size;
+}
+
+void WALTracker::rebuild(int64_t maxRecords, size_t ringSize) {
+	WALTracker wal;
+	wal.maxRecords_ = maxRecords;
+	wal.maxBytes_ = maxBytes_;
+	wal.ring_.resize(ringSize);
+	wal.lsnCounter_ = lsnCounter_;
+	wal.firstLSN_ = begin().idx_;
+	wal.records_.reserve(std::min(lsnCounter_, maxRecords));
+	for (auto it = begin(); it != end(); ++it) {
+		if (wal.available(it.GetLSN())) wal.put(it.GetLSN(), it.GetRaw());
+	}
+
+	records_ = std::move(wal.records_);
+	ring_ = std::move(wal.ring_);
+	ringBegin_ = wal.ringBegin_;
+	ringEnd_ = wal.ringEnd_;
+	firstLSN_ = wal.firstLSN_;
+	maxRecords_ = maxRecords;
+}
+
+WALTracker::ChunkHeader WALTracker::chunkHeader(uint64_t offset) const {
+	static_assert(sizeof(ChunkHeader) == 16, "Size of chunk header must be equal to chunks alignment");
+	ChunkHeader hdr;
+	memcpy(&hdr, ring_.data() + offset % ring_.size(), sizeof(hdr));
+	return hdr;
+}
+
+void WALTracker::setChunkHeader(uint64_t offset, const ChunkHeader &hdr) { memcpy(ring_.data() + offset % ring_.size(), &hdr, sizeof(hdr)); }
+
 void WALTracker::writeToStorage(int64_t lsn) {
-	uint64_t pos = lsn % walSize_;
+	uint64_t pos = lsn % maxRecords_;
 
 	WrSerializer key, data;
 	key << kStorageWALPrefix;
 	key.PutUInt32(pos);
 	data.PutUInt64(lsn);
-	data.Write(string_view(reinterpret_cast<char *>(records_[pos].data()), records_[pos].size()));
+	if (available(lsn)) {
+		auto rec = raw(lsn);
+		data.Write(string_view(reinterpret_cast<char *>(rec.data()), rec.size()));
+	}
 	auto storage = storage_.lock();
 	if (storage) storage->Write(StorageOpts(), key.Slice(), data.Slice());
 }
@@ -89,11 +288,6 @@ std::vector<std::pair<int64_t, std::string>> WALTracker::readFromStorage(int64_t
 	return data;
 }
 
-size_t WALTracker::heap_size() const {
-	size_t ret = records_.capacity() * sizeof(PackedWALRecord);
-	for (auto &rec : records_) ret += rec.heap_size();
-
-	return ret;
-}
+size_t WALTracker::heap_size() const { return records_.capacity() * sizeof(Record) + ring_.capacity(); }
 
 }  // namespace reindexer
@@ -8,15 +8,20 @@
 
 namespace reindexer {
 
-static const int kDefaultWALSize = 1000000;
-
 /// WAL trakcer
+/// Packed records are stored in the contiguous byte ring buffer, and are addressed by the ring of records, indexed by LSN.
+/// Small records are stored in the ring of records inline. WAL is limited both by records count and by bytes size of ring buffer:
+/// the oldest records are evicted, when either limit is exceeded.
 class WALTracker {
 public:
 	/// Initialize WAL tracker.
 	/// @param maxLSN - Current LSN counter value
 	/// @param storage - Storage object for store WAL records
 	void Init(int64_t maxLSN, shared_ptr<datastorage::IDataStorage> storage);
+	/// Set limits of WAL size
+	/// @param maxRecords - Maximum count of records in WAL
+	/// @param maxBytes - Maximum memory size of ring buffer
+	void SetLimits(int64_t maxRecords, int64_t maxBytes);
 	/// Add new record to WAL tracker
 	/// @param rec - Record to be added
 	/// @param oldLsn - Optional, previous LSN value of changed object
@@ -30,6 +35,13 @@ public:
 	/// Get current LSN counter value
 	/// @return current LSN counter value
 	int64_t LSNCounter() const { return lsnCounter_; }
+	/// Create empty WAL tracker, which continues LSN sequence of this one. Records of this tracker are not copied.
+	/// Records of forked tracker are kept in memory only, until they are merged
+	/// @return forked WAL tracker
+	WALTracker Fork() const;
+	/// Move records, which were added to the forked tracker, to this tracker, and write them to storage
+	/// @param fork - WAL tracker, created by Fork() of this tracker, without any changes of this tracker since then
+	void Merge(WALTracker &&fork);
 
 	/// Iterator for WAL records
 	class iterator {
@@ -37,12 +49,10 @@ public:
 		iterator &operator++() { return idx_++, *this; }
 		bool operator!=(const iterator &other) const { return idx_ != other.idx_; }
 		WALRecord operator*() const {
-			assertf(idx_ % wt_->walSize_ < int(wt_->records_.size()), "idx=%d,wt_->records_.size()=%d,lsnCounter=%d", idx_,
-					wt_->records_.size(), wt_->lsnCounter_);
-
-			return WALRecord(span<uint8_t>(wt_->records_[idx_ % wt_->walSize_]));
+			assertf(wt_->available(idx_), "idx=%d,firstLSN=%d,lsnCounter=%d", idx_, wt_->firstLSN_, wt_->lsnCounter_);
+			return WALRecord(wt_->raw(idx_));
 		}
-		span<uint8_t> GetRaw() const { return wt_->records_[idx_ % wt_->walSize_]; }
+		span<uint8_t> GetRaw() const { return wt_->raw(idx_); }
 		int64_t GetLSN() const { return idx_; }
 		int64_t idx_;
 		const WALTracker *wt_;
@@ -50,7 +60,7 @@ public:
 
 	/// Get begin iterator
 	/// @return iterator pointing to begin of WAL
-	iterator begin() const { return {lsnCounter_ > walSize_ ? lsnCounter_ - walSize_ : 0, this}; }
+	iterator begin() const { return {std::max(lsnCounter_ > maxRecords_ ? lsnCounter_ - maxRecords_ + 1 : 0, firstLSN_), this}; }
 	/// Get end iterator
 	/// @return iterator pointing to end of WAL
 	iterator end() const { return {lsnCounter_, this}; }
@@ -61,32 +71,85 @@ public:
 	/// Check is LSN outdated, and complete log is not available
 	/// @param lsn LSN of record
 	/// @return true if LSN is outdated
-	bool is_outdated(int64_t lsn) const { return bool(lsnCounter_ - lsn >= walSize_); }
+	bool is_outdated(int64_t lsn) const { return bool(lsnCounter_ - lsn >= maxRecords_) || lsn + 1 < firstLSN_; }
 
 	/// Get WAL size
 	/// @return count of actual records in WAL
-	size_t size() const { return lsnCounter_ > walSize_ ? walSize_ : lsnCounter_; }
+	size_t size() const { return lsnCounter_ - begin().idx_; }
 	/// Get WAL heap size
 	/// @return WAL memory consumption
 	size_t heap_size() const;
 
 protected:
+	/// Reference to packed record
+	struct Record {
+		static constexpr uint8_t kInRing = 0xFF;
+		static constexpr size_t kInlineSize = 7;
+		/// Size of inline record, or kInRing, if record is stored in the ring buffer
+		uint8_t tag = 0;
+		/// Inline record, or offset of record's chunk in the ring buffer
+		uint8_t data[kInlineSize];
+
+		uint64_t Offset() const;
+		void SetOffset(uint64_t offset);
+	};
+	/// Header of record's chunk in the ring buffer. Chunks are aligned by header size
+	struct ChunkHeader {
+		/// LSN of record, or -1 for padding at the end of the ring buffer
+		int64_t lsn;
+		/// Size of chunk, including header
+		uint32_t size;
+		/// Size of packed record
+		uint32_t dataSize;
+	};
+
 	/// put WAL record into lsn position, grow ring buffer, if neccessary
 	/// @param lsn LSN value
 	/// @param rec - Record to be added
 	void put(int64_t lsn, const WALRecord &rec);
+	/// put packed WAL record into lsn position
+	void put(int64_t lsn, span<uint8_t> packed);
 	/// check if lsn is available. e.g. in range of ring buffer
-	bool available(int64_t lsn) const { return lsn < lsnCounter_ && lsnCounter_ - lsn < walSize_; }
+	bool available(int64_t lsn) const { return lsn < lsnCounter_ && lsnCounter_ - lsn < maxRecords_ && lsn >= firstLSN_; }
+	/// get packed record
+	span<uint8_t> raw(int64_t lsn) const;
+	/// check if record refers to the chunk, which is not evicted from the ring buffer
+	bool inRing(const Record &rec) const;
+	/// allocate chunk for the record in the ring buffer, evicting the oldest records
+	/// @return logical offset of chunk
+	uint64_t allocChunk(int64_t lsn, size_t dataSize);
+	/// evict the oldest chunk from the ring buffer
+	void evictChunk();
+	/// copy available records to the new ring buffer
+	void rebuild(int64_t maxRecords, size_t ringSize);
+	size_t maxRingSize() const { return size_t(maxBytes_) & ~size_t(15); }
+	ChunkHeader chunkHeader(uint64_t offset) const;
+	void setChunkHeader(uint64_t offset, const ChunkHeader &hdr);
 
 	void writeToStorage(int64_t lsn);
 	std::vector<std::pair<int64_t, std::string>> readFromStorage(int64_t &maxLsn);
 
-	/// Ring buffer of WAL records
-	std::vector<PackedWALRecord> records_;
+	/// Ring of WAL records
+	std::vector<Record> records_;
+	/// Ring buffer of packed records. Chunk's position in the buffer is its logical offset modulo buffer size
+	std::vector<uint8_t> ring_;
+	/// Logical offsets of the oldest chunk, and of the end of the newest chunk in ring buffer
+	uint64_t ringBegin_ = 0, ringEnd_ = 0;
 	/// LSN counter value. Contains LSN of next record
 	int64_t lsnCounter_ = 0;
-	/// Size of ring buffer
-	int64_t walSize_ = kDefaultWALSize;
+	/// The oldest LSN, which was not evicted from ring buffer
+	int64_t firstLSN_ = 0;
+	/// Size of ring of records
+	int64_t maxRecords_ = kDefaultWALSize;
+	/// Maximum size of ring buffer
+	int64_t maxBytes_ = kDefaultWALBytes;
+
+	/// LSN counter value of the parent tracker at the moment of Fork(), or -1
+	int64_t forkLSN_ = -1;
+	/// LSNs of records of the parent tracker, which were emptied in the forked tracker
+	std::vector<int64_t> outdated_;
+	/// LSNs of records of the forked tracker, which have to be written to storage on merge
+	std::vector<int64_t> unstored_;
 
 	std::weak_ptr<datastorage::IDataStorage> storage_;
 };
@@ -13,6 +13,8 @@ void ServerConfig::Reset() {
 	StorageEngine = "leveldb";
 	HTTPAddr = "0.0.0.0:9088";
 	RPCAddr = "0.0.0.0:6534";
+	RPCWorkers = 4;
+	RPCQueueSize = 1024;
 	LogLevel = "info";
 	ServerLog = "stdout";
 	CoreLog = "stdout";
@@ -93,6 +95,10 @@ Error ServerConfig::ParseCmd(int argc, char *argv[]) {
 	args::ValueFlag<string> httpAddrF(netGroup, "PORT", "http listen host:port", {'p', "httpaddr"}, HTTPAddr, args::Options::Single);
 	args::ValueFlag<string> rpcAddrF(netGroup, "RPORT", "RPC listen host:port", {'r', "rpcaddr"}, RPCAddr, args::Options::Single);
 	args::ValueFlag<string> webRootF(netGroup, "PATH", "web root", {'w', "webroot"}, WebRoot, args::Options::Single);
+	args::ValueFlag<int> rpcWorkersF(netGroup, "N", "RPC worker threads per class of calls (0 - execute calls by network threads)",
+									 {"rpc-workers"}, RPCWorkers, args::Options::Single);
+	args::ValueFlag<int> rpcQueueSizeF(netGroup, "N", "Maximum RPC calls, waiting for execution, per class of calls", {"rpc-queue-size"},
+									   RPCQueueSize, args::Options::Single);
 	args::Flag pprofF(netGroup, "", "Enable pprof http handler", {'f', "pprof"});
 
 	args::Group metricsGroup(parser, "Metrics options");
@@ -143,6 +149,8 @@ Error ServerConfig::ParseCmd(int argc, char *argv[]) {
 	if (httpAddrF) HTTPAddr = args::get(httpAddrF);
 	if (rpcAddrF) RPCAddr = args::get(rpcAddrF);
 	if (webRootF) WebRoot = args::get(webRootF);
+	if (rpcWorkersF) RPCWorkers = args::get(rpcWorkersF);
+	if (rpcQueueSizeF) RPCQueueSize = args::get(rpcQueueSizeF);
 #ifndef _WIN32
 	if (userF) UserName = args::get(userF);
 	if (daemonizeF) Daemonize = args::get(daemonizeF);
@@ -180,6 +188,8 @@ reindexer::Error ServerConfig::fromYaml(Yaml::Node &root) {
 		HTTPAddr = root["net"]["httpaddr"].As<std::string>(HTTPAddr);
 		RPCAddr = root["net"]["rpcaddr"].As<std::string>(RPCAddr);
 		WebRoot = root["net"]["webroot"].As<std::string>(WebRoot);
+		RPCWorkers = root["net"]["rpc_workers"].As<int>(RPCWorkers);
+		RPCQueueSize = root["net"]["rpc_queue_size"].As<int>(RPCQueueSize);
 		EnableSecurity = root["net"]["security"].As<bool>(EnableSecurity);
 		EnablePrometheus = root["metrics"]["prometheus"].As<bool>(EnablePrometheus);
 		PrometheusCollectPeriod = std::chrono::milliseconds(root["metrics"]["collect_period"].As<int>(PrometheusCollectPeriod.count()));
@@ -29,6 +29,8 @@ struct ServerConfig {
 	string StorageEngine;
 	string HTTPAddr;
 	string RPCAddr;
+	int RPCWorkers;
+	int RPCQueueSize;
 	string LogLevel;
 	string ServerLog;
 	string CoreLog;
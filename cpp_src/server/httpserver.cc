@@ -1,11 +1,14 @@
 #include "httpserver.h"
 #include <sys/stat.h>
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
+#include <thread>
 #include "base64/base64.h"
 #include "core/cjson/jsonbuilder.h"
 #include "core/queryresults/tableviewbuilder.h"
 #include "core/type_consts.h"
+#include "core/workerpool.h"
 #include "gason/gason.h"
 #include "loggerwrapper.h"
 #include "net/http/serverconnection.h"
@@ -798,6 +801,7 @@ bool HTTPServer::Start(const string &addr, ev::dynamic_loop &loop) {
 	router_.PUT<HTTPServer, &HTTPServer::PutItems>("/api/v1/db/:db/namespaces/:ns/items", this);
 	router_.POST<HTTPServer, &HTTPServer::PostItems>("/api/v1/db/:db/namespaces/:ns/items", this);
 	router_.DELETE<HTTPServer, &HTTPServer::DeleteItems>("/api/v1/db/:db/namespaces/:ns/items", this);
+	router_.POST<HTTPServer, &HTTPServer::PostItemsBulk>("/api/v1/db/:db/namespaces/:ns/items/bulk", this);
 
 	router_.GET<HTTPServer, &HTTPServer::GetIndexes>("/api/v1/db/:db/namespaces/:ns/indexes", this);
 	router_.POST<HTTPServer, &HTTPServer::PostIndex>("/api/v1/db/:db/namespaces/:ns/indexes", this);
@@ -826,6 +830,229 @@ bool HTTPServer::Start(const string &addr, ev::dynamic_loop &loop) {
 	return listener_->Bind(addr);
 }
 
+// Send response body, which is produced by parts. Body, which fits into single part, is sent with known length, the others are
+// streamed with chunked transfer encoding. Parts are produced on the connection's I/O thread, so producer has to be cheap
+template <typename Producer>
+static int sendByParts(http::Context &ctx, string_view contentType, std::shared_ptr<Producer> producer) {
+	bool hasMore = true;
+	while (hasMore && !producer->Pending()) hasMore = producer->Next(ctx.writer->GetChunk());
+	chunk ch = producer->Detach();
+
+	if (!hasMore) ctx.writer->SetContentLength(ch.len_);
+	ctx.writer->SetRespCode(http::StatusOK);
+	ctx.writer->SetHeader(http::Header{"Content-Type"_sv, contentType});
+	ctx.writer->Write(std::move(ch));
+	if (hasMore) {
+		ctx.writer->Stream([producer](http::Writer &writer) {
+			bool more = producer->Next(writer.GetChunk());
+			chunk part = producer->Detach();
+			if (part.len_) writer.Write(std::move(part));
+			return more;
+		});
+	}
+	return 0;
+}
+
+// Send response body, which parts are produced by workers, so heavy producer doesn't block the connection's I/O thread. Body is
+// streamed with chunked transfer encoding. Streaming is suspended, while worker produces the next part, and it's resumed by worker
+template <typename Producer>
+static int sendByWorkerParts(http::Context &ctx, string_view contentType, std::shared_ptr<Producer> producer, WorkerPool &workers) {
+	// Part, produced by worker. Streamer accesses it only after resume, so it's not guarded
+	struct Part {
+		bool produced = false;
+		bool more = true;
+		std::exception_ptr error;
+	};
+	auto part = std::make_shared<Part>();
+
+	ctx.writer->SetRespCode(http::StatusOK);
+	ctx.writer->SetHeader(http::Header{"Content-Type"_sv, contentType});
+	ctx.writer->Stream([producer, part, &workers](http::Writer &writer) {
+		if (part->produced) {
+			part->produced = false;
+			if (part->error) std::rethrow_exception(part->error);
+			chunk ch = producer->Detach();
+			if (ch.len_) writer.Write(std::move(ch));
+			if (!part->more) return false;
+		}
+
+		http::Writer::Resumer resume = writer.Suspend();
+		auto task = [producer, part, resume]() {
+			try {
+				part->more = producer->Next(chunk());
+			} catch (...) {
+				part->error = std::current_exception();
+			}
+			part->produced = true;
+			resume();
+		};
+		// Pool is stopped on server shutdown: the rest of parts is produced by I/O thread
+		if (!workers.Run(task)) task();
+		return true;
+	});
+	return 0;
+}
+
+// Max count of threads, which parse batches of all the bulk requests together
+constexpr unsigned kMaxBulkParseWorkers = 8;
+// Max count of bulk requests, which apply their batches concurrently. Batches of the others wait in queue
+constexpr unsigned kMaxBulkApplyWorkers = 4;
+
+// Applies items from NDJSON body by batches. Each batch is parsed in parallel by the calling thread and the shared parse workers,
+// and then it is applied under the single namespace lock. Errors of lines are written to response (as NDJSON too) right after
+// their batch is applied. Batches are applied by apply workers (see sendByWorkerParts), so the connection's I/O thread is not blocked
+class HTTPServer::BulkModifier {
+public:
+	BulkModifier(Reindexer &&db, string &&nsName, string &&body, int mode, vector<string> &&precepts)
+		: db_(std::move(db)), nsName_(std::move(nsName)), body_(std::move(body)), mode_(mode), precepts_(std::move(precepts)) {}
+
+	/// Apply next batch of items
+	/// @param buf - buffer for serialization of errors, if previous part is detached
+	/// @return false, if all the items are applied and summary is serialized
+	bool Next(chunk &&buf) {
+		if (!ser_.Len()) ser_ = WrSerializer(std::move(buf));
+		if (pos_ < body_.size()) {
+			applyBatch();
+			if (pos_ < body_.size()) return true;
+			db_.Commit(nsName_);
+		}
+
+		JsonBuilder builder(ser_);
+		builder.Put("success", true);
+		builder.Put("updated", updated_);
+		builder.Put("errors", errors_);
+		builder.End();
+		ser_ << '\n';
+		return false;
+	}
+	size_t Pending() const { return ser_.Len(); }
+	chunk Detach() { return ser_.DetachChunk(); }
+
+	// Shared pool of workers, which apply batches of all the bulk requests
+	static WorkerPool &ApplyWorkers() {
+		// Apply workers use parse workers, so parse workers are created before them, and destroyed after them
+		parseWorkers();
+		static WorkerPool workers(std::max(1u, std::min(std::thread::hardware_concurrency(), kMaxBulkApplyWorkers)));
+		return workers;
+	}
+
+private:
+	void applyBatch() {
+		lines_.clear();
+		lineNumbers_.clear();
+		while (pos_ < body_.size() && lines_.size() < kBatchSize) {
+			size_t end = std::min(body_.find('\n', pos_), body_.size());
+			string_view line(&body_[pos_], end - pos_);
+			pos_ = end + 1;
+			++lineNumber_;
+			if (std::all_of(line.begin(), line.end(), [](char c) { return c == ' ' || c == '\t' || c == '\r'; })) continue;
+			lines_.push_back(line);
+			lineNumbers_.push_back(lineNumber_);
+		}
+
+		std::vector<Item> items(lines_.size());
+		std::vector<Error> errors(lines_.size());
+		parse(items, errors);
+
+		std::vector<Item> parsed;
+		std::vector<size_t> parsedIdx;
+		parsed.reserve(items.size());
+		parsedIdx.reserve(items.size());
+		for (size_t i = 0; i < items.size(); ++i) {
+			if (!errors[i].ok()) continue;
+			parsed.emplace_back(std::move(items[i]));
+			parsedIdx.push_back(i);
+		}
+		if (!parsed.empty()) {
+			std::vector<ItemModifyMode> modes(parsed.size(), ItemModifyMode(mode_));
+			std::vector<Error> statuses;
+			auto err = db_.ModifyItems(nsName_, parsed, modes, statuses);
+			for (size_t i = 0; i < parsed.size(); ++i) {
+				errors[parsedIdx[i]] = err.ok() ? statuses[i] : err;
+				if (errors[parsedIdx[i]].ok() && parsed[i].GetID() != -1) ++updated_;
+			}
+		}
+
+		for (size_t i = 0; i < errors.size(); ++i) {
+			if (errors[i].ok()) continue;
+			++errors_;
+			JsonBuilder builder(ser_);
+			builder.Put("line", lineNumbers_[i]);
+			builder.Put("success", false);
+			builder.Put("response_code", int(http::HttpStatus(errors[i]).code));
+			builder.Put("description", errors[i].what());
+			builder.End();
+			ser_ << '\n';
+		}
+	}
+
+	void parse(std::vector<Item> &items, std::vector<Error> &errors) {
+		auto parseRange = [&](size_t from, size_t to) {
+			for (size_t i = from; i < to; ++i) {
+				items[i] = db_.NewItem(nsName_);
+				errors[i] = items[i].Status();
+				// Lines are not overlapped, so they are parsed in place
+				if (errors[i].ok()) errors[i] = items[i].Unsafe().FromJSON(lines_[i], nullptr, mode_ == ModeDelete);
+				if (errors[i].ok()) items[i].SetPrecepts(precepts_);
+			}
+		};
+
+		size_t count = items.size();
+		unsigned threads = std::max(1u, std::min(std::thread::hardware_concurrency(), unsigned(count / kMinLinesPerThread)));
+		parseWorkers().Parallel(threads, [&](unsigned t) { parseRange(t * count / threads, (t + 1) * count / threads); });
+	}
+
+	// Shared pool of workers, which parse batches of all the bulk requests together with the apply workers
+	static WorkerPool &parseWorkers() {
+		static WorkerPool workers(std::max(1u, std::min(std::thread::hardware_concurrency(), kMaxBulkParseWorkers)) - 1);
+		return workers;
+	}
+
+	// Max count of lines in batch, applied under the single namespace lock
+	static const size_t kBatchSize = 4096;
+	// Min count of lines, parsed by each thread
+	static const size_t kMinLinesPerThread = 256;
+
+	Reindexer db_;
+	string nsName_;
+	string body_;
+	int mode_;
+	vector<string> precepts_;
+	size_t pos_ = 0, lineNumber_ = 0;
+	std::vector<string_view> lines_;
+	std::vector<size_t> lineNumbers_;
+	int updated_ = 0, errors_ = 0;
+	WrSerializer ser_;
+};
+
+int HTTPServer::PostItemsBulk(http::Context &ctx) {
+	auto db = getDB(ctx, kRoleDataWrite);
+	string nsName = urldecode2(ctx.request->urlParams[1]);
+	if (nsName.empty()) {
+		return jsonStatus(ctx, http::HttpStatus(http::StatusBadRequest, "Namespace is not specified"));
+	}
+
+	string_view modeParam = ctx.request->params.Get("mode");
+	int mode = ModeUpsert;
+	if (modeParam == "insert"_sv) {
+		mode = ModeInsert;
+	} else if (modeParam == "update"_sv) {
+		mode = ModeUpdate;
+	} else if (modeParam == "delete"_sv) {
+		mode = ModeDelete;
+	} else if (!modeParam.empty() && modeParam != "upsert"_sv) {
+		return jsonStatus(ctx, http::HttpStatus(http::StatusBadRequest, "Invalid `mode` parameter"));
+	}
+
+	vector<string> precepts;
+	for (auto &p : ctx.request->params) {
+		if (p.name == "precepts" || p.name == "precepts[]") precepts.push_back(urldecode2(p.val));
+	}
+
+	auto modifier = std::make_shared<BulkModifier>(std::move(db), std::move(nsName), ctx.body->Read(), mode, std::move(precepts));
+	return sendByWorkerParts(ctx, "application/x-ndjson; charset=utf-8"_sv, modifier, BulkModifier::ApplyWorkers());
+}
+
 int HTTPServer::modifyItem(http::Context &ctx, int mode) {
 	auto db = getDB(ctx, kRoleDataWrite);
 	string nsName = urldecode2(ctx.request->urlParams[1]);
@@ -904,89 +1131,135 @@ int HTTPServer::modifyItem(http::Context &ctx, int mode) {
 	return ctx.JSON(http::StatusOK, ser.DetachChunk());
 }
 
-int HTTPServer::queryResults(http::Context &ctx, reindexer::QueryResults &res, bool isQueryResults, unsigned limit, unsigned offset) {
-	string_view width = ctx.request->params.Get("width");
-	string_view withColumnsParam = ctx.request->params.Get("with_columns");
-	bool withColumns = ((withColumnsParam == "1") && (stoi(width) > 0)) ? true : false;
-
-	WrSerializer wrSer(ctx.writer->GetChunk());
-	JsonBuilder builder(wrSer);
-
-	auto nsarray = builder.Array("namespaces");
-	for (auto &ns : res.GetNamespaces()) nsarray.Put(nullptr, ns);
-	nsarray.End();
-
-	auto iarray = builder.Array("items");
-	// TODO: normal check for query type
-	bool isWALQuery = res.Count() && res[0].IsRaw();
-
-	for (size_t i = offset; i < res.Count() && i < offset + limit; i++) {
-		if (!isWALQuery) {
-			iarray.Raw(nullptr, "");
-			res[i].GetJSON(wrSer, false);
+// Serializes query results to response body by parts, so memory used by response doesn't depend on results count
+class HTTPServer::QueryResultsWriter {
+public:
+	QueryResultsWriter(reindexer::QueryResults &&res, Reindexer &&db, bool ndjson, bool isQueryResults, unsigned limit, unsigned offset,
+					   int columnsWidth)
+		: res_(std::move(res)),
+		  db_(std::move(db)),
+		  ndjson_(ndjson),
+		  isQueryResults_(isQueryResults),
+		  // TODO: normal check for query type
+		  isWALQuery_(res_.Count() && res_[0].IsRaw()),
+		  limit_(limit),
+		  pos_(offset),
+		  end_(std::min(size_t(res_.Count()), size_t(offset) + limit)),
+		  columnsWidth_(columnsWidth),
+		  builder_(ser_, ndjson ? JsonBuilder::TypePlain : JsonBuilder::TypeObject),
+		  items_(ndjson ? JsonBuilder() : beginItems()) {}
+
+	/// Serialize next part of results
+	/// @param buf - buffer for serialization, if previous part is detached
+	/// @return false, if all the results are serialized
+	bool Next(chunk &&buf) {
+		if (!ser_.Len()) ser_ = WrSerializer(std::move(buf));
+		for (; pos_ < end_ && ser_.Len() < kChunkSize; ++pos_) putItem(res_[pos_]);
+		if (pos_ < end_) return true;
+		if (!ndjson_) putTail();
+		return false;
+	}
+	size_t Pending() const { return ser_.Len(); }
+	chunk Detach() { return ser_.DetachChunk(); }
+
+private:
+	JsonBuilder beginItems() {
+		auto nsarray = builder_.Array("namespaces");
+		for (auto &ns : res_.GetNamespaces()) nsarray.Put(nullptr, ns);
+		nsarray.End();
+		return builder_.Array("items");
+	}
+
+	void putItem(reindexer::QueryResults::Iterator it) {
+		if (!isWALQuery_) {
+			if (!ndjson_) items_.Raw(nullptr, "");
+			it.GetJSON(ser_, false);
 		} else {
-			auto obj = iarray.Object(nullptr);
-			obj.Put("lsn", res[i].GetLSN());
-			if (!res[i].IsRaw()) {
-				iarray.Raw("item", "");
-				res[i].GetJSON(wrSer, false);
+			JsonBuilder obj = ndjson_ ? JsonBuilder(ser_) : items_.Object(nullptr);
+			obj.Put("lsn", it.GetLSN());
+			if (!it.IsRaw()) {
+				obj.Raw("item", "");
+				it.GetJSON(ser_, false);
 			} else {
-				reindexer::WALRecord rec(res[i].GetRaw());
-				rec.GetJSON(obj, [this, &res, &ctx](string_view cjson) {
-					auto item = getDB(ctx, kRoleDataRead).NewItem(res.GetNamespaces()[0]);
+				reindexer::WALRecord rec(it.GetRaw());
+				rec.GetJSON(obj, [this](string_view cjson) {
+					auto item = db_.NewItem(res_.GetNamespaces()[0]);
 					item.FromCJSON(cjson);
 					return string(item.GetJSON());
 				});
 			}
 		}
-
-		if (i == offset) wrSer.Reserve(wrSer.Len() * (std::min(limit, unsigned(res.Count() - offset)) + 1));
+		if (ndjson_) ser_ << '\n';
 	}
-	iarray.End();
 
-	builder.Put("cache_enabled", res.IsCacheEnabled() && !isWALQuery);
-	if (!res.aggregationResults.empty()) {
-		auto arrNode = builder.Array("aggregations");
-		for (unsigned i = 0; i < res.aggregationResults.size(); i++) {
-			arrNode.Raw(nullptr, "");
-			res.aggregationResults[i].GetJSON(wrSer);
+	void putTail() {
+		items_.End();
+
+		builder_.Put("cache_enabled", res_.IsCacheEnabled() && !isWALQuery_);
+		if (!res_.aggregationResults.empty()) {
+			auto arrNode = builder_.Array("aggregations");
+			for (unsigned i = 0; i < res_.aggregationResults.size(); i++) {
+				arrNode.Raw(nullptr, "");
+				res_.aggregationResults[i].GetJSON(ser_);
+			}
 		}
-	}
 
-	if (!res.GetExplainResults().empty()) {
-		builder.Raw("explain", res.GetExplainResults());
-	}
+		if (!res_.GetExplainResults().empty()) {
+			builder_.Raw("explain", res_.GetExplainResults());
+		}
 
-	unsigned totalItems = isQueryResults ? res.Count() : static_cast<unsigned>(res.totalCount);
+		unsigned totalItems = isQueryResults_ ? res_.Count() : static_cast<unsigned>(res_.totalCount);
 
-	if (!isQueryResults || limit != kDefaultLimit) {
-		builder.Put("total_items", totalItems);
-	}
+		if (!isQueryResults_ || limit_ != kDefaultLimit) {
+			builder_.Put("total_items", totalItems);
+		}
 
-	if (isQueryResults && res.totalCount) {
-		builder.Put("query_total_items", res.totalCount);
-		if (limit == kDefaultLimit) builder.Put("total_items", res.totalCount);
-	}
+		if (isQueryResults_ && res_.totalCount) {
+			builder_.Put("query_total_items", res_.totalCount);
+			if (limit_ == kDefaultLimit) builder_.Put("total_items", res_.totalCount);
+		}
 
-	if (withColumns) {
-		reindexer::TableCalculator<reindexer::QueryResults> tableCalculator(res, stoi(width));
-		auto &header = tableCalculator.GetHeader();
-		auto &columnsSettings = tableCalculator.GetColumnsSettings();
-		auto array = builder.Array("columns");
-		for (auto it = header.begin(); it != header.end(); ++it) {
-			ColumnData &data = columnsSettings[*it];
-			array.Object()
-				.Put("name", *it)
-				.Put("width_percents", data.widthTerminalPercentage)
-				.Put("max_chars", data.maxWidthCh)
-				.Put("width_chars", data.widthCh);
+		if (columnsWidth_ > 0) {
+			reindexer::TableCalculator<reindexer::QueryResults> tableCalculator(res_, columnsWidth_);
+			auto &header = tableCalculator.GetHeader();
+			auto &columnsSettings = tableCalculator.GetColumnsSettings();
+			auto array = builder_.Array("columns");
+			for (auto it = header.begin(); it != header.end(); ++it) {
+				ColumnData &data = columnsSettings[*it];
+				array.Object()
+					.Put("name", *it)
+					.Put("width_percents", data.widthTerminalPercentage)
+					.Put("max_chars", data.maxWidthCh)
+					.Put("width_chars", data.widthCh);
+			}
+			array.End();
 		}
-		array.End();
+
+		builder_.End();
 	}
 
-	builder.End();
+	// Size of serialized part, after which it is sent to client
+	static const size_t kChunkSize = 0x8000;
 
-	return ctx.JSON(http::StatusOK, wrSer.DetachChunk());
+	reindexer::QueryResults res_;
+	Reindexer db_;
+	bool ndjson_, isQueryResults_, isWALQuery_;
+	unsigned limit_;
+	size_t pos_, end_;
+	int columnsWidth_;
+	WrSerializer ser_;
+	JsonBuilder builder_, items_;
+};
+
+int HTTPServer::queryResults(http::Context &ctx, reindexer::QueryResults &res, bool isQueryResults, unsigned limit, unsigned offset) {
+	string_view width = ctx.request->params.Get("width");
+	string_view withColumnsParam = ctx.request->params.Get("with_columns");
+	int columnsWidth = (withColumnsParam == "1") ? stoi(width) : 0;
+	bool ndjson = (ctx.request->params.Get("format") == "ndjson"_sv);
+
+	auto resWriter = std::make_shared<QueryResultsWriter>(std::move(res), getDB(ctx, kRoleDataRead), ndjson, isQueryResults, limit,
+														  offset, columnsWidth);
+	return sendByParts(ctx, ndjson ? "application/x-ndjson; charset=utf-8"_sv : "application/json; charset=utf-8"_sv, resWriter);
 }
 
 int HTTPServer::jsonStatus(http::Context &ctx, http::HttpStatus status) {
@@ -60,6 +60,7 @@ public:
 	int PostItems(http::Context &ctx);
 	int PutItems(http::Context &ctx);
 	int DeleteItems(http::Context &ctx);
+	int PostItemsBulk(http::Context &ctx);
 	int GetIndexes(http::Context &ctx);
 	int PostIndex(http::Context &ctx);
 	int PutIndex(http::Context &ctx);
@@ -72,6 +73,9 @@ public:
 	void OnResponse(http::Context &ctx);
 
 protected:
+	class QueryResultsWriter;
+	class BulkModifier;
+
 	int modifyItem(http::Context &ctx, int mode);
 	int queryResults(http::Context &ctx, reindexer::QueryResults &res, bool isQueryResults = false, unsigned limit = kDefaultLimit,
 					 unsigned offset = kDefaultOffset);
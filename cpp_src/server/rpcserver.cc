@@ -10,8 +10,14 @@
 
 namespace reindexer_server {
 
-RPCServer::RPCServer(DBManager &dbMgr, LoggerWrapper logger, bool allocDebug, IStatsWatcher *statsCollector)
-	: dbMgr_(dbMgr), logger_(logger), allocDebug_(allocDebug), statsWatcher_(statsCollector), startTs_(std::chrono::system_clock::now()) {}
+RPCServer::RPCServer(DBManager &dbMgr, LoggerWrapper logger, bool allocDebug, IStatsWatcher *statsCollector,
+					 const cproto::ExecutorConfig &executorConfig)
+	: dbMgr_(dbMgr),
+	  executor_(executorConfig),
+	  logger_(logger),
+	  allocDebug_(allocDebug),
+	  statsWatcher_(statsCollector),
+	  startTs_(std::chrono::system_clock::now()) {}
 
 RPCServer::~RPCServer() {}
 
@@ -107,6 +113,10 @@ void RPCServer::OnResponse(cproto::Context &ctx) {
 			// Don't update stats on responses like "updates push"
 			statsWatcher_->OnInputTraffic(dbName, statsSourceName(), ctx.stat.sizeStat.reqSizeBytes);
 		}
+		if (executor_.Enabled() && ctx.call && ctx.stat.sizeStat.reqSizeBytes) {
+			statsWatcher_->OnRPCQueueWait(cproto::CmdClassName(cproto::GetCmdClass(*ctx.call)), ctx.stat.queueStat.waitUs,
+										  ctx.stat.queueStat.rejected);
+		}
 	}
 }
 
@@ -135,6 +145,9 @@ void RPCServer::Logger(cproto::Context &ctx, const Error &err, const cproto::Arg
 
 	HandlerStat statDiff = HandlerStat() - ctx.stat.allocStat;
 	ser << ' ' << statDiff.GetTimeElapsed() << "us"_sv;
+	if (ctx.stat.queueStat.waitUs) {
+		ser << " (queued "_sv << ctx.stat.queueStat.waitUs << "us)"_sv;
+	}
 
 	if (allocDebug_) {
 		ser << " |  allocs: "_sv << statDiff.GetAllocsCnt() << ", allocated: " << statDiff.GetAllocsBytes() << " byte(s)";
@@ -428,6 +441,78 @@ Error RPCServer::ModifyItem(cproto::Context &ctx, p_string ns, int format, p_str
 	return sendResults(ctx, qres, -1, opts);
 }
 
+Error RPCServer::ModifyItems(cproto::Context &ctx, p_string ns, int format, p_string itemsPack, int stateToken) {
+	auto db = getDB(ctx, kRoleDataWrite);
+	Serializer rser(itemsPack);
+	const uint64_t count = rser.GetVarUint();
+	// Each item takes at least 2 bytes (mode and length of data), so count can't exceed rest of the pack. Check it before any allocations
+	if (count > (itemsPack.size() - rser.Pos()) / 2) {
+		return Error(errParams, "Invalid items count %d: items pack has only %d bytes", count, itemsPack.size() - rser.Pos());
+	}
+
+	// Items, which are failed to parse, are not passed to the database, but get their statuses
+	vector<Error> statuses(count);
+	vector<Item> items;
+	vector<ItemModifyMode> modes;
+	vector<unsigned> positions;
+	items.reserve(count);
+	modes.reserve(count);
+	positions.reserve(count);
+	bool tmUpdated = false;
+	for (unsigned i = 0; i < count; ++i) {
+		const auto mode = ItemModifyMode(rser.GetVarUint());
+		const string_view itemData = rser.GetVString();
+		Item item = db.NewItem(ns);
+		if (!item.Status().ok()) return item.Status();
+		if (format == FormatCJson && item.GetStateToken() != stateToken) {
+			return Error(errStateInvalidated, "stateToken mismatch:  %08X, need %08X. Can't process items", stateToken, item.GetStateToken());
+		}
+
+		Error err;
+		switch (format) {
+			case FormatJson:
+				err = item.Unsafe().FromJSON(itemData, nullptr, mode == ModeDelete);
+				break;
+			case FormatCJson:
+				err = item.Unsafe().FromCJSON(itemData, mode == ModeDelete);
+				break;
+			default:
+				return Error(errParams, "Invalid source item format %d", format);
+		}
+		if (!err.ok()) {
+			statuses[i] = err;
+			continue;
+		}
+		tmUpdated = tmUpdated || item.IsTagsUpdated();
+		items.emplace_back(std::move(item));
+		modes.push_back(mode);
+		positions.push_back(i);
+	}
+
+	vector<Error> applied;
+	auto err = db.WithTimeout(ctx.call->execTimeout_).ModifyItems(ns, items, modes, applied);
+	if (!err.ok()) return err;
+
+	WrSerializer wrser;
+	wrser.PutVarUint(tmUpdated);
+	wrser.PutVarUint(count);
+	size_t pos = 0;
+	for (unsigned i = 0; i < count; ++i) {
+		int id = -1;
+		if (pos < positions.size() && positions[pos] == i) {
+			statuses[i] = applied[pos];
+			id = items[pos].GetID();
+			++pos;
+		}
+		wrser.PutVarint(statuses[i].code());
+		wrser.PutVString(statuses[i].what());
+		wrser.PutVarint(id);
+	}
+	string_view resSlice = wrser.Slice();
+	ctx.Return({cproto::Arg(p_string(&resSlice))});
+	return errOK;
+}
+
 Error RPCServer::DeleteQuery(cproto::Context &ctx, p_string queryBin) {
 	Query query;
 	Serializer ser(queryBin.data(), queryBin.size());
@@ -544,6 +629,14 @@ void RPCServer::clearTx(cproto::Context &ctx, uint64_t txId) {
 	data->txs[txId] = Transaction();
 }
 
+PreparedQuery::Ptr &RPCServer::getPreparedQuery(cproto::Context &ctx, int id) {
+	auto data = dynamic_cast<RPCClientData *>(ctx.GetClientData().get());
+	if (id < 0 || id >= int(data->preparedQueries.size()) || !data->preparedQueries[id]) {
+		throw Error(errLogic, "Invalid prepared query id");
+	}
+	return data->preparedQueries[id];
+}
+
 void RPCServer::freeQueryResults(cproto::Context &ctx, int id) {
 	auto data = dynamic_cast<RPCClientData *>(ctx.GetClientData().get());
 	if (id >= int(data->results.size()) || id < 0) {
@@ -594,6 +687,50 @@ Error RPCServer::SelectSQL(cproto::Context &ctx, p_string querySql, int flags, i
 	return fetchResults(ctx, id, opts);
 }
 
+Error RPCServer::PrepareSQL(cproto::Context &ctx, p_string querySql) {
+	PreparedQuery::Ptr prepared;
+	auto ret = getDB(ctx, kRoleDataRead).Prepare(querySql, prepared);
+	if (!ret.ok()) {
+		return ret;
+	}
+
+	auto data = dynamic_cast<RPCClientData *>(ctx.GetClientData().get());
+	int id = 0;
+	while (id < int(data->preparedQueries.size()) && data->preparedQueries[id]) id++;
+	if (id == int(data->preparedQueries.size())) {
+		if (data->preparedQueries.size() >= cproto::kMaxPreparedQueries) return Error(errLogic, "Too many prepared queries");
+		data->preparedQueries.emplace_back();
+	}
+	data->preparedQueries[id] = std::move(prepared);
+
+	ctx.Return({cproto::Arg(id)});
+	return errOK;
+}
+
+Error RPCServer::SelectPrepared(cproto::Context &ctx, int preparedId, p_string argsPck, int flags, int limit, p_string ptVersionsPck) {
+	PreparedQuery::Ptr prepared = getPreparedQuery(ctx, preparedId);
+	VariantArray args;
+	Serializer ser(argsPck);
+	for (int cnt = ser.GetVarUint(); cnt > 0; cnt--) args.push_back(ser.GetVariant().EnsureHold());
+
+	int id = -1;
+	QueryResults &qres = getQueryResults(ctx, id);
+	auto ret = getDB(ctx, kRoleDataRead).Select(*prepared, args, qres);
+	if (!ret.ok()) {
+		freeQueryResults(ctx, id);
+		return ret;
+	}
+	auto ptVersions = pack2vec(ptVersionsPck);
+	ResultFetchOpts opts{flags, ptVersions, 0, unsigned(limit)};
+
+	return fetchResults(ctx, id, opts);
+}
+
+Error RPCServer::ClosePrepared(cproto::Context &ctx, int preparedId) {
+	getPreparedQuery(ctx, preparedId).reset();
+	return errOK;
+}
+
 Error RPCServer::FetchResults(cproto::Context &ctx, int reqId, int flags, int offset, int limit) {
 	flags &= ~kResultsWithPayloadTypes;
 
@@ -691,6 +828,7 @@ bool RPCServer::Start(const string &addr, ev::dynamic_loop &loop) {
 	dispatcher_.Register(cproto::kCmdRollbackTx, this, &RPCServer::RollbackTx);
 
 	dispatcher_.Register(cproto::kCmdModifyItem, this, &RPCServer::ModifyItem);
+	dispatcher_.Register(cproto::kCmdModifyItems, this, &RPCServer::ModifyItems);
 	dispatcher_.Register(cproto::kCmdDeleteQuery, this, &RPCServer::DeleteQuery);
 	dispatcher_.Register(cproto::kCmdUpdateQuery, this, &RPCServer::UpdateQuery);
 
@@ -698,6 +836,9 @@ bool RPCServer::Start(const string &addr, ev::dynamic_loop &loop) {
 	dispatcher_.Register(cproto::kCmdSelectSQL, this, &RPCServer::SelectSQL);
 	dispatcher_.Register(cproto::kCmdFetchResults, this, &RPCServer::FetchResults);
 	dispatcher_.Register(cproto::kCmdCloseResults, this, &RPCServer::CloseResults);
+	dispatcher_.Register(cproto::kCmdPrepareSQL, this, &RPCServer::PrepareSQL);
+	dispatcher_.Register(cproto::kCmdSelectPrepared, this, &RPCServer::SelectPrepared);
+	dispatcher_.Register(cproto::kCmdClosePrepared, this, &RPCServer::ClosePrepared);
 
 	dispatcher_.Register(cproto::kCmdGetSQLSuggestions, this, &RPCServer::GetSQLSuggestions);
 
@@ -713,7 +854,7 @@ bool RPCServer::Start(const string &addr, ev::dynamic_loop &loop) {
 		dispatcher_.Logger(this, &RPCServer::Logger);
 	}
 
-	listener_.reset(new Listener(loop, cproto::ServerConnection::NewFactory(dispatcher_)));
+	listener_.reset(new Listener(loop, cproto::ServerConnection::NewFactory(dispatcher_, executor_.Enabled() ? &executor_ : nullptr)));
 	return listener_->Bind(addr);
 }
 
@@ -8,6 +8,7 @@
 #include "dbmanager.h"
 #include "loggerwrapper.h"
 #include "net/cproto/dispatcher.h"
+#include "net/cproto/executor.h"
 #include "net/listener.h"
 #include "rpcupdatespusher.h"
 #include "statscollect/istatswatcher.h"
@@ -23,6 +24,7 @@ struct RPCClientData : public cproto::ClientData {
 	~RPCClientData();
 	h_vector<pair<QueryResults, bool>, 1> results;
 	vector<Transaction> txs;
+	vector<PreparedQuery::Ptr> preparedQueries;
 
 	AuthContext auth;
 	cproto::RPCUpdatesPusher pusher;
@@ -32,11 +34,16 @@ struct RPCClientData : public cproto::ClientData {
 
 class RPCServer {
 public:
-	RPCServer(DBManager &dbMgr, LoggerWrapper logger, bool allocDebug = false, IStatsWatcher *statsCollector = nullptr);
+	RPCServer(DBManager &dbMgr, LoggerWrapper logger, bool allocDebug = false, IStatsWatcher *statsCollector = nullptr,
+			  const cproto::ExecutorConfig &executorConfig = cproto::ExecutorConfig());
 	~RPCServer();
 
 	bool Start(const string &addr, ev::dynamic_loop &loop);
-	void Stop() { listener_->Stop(); }
+	void Stop() {
+		// Calls in progress are finished before connections are closed
+		executor_.Stop();
+		listener_->Stop();
+	}
 
 	Error Ping(cproto::Context &ctx);
 	Error Login(cproto::Context &ctx, p_string login, p_string password, p_string db);
@@ -59,6 +66,7 @@ public:
 
 	Error ModifyItem(cproto::Context &ctx, p_string nsName, int format, p_string itemData, int mode, p_string percepsPack, int stateToken,
 					 int txID);
+	Error ModifyItems(cproto::Context &ctx, p_string nsName, int format, p_string itemsPack, int stateToken);
 
 	Error StartTransaction(cproto::Context &ctx, p_string nsName);
 
@@ -77,6 +85,9 @@ public:
 	Error SelectSQL(cproto::Context &ctx, p_string query, int flags, int limit, p_string ptVersions);
 	Error FetchResults(cproto::Context &ctx, int reqId, int flags, int offset, int limit);
 	Error CloseResults(cproto::Context &ctx, int reqId);
+	Error PrepareSQL(cproto::Context &ctx, p_string query);
+	Error SelectPrepared(cproto::Context &ctx, int preparedId, p_string argsPck, int flags, int limit, p_string ptVersions);
+	Error ClosePrepared(cproto::Context &ctx, int preparedId);
 	Error GetSQLSuggestions(cproto::Context &ctx, p_string query, int pos);
 
 	Error GetMeta(cproto::Context &ctx, p_string ns, p_string key);
@@ -98,12 +109,14 @@ protected:
 	Transaction &getTx(cproto::Context &ctx, int64_t id);
 	int64_t addTx(cproto::Context &ctx, Transaction &&tr);
 	void clearTx(cproto::Context &ctx, uint64_t txId);
+	PreparedQuery::Ptr &getPreparedQuery(cproto::Context &ctx, int id);
 
 	Reindexer getDB(cproto::Context &ctx, UserRole role);
 	constexpr static string_view statsSourceName() { return "rpc"_sv; }
 
 	DBManager &dbMgr_;
 	cproto::Dispatcher dispatcher_;
+	cproto::Executor executor_;
 	std::unique_ptr<Listener> listener_;
 
 	LoggerWrapper logger_;
@@ -269,7 +269,10 @@ int ServerImpl::run() {
 		}
 
 		LoggerWrapper rpcLogger("rpc");
-		RPCServer rpcServer(*dbMgr_, rpcLogger, config_.DebugAllocs, statsCollector.get());
+		cproto::ExecutorConfig executorConfig;
+		executorConfig.workersPerClass = config_.RPCWorkers;
+		executorConfig.maxQueueSize = config_.RPCQueueSize;
+		RPCServer rpcServer(*dbMgr_, rpcLogger, config_.DebugAllocs, statsCollector.get(), executorConfig);
 		if (!rpcServer.Start(config_.RPCAddr, loop_)) {
 			logger_.error("Can't listen RPC on '{0}'", config_.RPCAddr);
 			return EXIT_FAILURE;
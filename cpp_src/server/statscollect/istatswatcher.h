@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdint.h>
 #include "estl/string_view.h"
 
 namespace reindexer_server {
@@ -11,6 +12,7 @@ struct IStatsWatcher {
 	virtual void OnOutputTraffic(const std::string& db, string_view source, size_t bytes) noexcept = 0;
 	virtual void OnClientConnected(const std::string& db, string_view source) noexcept = 0;
 	virtual void OnClientDisconnected(const std::string& db, string_view source) noexcept = 0;
+	virtual void OnRPCQueueWait(string_view cmdClass, uint64_t waitUs, bool rejected) noexcept = 0;
 	virtual ~IStatsWatcher() noexcept = default;
 };
 
@@ -29,6 +29,14 @@ void Prometheus::Attach(http::Router& router) {
 	outputTraffic_ =
 		&BuildGauge().Name("reindexer_output_traffic_total_bytes").Help("Total RPC output traffic in bytes").Register(registry_);
 	collectables_.emplace_back(outputTraffic_);
+	rpcQueueWait_ = &BuildGauge()
+						 .Name("reindexer_rpc_queue_avg_wait")
+						 .Help("Average time, which RPC calls spend in executor's queue (seconds)")
+						 .Register(registry_);
+	collectables_.emplace_back(rpcQueueWait_);
+	rpcRejected_ =
+		&BuildGauge().Name("reindexer_rpc_rejected_total").Help("Total RPC calls, rejected due to executor's queue overflow").Register(registry_);
+	collectables_.emplace_back(rpcRejected_);
 
 	router.GET<Prometheus, &Prometheus::collect>("/metrics", this);
 }
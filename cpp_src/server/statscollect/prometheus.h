@@ -34,6 +34,10 @@ public:
 	void RegisterRPCClients(const string &db, size_t count) { setMetricValue(rpcClients_, count, db); }
 	void RegisterInputTraffic(const string &db, string_view type, size_t bytes) { setMetricValue(inputTraffic_, bytes, db, type); }
 	void RegisterOutputTraffic(const string &db, string_view type, size_t bytes) { setMetricValue(outputTraffic_, bytes, db, type); }
+	void RegisterRPCQueueWait(string_view cmdClass, size_t waitUS) {
+		setMetricValue(rpcQueueWait_, static_cast<double>(waitUS) / 1e6, string(), cmdClass);
+	}
+	void RegisterRPCRejected(string_view cmdClass, size_t count) { setMetricValue(rpcRejected_, count, string(), cmdClass); }
 
 	static void setMetricValue(PFamily<PGauge> *metricFamily, double value, const string &db = "", const string &ns = "",
 							   string_view queryType = "") noexcept;
@@ -53,6 +57,8 @@ public:
 	PFamily<PGauge> *inputTraffic_{nullptr};
 	PFamily<PGauge> *outputTraffic_{nullptr};
 	PFamily<PGauge> *itemsCount_{nullptr};
+	PFamily<PGauge> *rpcQueueWait_{nullptr};
+	PFamily<PGauge> *rpcRejected_{nullptr};
 };
 
 }  // namespace reindexer_server
@@ -1,4 +1,5 @@
 #include "statscollector.h"
+#include <algorithm>
 #include "dbmanager.h"
 #include "prometheus.h"
 #include "tools/alloc_ext/je_malloc_extension.h"
@@ -58,6 +59,21 @@ void StatsCollector::OnClientDisconnected(const std::string& db, string_view sou
 	}
 }
 
+void StatsCollector::OnRPCQueueWait(string_view cmdClass, uint64_t waitUs, bool rejected) noexcept {
+	if (prometheus_ && enabled_.load(std::memory_order_acquire)) {
+		std::lock_guard<std::mutex> lck(mtx_);
+		auto it = std::find_if(queueCounters_.begin(), queueCounters_.end(),
+							   [cmdClass](const std::pair<std::string, QueueCounters>& el) { return string_view(el.first) == cmdClass; });
+		if (it == queueCounters_.end()) it = queueCounters_.emplace(queueCounters_.end(), std::string(cmdClass), QueueCounters());
+		if (rejected) {
+			++it->second.rejected;
+		} else {
+			++it->second.calls;
+			it->second.waitUs += waitUs;
+		}
+	}
+}
+
 void StatsCollector::collectStats(DBManager& dbMngr) noexcept {
 	auto dbNames = dbMngr.EnumDatabases();
 	for (auto& dbName : dbNames) {
@@ -127,6 +143,13 @@ void StatsCollector::collectStats(DBManager& dbMngr) noexcept {
 				prometheus_->RegisterOutputTraffic(counter.first, dbCounters.first, counter.second.outputTraffic);
 			}
 		}
+		for (auto& queueCounters : queueCounters_) {
+			auto& counters = queueCounters.second;
+			prometheus_->RegisterRPCQueueWait(queueCounters.first, counters.calls ? counters.waitUs / counters.calls : 0);
+			prometheus_->RegisterRPCRejected(queueCounters.first, counters.rejected);
+			counters.calls = 0;
+			counters.waitUs = 0;
+		}
 	}
 }
 
@@ -24,6 +24,7 @@ public:
 	void OnOutputTraffic(const std::string& db, string_view source, size_t bytes) noexcept override final;
 	void OnClientConnected(const std::string& db, string_view source) noexcept override final;
 	void OnClientDisconnected(const std::string& db, string_view source) noexcept override final;
+	void OnRPCQueueWait(string_view cmdClass, uint64_t waitUs, bool rejected) noexcept override final;
 
 private:
 	struct DBCounters {
@@ -33,6 +34,13 @@ private:
 	};
 	using CountersByDB = std::unordered_map<std::string, DBCounters, reindexer::nocase_hash_str, reindexer::nocase_equal_str>;
 	using Counters = std::vector<std::pair<std::string, CountersByDB>>;
+	struct QueueCounters {
+		// Calls and their total wait time since the last collect
+		uint64_t calls{0};
+		uint64_t waitUs{0};
+		uint64_t rejected{0};
+	};
+	using QueueCountersByClass = std::vector<std::pair<std::string, QueueCounters>>;
 
 	void collectStats(DBManager& dbMngr) noexcept;
 	DBCounters& getCounters(const std::string& db, string_view source) noexcept;
@@ -43,6 +51,7 @@ private:
 	std::atomic<bool> enabled_;
 	std::chrono::milliseconds collectPeriod_;
 	Counters counters_;
+	QueueCountersByClass queueCounters_;
 	std::mutex mtx_;
 };
 
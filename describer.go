@@ -76,6 +76,21 @@ type CacheMemStat struct {
 	EmptyCount int64 `json:"empty_count"`
 	// Number of hits of queries, to store results in cache
 	HitCountLimit int64 `json:"hit_count_limit"`
+	// Count of cache lookups, which were served from cache
+	HitsCount int64 `json:"hits_count"`
+	// Count of cache lookups, which were not served from cache
+	MissesCount int64 `json:"misses_count"`
+	// Stats of independent cache shards
+	Shards []struct {
+		// Total memory consumption by this shard
+		TotalSize int64 `json:"total_size"`
+		// Count of elements stored in this shard
+		ItemsCount int64 `json:"items_count"`
+		// Count of lookups, which were served from this shard
+		HitsCount int64 `json:"hits_count"`
+		// Count of lookups, which were not served from this shard
+		MissesCount int64 `json:"misses_count"`
+	} `json:"shards"`
 }
 
 // NamespaceMemStat information about reindexer's namespace memory statisctics
@@ -137,8 +152,16 @@ type NamespaceMemStat struct {
 		IDSetPlainSize int64 `json:"idset_plain_size"`
 		// Total memory consumption of reverse index b-tree structures. For `dense` and `store` indexes always 0
 		IDSetBTreeSize int64 `json:"idset_btree_size"`
+		// Total memory consumption of reverse index compressed bitmaps. Applicable only to `hash` indexes without sort orders
+		IDSetBitmapSize int64 `json:"idset_bitmap_size"`
 		// Total memory consumption of fulltext search structures
 		FulltextSize int64 `json:"fulltext_size"`
+		// Duration of the last build of fulltext search structures
+		FulltextBuildTimeMs int64 `json:"fulltext_build_time_ms"`
+		// Count of builds of fulltext search structures
+		FulltextGeneration int64 `json:"fulltext_generation"`
+		// Time since the first update, which is not reflected in fulltext search structures yet
+		FulltextGenerationLagMs int64 `json:"fulltext_generation_lag_ms"`
 		// Idset cache stats. Stores merged reverse index results of SELECT field IN(...) by IN(...) keys
 		IDSetCache CacheMemStat `json:"idset_cache"`
 	} `json:"indexes"`
@@ -146,6 +169,23 @@ type NamespaceMemStat struct {
 	JoinCache CacheMemStat `json:"join_cache"`
 	// Query cache stats. Stores results of SELECT COUNT(*) by Where conditions
 	QueryCache CacheMemStat `json:"query_cache"`
+	// Query results cache stats. Stores ids of documents and aggregation results of SELECT queries
+	ResultsCache CacheMemStat `json:"results_cache"`
+	// Memory consumption of slab allocator of documents data
+	Arena struct {
+		// Count of allocated memory regions, which slabs are carved from
+		RegionsCount int64 `json:"regions_count"`
+		// Count of allocated slabs
+		SlabsCount int64 `json:"slabs_count"`
+		// Count of documents data blocks, allocated in slabs
+		BlocksCount int64 `json:"blocks_count"`
+		// Total memory size of slabs
+		TotalSize int64 `json:"total_size"`
+		// Memory size of used blocks in slabs
+		UsedSize int64 `json:"used_size"`
+		// Part of slabs memory, which is not used by documents data
+		Fragmentation float64 `json:"fragmentation"`
+	} `json:"arena"`
 }
 
 // PerfStat is information about different reinexer's objects performance statistics
@@ -228,6 +268,12 @@ type DBNamespacesConfig struct {
 	OptimizationTimeout int `json:"optimization_timeout_ms"`
 	// Maximum number of background threads of sort indexes optimization. 0 - disable sort optimizations
 	OptimizationSortWorkers int `json:"optimization_sort_workers"`
+	// Maximum number of WAL records for this namespace. 0 - use default
+	WALSize int64 `json:"wal_size"`
+	// Maximum memory size of WAL records for this namespace. The oldest records are evicted, when limit is exceeded. 0 - use default
+	WALMaxBytes int64 `json:"wal_max_bytes"`
+	// Maximum memory size of query results cache for this namespace. 0 - disable cache
+	ResultsCacheSize int64 `json:"results_cache_size"`
 }
 
 // DBReplicationConfig is part of reindexer configuration contains replication options
@@ -242,6 +288,8 @@ type DBReplicationConfig struct {
 	ForceSyncOnLogicError bool `json:"force_sync_on_logic_error"`
 	// force resync on wrong data hash conditions
 	ForceSyncOnWrongDataHash bool `json:"force_sync_on_wrong_data_hash"`
+	// Count of items in chunk of bulk snapshot of namespace on forced sync. 0 means, that namespace is fetched by single query
+	SnapshotChunkSize int `json:"snapshot_chunk_size"`
 	// List of namespaces for replication. If emply, all namespaces. All replicated namespaces will become read only for slave
 	Namespaces []string `json:"namespaces"`
 }
@@ -33,6 +33,9 @@ type FtFastConfig struct {
 	MaxRebuildSteps int `json:"max_rebuild_steps"`
 	// Maximum words in one commit - it can be from 5 to DOUBLE_MAX
 	MaxStepSize int `json:"max_step_size"`
+	// Maximum time in ms, during which selects use outdated data, while it is rebuilt in background after updates
+	// 0: data is rebuilt by the first select after updates
+	MaxRebuildStalenessMs int `json:"max_rebuild_staleness_ms"`
 	// Maximum documents which will be processed in merge query results
 	// Default value is 20000. Increasing this value may refine ranking
 	// of queries with high frequency words
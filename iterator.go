@@ -30,6 +30,8 @@ type ExplainResults struct {
 		Field string `json:"field"`
 		// Method, used to process condition
 		Method string `json:"method"`
+		// Strategy, used to execute join
+		JoinStrategy string `json:"join_strategy"`
 		// Number of uniq keys, processed by this selector (may be incorrect, in case of internal query optimization/caching
 		Keys int `json:"keys"`
 		// Count of comparators used, for this selector
@@ -36,6 +36,7 @@ const (
 	queryOpenBracket       = bindings.QueryOpenBracket
 	queryCloseBracket      = bindings.QueryCloseBracket
 	queryJoinCondition     = bindings.QueryJoinCondition
+	queryParallel          = bindings.QueryParallel
 )
 
 // Constants for calc total
@@ -565,6 +566,13 @@ func (q *Query) Explain() *Query {
 	return q
 }
 
+// Parallel - Allow parallel execution of query by several threads.
+// Query is executed in parallel only on big enough namespaces, and only without joins, distinct and fulltext conditions
+func (q *Query) Parallel() *Query {
+	q.ser.PutVarCUInt(queryParallel)
+	return q
+}
+
 // SetContext set interface, which will be passed to Joined interface
 func (q *Query) SetContext(ctx interface{}) *Query {
 	q.context = ctx